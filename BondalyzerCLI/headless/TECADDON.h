@@ -0,0 +1,333 @@
+#pragma once
+#ifndef HEADLESS_TECADDON_H_
+#define HEADLESS_TECADDON_H_
+
+/*
+*	Stand-in for Tecplot's TECADDON.h, used to build BondalyzerLib and
+*	BondalyzerCLI without the Tecplot SDK (e.g. on a Linux compute node).
+*
+*	Only the types, constants and TecUtil functions that the library code
+*	uses are declared here. tecutil_headless.cpp implements them as a
+*	Tecplot with no dataset loaded: queries return zero/NULL/FALSE, calls
+*	that would add zones or variables fail, messages go to stderr and the
+*	locks, status bar and style calls do nothing.
+*
+*	Everything that runs on VolumeData_c and FieldDataPointer_c's array
+*	backend (FindCPs(), GradPath_c, ...) works the same as in Tecplot.
+*/
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#include <cstring>
+#include <cassert>
+
+typedef char Boolean_t;
+typedef unsigned char Byte_t;
+typedef int16_t Int16_t;
+typedef int32_t Int32_t;
+typedef int64_t Int64_t;
+typedef int32_t LgIndex_t;
+typedef int32_t EntIndex_t;
+typedef int16_t SmInteger_t;
+typedef SmInteger_t ColorIndex_t;
+typedef LgIndex_t NodeMap_t;
+typedef LgIndex_t SetIndex_t;
+typedef int32_t ElemFaceOffset_t;
+typedef int64_t UniqueID_t;
+typedef intptr_t ArbParam_t;
+typedef char * VarName_t;
+typedef char * ZoneName_t;
+
+typedef struct _AddOn_s *			AddOn_pa;
+typedef struct _Set_s *				Set_pa;
+typedef struct _ArgList_s *			ArgList_pa;
+typedef struct _AuxData_s *			AuxData_pa;
+typedef struct _FieldData_s *		FieldData_pa;
+typedef struct _NodeMap_s *			NodeMap_pa;
+typedef struct _NodeToElemMap_s *	NodeToElemMap_pa;
+
+#ifndef TRUE
+#define TRUE  ((Boolean_t)1)
+#endif
+#ifndef FALSE
+#define FALSE ((Boolean_t)0)
+#endif
+
+#ifndef MIN
+#define MIN(X,Y) ((X) < (Y) ? (X) : (Y))
+#endif
+#ifndef MAX
+#define MAX(X,Y) ((X) > (Y) ? (X) : (Y))
+#endif
+#ifndef ABS
+#define ABS(X) ((X) >= 0 ? (X) : -(X))
+#endif
+#ifndef PI
+#define PI 3.14159265358979323846
+#endif
+
+#if defined _DEBUG
+#define REQUIRE(X) assert(X)
+#define ENSURE(X) assert(X)
+#define CHECK(X) assert(X)
+#else
+#define REQUIRE(X) ((void)0)
+#define ENSURE(X) ((void)0)
+#define CHECK(X) ((void)0)
+#endif
+#define VALID_REF(P) ((P) != NULL)
+
+enum FieldDataType_e {
+	FieldDataType_Reserved,
+	FieldDataType_Float,
+	FieldDataType_Double,
+	FieldDataType_Int32,
+	FieldDataType_Int16,
+	FieldDataType_Byte,
+	FieldDataType_Bit,
+	FieldDataType_Invalid = -1
+};
+
+enum ValueLocation_e {
+	ValueLocation_CellCentered,
+	ValueLocation_Nodal,
+	ValueLocation_Invalid = -1
+};
+
+enum ZoneType_e {
+	ZoneType_Ordered,
+	ZoneType_FELineSeg,
+	ZoneType_FETriangle,
+	ZoneType_FEQuad,
+	ZoneType_FETetra,
+	ZoneType_FEBrick,
+	ZoneType_FEPolygon,
+	ZoneType_FEPolyhedron,
+	ZoneType_Invalid = -1
+};
+
+enum StreamDir_e {
+	StreamDir_Forward,
+	StreamDir_Reverse,
+	StreamDir_Both,
+	StreamDir_Invalid = -1
+};
+
+enum AssignOp_e {
+	AssignOp_Equals,
+	AssignOp_PlusEquals,
+	AssignOp_MinusEquals,
+	AssignOp_TimesEquals,
+	AssignOp_DivideEquals,
+	AssignOp_Invalid = -1
+};
+
+enum MessageBoxType_e {
+	MessageBoxType_Error,
+	MessageBoxType_Warning,
+	MessageBoxType_Information,
+	MessageBoxType_Question,
+	MessageBoxType_Invalid = -1
+};
+
+enum StateChange_e {
+	StateChange_VarsAltered,
+	StateChange_VarsAdded,
+	StateChange_ZonesDeleted,
+	StateChange_ZonesAdded,
+	StateChange_Invalid = -1
+};
+
+enum AuxDataType_e {
+	AuxDataType_String,
+	AuxDataType_Invalid = -1
+};
+
+enum GeomShape_e {
+	GeomShape_Square,
+	GeomShape_Del,
+	GeomShape_Grad,
+	GeomShape_RTri,
+	GeomShape_LTri,
+	GeomShape_Diamond,
+	GeomShape_Circle,
+	GeomShape_Cube,
+	GeomShape_Sphere,
+	GeomShape_Octahedron,
+	GeomShape_Point,
+	GeomShape_Invalid = -1
+};
+
+enum SetValueReturnCode_e {
+	SetValue_Ok,
+	SetValue_Invalid = -1
+};
+
+enum {
+	Black_C,
+	Red_C,
+	Green_C,
+	Blue_C,
+	Cyan_C,
+	Yellow_C,
+	Purple_C,
+	White_C,
+	Custom1_C,
+	Custom2_C,
+	Custom3_C,
+	Custom4_C,
+	Custom5_C,
+	Custom6_C,
+	Custom7_C,
+	Custom8_C
+};
+
+#define SV_COLOR					"COLOR"
+#define SV_EFFECTS					"EFFECTS"
+#define SV_FIELDMAP					"FIELDMAP"
+#define SV_FRAMESIZE				"FRAMESIZE"
+#define SV_GEOMSHAPE				"GEOMSHAPE"
+#define SV_IMAX						"IMAX"
+#define SV_IVALUE					"IVALUE"
+#define SV_JMAX						"JMAX"
+#define SV_NAME						"NAME"
+#define SV_OBJECTSET				"OBJECTSET"
+#define SV_P1						"P1"
+#define SV_P2						"P2"
+#define SV_P3						"P3"
+#define SV_SHAREVARWITHALLZONES		"SHAREVARWITHALLZONES"
+#define SV_SHOW						"SHOW"
+#define SV_STATECHANGE				"STATECHANGE"
+#define SV_USETRANSLUCENCY			"USETRANSLUCENCY"
+#define SV_VALUELOCATION			"VALUELOCATION"
+#define SV_VARDATATYPE				"VARDATATYPE"
+#define SV_VARLIST					"VARLIST"
+#define SV_ZONELIST					"ZONELIST"
+#define SV_ZONETYPE					"ZONETYPE"
+
+/*
+*	Windows' processor count query, which the add-ons get through
+*	windows.h on the Tecplot side.
+*/
+struct SYSTEM_INFO{
+	unsigned int dwNumberOfProcessors;
+};
+void GetSystemInfo(SYSTEM_INFO * SysInfo);
+
+/*
+*	Argument lists
+*/
+ArgList_pa TecUtilArgListAlloc();
+void TecUtilArgListDealloc(ArgList_pa * ArgList);
+Boolean_t TecUtilArgListAppendArbParam(ArgList_pa ArgList, const char * Name, ArbParam_t Value);
+Boolean_t TecUtilArgListAppendArray(ArgList_pa ArgList, const char * Name, const void * Value);
+Boolean_t TecUtilArgListAppendInt(ArgList_pa ArgList, const char * Name, LgIndex_t Value);
+Boolean_t TecUtilArgListAppendSet(ArgList_pa ArgList, const char * Name, Set_pa Value);
+Boolean_t TecUtilArgListAppendString(ArgList_pa ArgList, const char * Name, const char * Value);
+
+/*
+*	Sets, strings and arrays
+*/
+Set_pa TecUtilSetAlloc(Boolean_t ShowErr);
+void TecUtilSetDealloc(Set_pa * Set);
+void TecUtilSetClear(Set_pa Set);
+Boolean_t TecUtilSetAddMember(Set_pa Set, SetIndex_t Member, Boolean_t ShowErr);
+void TecUtilStringDealloc(char ** String);
+void TecUtilArrayDealloc(void ** Array);
+
+/*
+*	Auxiliary data
+*/
+AuxData_pa TecUtilAuxDataDataSetGetRef();
+AuxData_pa TecUtilAuxDataVarGetRef(EntIndex_t Var);
+AuxData_pa TecUtilAuxDataZoneGetRef(EntIndex_t Zone);
+LgIndex_t TecUtilAuxDataGetNumItems(AuxData_pa AuxData);
+void TecUtilAuxDataGetItemByIndex(AuxData_pa AuxData, LgIndex_t Index, char ** Name, ArbParam_t * Value, AuxDataType_e * Type, Boolean_t * Retain);
+Boolean_t TecUtilAuxDataGetItemByName(AuxData_pa AuxData, const char * Name, ArbParam_t * Value, AuxDataType_e * Type, Boolean_t * Retain);
+Boolean_t TecUtilAuxDataSetItem(AuxData_pa AuxData, const char * Name, ArbParam_t Value, AuxDataType_e Type, Boolean_t Retain);
+Boolean_t TecUtilAuxDataSetStrItem(AuxData_pa AuxData, const char * Name, const char * Value, Boolean_t Retain);
+Boolean_t TecUtilAuxDataDeleteItemByName(AuxData_pa AuxData, const char * Name);
+
+/*
+*	Dataset, zones and variables
+*/
+Boolean_t TecUtilDataSetGetInfo(char ** DataSetTitle, EntIndex_t * NumZones, EntIndex_t * NumVars);
+EntIndex_t TecUtilDataSetGetNumVars();
+EntIndex_t TecUtilDataSetGetNumZones();
+Boolean_t TecUtilDataSetAddVar(const char * VarName, FieldDataType_e * VarDataType);
+Boolean_t TecUtilDataSetAddVarX(ArgList_pa ArgList);
+Boolean_t TecUtilDataSetAddZone(const char * Name, LgIndex_t IMax, LgIndex_t JMax, LgIndex_t KMax, ZoneType_e ZoneType, FieldDataType_e * VarDataType);
+Boolean_t TecUtilDataSetAddZoneX(ArgList_pa ArgList);
+Boolean_t TecUtilDataSetDeleteVar(Set_pa VarList);
+void TecUtilDataLoadBegin();
+void TecUtilDataLoadEnd();
+void TecUtilAxisGetVarAssignments(EntIndex_t * XVar, EntIndex_t * YVar, EntIndex_t * ZVar);
+
+Boolean_t TecUtilVarGetName(EntIndex_t VarNum, char ** VName);
+EntIndex_t TecUtilVarGetNumByName(const char * VarName);
+void TecUtilVarGetMinMax(EntIndex_t Var, double * VarMin, double * VarMax);
+
+Boolean_t TecUtilZoneGetName(EntIndex_t Zone, char ** ZName);
+void TecUtilZoneGetIJK(EntIndex_t Zone, LgIndex_t * IMax, LgIndex_t * JMax, LgIndex_t * KMax);
+ZoneType_e TecUtilZoneGetType(EntIndex_t Zone);
+Boolean_t TecUtilZoneIsActive(EntIndex_t Zone);
+Boolean_t TecUtilZoneIsFiniteElement(EntIndex_t Zone);
+Boolean_t TecUtilZoneIsOrdered(EntIndex_t Zone);
+
+/*
+*	Field data and connectivity
+*/
+FieldDataType_e TecUtilDataValueGetType(EntIndex_t Zone, EntIndex_t Var);
+ValueLocation_e TecUtilDataValueGetLocation(EntIndex_t Zone, EntIndex_t Var);
+double TecUtilDataValueGetByZoneVar(EntIndex_t Zone, EntIndex_t Var, LgIndex_t PointIndex);
+Boolean_t TecUtilDataValueSetByZoneVar(EntIndex_t Zone, EntIndex_t Var, LgIndex_t PointIndex, double Value);
+void TecUtilDataValueGetReadableRawPtr(EntIndex_t Zone, EntIndex_t Var, void ** DataPtr, FieldDataType_e * FieldDataType);
+void TecUtilDataValueGetWritableRawPtr(EntIndex_t Zone, EntIndex_t Var, void ** DataPtr, FieldDataType_e * FieldDataType);
+FieldData_pa TecUtilDataValueGetWritableNativeRef(EntIndex_t Zone, EntIndex_t Var);
+void TecUtilDataValueArraySetByRef(FieldData_pa DestFieldData, LgIndex_t DestOffset, LgIndex_t DestCount, const void * SourceValueArray);
+
+void TecUtilDataNodeGetReadableRawPtr(EntIndex_t Zone, NodeMap_t ** NodeMapPtr);
+NodeMap_pa TecUtilDataNodeGetWritableRef(EntIndex_t Zone);
+void TecUtilDataNodeSetByRef(NodeMap_pa NodeMap, LgIndex_t Element, LgIndex_t Corner, NodeMap_t Node);
+NodeToElemMap_pa TecUtilDataNodeToElemMapGetReadableRef(EntIndex_t Zone);
+LgIndex_t TecUtilDataNodeToElemMapGetNumElems(NodeToElemMap_pa NodeToElemMap, NodeMap_t Node);
+LgIndex_t TecUtilDataNodeToElemMapGetElem(NodeToElemMap_pa NodeToElemMap, NodeMap_t Node, LgIndex_t ElemIndex);
+void TecUtilDataFECellGetUniqueNodes(EntIndex_t Zone, LgIndex_t Face, LgIndex_t Element, LgIndex_t * NumUniqueNodes, LgIndex_t * UniqueNodesArraySize, LgIndex_t ** UniqueNodes);
+
+/*
+*	Style and state
+*/
+void TecUtilZoneSetActive(Set_pa ZoneSet, AssignOp_e AssignModifier);
+SetValueReturnCode_e TecUtilZoneSetContour(const char * Attribute, Set_pa ZoneSet, double DValue, ArbParam_t IValue);
+SetValueReturnCode_e TecUtilZoneSetEdgeLayer(const char * Attribute, Set_pa ZoneSet, ArbParam_t IValue, Boolean_t BValue);
+SetValueReturnCode_e TecUtilZoneSetMesh(const char * Attribute, Set_pa ZoneSet, double DValue, ArbParam_t IValue);
+SetValueReturnCode_e TecUtilZoneSetScatter(const char * Attribute, Set_pa ZoneSet, double DValue, ArbParam_t IValue);
+SetValueReturnCode_e TecUtilZoneSetScatterSymbolShape(const char * Attribute, Set_pa ZoneSet, ArbParam_t IValue);
+SetValueReturnCode_e TecUtilZoneSetShade(const char * Attribute, Set_pa ZoneSet, double DValue, ArbParam_t IValue);
+SetValueReturnCode_e TecUtilZoneSetVector(const char * Attribute, Set_pa ZoneSet, double DValue, ArbParam_t IValue);
+SetValueReturnCode_e TecUtilStyleSetLowLevelX(ArgList_pa ArgList);
+void TecUtilStateChanged(StateChange_e StateChange, ArbParam_t CallData);
+void TecUtilStateChangedX(ArgList_pa ArgList);
+void TecUtilDrawGraphics(Boolean_t DoDrawing);
+
+/*
+*	Locks, status bar and dialogs
+*/
+void TecUtilLockStart(AddOn_pa AddOn);
+void TecUtilLockFinish(AddOn_pa AddOn);
+void TecUtilStatusSuspend(Boolean_t DoSuspend);
+void TecUtilStatusStartPercentDone(const char * PercentDoneText, Boolean_t ShowStopButton, Boolean_t ShowProgressBar);
+void TecUtilStatusSetPercentDoneText(const char * PercentDoneText);
+Boolean_t TecUtilStatusCheckPercentDone(int PercentDone);
+void TecUtilStatusFinishPercentDone();
+void TecUtilDialogLaunchPercentDone(const char * Label, Boolean_t ShowTheScale);
+void TecUtilDialogSetPercentDoneText(const char * Text);
+Boolean_t TecUtilDialogCheckPercentDone(int PercentDone);
+void TecUtilDialogDropPercentDone();
+void TecUtilDialogErrMsg(const char * Message);
+Boolean_t TecUtilDialogMessageBox(const char * Message, MessageBoxType_e MessageBoxType);
+
+#endif
@@ -0,0 +1,167 @@
+/*
+*	TecUtil functions for headless builds (see headless/TECADDON.h).
+*	Behaves as a Tecplot session with no dataset loaded, so any code
+*	path that still goes through a Tecplot zone fails cleanly instead
+*	of crashing.
+*/
+
+#include "TECADDON.h"
+
+#include <iostream>
+#include <thread>
+
+using std::cerr;
+using std::endl;
+
+void GetSystemInfo(SYSTEM_INFO * SysInfo){
+	SysInfo->dwNumberOfProcessors = MAX(1u, std::thread::hardware_concurrency());
+}
+
+/*
+*	Argument lists
+*/
+ArgList_pa TecUtilArgListAlloc(){ return NULL; }
+void TecUtilArgListDealloc(ArgList_pa * ArgList){ if (ArgList != NULL) *ArgList = NULL; }
+Boolean_t TecUtilArgListAppendArbParam(ArgList_pa ArgList, const char * Name, ArbParam_t Value){ return FALSE; }
+Boolean_t TecUtilArgListAppendArray(ArgList_pa ArgList, const char * Name, const void * Value){ return FALSE; }
+Boolean_t TecUtilArgListAppendInt(ArgList_pa ArgList, const char * Name, LgIndex_t Value){ return FALSE; }
+Boolean_t TecUtilArgListAppendSet(ArgList_pa ArgList, const char * Name, Set_pa Value){ return FALSE; }
+Boolean_t TecUtilArgListAppendString(ArgList_pa ArgList, const char * Name, const char * Value){ return FALSE; }
+
+/*
+*	Sets, strings and arrays
+*/
+Set_pa TecUtilSetAlloc(Boolean_t ShowErr){ return NULL; }
+void TecUtilSetDealloc(Set_pa * Set){ if (Set != NULL) *Set = NULL; }
+void TecUtilSetClear(Set_pa Set){}
+Boolean_t TecUtilSetAddMember(Set_pa Set, SetIndex_t Member, Boolean_t ShowErr){ return FALSE; }
+void TecUtilStringDealloc(char ** String){
+	if (String != NULL){
+		delete[] * String;
+		*String = NULL;
+	}
+}
+void TecUtilArrayDealloc(void ** Array){ if (Array != NULL) *Array = NULL; }
+
+/*
+*	Auxiliary data
+*/
+AuxData_pa TecUtilAuxDataDataSetGetRef(){ return NULL; }
+AuxData_pa TecUtilAuxDataVarGetRef(EntIndex_t Var){ return NULL; }
+AuxData_pa TecUtilAuxDataZoneGetRef(EntIndex_t Zone){ return NULL; }
+LgIndex_t TecUtilAuxDataGetNumItems(AuxData_pa AuxData){ return 0; }
+void TecUtilAuxDataGetItemByIndex(AuxData_pa AuxData, LgIndex_t Index, char ** Name, ArbParam_t * Value, AuxDataType_e * Type, Boolean_t * Retain){
+	*Name = NULL;
+	*Value = 0;
+	*Type = AuxDataType_Invalid;
+	*Retain = FALSE;
+}
+Boolean_t TecUtilAuxDataGetItemByName(AuxData_pa AuxData, const char * Name, ArbParam_t * Value, AuxDataType_e * Type, Boolean_t * Retain){ return FALSE; }
+Boolean_t TecUtilAuxDataSetItem(AuxData_pa AuxData, const char * Name, ArbParam_t Value, AuxDataType_e Type, Boolean_t Retain){ return FALSE; }
+Boolean_t TecUtilAuxDataSetStrItem(AuxData_pa AuxData, const char * Name, const char * Value, Boolean_t Retain){ return FALSE; }
+Boolean_t TecUtilAuxDataDeleteItemByName(AuxData_pa AuxData, const char * Name){ return FALSE; }
+
+/*
+*	Dataset, zones and variables
+*/
+Boolean_t TecUtilDataSetGetInfo(char ** DataSetTitle, EntIndex_t * NumZones, EntIndex_t * NumVars){
+	if (DataSetTitle != NULL) *DataSetTitle = NULL;
+	if (NumZones != NULL) *NumZones = 0;
+	if (NumVars != NULL) *NumVars = 0;
+	return FALSE;
+}
+EntIndex_t TecUtilDataSetGetNumVars(){ return 0; }
+EntIndex_t TecUtilDataSetGetNumZones(){ return 0; }
+Boolean_t TecUtilDataSetAddVar(const char * VarName, FieldDataType_e * VarDataType){ return FALSE; }
+Boolean_t TecUtilDataSetAddVarX(ArgList_pa ArgList){ return FALSE; }
+Boolean_t TecUtilDataSetAddZone(const char * Name, LgIndex_t IMax, LgIndex_t JMax, LgIndex_t KMax, ZoneType_e ZoneType, FieldDataType_e * VarDataType){ return FALSE; }
+Boolean_t TecUtilDataSetAddZoneX(ArgList_pa ArgList){ return FALSE; }
+Boolean_t TecUtilDataSetDeleteVar(Set_pa VarList){ return FALSE; }
+void TecUtilDataLoadBegin(){}
+void TecUtilDataLoadEnd(){}
+void TecUtilAxisGetVarAssignments(EntIndex_t * XVar, EntIndex_t * YVar, EntIndex_t * ZVar){
+	*XVar = *YVar = *ZVar = 0;
+}
+
+Boolean_t TecUtilVarGetName(EntIndex_t VarNum, char ** VName){ *VName = NULL; return FALSE; }
+EntIndex_t TecUtilVarGetNumByName(const char * VarName){ return 0; }
+void TecUtilVarGetMinMax(EntIndex_t Var, double * VarMin, double * VarMax){ *VarMin = *VarMax = 0.0; }
+
+Boolean_t TecUtilZoneGetName(EntIndex_t Zone, char ** ZName){ *ZName = NULL; return FALSE; }
+void TecUtilZoneGetIJK(EntIndex_t Zone, LgIndex_t * IMax, LgIndex_t * JMax, LgIndex_t * KMax){
+	if (IMax != NULL) *IMax = 0;
+	if (JMax != NULL) *JMax = 0;
+	if (KMax != NULL) *KMax = 0;
+}
+ZoneType_e TecUtilZoneGetType(EntIndex_t Zone){ return ZoneType_Invalid; }
+Boolean_t TecUtilZoneIsActive(EntIndex_t Zone){ return FALSE; }
+Boolean_t TecUtilZoneIsFiniteElement(EntIndex_t Zone){ return FALSE; }
+Boolean_t TecUtilZoneIsOrdered(EntIndex_t Zone){ return FALSE; }
+
+/*
+*	Field data and connectivity
+*/
+FieldDataType_e TecUtilDataValueGetType(EntIndex_t Zone, EntIndex_t Var){ return FieldDataType_Invalid; }
+ValueLocation_e TecUtilDataValueGetLocation(EntIndex_t Zone, EntIndex_t Var){ return ValueLocation_Invalid; }
+double TecUtilDataValueGetByZoneVar(EntIndex_t Zone, EntIndex_t Var, LgIndex_t PointIndex){ return 0.0; }
+Boolean_t TecUtilDataValueSetByZoneVar(EntIndex_t Zone, EntIndex_t Var, LgIndex_t PointIndex, double Value){ return FALSE; }
+void TecUtilDataValueGetReadableRawPtr(EntIndex_t Zone, EntIndex_t Var, void ** DataPtr, FieldDataType_e * FieldDataType){
+	*DataPtr = NULL;
+	*FieldDataType = FieldDataType_Invalid;
+}
+void TecUtilDataValueGetWritableRawPtr(EntIndex_t Zone, EntIndex_t Var, void ** DataPtr, FieldDataType_e * FieldDataType){
+	*DataPtr = NULL;
+	*FieldDataType = FieldDataType_Invalid;
+}
+FieldData_pa TecUtilDataValueGetWritableNativeRef(EntIndex_t Zone, EntIndex_t Var){ return NULL; }
+void TecUtilDataValueArraySetByRef(FieldData_pa DestFieldData, LgIndex_t DestOffset, LgIndex_t DestCount, const void * SourceValueArray){}
+
+void TecUtilDataNodeGetReadableRawPtr(EntIndex_t Zone, NodeMap_t ** NodeMapPtr){ *NodeMapPtr = NULL; }
+NodeMap_pa TecUtilDataNodeGetWritableRef(EntIndex_t Zone){ return NULL; }
+void TecUtilDataNodeSetByRef(NodeMap_pa NodeMap, LgIndex_t Element, LgIndex_t Corner, NodeMap_t Node){}
+NodeToElemMap_pa TecUtilDataNodeToElemMapGetReadableRef(EntIndex_t Zone){ return NULL; }
+LgIndex_t TecUtilDataNodeToElemMapGetNumElems(NodeToElemMap_pa NodeToElemMap, NodeMap_t Node){ return 0; }
+LgIndex_t TecUtilDataNodeToElemMapGetElem(NodeToElemMap_pa NodeToElemMap, NodeMap_t Node, LgIndex_t ElemIndex){ return 0; }
+void TecUtilDataFECellGetUniqueNodes(EntIndex_t Zone, LgIndex_t Face, LgIndex_t Element, LgIndex_t * NumUniqueNodes, LgIndex_t * UniqueNodesArraySize, LgIndex_t ** UniqueNodes){
+	*NumUniqueNodes = 0;
+	*UniqueNodesArraySize = 0;
+	*UniqueNodes = NULL;
+}
+
+/*
+*	Style and state
+*/
+void TecUtilZoneSetActive(Set_pa ZoneSet, AssignOp_e AssignModifier){}
+SetValueReturnCode_e TecUtilZoneSetContour(const char * Attribute, Set_pa ZoneSet, double DValue, ArbParam_t IValue){ return SetValue_Invalid; }
+SetValueReturnCode_e TecUtilZoneSetEdgeLayer(const char * Attribute, Set_pa ZoneSet, ArbParam_t IValue, Boolean_t BValue){ return SetValue_Invalid; }
+SetValueReturnCode_e TecUtilZoneSetMesh(const char * Attribute, Set_pa ZoneSet, double DValue, ArbParam_t IValue){ return SetValue_Invalid; }
+SetValueReturnCode_e TecUtilZoneSetScatter(const char * Attribute, Set_pa ZoneSet, double DValue, ArbParam_t IValue){ return SetValue_Invalid; }
+SetValueReturnCode_e TecUtilZoneSetScatterSymbolShape(const char * Attribute, Set_pa ZoneSet, ArbParam_t IValue){ return SetValue_Invalid; }
+SetValueReturnCode_e TecUtilZoneSetShade(const char * Attribute, Set_pa ZoneSet, double DValue, ArbParam_t IValue){ return SetValue_Invalid; }
+SetValueReturnCode_e TecUtilZoneSetVector(const char * Attribute, Set_pa ZoneSet, double DValue, ArbParam_t IValue){ return SetValue_Invalid; }
+SetValueReturnCode_e TecUtilStyleSetLowLevelX(ArgList_pa ArgList){ return SetValue_Invalid; }
+void TecUtilStateChanged(StateChange_e StateChange, ArbParam_t CallData){}
+void TecUtilStateChangedX(ArgList_pa ArgList){}
+void TecUtilDrawGraphics(Boolean_t DoDrawing){}
+
+/*
+*	Locks, status bar and dialogs
+*/
+void TecUtilLockStart(AddOn_pa AddOn){}
+void TecUtilLockFinish(AddOn_pa AddOn){}
+void TecUtilStatusSuspend(Boolean_t DoSuspend){}
+void TecUtilStatusStartPercentDone(const char * PercentDoneText, Boolean_t ShowStopButton, Boolean_t ShowProgressBar){}
+void TecUtilStatusSetPercentDoneText(const char * PercentDoneText){}
+Boolean_t TecUtilStatusCheckPercentDone(int PercentDone){ return TRUE; }
+void TecUtilStatusFinishPercentDone(){}
+void TecUtilDialogLaunchPercentDone(const char * Label, Boolean_t ShowTheScale){}
+void TecUtilDialogSetPercentDoneText(const char * Text){}
+Boolean_t TecUtilDialogCheckPercentDone(int PercentDone){ return TRUE; }
+void TecUtilDialogDropPercentDone(){}
+void TecUtilDialogErrMsg(const char * Message){
+	cerr << "Error: " << Message << endl;
+}
+Boolean_t TecUtilDialogMessageBox(const char * Message, MessageBoxType_e MessageBoxType){
+	cerr << Message << endl;
+	return TRUE;
+}
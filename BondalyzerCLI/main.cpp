@@ -0,0 +1,221 @@
+/*
+*	Command-line driver for the BondalyzerLib numerics.
+*	Reads a Gaussian cube or VASP CHGCAR file into memory, finds the
+*	critical points of the electron density and writes them out,
+*	without a Tecplot session, so analyses can run on compute nodes.
+*
+*	Usage:
+*		BondalyzerCLI <file> [-chgcar] [-periodic] [-spacing <d>]
+*			[-levels <n>] [-topocheck] [-rhocutoff <rho>] [-nodecache] [-threads <n>] [-o <output.csv>]
+*
+*	-levels searches coarse to fine, starting from blocks 2^n cells across.
+*	-topocheck checks the CPs against the Poincare-Hopf rule and, if
+*	it's not met, searches again at a finer spacing where CPs are
+*	likely missing.
+*	-nodecache interleaves rho, gradient and Hessian per node for the
+*	cell searches, at the cost of a second copy of the data.
+*
+*	Files whose name contains CHGCAR, AECCAR or PARCHG are read as VASP
+*	files (always periodic); anything else as a formatted cube file.
+*
+*	CMakeLists.txt builds this with headless/TECADDON.h in place of the
+*	Tecplot SDK, so it runs on Linux as well as Windows.
+*/
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <cstdlib>
+
+#include <omp.h>
+
+#include "TECADDON.h"
+#include "CSM_DATA_SET_INFO.h"
+#include "CSM_DATA_TYPES.h"
+#include "CSM_FIELD_DATA_POINTER.h"
+#include "CSM_VOL_EXTENT_INDEX_WEIGHTS.h"
+#include "CSM_VOLUME_DATA.h"
+#include "CSM_NODE_RECORD_CACHE.h"
+#include "CSM_CRIT_POINTS.h"
+
+#include <armadillo>
+using namespace arma;
+
+using std::vector;
+using std::string;
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::ofstream;
+using std::setprecision;
+using std::chrono::high_resolution_clock;
+using std::chrono::duration;
+
+static void PrintUsage(const string & ProgName)
+{
+	cerr << "Usage: " << ProgName << " <file> [-chgcar] [-periodic] [-spacing <d>] [-levels <n>] [-topocheck] [-rhocutoff <rho>] [-nodecache] [-threads <n>] [-o <output.csv>]" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 2){
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	string FileName = argv[1], OutFileName;
+	Boolean_t IsCHGCAR = (FileName.find("CHGCAR") != string::npos
+		|| FileName.find("AECCAR") != string::npos
+		|| FileName.find("PARCHG") != string::npos);
+	Boolean_t IsPeriodic = FALSE, DoTopologyCheck = FALSE, UseNodeCache = FALSE;
+	double CellSpacing = DefaultCellSpacing,
+		RhoCutoff = DefaultRhoCutoff;
+	int NumCoarseLevels = 0;
+
+	for (int i = 2; i < argc; ++i){
+		string Arg = argv[i];
+		if (Arg == "-chgcar")
+			IsCHGCAR = TRUE;
+		else if (Arg == "-periodic")
+			IsPeriodic = TRUE;
+		else if (Arg == "-spacing" && i + 1 < argc)
+			CellSpacing = atof(argv[++i]);
+		else if (Arg == "-levels" && i + 1 < argc)
+			NumCoarseLevels = atoi(argv[++i]);
+		else if (Arg == "-topocheck")
+			DoTopologyCheck = TRUE;
+		else if (Arg == "-rhocutoff" && i + 1 < argc)
+			RhoCutoff = atof(argv[++i]);
+		else if (Arg == "-nodecache")
+			UseNodeCache = TRUE;
+		else if (Arg == "-threads" && i + 1 < argc)
+			omp_set_num_threads(atoi(argv[++i]));
+		else if (Arg == "-o" && i + 1 < argc)
+			OutFileName = argv[++i];
+		else{
+			PrintUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	/*
+	*	No Tecplot, so no progress dialogs.
+	*/
+	StatusSetHeadless(TRUE);
+
+	high_resolution_clock::time_point StartTime = high_resolution_clock::now();
+
+	VolumeData_c VolData;
+	Boolean_t IsOk = (IsCHGCAR ? VolData.ReadCHGCARFile(FileName) : VolData.ReadCubeFile(FileName));
+	if (!IsOk){
+		cerr << "Failed to read " << FileName << endl;
+		return 1;
+	}
+	IsPeriodic = (IsPeriodic || VolData.IsPeriodic());
+
+	int RhoIndex = VolData.VarIndex(CSMVarName.Dens);
+	if (RhoIndex < 0){
+		cerr << "Assuming the first variable (" << VolData.VarName(0) << ") is the electron density" << endl;
+		RhoIndex = 0;
+	}
+
+	VolExtentInfo_s VolInfo;
+	FieldDataPointer_c RhoPtr;
+	vector<FieldDataPointer_c> GradPtrs, HessPtrs;
+
+	IsOk = (VolData.GetVolInfo(VolInfo) && VolData.GetReadPtr(RhoIndex, RhoPtr));
+	VolInfo.IsPeriodic = IsPeriodic;
+
+	/*
+	*	Use analytical gradients if the file had them.
+	*/
+	vector<int> GradIndices(3);
+	for (int i = 0; i < 3 && IsOk; ++i)
+		GradIndices[i] = VolData.VarIndex(CSMVarName.DensGradVec[i]);
+	if (IsOk && GradIndices[0] >= 0 && GradIndices[1] >= 0 && GradIndices[2] >= 0){
+		GradPtrs.resize(3);
+		for (int i = 0; i < 3 && IsOk; ++i)
+			IsOk = VolData.GetReadPtr(GradIndices[i], GradPtrs[i]);
+	}
+
+	if (!IsOk){
+		cerr << "Failed to prepare volume data" << endl;
+		return 1;
+	}
+
+	double ReadTime = duration<double>(high_resolution_clock::now() - StartTime).count();
+
+	cout << FileName << ": " << VolData.MaxIJK()[0] << "x" << VolData.MaxIJK()[1] << "x" << VolData.MaxIJK()[2]
+		<< " grid, " << VolData.NumVars() << " variable(s), " << VolData.AtomPositions().size() << " atom(s)"
+		<< (IsPeriodic ? ", periodic" : "") << endl
+		<< "Read in " << setprecision(4) << ReadTime << " s" << endl;
+
+	StartTime = high_resolution_clock::now();
+
+	NodeRecordCache_c NodeCache;
+	if (UseNodeCache)
+		NodeCache.Build(RhoPtr, GradPtrs, HessPtrs);
+
+	CritPoints_c CPs;
+	double SkippedCellFraction = 0.0;
+	CPSearchCoverage_s Coverage;
+	if (NumCoarseLevels > 0)
+		IsOk = FindCPsCoarseToFine(CPs, VolInfo, CellSpacing, NumCoarseLevels, RhoCutoff, IsPeriodic, RhoPtr, GradPtrs, HessPtrs, NodeCache.IsReady() ? &NodeCache : NULL, &Coverage);
+	else
+		IsOk = FindCPs(CPs, VolInfo, CellSpacing, RhoCutoff, IsPeriodic, RhoPtr, GradPtrs, HessPtrs, NodeCache.IsReady() ? &NodeCache : NULL, &SkippedCellFraction);
+
+	double CPTime = duration<double>(high_resolution_clock::now() - StartTime).count();
+
+	if (!IsOk){
+		cerr << "Critical point search failed" << endl;
+		return 1;
+	}
+
+	cout << "Found " << CPs.NumCPs() << " critical points in " << setprecision(4) << CPTime << " s:";
+	for (int t = 0; t < CPNameList.size(); ++t)
+		cout << " " << CPs.NumCPs(t) << " " << CPNameList[t] << ";";
+	cout << endl;
+	if (NumCoarseLevels > 0){
+		cout << "Coarse-to-fine search over " << Coverage.NumLevels << " levels:" << endl;
+		for (int l = 0; l < Coverage.RuledOutFraction.size(); ++l)
+			cout << "  " << setprecision(4) << 100.0 * Coverage.RuledOutFraction[l] << "% of cells ruled out at spacing " << CellSpacing * static_cast<double>(1 << (Coverage.NumLevels - 1 - l)) << endl;
+		cout << "  " << setprecision(4) << 100.0 * Coverage.SearchedFraction << "% of cells searched at spacing " << CellSpacing
+			<< " (" << 100.0 * Coverage.NewtonFraction << "% with a Newton search)" << endl;
+	}
+	else
+		cout << "Newton search skipped in " << setprecision(4) << 100.0 * SkippedCellFraction << "% of cells" << endl;
+
+	if (DoTopologyCheck){
+		StartTime = high_resolution_clock::now();
+		CPTopologyCheck_s Check;
+		Boolean_t IsConsistent = CheckCPTopology(CPs, VolInfo, CellSpacing, RhoCutoff, IsPeriodic, RhoPtr, GradPtrs, HessPtrs, NodeCache.IsReady() ? &NodeCache : NULL, &Check);
+		double CheckTime = duration<double>(high_resolution_clock::now() - StartTime).count();
+
+		cout << "Poincare-Hopf sum " << Check.StartSum << " (should be " << Check.ExpectedSum << ")";
+		if (Check.NumRefinements > 0)
+			cout << ", " << Check.EndSum << " after " << Check.NumRefinements << " focused search(es) over "
+				<< Check.NumRegions << " region(s) added " << Check.NumCPsAdded << " CP(s)";
+		cout << (IsConsistent ? "; consistent" : "; still inconsistent") << " (" << setprecision(4) << CheckTime << " s)" << endl;
+	}
+
+	if (!OutFileName.empty()){
+		ofstream OutFile(OutFileName);
+		if (!OutFile.is_open()){
+			cerr << "Failed to open " << OutFileName << endl;
+			return 1;
+		}
+		OutFile << "Type,X,Y,Z," << CSMVarName.Dens << "\n" << setprecision(12);
+		for (int t = 0; t < CPNameList.size(); ++t){
+			for (int i = 0; i < CPs.NumCPs(t); ++i){
+				vec3 Pos = CPs.GetXYZ(t, i);
+				OutFile << CPNameList[t] << "," << Pos[0] << "," << Pos[1] << "," << Pos[2] << "," << CPs.GetRho(t, i) << "\n";
+			}
+		}
+		OutFile.close();
+	}
+
+	return 0;
+}
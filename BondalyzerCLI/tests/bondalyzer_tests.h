@@ -0,0 +1,81 @@
+#pragma once
+#ifndef BONDALYZERTESTS_H_
+#define BONDALYZERTESTS_H_
+
+/*
+*	Shared pieces of the BondalyzerLib checks run by ctest: the check
+*	macro, a synthetic volume to run them on, and the test groups
+*	test_main.cpp runs.
+*/
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <cmath>
+
+#include "TECADDON.h"
+#include "CSM_DATA_TYPES.h"
+#include "CSM_FIELD_DATA_POINTER.h"
+#include "CSM_VOL_EXTENT_INDEX_WEIGHTS.h"
+
+#include <armadillo>
+using namespace arma;
+
+using std::vector;
+using std::string;
+using std::cout;
+using std::endl;
+
+// Number of failed checks so far
+extern int NumFailed;
+
+#define EXPECT(Cond) \
+	do { \
+		if (!(Cond)){ \
+			cout << __FILE__ << ":" << __LINE__ << ": check failed: " << #Cond << endl; \
+			NumFailed++; \
+		} \
+	} while (0)
+
+/*
+*	A cubic grid of N^3 nodes spaced Spacing apart from Origin, with rho
+*	the sum of exp(-Alpha r^2) over the atoms (and, if periodic, their
+*	images in the neighboring cells). A periodic grid doesn't repeat
+*	its first plane of nodes, as in a CHGCAR file, so the cell is N
+*	spacings across while the grid (BasisVectors) spans N - 1.
+*
+*	GradPtrs is left empty, as when a density is loaded without its
+*	gradient, unless MakeGradient() is called.
+*/
+struct TestVolume_s{
+	vector<double> Rho;
+	vector<vector<double> > Grad;
+	VolExtentInfo_s VolInfo;
+	FieldDataPointer_c RhoPtr;
+	vector<FieldDataPointer_c> GradPtrs, HessPtrs;
+
+	TestVolume_s(const int & N, const double & Spacing, const vec3 & Origin, const vector<vec3> & Atoms, const double & Alpha, const Boolean_t & IsPeriodic);
+
+	// Fill Grad (and GradPtrs) with the analytic gradient of rho.
+	void MakeGradient();
+
+private:
+	template <typename NodeFunc> void ForEachNodeAtom(NodeFunc Func) const;
+
+	int m_N;
+	double m_Spacing, m_Alpha;
+	vec3 m_Origin;
+	vector<vec3> m_Atoms;
+};
+
+/*
+*	Test groups, each in its own file. Run them all, or only the one
+*	named on the command line.
+*/
+void RunCalcVarsTests();
+void RunCritPointTests();
+void RunGradPathTests();
+void RunGradPathCacheTests();
+void RunVolExtentTests();
+
+#endif
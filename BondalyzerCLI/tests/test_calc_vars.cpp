@@ -0,0 +1,259 @@
+/*
+*	Checks of the single sweep CalcVars() uses for volume zones
+*	against the per-variable passes it replaced.
+*/
+
+#include <algorithm>
+#include <set>
+
+#include "TECADDON.h"
+#include "CSM_DATA_TYPES.h"
+#include "CSM_DATA_SET_INFO.h"
+#include "CSM_CALC_VARS.h"
+
+#include "bondalyzer_tests.h"
+
+static const int CalcVarNumComponents[CalcEigenRank + 1] = { 3, 1, 6, 12, 1, 1, 3, 1, 1, 1 };
+
+static const int HessIndices[3][3] = {
+	{ 0, 1, 2 },
+	{ 1, 3, 4 },
+	{ 2, 4, 5 }
+};
+
+/*
+*	Output arrays for every CalcVar_e, and write pointers to them.
+*/
+struct CalcVarsOutput_s{
+	vector<vector<vector<double> > > Vals;
+	vector<vector<FieldDataPointer_c> > Ptrs;
+
+	CalcVarsOutput_s(const vector<int> & MaxIJK)
+		: Vals(CalcEigenRank + 1), Ptrs(CalcEigenRank + 1)
+	{
+		int NumNodes = MaxIJK[0] * MaxIJK[1] * MaxIJK[2];
+		for (int v = 0; v <= CalcEigenRank; ++v){
+			Vals[v].assign(CalcVarNumComponents[v], vector<double>(NumNodes, 0.0));
+			Ptrs[v].resize(CalcVarNumComponents[v]);
+			for (int i = 0; i < CalcVarNumComponents[v]; ++i)
+				Ptrs[v][i].GetWritePtr(Vals[v][i].data(), MaxIJK);
+		}
+	}
+
+	const vector<FieldDataPointer_c> ReadPtrs(const CalcVar_e & Var, const vector<int> & MaxIJK) const{
+		vector<FieldDataPointer_c> OutPtrs(Vals[Var].size());
+		for (int i = 0; i < OutPtrs.size(); ++i)
+			OutPtrs[i].GetReadPtr(Vals[Var][i].data(), MaxIJK);
+		return OutPtrs;
+	}
+};
+
+template <typename NodeFunc>
+static void ForEachNode(const vector<int> & MaxIJK, NodeFunc Func)
+{
+	for (int kk = 1; kk <= MaxIJK[2]; ++kk)
+		for (int jj = 1; jj <= MaxIJK[1]; ++jj)
+			for (int ii = 1; ii <= MaxIJK[0]; ++ii)
+				Func(ii, jj, kk, IndexFromIJK(ii, jj, kk, MaxIJK[0], MaxIJK[1]) - 1);
+}
+
+/*
+*	Every variable, a pass at a time as CalcVars() used to do them:
+*	gradient from rho, Hessian from the gradient variables, eigen
+*	system from the Hessian variables, and the rest from the eigen
+*	system and gradient variables. The eigenvalue rank uses the node's
+*	own eigenvalues, as the sweep does.
+*/
+static void CalcVarsOnePassEach(const TestVolume_s & Vol, const CalcVarsOptions_s & Opt, CalcVarsOutput_s & Out)
+{
+	const vector<int> & MaxIJK = Vol.VolInfo.MaxIJK;
+	const Boolean_t & IsPeriodic = Vol.VolInfo.IsPeriodic;
+	const vec3 DelXYZx2 = Vol.VolInfo.DelXYZ * 2,
+		DelXYZx12 = Vol.VolInfo.DelXYZ * 12;
+	vector<double> Vals(5);
+	vector<int> DirInd(5);
+
+	ForEachNode(MaxIJK, [&](const int & ii, const int & jj, const int & kk, const int & Index){
+		vec3 Grad;
+		CalcGradForNode(ii, jj, kk, DelXYZx2, DelXYZx12, Vals, DirInd, 0, MaxIJK, IsPeriodic, Vol.RhoPtr, Grad);
+		for (int i = 0; i < 3; ++i)
+			Out.Ptrs[CalcGradientVectors][i].Write(Index, Grad[i]);
+	});
+	vector<FieldDataPointer_c> GradPtrs = Out.ReadPtrs(CalcGradientVectors, MaxIJK);
+
+	ForEachNode(MaxIJK, [&](const int & ii, const int & jj, const int & kk, const int & Index){
+		vec3 Grad;
+		for (int i = 0; i < 3; ++i)
+			Grad[i] = GradPtrs[i][Index];
+		Out.Ptrs[CalcGradientMagnitude][0].Write(Index, norm(Grad));
+
+		mat33 Hess;
+		CalcHessForNode(ii, jj, kk, DelXYZx2, DelXYZx12, Vals, DirInd, MaxIJK, IsPeriodic, Vol.RhoPtr, GradPtrs, Hess);
+		for (int i = 0; i < 3; ++i)
+			for (int j = i; j < 3; ++j)
+				Out.Ptrs[CalcHessian][HessIndices[i][j]].Write(Index, Hess.at(i, j));
+	});
+	vector<FieldDataPointer_c> HessPtrs = Out.ReadPtrs(CalcHessian, MaxIJK);
+
+	VolExtentIndexWeights_s VolInfo(Vol.VolInfo);
+	MultiRootParams_s Params;
+	Params.VolInfo = &VolInfo;
+	Params.IsPeriodic = IsPeriodic;
+	Params.HasGrad = TRUE;
+	Params.HasHess = TRUE;
+	Params.RhoPtr = &Vol.RhoPtr;
+	Params.GradPtrs = &GradPtrs;
+	Params.HessPtrs = &HessPtrs;
+	ForEachNode(MaxIJK, [&](const int & ii, const int & jj, const int & kk, const int & Index){
+		vec3 EigVals;
+		mat33 EigVecs;
+		CalcEigenSystemForNode(ii, jj, kk, EigVals, EigVecs, Params);
+		for (int i = 0; i < 3; ++i){
+			for (int j = 0; j < 3; ++j)
+				Out.Ptrs[CalcEigenSystem][3 * j + i].Write(Index, EigVecs.at(i, j));
+			Out.Ptrs[CalcEigenSystem][9 + i].Write(Index, EigVals[i]);
+		}
+	});
+	vector<FieldDataPointer_c> EigSysPtrs = Out.ReadPtrs(CalcEigenSystem, MaxIJK);
+
+	ForEachNode(MaxIJK, [&](const int & ii, const int & jj, const int & kk, const int & Index){
+		vec3 Grad, EigVals;
+		mat33 EigVecs;
+		for (int i = 0; i < 3; ++i){
+			Grad[i] = GradPtrs[i][Index];
+			for (int j = 0; j < 3; ++j)
+				EigVecs.at(i, j) = EigSysPtrs[3 * i + j][Index];
+			EigVals[i] = EigSysPtrs[9 + i][Index];
+		}
+
+		Out.Ptrs[CalcLaplacian][0].Write(Index, EigVals[0] + EigVals[1] + EigVals[2]);
+		Out.Ptrs[CalcGaussianCurvature][0].Write(Index, EigVals[0] * EigVals[1] * EigVals[2]);
+		for (int i = 0; i < 3; ++i)
+			Out.Ptrs[CalcEigenVectorsDotGradient][i].Write(Index, dot(EigVecs.row(i), Grad));
+
+		double Dots[3];
+		for (int i = 0; i < 3; ++i)
+			Dots[i] = abs(dot(EigVecs.col(i), Grad));
+		std::sort(Dots, Dots + 3);
+		for (int r = 0; r < 2; ++r){
+			Boolean_t IsAboveCutoff = (!Opt.EberlyUseCutoff[r] || Vol.RhoPtr[Index] >= Opt.EberlyCutoff[r]);
+			Out.Ptrs[CalcEberly1Ridge + r][0].Write(Index, IsAboveCutoff ? (r == 0 ? Dots[0] + Dots[1] : Dots[0]) : 0.0);
+		}
+
+		double Rank = 0;
+		for (int i = 0; i < 3; ++i)
+			Rank += (EigVals[i] >= 0 ? 1 : -1);
+		Out.Ptrs[CalcEigenRank][0].Write(Index, Rank);
+	});
+}
+
+/*
+*	Number of values of Var that differ between A and B.
+*/
+static const int NumDifferent(const CalcVarsOutput_s & A, const CalcVarsOutput_s & B, const CalcVar_e & Var)
+{
+	int NumDiff = 0;
+	for (int i = 0; i < A.Vals[Var].size(); ++i)
+		for (int n = 0; n < A.Vals[Var][i].size(); ++n)
+			NumDiff += (A.Vals[Var][i][n] != B.Vals[Var][i][n] ? 1 : 0);
+	return NumDiff;
+}
+
+static void CheckSweepMatchesPasses(const TestVolume_s & Vol)
+{
+	const vector<int> & MaxIJK = Vol.VolInfo.MaxIJK;
+	const vec3 & DelXYZ = Vol.VolInfo.DelXYZ;
+	const Boolean_t & IsPeriodic = Vol.VolInfo.IsPeriodic;
+
+	CalcVarsOptions_s Opt;
+	Opt.AddOnID = NULL;
+	Opt.IsPeriodic = IsPeriodic;
+	Opt.EberlyUseCutoff[1] = TRUE;
+	Opt.EberlyCutoff[1] = 0.1;
+
+	CalcVarsOutput_s Passes(MaxIJK);
+	CalcVarsOnePassEach(Vol, Opt, Passes);
+
+	/*
+	*	Everything, with no variables already present.
+	*/
+	vector<Boolean_t> DoCalc(CalcEigenRank + 1, TRUE);
+	CalcVarsOutput_s Sweep(MaxIJK);
+	EXPECT(CalcVarsForVolumeNodes(DoCalc, Opt, MaxIJK, DelXYZ, IsPeriodic, Vol.RhoPtr,
+		vector<FieldDataPointer_c>(), vector<FieldDataPointer_c>(), vector<FieldDataPointer_c>(), Sweep.Ptrs, "Calculating variables"));
+	for (int v = 0; v <= CalcEigenRank; ++v){
+		int NumDiff = NumDifferent(Sweep, Passes, static_cast<CalcVar_e>(v));
+		if (NumDiff > 0)
+			cout << CalcVarTypeNames[v] << ": " << NumDiff << " values differ" << endl;
+		EXPECT(NumDiff == 0);
+	}
+
+	/*
+	*	The rank has to change over the volume for the check of it
+	*	against each node's own eigenvalues to mean anything.
+	*/
+	std::set<double> Ranks(Sweep.Vals[CalcEigenRank][0].begin(), Sweep.Vals[CalcEigenRank][0].end());
+	EXPECT(Ranks.size() > 1);
+
+	/*
+	*	With the eigen system variables already present, the rank and
+	*	Laplacian still come from each node's own eigenvalues.
+	*/
+	DoCalc.assign(CalcEigenRank + 1, FALSE);
+	DoCalc[CalcLaplacian] = DoCalc[CalcEigenRank] = TRUE;
+	CalcVarsOutput_s FromEigSys(MaxIJK);
+	EXPECT(CalcVarsForVolumeNodes(DoCalc, Opt, MaxIJK, DelXYZ, IsPeriodic, Vol.RhoPtr,
+		vector<FieldDataPointer_c>(), vector<FieldDataPointer_c>(), Passes.ReadPtrs(CalcEigenSystem, MaxIJK), FromEigSys.Ptrs, "Calculating variables"));
+	EXPECT(NumDifferent(FromEigSys, Passes, CalcLaplacian) == 0);
+	EXPECT(NumDifferent(FromEigSys, Passes, CalcEigenRank) == 0);
+
+	/*
+	*	The Hessian alone, with no gradient variables present or
+	*	requested, is the upper triangle of the finite differences of
+	*	the gradient, as when the gradient variables are present. The
+	*	per-variable pass took the lower triangle (derivatives of
+	*	gradient component j along i) here, which differs by rounding.
+	*/
+	DoCalc.assign(CalcEigenRank + 1, FALSE);
+	DoCalc[CalcHessian] = TRUE;
+	CalcVarsOutput_s HessOnly(MaxIJK);
+	EXPECT(CalcVarsForVolumeNodes(DoCalc, Opt, MaxIJK, DelXYZ, IsPeriodic, Vol.RhoPtr,
+		vector<FieldDataPointer_c>(), vector<FieldDataPointer_c>(), vector<FieldDataPointer_c>(), HessOnly.Ptrs, "Calculating variables"));
+	EXPECT(NumDifferent(HessOnly, Passes, CalcHessian) == 0);
+
+	const vec3 DelXYZx2 = DelXYZ * 2,
+		DelXYZx12 = DelXYZ * 12;
+	vector<double> Vals(5);
+	vector<int> DirInd(5);
+	double MaxHess = 0.0, MaxDiff = 0.0;
+	ForEachNode(MaxIJK, [&](const int & ii, const int & jj, const int & kk, const int & Index){
+		mat33 Hess;
+		CalcHessForNode(ii, jj, kk, DelXYZx2, DelXYZx12, Vals, DirInd, MaxIJK, IsPeriodic, Vol.RhoPtr, vector<FieldDataPointer_c>(3), Hess);
+		for (int i = 0; i < 3; ++i){
+			for (int j = i; j < 3; ++j){
+				double Val = HessOnly.Vals[CalcHessian][HessIndices[i][j]][Index];
+				MaxHess = MAX(MaxHess, std::abs(Val));
+				MaxDiff = MAX(MaxDiff, std::abs(Val - Hess.at(i, j)));
+			}
+		}
+	});
+	EXPECT(MaxHess > 0.0 && MaxDiff <= 1e-12 * MaxHess);
+}
+
+static void TestSweepMatchesPassesNonPeriodic()
+{
+	TestVolume_s Vol(13, 0.25, vec3({ -1.5, -1.5, -1.5 }), { vec3({ -0.52, 0.11, 0.07 }), vec3({ 0.61, -0.13, 0.22 }) }, 1.0, FALSE);
+	CheckSweepMatchesPasses(Vol);
+}
+
+static void TestSweepMatchesPassesPeriodic()
+{
+	TestVolume_s Vol(14, 0.25, vec3({ 0.0, 0.0, 0.0 }), { vec3({ 1.1, 1.7, 1.3 }), vec3({ 2.3, 1.4, 2.1 }) }, 1.5, TRUE);
+	CheckSweepMatchesPasses(Vol);
+}
+
+void RunCalcVarsTests()
+{
+	TestSweepMatchesPassesNonPeriodic();
+	TestSweepMatchesPassesPeriodic();
+}
@@ -0,0 +1,488 @@
+/*
+*	Checks of the BondalyzerLib critical point search.
+*/
+
+#include <algorithm>
+#include <random>
+
+#include "TECADDON.h"
+#include "CSM_DATA_SET_INFO.h"
+#include "CSM_CRIT_POINTS.h"
+
+#include "bondalyzer_tests.h"
+
+/*
+*	CP sets made by merging others keep their lattice, so a nucleus just
+*	inside one face of a periodic cell is found from just inside the
+*	opposite face, at its image outside that face.
+*/
+static void TestMergedCPsKeepLattice()
+{
+	const double CellLength = 4.0;
+	const vec3 NucleusPt({ 0.1, 2.0, 2.0 }), QueryPt({ CellLength - 0.1, 2.0, 2.0 });
+
+	CritPoints_c Found;
+	Found.SetSpatialIndexLattice(eye<mat>(3, 3) * CellLength);
+	Found.AddPoint(1.0, NucleusPt, vec3({ 1.0, 0.0, 0.0 }), CPType_Nuclear);
+	Found.AddPoint(0.5, vec3({ 2.0, 2.0, 2.0 }), vec3({ 1.0, 0.0, 0.0 }), CPType_Bond);
+
+	CritPoints_c Appended;
+	Appended.Append(Found);
+	CritPoints_c Listed(vector<CritPoints_c>(1, Found));
+
+	for (CritPoints_c * CPs : { &Appended, &Listed }){
+		vec3 CPPos;
+		EXPECT(CPs->GetFirstCPInRadius(QueryPt, 0.5, CPPos, vector<int>(1, 0)) == 0);
+		EXPECT(norm(CPPos - vec3({ CellLength + 0.1, 2.0, 2.0 })) < 1e-12);
+
+		double Dist;
+		EXPECT(CPs->GetClosestCP(QueryPt, Dist, CPPos, vector<int>(1, 0)) == 0);
+		EXPECT(std::abs(Dist - 0.2) < 1e-12);
+	}
+
+	// Without a lattice the nucleus is across the cell
+	CritPoints_c NotPeriodic;
+	NotPeriodic.AddPoint(1.0, NucleusPt, vec3({ 1.0, 0.0, 0.0 }), CPType_Nuclear);
+	vec3 CPPos;
+	EXPECT(NotPeriodic.GetFirstCPInRadius(QueryPt, 0.5, CPPos) == -1);
+}
+
+/*
+*	A periodic search, where the density minima are below the rho
+*	cutoff, finds the nucleus and keeps only CPs at finite positions.
+*/
+static void TestPeriodicSearchIsFinite()
+{
+	TestVolume_s Vol(21, 0.2, zeros<vec>(3), { vec3({ 0.1, 2.0, 2.0 }) }, 2.0, TRUE);
+
+	CritPoints_c CPs;
+	double RhoCutoff = DefaultRhoCutoff;
+	EXPECT(FindCPs(CPs, Vol.VolInfo, DefaultCellSpacing, RhoCutoff, TRUE, Vol.RhoPtr, Vol.GradPtrs, Vol.HessPtrs));
+	EXPECT(CPs.NumAtoms() >= 1);
+	for (int t = 0; t < 6; ++t){
+		for (int i = 0; i < CPs.NumCPs(t); ++i)
+			EXPECT(CPs.GetXYZ(t, i).is_finite());
+	}
+}
+
+/*
+*	A nucleus just inside one face of a periodic cell is one CP, found
+*	by the spatial queries from just inside the opposite face, at its
+*	image outside that face.
+*/
+static void TestPeriodicCPQueries()
+{
+	const int N = 21;
+	const double Spacing = 0.2, CellLength = Spacing * N;
+	TestVolume_s Vol(N, Spacing, zeros<vec>(3), { vec3({ 0.1, 2.0, 2.0 }) }, 2.0, TRUE);
+
+	CritPoints_c CPs;
+	double RhoCutoff = DefaultRhoCutoff;
+	EXPECT(FindCPs(CPs, Vol.VolInfo, DefaultCellSpacing, RhoCutoff, TRUE, Vol.RhoPtr, Vol.GradPtrs, Vol.HessPtrs));
+	EXPECT(CPs.NumAtoms() == 1);
+	if (CPs.NumAtoms() != 1)
+		return;
+
+	vec3 QueryPt({ CellLength - 0.1, 2.0, 2.0 }), CPPos;
+	EXPECT(CPs.GetFirstCPInRadius(QueryPt, 0.5, CPPos, vector<int>(1, 0)) == 0);
+	EXPECT(norm(CPPos - vec3({ CellLength + 0.1, 2.0, 2.0 })) < 0.05);
+
+	double Dist;
+	EXPECT(CPs.GetClosestCP(QueryPt, Dist, CPPos, vector<int>(1, 0)) == 0);
+	EXPECT(std::abs(Dist - 0.2) < 0.05);
+}
+
+/*
+*	Two nuclei and none of the bond CP between them (as when the lattice
+*	search misses every bond CP) break the Poincare-Hopf rule, and the
+*	focused search halfway between the nuclei finds the bond CP.
+*/
+static void TestTopologyCheckWithNoBonds()
+{
+	const int N = 61;
+	const double Spacing = 0.1;
+	// Off the grid nodes, which the lattice search can miss CPs on
+	const vec3 Center({ 0.03, 0.04, 0.05 }), HalfBond({ 1.0, 0.0, 0.0 });
+	TestVolume_s Vol(N, Spacing, vec3({ -3.0, -3.0, -3.0 }), { Center - HalfBond, Center + HalfBond }, 2.0, FALSE);
+
+	CritPoints_c FoundCPs;
+	double RhoCutoff = DefaultRhoCutoff;
+	EXPECT(FindCPs(FoundCPs, Vol.VolInfo, DefaultCellSpacing, RhoCutoff, FALSE, Vol.RhoPtr, Vol.GradPtrs, Vol.HessPtrs));
+	EXPECT(FoundCPs.NumAtoms() == 2);
+	if (FoundCPs.NumAtoms() != 2)
+		return;
+
+	CritPoints_c CPs;
+	for (int i = 0; i < FoundCPs.NumAtoms(); ++i)
+		CPs.AddPoint(FoundCPs.GetRho(0, i), FoundCPs.GetXYZ(0, i), FoundCPs.GetPrincDir(0, i), CPType_Nuclear);
+	EXPECT(CPs.PoincareHopfSum() == 2);
+
+	CPTopologyCheck_s Check;
+	EXPECT(CheckCPTopology(CPs, Vol.VolInfo, DefaultCellSpacing, RhoCutoff, FALSE, Vol.RhoPtr, Vol.GradPtrs, Vol.HessPtrs, NULL, &Check));
+	EXPECT(Check.StartSum == 2 && Check.EndSum == 1);
+	EXPECT(Check.NumRegions > 0);
+	EXPECT(CPs.NumAtoms() == 2 && CPs.NumBonds() == 1);
+	if (CPs.NumBonds() == 1)
+		EXPECT(norm(CPs.GetXYZ(1, 0) - Center) < 0.05);
+}
+
+/*
+*	The search cache reuses every block when only the rho cutoff goes
+*	up, and gives the CPs FindCPs() gives at that cutoff; a search
+*	region only gets the CPs in it.
+*/
+static void TestSearchCacheCutoffReuse()
+{
+	const int N = 61;
+	const double Spacing = 0.1;
+	const vec3 Center({ 0.03, 0.04, 0.05 }), HalfBond({ 1.0, 0.0, 0.0 });
+	TestVolume_s Vol(N, Spacing, vec3({ -3.0, -3.0, -3.0 }), { Center - HalfBond, Center + HalfBond }, 2.0, FALSE);
+
+	CPSearchCache_c Cache;
+	CritPoints_c CachedCPs;
+	double RhoCutoff = DefaultRhoCutoff;
+	EXPECT(Cache.FindCPs(CachedCPs, Vol.VolInfo, DefaultCellSpacing, RhoCutoff, FALSE, Vol.RhoPtr, Vol.GradPtrs, Vol.HessPtrs));
+	EXPECT(Cache.NumBlocksSearched() > 0 && Cache.NumBlocksReused() == 0);
+
+	// Over the bond CP's rho, but under the nuclei's
+	double HighCutoff = 0.5 * (exp(-2.0) + 1.0);
+	CritPoints_c CPs;
+	EXPECT(FindCPs(CPs, Vol.VolInfo, DefaultCellSpacing, HighCutoff, FALSE, Vol.RhoPtr, Vol.GradPtrs, Vol.HessPtrs));
+	EXPECT(Cache.FindCPs(CachedCPs, Vol.VolInfo, DefaultCellSpacing, HighCutoff, FALSE, Vol.RhoPtr, Vol.GradPtrs, Vol.HessPtrs));
+	EXPECT(Cache.NumBlocksSearched() == 0);
+	for (int t = 0; t < 4; ++t)
+		EXPECT(CachedCPs.NumCPs(t) == CPs.NumCPs(t));
+	EXPECT(CachedCPs.NumAtoms() == 2 && CachedCPs.NumBonds() == 0);
+
+	// Lattice cells on the -x side of the bond midpoint
+	int MidCell = static_cast<int>((Center[0] + 3.0) / DefaultCellSpacing);
+	EXPECT(Cache.FindCPs(CachedCPs, Vol.VolInfo, DefaultCellSpacing, RhoCutoff, FALSE, Vol.RhoPtr, Vol.GradPtrs, Vol.HessPtrs, NULL, vector<int>(3, 0), { MidCell, N, N }));
+	EXPECT(Cache.NumBlocksSearched() == 0);
+	EXPECT(CachedCPs.NumAtoms() == 1);
+	if (CachedCPs.NumAtoms() == 1)
+		EXPECT(norm(CachedCPs.GetXYZ(0, 0) - (Center - HalfBond)) < 0.05);
+}
+
+/*
+*	The coarse-to-fine search finds the same CPs as FindCPs(), while
+*	ruling out most of the volume before the finest level.
+*/
+static void TestCoarseToFineRulesOutBlocks()
+{
+	const int N = 81;
+	const double Spacing = 0.1;
+	const vec3 Center({ 0.03, 0.04, 0.05 }), HalfBond({ 1.5, 0.0, 0.0 });
+	TestVolume_s Vol(N, Spacing, vec3({ -4.0, -4.0, -4.0 }), { Center - HalfBond, Center + HalfBond, Center + vec3({ 0.3, 2.6, 0.0 }) }, 0.5, FALSE);
+
+	CritPoints_c CPs, CoarseCPs;
+	double RhoCutoff = DefaultRhoCutoff;
+	EXPECT(FindCPs(CPs, Vol.VolInfo, DefaultCellSpacing, RhoCutoff, FALSE, Vol.RhoPtr, Vol.GradPtrs, Vol.HessPtrs));
+	CPSearchCoverage_s Coverage;
+	EXPECT(FindCPsCoarseToFine(CoarseCPs, Vol.VolInfo, DefaultCellSpacing, 3, RhoCutoff, FALSE, Vol.RhoPtr, Vol.GradPtrs, Vol.HessPtrs, NULL, &Coverage));
+
+	EXPECT(CPs.NumAtoms() == 3 && CPs.NumBonds() >= 2);
+	for (int t = 0; t < 4; ++t){
+		EXPECT(CoarseCPs.NumCPs(t) == CPs.NumCPs(t));
+		if (CoarseCPs.NumCPs(t) != CPs.NumCPs(t))
+			continue;
+		for (int i = 0; i < CPs.NumCPs(t); ++i){
+			double MinDist = DBL_MAX;
+			for (int j = 0; j < CoarseCPs.NumCPs(t); ++j)
+				MinDist = MIN(MinDist, norm(CPs.GetXYZ(t, i) - CoarseCPs.GetXYZ(t, j)));
+			EXPECT(MinDist < 1e-8);
+		}
+	}
+
+	double RuledOut = 0.0;
+	for (const double & f : Coverage.RuledOutFraction)
+		RuledOut += f;
+	cout << "Coarse-to-fine: " << 100.0 * RuledOut << "% of cells ruled out, " << 100.0 * Coverage.SearchedFraction << "% searched" << endl;
+	EXPECT(std::abs(RuledOut + Coverage.SearchedFraction - 1.0) < 1e-8);
+	EXPECT(Coverage.SearchedFraction < 0.45);
+}
+
+/*
+*	CPs kept in plain lists for the brute force versions of the
+*	CritPoints_c spatial queries, which check every CP, using the
+*	nearest image over the neighboring cells if there's a lattice.
+*/
+struct BruteForceCPs_s{
+	vector<vec3> XYZ[6];
+	vector<double> Rho[6];
+	Boolean_t HasLattice = FALSE;
+	mat33 Lattice;
+
+	// Same shifts, and tie breaking, as CritPoints_c::NearestImage()
+	vec3 Image(const vec3 & Pt, const vec3 & RefPt) const{
+		vec3 BestPt = Pt;
+		if (HasLattice){
+			double BestDistSqr = DistSqr(Pt, RefPt);
+			for (int s = 0; s < 27; ++s){
+				vec3 Shift = zeros<vec>(3);
+				for (int d = 0, Div = 1; d < 3; ++d, Div *= 3)
+					Shift += Lattice.col(d) * static_cast<double>((s / Div) % 3 - 1);
+				if (DistSqr(Pt + Shift, RefPt) < BestDistSqr){
+					BestDistSqr = DistSqr(Pt + Shift, RefPt);
+					BestPt = Pt + Shift;
+				}
+			}
+		}
+		return BestPt;
+	}
+	double Dist(const vec3 & Pt, const vec3 & RefPt) const{
+		return norm(Image(Pt, RefPt) - RefPt);
+	}
+
+	int TotOffset(const int & t, const int & i) const{
+		int Offset = i;
+		for (int tt = 0; tt < t; ++tt)
+			Offset += XYZ[tt].size();
+		return Offset;
+	}
+
+	// All CPs of TypeNums (all types if empty) within Radius of Point, in order of total offset
+	vector<int> InRadius(const vec3 & Point, const double & Radius, const vector<int> & TypeNums, const int & ExcludeTotOffset) const{
+		vector<int> TotOffsets;
+		for (int t = 0; t < 6; ++t){
+			if (!TypeNums.empty() && std::find(TypeNums.begin(), TypeNums.end(), t) == TypeNums.end())
+				continue;
+			for (int i = 0; i < XYZ[t].size(); ++i){
+				if (TotOffset(t, i) != ExcludeTotOffset && Dist(XYZ[t][i], Point) <= Radius)
+					TotOffsets.push_back(TotOffset(t, i));
+			}
+		}
+		return TotOffsets;
+	}
+
+	int Closest(const vec3 & Point, const vector<int> & TypeNums, const int & ExcludeTotOffset, double & BestDist, vec3 & BestPos) const{
+		int Best = -1;
+		BestDist = DBL_MAX;
+		for (int t = 0; t < 6; ++t){
+			if (!TypeNums.empty() && std::find(TypeNums.begin(), TypeNums.end(), t) == TypeNums.end())
+				continue;
+			for (int i = 0; i < XYZ[t].size(); ++i){
+				double TmpDist = Dist(XYZ[t][i], Point);
+				if (TotOffset(t, i) != ExcludeTotOffset && TmpDist < BestDist){
+					BestDist = TmpDist;
+					BestPos = Image(XYZ[t][i], Point);
+					Best = TotOffset(t, i);
+				}
+			}
+		}
+		return Best;
+	}
+
+	// Every pair, for the same pairs of types as CritPoints_c::FindMinCPDist()
+	double MinCPDist(const vector<int> & TypeNums) const{
+		double MinDist = DBL_MAX;
+		for (int a = 0; a < static_cast<int>(TypeNums.size()) - 1; ++a){
+			for (int b = a; b < TypeNums.size(); ++b){
+				int ta = TypeNums[a], tb = TypeNums[b];
+				for (int i = 0; i < XYZ[ta].size(); ++i){
+					for (int j = (ta == tb ? i + 1 : 0); j < XYZ[tb].size(); ++j)
+						MinDist = MIN(MinDist, Dist(XYZ[tb][j], XYZ[ta][i]));
+				}
+			}
+		}
+		return MinDist;
+	}
+
+	/*
+	*	RemoveSpuriousCPs() as it was before the spatial index: each CP
+	*	checked against every later CP of its type, then against every
+	*	CP of each lower priority type.
+	*/
+	void RemoveSpurious(const double & CheckDist){
+		for (int t = 0; t < 6; ++t){
+			vector<vector<int> > DuplicateNeighbors(XYZ[t].size());
+			vector<bool> IsSpurious(XYZ[t].size(), false);
+			for (int i = 0; i < XYZ[t].size(); ++i){
+				if (!IsSpurious[i]) DuplicateNeighbors[i].push_back(i);
+				for (int j = i + 1; j < XYZ[t].size(); ++j){
+					if (Dist(XYZ[t][j], XYZ[t][i]) <= CheckDist){
+						IsSpurious[j] = true;
+						DuplicateNeighbors[DuplicateNeighbors[i][0]].push_back(j);
+						DuplicateNeighbors[j].push_back(DuplicateNeighbors[i][0]);
+					}
+				}
+			}
+
+			vector<vec3> NewXYZ;
+			vector<double> NewRho;
+			for (int i = 0; i < XYZ[t].size(); ++i){
+				if (!IsSpurious[i]){
+					NewXYZ.push_back(zeros<vec>(3));
+					NewRho.push_back(0.0);
+					for (const int & j : DuplicateNeighbors[i]){
+						NewXYZ.back() += Image(XYZ[t][j], XYZ[t][i]);
+						NewRho.back() += Rho[t][j];
+					}
+					NewXYZ.back() /= static_cast<double>(DuplicateNeighbors[i].size());
+					NewRho.back() /= static_cast<double>(DuplicateNeighbors[i].size());
+				}
+			}
+			XYZ[t] = NewXYZ;
+			Rho[t] = NewRho;
+		}
+
+		vector<vector<bool> > IsSpurious(6);
+		for (int t = 0; t < 6; ++t) IsSpurious[t].resize(XYZ[t].size(), false);
+		for (int ti = 0; ti < 6; ++ti){
+			for (int tj = ti + 1; tj < 6; ++tj){
+				for (int i = 0; i < XYZ[ti].size(); ++i){
+					if (IsSpurious[ti][i])
+						continue;
+					for (int j = 0; j < XYZ[tj].size(); ++j){
+						if (Dist(XYZ[tj][j], XYZ[ti][i]) <= CheckDist)
+							IsSpurious[tj][j] = true;
+					}
+				}
+			}
+		}
+		for (int t = 0; t < 6; ++t){
+			vector<vec3> NewXYZ;
+			vector<double> NewRho;
+			for (int i = 0; i < XYZ[t].size(); ++i){
+				if (!IsSpurious[t][i]){
+					NewXYZ.push_back(XYZ[t][i]);
+					NewRho.push_back(Rho[t][i]);
+				}
+			}
+			XYZ[t] = NewXYZ;
+			Rho[t] = NewRho;
+		}
+	}
+};
+
+/*
+*	Random CPs of the first four types in a cube CellLength across,
+*	some in tight clusters (of one type or mixed) so that
+*	RemoveSpuriousCPs() has groups to merge, in both a CritPoints_c
+*	and a BruteForceCPs_s.
+*/
+static void MakeRandomCPs(const double & CellLength, const Boolean_t & IsPeriodic, std::mt19937 & Gen, CritPoints_c & CPs, BruteForceCPs_s & BruteCPs)
+{
+	std::uniform_real_distribution<double> Unit(0.0, 1.0);
+	std::uniform_int_distribution<int> RandomType(0, 3);
+
+	auto AddCP = [&](const vec3 & Pos, const int & t){
+		double Rho = Unit(Gen);
+		CPs.AddPoint(Rho, Pos, zeros<vec>(3), CPTypeList[t]);
+		BruteCPs.XYZ[t].push_back(Pos);
+		BruteCPs.Rho[t].push_back(Rho);
+	};
+
+	for (int i = 0; i < 250; ++i)
+		AddCP(vec3({ Unit(Gen), Unit(Gen), Unit(Gen) }) * CellLength, RandomType(Gen));
+
+	for (int c = 0; c < 20; ++c){
+		// Half the clusters straddle a face of the cell
+		vec3 Center({ Unit(Gen), Unit(Gen), Unit(Gen) });
+		if (c % 2 == 0) Center[c % 3] = 0.0;
+		Center *= CellLength;
+		int t = RandomType(Gen);
+		for (int i = 0; i < 3; ++i){
+			vec3 Pos = Center + 0.2 * (vec3({ Unit(Gen), Unit(Gen), Unit(Gen) }) - 0.5);
+			if (IsPeriodic){
+				for (int d = 0; d < 3; ++d)
+					Pos[d] -= CellLength * floor(Pos[d] / CellLength);
+			}
+			AddCP(Pos, (c % 4 == 1 ? RandomType(Gen) : t));
+		}
+	}
+
+	if (IsPeriodic){
+		mat33 Lattice = eye<mat>(3, 3) * CellLength;
+		CPs.SetSpatialIndexLattice(Lattice);
+		BruteCPs.HasLattice = TRUE;
+		BruteCPs.Lattice = Lattice;
+	}
+}
+
+/*
+*	The spatial queries, FindMinCPDist() and RemoveSpuriousCPs() give
+*	what checking every CP gives, for random CPs with and without a
+*	lattice.
+*/
+static void CheckCPQueriesMatchBruteForce(const Boolean_t & IsPeriodic)
+{
+	const double CellLength = 6.0, Radius = 0.8, CheckDist = 0.35;
+	std::mt19937 Gen(IsPeriodic ? 21 : 12);
+	std::uniform_real_distribution<double> Unit(0.0, 1.0);
+
+	CritPoints_c CPs;
+	BruteForceCPs_s BruteCPs;
+	MakeRandomCPs(CellLength, IsPeriodic, Gen, CPs, BruteCPs);
+
+	const vector<vector<int> > TypeNumLists = { vector<int>(), { 1 }, { 0, 2 } };
+	std::uniform_int_distribution<int> RandomCP(-1, CPs.NumCPs() - 1);
+
+	int NumClosestWrong = 0, NumInRadiusWrong = 0, NumFirstWrong = 0;
+	for (int q = 0; q < 600; ++q){
+		vec3 Point = (vec3({ Unit(Gen), Unit(Gen), Unit(Gen) }) * 1.2 - 0.1) * CellLength;
+		const vector<int> & TypeNums = TypeNumLists[q % TypeNumLists.size()];
+		// Sometimes start at, and exclude, a CP as a gradient path would
+		int Exclude = RandomCP(Gen);
+		if (Exclude >= 0 && q % 2 == 0)
+			Point = CPs.GetXYZ(Exclude);
+
+		double Dist, BruteDist;
+		vec3 CPPos, BrutePos;
+		int Closest = CPs.GetClosestCP(Point, Dist, CPPos, TypeNums, Exclude);
+		int BruteClosest = BruteCPs.Closest(Point, TypeNums, Exclude, BruteDist, BrutePos);
+		if (Closest != BruteClosest || (Closest >= 0 && (std::abs(Dist - BruteDist) > 1e-12 || norm(CPPos - BrutePos) > 1e-12)))
+			NumClosestWrong++;
+
+		vector<int> InRadius;
+		CPs.GetCPsInRadius(Point, Radius, InRadius, TypeNums, Exclude);
+		vector<int> BruteInRadius = BruteCPs.InRadius(Point, Radius, TypeNums, Exclude);
+		if (InRadius != BruteInRadius)
+			NumInRadiusWrong++;
+
+		int First = CPs.GetFirstCPInRadius(Point, Radius, CPPos, TypeNums, Exclude);
+		if (First != (BruteInRadius.empty() ? -1 : BruteInRadius.front()))
+			NumFirstWrong++;
+	}
+	EXPECT(NumClosestWrong == 0);
+	EXPECT(NumInRadiusWrong == 0);
+	EXPECT(NumFirstWrong == 0);
+
+	EXPECT(CPs.FindMinCPDist(CPTypeList));
+	EXPECT(std::abs(CPs.GetMinCPDist() - BruteCPs.MinCPDist({ 0, 1, 2, 3, 4, 5 })) <= 1e-12);
+	EXPECT(CPs.FindMinCPDist({ CPType_Bond, CPType_Cage }));
+	EXPECT(std::abs(CPs.GetMinCPDist({ CPType_Bond, CPType_Cage }) - BruteCPs.MinCPDist({ 1, 3 })) <= 1e-12);
+
+	int NumBefore = CPs.NumCPs();
+	CPs.RemoveSpuriousCPs(CheckDist);
+	BruteCPs.RemoveSpurious(CheckDist);
+	EXPECT(CPs.NumCPs() < NumBefore);
+
+	int NumWrong = 0;
+	for (int t = 0; t < 6; ++t){
+		EXPECT(CPs.NumCPs(t) == BruteCPs.XYZ[t].size());
+		if (CPs.NumCPs(t) != BruteCPs.XYZ[t].size())
+			continue;
+		for (int i = 0; i < CPs.NumCPs(t); ++i){
+			if (norm(CPs.GetXYZ(t, i) - BruteCPs.XYZ[t][i]) > 1e-12 || std::abs(CPs.GetRho(t, i) - BruteCPs.Rho[t][i]) > 1e-12)
+				NumWrong++;
+		}
+	}
+	EXPECT(NumWrong == 0);
+}
+
+static void TestCPQueriesMatchBruteForce()
+{
+	CheckCPQueriesMatchBruteForce(FALSE);
+	CheckCPQueriesMatchBruteForce(TRUE);
+}
+
+void RunCritPointTests()
+{
+	TestMergedCPsKeepLattice();
+	TestPeriodicSearchIsFinite();
+	TestPeriodicCPQueries();
+	TestTopologyCheckWithNoBonds();
+	TestSearchCacheCutoffReuse();
+	TestCoarseToFineRulesOutBlocks();
+	TestCPQueriesMatchBruteForce();
+}
@@ -0,0 +1,294 @@
+/*
+*	Checks of the on-disk gradient path cache, and of GBA using it.
+*/
+
+#include <cstdio>
+#include <memory>
+
+#include "TECADDON.h"
+#include "CSM_GRAD_PATH.h"
+#include "CSM_GRAD_PATH_CACHE.h"
+#include "CSM_FE_VOLUME.h"
+
+#include "bondalyzer_tests.h"
+
+/*
+*	Paths down from a nucleus to a rho cutoff, seeded on a small sphere
+*	around it like the GBA sphere paths.
+*/
+struct TestSpherePaths_s{
+	TestVolume_s Vol;
+	std::shared_ptr<const VolExtentInfo_s> VolInfo;
+	vec3 Nucleus;
+	vector<vec3> SeedPts;
+	double Cutoff = 1e-3;
+	int NumPoints = 50;
+
+	TestSpherePaths_s()
+		: Vol(41, 0.1, vec3({ -2.0, -2.0, -2.0 }), { vec3({ 0.03, 0.04, 0.05 }) }, 2.0, FALSE),
+		Nucleus({ 0.03, 0.04, 0.05 })
+	{
+		Vol.MakeGradient();
+		VolInfo = std::make_shared<const VolExtentInfo_s>(Vol.VolInfo);
+
+		// A pole and a ring of points around it
+		const double Radius = 0.3, Polar = 0.5;
+		SeedPts.push_back(Nucleus + vec3({ 0.0, 0.0, Radius }));
+		for (int i = 0; i < 6; ++i){
+			double Az = static_cast<double>(i) * PI / 3.0;
+			SeedPts.push_back(Nucleus + Radius * vec3({ sin(Polar) * cos(Az), sin(Polar) * sin(Az), cos(Polar) }));
+		}
+	}
+
+	const Boolean_t Setup(GradPath_c & GP, const vec3 & SeedPt){
+		return GP.SetupGradPath(SeedPt, StreamDir_Reverse, NumPoints, GPType_Classic, GPTerminate_AtRhoValue,
+			NULL, NULL, NULL, &Cutoff, VolInfo, vector<FieldDataPointer_c>(), Vol.GradPtrs, Vol.RhoPtr);
+	}
+};
+
+/*
+*	Make the pole-and-ring bundles of the sphere paths from their
+*	compact forms, as GBA does.
+*/
+static const vector<FESurface_c> MakeTestBundles(const vector<CompactGradPath_c> & CompactGPs, const int & NumPoints)
+{
+	vector<FESurface_c> Bundles(CompactGPs.size() - 1);
+	for (int i = 1; i < CompactGPs.size(); ++i){
+		int Next = (i % (static_cast<int>(CompactGPs.size()) - 1)) + 1;
+		vector<const CompactGradPath_c*> GPPtrs = { &CompactGPs[0], &CompactGPs[i], &CompactGPs[Next] };
+		EXPECT(Bundles[i - 1].MakeGradientBundle(GPPtrs, NumPoints));
+	}
+	return Bundles;
+}
+
+/*
+*	GBA gives the same bundles whether its sphere paths were just
+*	seeded (cold) or read back from the cache (warm).
+*/
+static void TestColdWarmBundlesMatch()
+{
+	TestSpherePaths_s Test;
+	int NumGPs = static_cast<int>(Test.SeedPts.size());
+
+	GradPath_c SetupGP;
+	EXPECT(Test.Setup(SetupGP, Test.Nucleus));
+
+	GradPathCache_c Cache;
+	EXPECT(Cache.Open(".", SetupGP));
+	if (!Cache.IsOpen())
+		return;
+	string FileName = Cache.FileName();
+	Cache.Close();
+	std::remove(FileName.c_str());
+
+	/*
+	*	Cold: seed the paths, store them resampled, and cache them.
+	*/
+	EXPECT(Cache.Open(".", SetupGP));
+	EXPECT(Cache.NumPaths() == 0);
+	GradPathSet_c ColdGPs;
+	ColdGPs.Resize(NumGPs, Test.NumPoints);
+	for (int i = 0; i < NumGPs; ++i){
+		GradPath_c GP;
+		EXPECT(Test.Setup(GP, Test.SeedPts[i]));
+		EXPECT(GP.Seed(false));
+		EXPECT(GP.GetCount() > Test.NumPoints);
+		EXPECT(ColdGPs.SetPath(i, GP, Test.NumPoints));
+		Cache.Add(Test.SeedPts[i], ColdGPs, i);
+	}
+	EXPECT(Cache.Flush());
+	Cache.Close();
+
+	/*
+	*	Warm: read them all back.
+	*/
+	EXPECT(Cache.Open(".", SetupGP));
+	EXPECT(Cache.NumPaths() == NumGPs);
+	GradPathSet_c WarmGPs;
+	WarmGPs.Resize(NumGPs, Test.NumPoints);
+	for (int i = 0; i < NumGPs; ++i)
+		EXPECT(Cache.Find(Test.SeedPts[i], WarmGPs, i));
+	Cache.Close();
+	std::remove(FileName.c_str());
+
+	vector<CompactGradPath_c> ColdCompactGPs(NumGPs), WarmCompactGPs(NumGPs);
+	for (int i = 0; i < NumGPs; ++i){
+		EXPECT(ColdCompactGPs[i].Build(ColdGPs, i));
+		EXPECT(WarmCompactGPs[i].Build(WarmGPs, i));
+	}
+
+	vector<FESurface_c> ColdBundles = MakeTestBundles(ColdCompactGPs, Test.NumPoints),
+		WarmBundles = MakeTestBundles(WarmCompactGPs, Test.NumPoints);
+	for (int i = 0; i < ColdBundles.size(); ++i){
+		const vector<vec3> & ColdXYZ = ColdBundles[i].GetXYZList(),
+			& WarmXYZ = WarmBundles[i].GetXYZList();
+		EXPECT(!ColdXYZ.empty() && ColdXYZ.size() == WarmXYZ.size());
+		if (ColdXYZ.size() != WarmXYZ.size())
+			continue;
+		Boolean_t AllSame = TRUE;
+		for (int j = 0; j < ColdXYZ.size() && AllSame; ++j)
+			AllSame = (sum(ColdXYZ[j] != WarmXYZ[j]) == 0);
+		EXPECT(AllSame);
+	}
+}
+
+/*
+*	Paths written to the cache are read back, after reopening it,
+*	exactly as they were written, and a partial record at the end of
+*	the file is dropped rather than read.
+*/
+static void TestCacheRoundTrip()
+{
+	TestSpherePaths_s Test;
+	int NumGPs = static_cast<int>(Test.SeedPts.size());
+
+	GradPath_c SetupGP;
+	EXPECT(Test.Setup(SetupGP, Test.Nucleus));
+
+	GradPathCache_c Cache;
+	EXPECT(Cache.Open(".", SetupGP));
+	if (!Cache.IsOpen())
+		return;
+	string FileName = Cache.FileName();
+	Cache.Close();
+	std::remove(FileName.c_str());
+
+	EXPECT(Cache.Open(".", SetupGP));
+	vector<GradPath_c> GPs(NumGPs);
+	for (int i = 0; i < NumGPs; ++i){
+		EXPECT(Test.Setup(GPs[i], Test.SeedPts[i]));
+		EXPECT(GPs[i].Seed());
+		int CPNums[2] = { i, NumGPs + i };
+		GPs[i].SetStartEndCPNum(CPNums);
+		Cache.Add(Test.SeedPts[i], GPs[i]);
+	}
+	Cache.Close();
+
+	EXPECT(Cache.Open(".", SetupGP));
+	EXPECT(Cache.NumPaths() == NumGPs);
+	for (int i = 0; i < NumGPs; ++i){
+		GradPath_c GP;
+		EXPECT(Cache.Find(Test.SeedPts[i], GP));
+		EXPECT(GP.IsMade() && GP.GetCount() == GPs[i].GetCount());
+		EXPECT(GP.GetStartEndCPNum(0) == i && GP.GetStartEndCPNum(1) == NumGPs + i);
+		if (GP.GetCount() != GPs[i].GetCount())
+			continue;
+		Boolean_t AllSame = TRUE;
+		for (int j = 0; j < GP.GetCount() && AllSame; ++j)
+			AllSame = (sum(GP.XYZAt(j) != GPs[i].XYZAt(j)) == 0 && GP.RhoAt(j) == GPs[i].RhoAt(j));
+		EXPECT(AllSame);
+	}
+	GradPath_c Missing;
+	EXPECT(!Cache.Find(Test.Nucleus, Missing));
+	Cache.Close();
+
+	/*
+	*	Cut the last record short, as if a run died while writing it.
+	*/
+	FILE * File = std::fopen(FileName.c_str(), "ab");
+	EXPECT(File != NULL);
+	if (File != NULL){
+		double Partial[4] = { 1.0, 2.0, 3.0, 4.0 };
+		std::fwrite(Partial, sizeof(double), 4, File);
+		std::fclose(File);
+	}
+	EXPECT(Cache.Open(".", SetupGP));
+	EXPECT(Cache.NumPaths() == NumGPs);
+	Cache.Close();
+	std::remove(FileName.c_str());
+}
+
+/*
+*	A change to any of the settings a path depends on opens another
+*	cache file, so paths cached with the old settings are never found.
+*/
+static void TestSettingsChangeMissesCache()
+{
+	TestSpherePaths_s Test;
+	const vec3 & SeedPt = Test.SeedPts[0];
+
+	GradPath_c SetupGP;
+	EXPECT(Test.Setup(SetupGP, Test.Nucleus));
+
+	GradPathCache_c Cache;
+	EXPECT(Cache.Open(".", SetupGP));
+	if (!Cache.IsOpen())
+		return;
+	string FileName = Cache.FileName();
+	Cache.Close();
+	std::remove(FileName.c_str());
+
+	EXPECT(Cache.Open(".", SetupGP));
+	GradPath_c GP;
+	EXPECT(Test.Setup(GP, SeedPt));
+	EXPECT(GP.Seed());
+	Cache.Add(SeedPt, GP);
+	Cache.Close();
+
+	/*
+	*	The same settings, set up again (and from another seed), hit.
+	*/
+	GradPath_c SameGP;
+	EXPECT(Test.Setup(SameGP, Test.SeedPts[1]));
+	EXPECT(Cache.Open(".", SameGP));
+	EXPECT(Cache.FileName() == FileName);
+	EXPECT(Cache.Find(SeedPt, GP));
+	Cache.Close();
+
+	/*
+	*	Each change on its own misses.
+	*/
+	TestVolume_s OtherVol(41, 0.1, vec3({ -2.0, -2.0, -2.0 }), { vec3({ 0.03, 0.04, 0.06 }) }, 2.0, FALSE);
+	OtherVol.MakeGradient();
+	VolExtentInfo_s OtherExtent = Test.Vol.VolInfo;
+	OtherExtent.MaxXYZ += vec3({ 0.1, 0.0, 0.0 });
+	OtherExtent.BasisVectors.col(0) += vec3({ 0.1, 0.0, 0.0 });
+	std::shared_ptr<const VolExtentInfo_s> OtherVolInfo = std::make_shared<const VolExtentInfo_s>(OtherExtent);
+	double OtherCutoff = 2.0 * Test.Cutoff;
+
+	vector<GradPath_c> ChangedGPs;
+	ChangedGPs.reserve(9);
+	ChangedGPs.emplace_back();
+	EXPECT(ChangedGPs.back().SetupGradPath(SeedPt, StreamDir_Forward, Test.NumPoints, GPType_Classic, GPTerminate_AtRhoValue,
+		NULL, NULL, NULL, &Test.Cutoff, Test.VolInfo, vector<FieldDataPointer_c>(), Test.Vol.GradPtrs, Test.Vol.RhoPtr));
+	ChangedGPs.emplace_back();
+	EXPECT(ChangedGPs.back().SetupGradPath(SeedPt, StreamDir_Reverse, Test.NumPoints + 1, GPType_Classic, GPTerminate_AtRhoValue,
+		NULL, NULL, NULL, &Test.Cutoff, Test.VolInfo, vector<FieldDataPointer_c>(), Test.Vol.GradPtrs, Test.Vol.RhoPtr));
+	ChangedGPs.emplace_back();
+	EXPECT(ChangedGPs.back().SetupGradPath(SeedPt, StreamDir_Reverse, Test.NumPoints, GPType_Classic, GPTerminate_AtRhoValue,
+		NULL, NULL, NULL, &OtherCutoff, Test.VolInfo, vector<FieldDataPointer_c>(), Test.Vol.GradPtrs, Test.Vol.RhoPtr));
+	ChangedGPs.emplace_back();
+	EXPECT(ChangedGPs.back().SetupGradPath(SeedPt, StreamDir_Reverse, Test.NumPoints, GPType_Classic, GPTerminate_AtRhoValue,
+		NULL, NULL, NULL, &Test.Cutoff, OtherVolInfo, vector<FieldDataPointer_c>(), Test.Vol.GradPtrs, Test.Vol.RhoPtr));
+	ChangedGPs.emplace_back();
+	EXPECT(ChangedGPs.back().SetupGradPath(SeedPt, StreamDir_Reverse, Test.NumPoints, GPType_Classic, GPTerminate_AtRhoValue,
+		NULL, NULL, NULL, &Test.Cutoff, Test.VolInfo, vector<FieldDataPointer_c>(), OtherVol.GradPtrs, OtherVol.RhoPtr));
+	ChangedGPs.emplace_back();
+	EXPECT(ChangedGPs.back().SetupGradPath(SeedPt, StreamDir_Reverse, Test.NumPoints, GPType_Classic, GPTerminate_AtRhoValue,
+		NULL, NULL, NULL, &Test.Cutoff, Test.VolInfo, vector<FieldDataPointer_c>(), vector<FieldDataPointer_c>(), Test.Vol.RhoPtr));
+	for (int i = 0; i < 3; ++i){
+		ChangedGPs.emplace_back();
+		EXPECT(Test.Setup(ChangedGPs.back(), SeedPt));
+	}
+	ChangedGPs[ChangedGPs.size() - 3].SetIntegrator(GPIntegrator_GSLRK4);
+	EXPECT(ChangedGPs[ChangedGPs.size() - 2].SetODETolerances(1e-9, 1e-9));
+	ChangedGPs.back().SetUseTricubic(FALSE);
+
+	for (int i = 0; i < ChangedGPs.size(); ++i){
+		EXPECT(Cache.Open(".", ChangedGPs[i]));
+		EXPECT(Cache.FileName() != FileName);
+		EXPECT(Cache.NumPaths() == 0);
+		GradPath_c FoundGP;
+		EXPECT(!Cache.Find(SeedPt, FoundGP));
+		Cache.Close();
+	}
+
+	std::remove(FileName.c_str());
+}
+
+void RunGradPathCacheTests()
+{
+	TestColdWarmBundlesMatch();
+	TestCacheRoundTrip();
+	TestSettingsChangeMissesCache();
+}
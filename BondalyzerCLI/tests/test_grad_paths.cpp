@@ -0,0 +1,416 @@
+/*
+*	Checks of gradient path seeding and storage.
+*/
+
+#include <memory>
+#include <random>
+
+#include "TECADDON.h"
+#include "CSM_GRAD_PATH.h"
+#include "CSM_CRIT_POINTS.h"
+
+#include "bondalyzer_tests.h"
+
+/*
+*	rho = RhoMax - sum_i K[i] x_i^2 on a cubic grid centered on the
+*	origin, with its gradient. The gradient is linear, so trilinear
+*	interpolation gives it exactly, and the path down from a point X0
+*	is known: x_i = X0[i] exp(K[i] t), so each x_i / X0[i] is
+*	(x_2 / X0[2])^(K[i] / K[2]).
+*/
+struct QuadraticVolume_s{
+	const vec3 K = vec3({ 0.5, 1.0, 2.0 });
+	const double RhoMax = 1.0;
+
+	vector<double> Rho;
+	vector<vector<double> > Grad;
+	std::shared_ptr<const VolExtentInfo_s> VolInfo;
+	FieldDataPointer_c RhoPtr;
+	vector<FieldDataPointer_c> GradPtrs;
+
+	QuadraticVolume_s(){
+		const int N = 41;
+		const double Spacing = 0.1;
+		const vec3 Origin({ -2.0, -2.0, -2.0 });
+		vector<int> MaxIJK(3, N);
+
+		VolExtentInfo_s Info;
+		GetVolInfo(MaxIJK, Origin, eye<mat>(3, 3) * (Spacing * static_cast<double>(N - 1)), FALSE, Info);
+		Info.AddOnID = NULL;
+		VolInfo = std::make_shared<const VolExtentInfo_s>(Info);
+
+		Rho.resize(N * N * N);
+		Grad.assign(3, vector<double>(Rho.size()));
+		for (int k = 0; k < N; ++k){
+			for (int j = 0; j < N; ++j){
+				for (int i = 0; i < N; ++i){
+					int Node = i + N * (j + N * k);
+					vec3 Pt = Origin + Spacing * vec3({ static_cast<double>(i), static_cast<double>(j), static_cast<double>(k) });
+					Rho[Node] = RhoAt(Pt);
+					for (int d = 0; d < 3; ++d)
+						Grad[d][Node] = -2.0 * K[d] * Pt[d];
+				}
+			}
+		}
+
+		RhoPtr.GetReadPtr(Rho.data(), MaxIJK);
+		GradPtrs.resize(3);
+		for (int d = 0; d < 3; ++d)
+			GradPtrs[d].GetReadPtr(Grad[d].data(), MaxIJK);
+	}
+
+	const double RhoAt(const vec3 & Pt) const{ return RhoMax - dot(K, Pt % Pt); }
+
+	// Largest relative distance of a path point (but the last) from the exact path
+	const double MaxPathError(const GradPath_c & GP, const vec3 & X0) const{
+		double MaxErr = 0.0;
+		for (int p = 0; p < GP.GetCount() - 1; ++p){
+			vec3 Pt = GP.XYZAt(p);
+			for (int d = 0; d < 2; ++d){
+				double Exact = pow(Pt[2] / X0[2], K[d] / K[2]);
+				MaxErr = MAX(MaxErr, std::abs(Pt[d] / X0[d] - Exact) / Exact);
+			}
+		}
+		return MaxErr;
+	}
+};
+
+/*
+*	Paths follow the exact path to within a small multiple of the
+*	integrator tolerance, with fewer steps at looser tolerances, and
+*	end on the rho cutoff. Without GSL, GSLRK4 paths use Dormand-Prince.
+*/
+static void TestIntegratorFollowsExactPath()
+{
+	QuadraticVolume_s Vol;
+	const vec3 X0({ 0.1, 0.08, 0.05 });
+	double TermValue = 0.2;
+
+	const vector<GPIntegrator_e> Integrators = { GPIntegrator_DormandPrince, GPIntegrator_GSLRK4 };
+	for (const GPIntegrator_e & Integrator : Integrators){
+		int LastCount = INT_MAX;
+		const vector<double> Tols = { 1e-12, 1e-9, 1e-6 };
+		for (const double & Tol : Tols){
+			GradPath_c GP;
+			EXPECT(GP.SetupGradPath(X0, StreamDir_Reverse, 100, GPType_Classic, GPTerminate_AtRhoValue,
+				NULL, NULL, NULL, &TermValue, Vol.VolInfo, vector<FieldDataPointer_c>(), Vol.GradPtrs, Vol.RhoPtr));
+			GP.SetIntegrator(Integrator);
+			EXPECT(GP.SetODETolerances(Tol, Tol));
+			EXPECT(GP.Seed(false));
+			EXPECT(GP.GetEndReason() == GPEnd_Terminated);
+			if (GP.GetCount() < 3){
+				EXPECT(GP.GetCount() >= 3);
+				continue;
+			}
+
+			EXPECT(Vol.MaxPathError(GP, X0) < 100.0 * Tol);
+			EXPECT(GP.GetCount() <= LastCount);
+			LastCount = GP.GetCount();
+
+			/*
+			*	The last point is interpolated to the cutoff along the last
+			*	step, which with small steps is close to the exact path.
+			*/
+			EXPECT(GP.RhoAt(-1) == TermValue);
+			if (Tol == Tols.front()){
+				vec3 EndPt = GP.XYZAt(-1);
+				EXPECT(std::abs(Vol.RhoAt(EndPt) - TermValue) < 0.01);
+				EXPECT(std::abs(EndPt[0] / X0[0] - pow(EndPt[2] / X0[2], Vol.K[0] / Vol.K[2])) < 0.01);
+			}
+		}
+	}
+}
+
+/*
+*	Two atoms on the X axis, and paths of every kind the batch handles,
+*	or passes to Seed(), between and around them: down to a rho cutoff,
+*	to the volume boundary or to the bond CP, and up to an atom. Setup()
+*	always makes the same paths, so they can be seeded one way and then
+*	the other.
+*/
+struct TestPathMix_s{
+	TestVolume_s Vol;
+	std::shared_ptr<const VolExtentInfo_s> VolInfo;
+	vec3 Atoms[2];
+	CritPoints_c CPs;
+	double Cutoff = 1e-2, AtomRadius = 0.1, CPRadius = 0.2;
+
+	TestPathMix_s()
+		: Vol(41, 0.1, vec3({ -2.0, -2.0, -2.0 }), { vec3({ -0.7, 0.03, 0.02 }), vec3({ 0.7, 0.03, 0.02 }) }, 2.0, FALSE)
+	{
+		Vol.MakeGradient();
+		VolInfo = std::make_shared<const VolExtentInfo_s>(Vol.VolInfo);
+		Atoms[0] = vec3({ -0.7, 0.03, 0.02 });
+		Atoms[1] = vec3({ 0.7, 0.03, 0.02 });
+		CPs.AddPoint(0.0, Atoms[0], zeros<vec>(3), CPType_Nuclear);
+		CPs.AddPoint(0.0, Atoms[1], zeros<vec>(3), CPType_Nuclear);
+		// On the axis between two identical atoms, so exactly where the bond CP is
+		CPs.AddPoint(0.0, vec3({ 0.0, 0.03, 0.02 }), zeros<vec>(3), CPType_Bond);
+	}
+
+	/*
+	*	NumGPs paths, some (every third if Mixed) reading rho rather than
+	*	the gradient, and if Mixed some that GradPathBatch_c hands to
+	*	Seed(): both directions, or the GSL rk4 integrator.
+	*/
+	void Setup(vector<GradPath_c> & GPs, const int & NumGPs, const Boolean_t & Mixed){
+		std::mt19937 Gen(7);
+		std::uniform_real_distribution<double> Unit(-1.0, 1.0);
+		vector<FieldDataPointer_c> NoGradPtrs;
+
+		GPs.assign(NumGPs, GradPath_c());
+		for (int i = 0; i < NumGPs; ++i){
+			const vec3 & Atom = Atoms[i % 2];
+			vec3 Dir = normalise(vec3({ Unit(Gen), Unit(Gen), Unit(Gen) }));
+			vec3 Start = Atom + (0.3 + 0.3 * std::abs(Unit(Gen))) * Dir;
+			const vector<FieldDataPointer_c> & GradPtrs = (Mixed && i % 3 == 0 ? NoGradPtrs : Vol.GradPtrs);
+
+			switch (i % 5){
+				case 0:
+				case 1:
+					EXPECT(GPs[i].SetupGradPath(Start, StreamDir_Reverse, 50, GPType_Classic, GPTerminate_AtRhoValue,
+						NULL, NULL, NULL, &Cutoff, VolInfo, vector<FieldDataPointer_c>(), GradPtrs, Vol.RhoPtr));
+					break;
+				case 2:
+					EXPECT(GPs[i].SetupGradPath(Start, StreamDir_Forward, 50, GPType_Classic, GPTerminate_AtPointRadius,
+						&Atoms[i % 2], NULL, &AtomRadius, NULL, VolInfo, vector<FieldDataPointer_c>(), GradPtrs, Vol.RhoPtr));
+					break;
+				case 3:
+					EXPECT(GPs[i].SetupGradPath(Start, StreamDir_Reverse, 50, GPType_Classic, GPTerminate_AtBoundary,
+						NULL, NULL, NULL, NULL, VolInfo, vector<FieldDataPointer_c>(), GradPtrs, Vol.RhoPtr));
+					break;
+				default:
+					// Just off the axis between the atoms, so down the axis to the bond CP
+					Start = Atom + vec3({ (i % 2 == 0 ? 0.3 : -0.3), 0.02 * Unit(Gen), 0.02 * Unit(Gen) });
+					EXPECT(GPs[i].SetupGradPath(Start, StreamDir_Reverse, 50, GPType_Classic, GPTerminate_AtCPRadius,
+						NULL, &CPs, &CPRadius, &Cutoff, VolInfo, vector<FieldDataPointer_c>(), GradPtrs, Vol.RhoPtr));
+					GPs[i].SetStartEndCPNum(i % 2, 0);
+					break;
+			}
+
+			if (Mixed && i % 7 == 3)
+				GPs[i].SetIntegrator(GPIntegrator_GSLRK4);
+			if (Mixed && i % 11 == 5){
+				GPs[i] = GradPath_c();
+				EXPECT(GPs[i].SetupGradPath(Start, StreamDir_Both, 50, GPType_Classic, GPTerminate_AtRhoValue,
+					NULL, NULL, NULL, &Cutoff, VolInfo, vector<FieldDataPointer_c>(), GradPtrs, Vol.RhoPtr));
+			}
+		}
+	}
+};
+
+static const Boolean_t SamePaths(const GradPath_c & A, const GradPath_c & B)
+{
+	if (A.IsMade() != B.IsMade() || A.GetCount() != B.GetCount() || A.GetEndReason() != B.GetEndReason() || A.GetStartEndCPNum() != B.GetStartEndCPNum())
+		return FALSE;
+	for (int i = 0; i < A.GetCount(); ++i){
+		if (sum(A.XYZAt(i) != B.XYZAt(i)) > 0 || A.RhoAt(i) != B.RhoAt(i))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+*	Paths seeded by a GradPathBatch_c, narrower than the number of paths
+*	so lanes are refilled as paths end, are bit for bit the paths
+*	Seed() makes one at a time, with the lanes evaluated together
+*	(every path reading the gradient) or each by its path's ODE function
+*	(a mix).
+*/
+static void TestBatchMatchesSeed()
+{
+	TestPathMix_s Test;
+	const int NumGPs = 60;
+
+	for (int Mixed = 0; Mixed < 2; ++Mixed){
+		for (int Resample = 0; Resample < 2; ++Resample){
+			vector<GradPath_c> GPs;
+			Test.Setup(GPs, NumGPs, Mixed);
+			for (GradPath_c & GP : GPs)
+				GP.Seed(Resample);
+
+			const vector<int> Widths = { 4, GP_BatchWidth };
+			for (const int & Width : Widths){
+				vector<GradPath_c> BatchGPs;
+				Test.Setup(BatchGPs, NumGPs, Mixed);
+				vector<GradPath_c*> GPPtrs;
+				for (GradPath_c & GP : BatchGPs)
+					GPPtrs.push_back(&GP);
+
+				GradPathBatch_c Batch(Width);
+				Batch.Seed(GPPtrs, Resample);
+
+				int NumDifferent = 0;
+				for (int i = 0; i < NumGPs; ++i){
+					if (!SamePaths(GPs[i], BatchGPs[i]))
+						NumDifferent++;
+				}
+				EXPECT(NumDifferent == 0);
+			}
+
+			// Some paths end on their conditions (some at the bond CP) and some at the volume boundary
+			int NumTerminated = 0, NumAtBond = 0;
+			for (const GradPath_c & GP : GPs){
+				NumTerminated += (GP.GetEndReason() == GPEnd_Terminated);
+				NumAtBond += (GP.GetStartEndCPNum(1) == 2);
+			}
+			EXPECT(NumTerminated > 0 && NumTerminated < NumGPs);
+			EXPECT(NumAtBond > 0);
+		}
+	}
+}
+
+// Path PathNum of Set is GP, bit for bit
+static const Boolean_t SamePaths(const GradPathSet_c & Set, const int & PathNum, const GradPathBase_c & GP)
+{
+	int Count = (GP.IsMade() ? GP.GetCount() : 0);
+	if (Set.GetCount(PathNum) != Count || Set.IsMade(PathNum) != GP.IsMade())
+		return FALSE;
+	for (int i = 0; i < 2; ++i){
+		if (Set.GetStartEndCPNum(PathNum, i) != GP.GetStartEndCPNum(i))
+			return FALSE;
+	}
+	for (int i = 0; i < Count; ++i){
+		if (sum(Set.XYZAt(PathNum, i) != GP.XYZAt(i)) > 0 || Set.RhoAt(PathNum, i) != GP.RhoAt(i))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+*	Paths stored in a GradPathSet_c, whether resampled into fixed slots
+*	by SetPath() or appended whole by AddPath(), are the paths
+*	GradPathBase_c::Resample() gives (or the paths themselves), and
+*	copying them back out, reversing them and finding their closest
+*	points give what the same GradPathBase_c methods give.
+*/
+static void TestPathSetMatchesPaths()
+{
+	TestPathMix_s Test;
+	const int NumGPs = 30, NumPoints = 50;
+
+	vector<GradPath_c> GPs;
+	Test.Setup(GPs, NumGPs, FALSE);
+	for (GradPath_c & GP : GPs)
+		EXPECT(GP.Seed(false));
+	// One that wasn't made is stored empty
+	GPs.push_back(GradPath_c());
+
+	GradPathSet_c Slots, Whole;
+	Slots.Resize(GPs.size(), NumPoints);
+	int NumDifferent = 0, NumShort = 0;
+	for (int i = 0; i < GPs.size(); ++i){
+		EXPECT(Slots.SetPath(i, GPs[i], NumPoints));
+		EXPECT(Whole.AddPath(GPs[i]) == i);
+
+		GradPath_c Resampled(GPs[i]);
+		Resampled.Resample(NumPoints);
+		if (!SamePaths(Slots, i, Resampled) || !SamePaths(Whole, i, GPs[i]))
+			NumDifferent++;
+		NumShort += (GPs[i].IsMade() && GPs[i].GetCount() <= NumPoints);
+	}
+	EXPECT(NumDifferent == 0);
+	EXPECT(!Slots.IsMade(NumGPs) && !Whole.IsMade(NumGPs));
+	// Some paths fit their slots without resampling
+	EXPECT(NumShort > 0 && NumShort < NumGPs);
+
+	std::mt19937 Gen(3);
+	std::uniform_real_distribution<double> Unit(-2.0, 2.0);
+	NumDifferent = 0;
+	for (int i = 0; i < NumGPs; ++i){
+		GradPathBase_c GP;
+		EXPECT(Whole.GetPath(i, GP));
+		if (!SamePaths(Whole, i, GP))
+			NumDifferent++;
+
+		for (int p = 0; p < 10; ++p){
+			vec3 CheckPt({ Unit(Gen), Unit(Gen), Unit(Gen) });
+			int SetPtNum = -1, PtNum = -1;
+			vec3 SetPt = Whole.ClosestPoint(i, CheckPt, SetPtNum),
+				Pt = GP.ClosestPoint(CheckPt, PtNum);
+			if (SetPtNum != PtNum || sum(SetPt != Pt) > 0)
+				NumDifferent++;
+		}
+
+		EXPECT(Whole.Reverse(i));
+		EXPECT(GP.Reverse());
+		if (!SamePaths(Whole, i, GP))
+			NumDifferent++;
+	}
+	EXPECT(NumDifferent == 0);
+
+	// Cleared sets are reused
+	Slots.Clear();
+	EXPECT(Slots.NumPaths() == 0);
+	EXPECT(Slots.AddPath(GPs[1]) == 0);
+	EXPECT(SamePaths(Slots, 0, GPs[1]));
+}
+
+/*
+*	The stall and loop checks on made up paths: a straight line carries
+*	on, and going back and forth around one point stalls, and circling
+*	loops, within a window of points.
+*/
+static void TestStallDetector()
+{
+	GPStallDetector_s Stall;
+	GPEndReason_e Reason = GPEnd_Invalid;
+	for (int i = 0; i < 10 * GP_StallWindow && Reason == GPEnd_Invalid; ++i)
+		Reason = Stall.AddPoint(vec3({ 0.1 * i, 0.05 * i, 0.0 }), 0.1);
+	EXPECT(Reason == GPEnd_Invalid);
+
+	Stall.Reset();
+	int NumPoints = 0;
+	for (Reason = GPEnd_Invalid; NumPoints < GP_StallWindow && Reason == GPEnd_Invalid; ++NumPoints)
+		Reason = Stall.AddPoint(vec3({ (NumPoints % 2 == 0 ? 1e-5 : -1e-5), 0.0, 0.0 }), 0.1);
+	EXPECT(Reason == GPEnd_Stalled);
+	EXPECT(NumPoints <= GP_StallNumPointsToCheck + GP_StallPointCount + 1);
+
+	Stall.Reset();
+	NumPoints = 0;
+	for (Reason = GPEnd_Invalid; NumPoints < 2 * GP_StallWindow && Reason == GPEnd_Invalid; ++NumPoints){
+		double Angle = 0.3 * NumPoints;
+		Reason = Stall.AddPoint(vec3({ cos(Angle), sin(Angle), 0.0 }), 0.3);
+	}
+	EXPECT(Reason == GPEnd_Looping);
+	EXPECT(NumPoints == GP_StallWindow);
+}
+
+/*
+*	With nothing to stop it, a path up to an atom stalls at the atom
+*	long before it runs out of points, and is counted as stalled.
+*/
+static void TestPathStallsAtMaximum()
+{
+	TestPathMix_s Test;
+
+	GradPath_c GP;
+	EXPECT(GP.SetupGradPath(Test.Atoms[0] + vec3({ 0.3, 0.2, -0.1 }), StreamDir_Forward, 50, GPType_Classic, GPTerminate_AtBoundary,
+		NULL, NULL, NULL, NULL, Test.VolInfo, vector<FieldDataPointer_c>(), Test.Vol.GradPtrs, Test.Vol.RhoPtr));
+
+	ResetGradPathEndCounts();
+	EXPECT(GP.Seed(false));
+	EXPECT(GP.GetEndReason() == GPEnd_Stalled || GP.GetEndReason() == GPEnd_Looping);
+	EXPECT(GP.GetCount() < GP_MaxNumPoints / 10);
+	EXPECT(norm(GP.XYZAt(-1) - Test.Atoms[0]) < Test.Vol.VolInfo.DelXYZ[0]);
+
+	vector<long long> Counts;
+	GetGradPathEndCounts(Counts);
+	EXPECT(Counts.size() == GPEnd_NumReasons);
+	if (Counts.size() == GPEnd_NumReasons){
+		long long Total = 0;
+		for (const long long & c : Counts)
+			Total += c;
+		EXPECT(Total == 1 && Counts[GP.GetEndReason()] == 1);
+	}
+	ResetGradPathEndCounts();
+}
+
+void RunGradPathTests()
+{
+	TestIntegratorFollowsExactPath();
+	TestBatchMatchesSeed();
+	TestPathSetMatchesPaths();
+	TestStallDetector();
+	TestPathStallsAtMaximum();
+}
@@ -0,0 +1,106 @@
+/*
+*	Checks of the BondalyzerLib numerics on small synthetic densities
+*	(sums of Gaussian "atoms"), run by ctest. Runs every test group, or
+*	only the one named by the first argument, and returns nonzero if any
+*	check fails.
+*/
+
+#include "TECADDON.h"
+#include "CSM_DATA_SET_INFO.h"
+
+#include "bondalyzer_tests.h"
+
+int NumFailed = 0;
+
+TestVolume_s::TestVolume_s(const int & N, const double & Spacing, const vec3 & Origin, const vector<vec3> & Atoms, const double & Alpha, const Boolean_t & IsPeriodic)
+	: m_N(N), m_Spacing(Spacing), m_Alpha(Alpha), m_Origin(Origin), m_Atoms(Atoms)
+{
+	vector<int> MaxIJK(3, N);
+	mat33 Basis = eye<mat>(3, 3) * (Spacing * static_cast<double>(N - 1));
+	GetVolInfo(MaxIJK, Origin, Basis, IsPeriodic, VolInfo);
+	VolInfo.AddOnID = NULL;
+
+	Rho.assign(N * N * N, 0.0);
+	ForEachNodeAtom([&](const int & Node, const vec3 & Pt, const vec3 & Atom){
+		Rho[Node] += exp(-m_Alpha * DistSqr(Pt, Atom));
+	});
+
+	RhoPtr.GetReadPtr(Rho.data(), MaxIJK);
+}
+
+void TestVolume_s::MakeGradient()
+{
+	Grad.assign(3, vector<double>(Rho.size(), 0.0));
+	ForEachNodeAtom([&](const int & Node, const vec3 & Pt, const vec3 & Atom){
+		vec3 Diff = Pt - Atom;
+		double Val = exp(-m_Alpha * dot(Diff, Diff));
+		for (int d = 0; d < 3; ++d)
+			Grad[d][Node] -= 2.0 * m_Alpha * Diff[d] * Val;
+	});
+
+	GradPtrs.resize(3);
+	for (int d = 0; d < 3; ++d)
+		GradPtrs[d].GetReadPtr(Grad[d].data(), VolInfo.MaxIJK);
+}
+
+/*
+*	Call Func(Node, Pt, Atom) for each node and each atom (or, if
+*	periodic, each image of an atom in this and the neighboring cells).
+*/
+template <typename NodeFunc>
+void TestVolume_s::ForEachNodeAtom(NodeFunc Func) const
+{
+	int N = m_N;
+	int NumShifts = (VolInfo.IsPeriodic ? 27 : 1);
+	for (int k = 0; k < N; ++k){
+		for (int j = 0; j < N; ++j){
+			for (int i = 0; i < N; ++i){
+				vec3 Pt = m_Origin + m_Spacing * vec3({ static_cast<double>(i), static_cast<double>(j), static_cast<double>(k) });
+				for (const vec3 & Atom : m_Atoms){
+					for (int s = 0; s < NumShifts; ++s){
+						vec3 Shift = zeros<vec>(3);
+						if (VolInfo.IsPeriodic){
+							for (int d = 0, Div = 1; d < 3; ++d, Div *= 3)
+								Shift[d] += m_Spacing * N * static_cast<double>((s / Div) % 3 - 1);
+						}
+						Func(i + N * (j + N * k), Pt, Atom + Shift);
+					}
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	StatusSetHeadless(TRUE);
+
+	struct TestGroup_s{
+		const char * Name;
+		void(*Run)();
+	} const Groups[] = {
+		{ "CalcVars", RunCalcVarsTests },
+		{ "CritPoints", RunCritPointTests },
+		{ "GradPaths", RunGradPathTests },
+		{ "GradPathCache", RunGradPathCacheTests },
+		{ "VolExtent", RunVolExtentTests }
+	};
+
+	string Only = (argc > 1 ? argv[1] : "");
+	Boolean_t RanAny = FALSE;
+	for (const TestGroup_s & Group : Groups){
+		if (Only.empty() || Only == Group.Name){
+			Group.Run();
+			RanAny = TRUE;
+		}
+	}
+	if (!RanAny){
+		cout << "no test group named " << Only << endl;
+		return 1;
+	}
+
+	if (NumFailed > 0)
+		cout << NumFailed << " check(s) failed" << endl;
+
+	return (NumFailed > 0 ? 1 : 0);
+}
@@ -0,0 +1,134 @@
+/*
+*	Checks of the grid type found by GetVolInfo() and of the orthogonal
+*	and cubic point location fast paths against the general one.
+*/
+
+#include <random>
+
+#include "TECADDON.h"
+#include "CSM_DATA_TYPES.h"
+#include "CSM_VOL_EXTENT_INDEX_WEIGHTS.h"
+
+#include "bondalyzer_tests.h"
+
+static const VolGridType_e GridTypeFor(const vector<int> & MaxIJK, const mat33 & Basis)
+{
+	VolExtentInfo_s VolInfo;
+	GetVolInfo(MaxIJK, zeros<vec>(3), Basis, FALSE, VolInfo);
+	return VolInfo.GridType;
+}
+
+static void TestGridTypes()
+{
+	vector<int> MaxIJK = { 11, 21, 31 };
+
+	// Same spacing along each axis, though not the same extent
+	EXPECT(GridTypeFor(MaxIJK, diagmat(vec3({ 1.0, 2.0, 3.0 }))) == VolGridType_Cubic);
+	EXPECT(GridTypeFor(MaxIJK, diagmat(vec3({ 1.0, 2.0, 3.3 }))) == VolGridType_Orthogonal);
+
+	// Round-off in the basis vectors doesn't make a grid general
+	mat33 Basis = diagmat(vec3({ 1.0, 2.0, 3.0 }));
+	Basis(1, 0) = 1e-14;
+	EXPECT(GridTypeFor(MaxIJK, Basis) == VolGridType_Cubic);
+
+	Basis(1, 0) = 0.1;
+	EXPECT(GridTypeFor(MaxIJK, Basis) == VolGridType_General);
+
+	// Axes along -X etc. aren't handled by the fast path
+	EXPECT(GridTypeFor(MaxIJK, diagmat(vec3({ -1.0, 2.0, 3.0 }))) == VolGridType_General);
+
+	// Nor is one filled by hand rather than by GetVolInfo()
+	VolExtentInfo_s VolInfo;
+	EXPECT(VolInfo.GridType == VolGridType_General);
+}
+
+/*
+*	For random points in and around the grid (so some are clamped, or
+*	for a periodic grid wrapped, back into it), the stencil for the
+*	grid's own type matches the general one, and so does the value
+*	interpolated from it. A linear function is interpolated exactly
+*	inside the grid.
+*/
+static void CheckFastPathMatchesGeneral(const vector<int> & MaxIJK, const vec3 & Origin, const vec3 & Extent, const VolGridType_e & ExpectedType, const Boolean_t & IsPeriodic)
+{
+	VolExtentInfo_s VolInfo;
+	GetVolInfo(MaxIJK, Origin, diagmat(Extent), IsPeriodic, VolInfo);
+	EXPECT(VolInfo.GridType == ExpectedType);
+	if (VolInfo.GridType != ExpectedType)
+		return;
+
+	const vec3 Slope({ 0.7, -1.3, 2.1 });
+	const double Offset = 0.4;
+	vector<double> Vals(MaxIJK[0] * MaxIJK[1] * MaxIJK[2]);
+	for (int k = 0; k < MaxIJK[2]; ++k){
+		for (int j = 0; j < MaxIJK[1]; ++j){
+			for (int i = 0; i < MaxIJK[0]; ++i){
+				vec3 Frac({ static_cast<double>(i) / (MaxIJK[0] - 1), static_cast<double>(j) / (MaxIJK[1] - 1), static_cast<double>(k) / (MaxIJK[2] - 1) });
+				vec3 Pt = Origin + Extent % Frac;
+				Vals[i + MaxIJK[0] * (j + MaxIJK[1] * k)] = dot(Slope, Pt) + Offset;
+			}
+		}
+	}
+	FieldDataPointer_c ValPtr;
+	ValPtr.GetReadPtr(Vals.data(), MaxIJK);
+
+	std::mt19937 Gen(1234);
+	std::uniform_real_distribution<double> Dist(-0.2, 1.2);
+
+	int NumDifferent = 0, NumInexact = 0;
+	for (int p = 0; p < 2000; ++p){
+		vec3 Frac({ Dist(Gen), Dist(Gen), Dist(Gen) });
+		vec3 Pt = Origin + Extent % Frac;
+
+		IndexWeights_s General, Fast;
+		Boolean_t GeneralOk = GetIndexAndWeightsForPointOnGrid<VolGridType_General>(Pt, VolInfo, General);
+		Boolean_t FastOk = (ExpectedType == VolGridType_Cubic
+			? GetIndexAndWeightsForPointOnGrid<VolGridType_Cubic>(Pt, VolInfo, Fast)
+			: GetIndexAndWeightsForPointOnGrid<VolGridType_Orthogonal>(Pt, VolInfo, Fast));
+		if (GeneralOk != FastOk){
+			NumDifferent++;
+			continue;
+		}
+		if (!GeneralOk)
+			continue;
+
+		Boolean_t Same = TRUE;
+		for (int c = 0; c < 8 && Same; ++c)
+			Same = (General.Index[c] == Fast.Index[c] && std::abs(General.Weights[c] - Fast.Weights[c]) <= 1e-12);
+		double GeneralVal = ValByCurrentIndexAndWeightsFromRawPtr(General, ValPtr),
+			FastVal = ValByCurrentIndexAndWeightsFromRawPtr(Fast, ValPtr);
+		if (!Same || std::abs(GeneralVal - FastVal) > 1e-12)
+			NumDifferent++;
+
+		// The dispatching version uses the fast path too
+		IndexWeights_s Dispatched;
+		GetIndexAndWeightsForPoint(Pt, VolInfo, Dispatched);
+		if (!(Dispatched == Fast))
+			NumDifferent++;
+
+		if (all(Frac >= 0.0) && all(Frac <= 1.0) && std::abs(FastVal - (dot(Slope, Pt) + Offset)) > 1e-10)
+			NumInexact++;
+	}
+
+	EXPECT(NumDifferent == 0);
+	EXPECT(NumInexact == 0);
+}
+
+static void TestOrthogonalMatchesGeneral()
+{
+	CheckFastPathMatchesGeneral({ 9, 12, 15 }, vec3({ -1.0, 0.5, 2.0 }), vec3({ 2.0, 3.3, 4.1 }), VolGridType_Orthogonal, FALSE);
+	CheckFastPathMatchesGeneral({ 9, 12, 15 }, vec3({ -1.0, 0.5, 2.0 }), vec3({ 2.0, 3.3, 4.1 }), VolGridType_Orthogonal, TRUE);
+}
+
+static void TestCubicMatchesGeneral()
+{
+	CheckFastPathMatchesGeneral({ 11, 16, 21 }, vec3({ 0.3, -2.0, 1.0 }), vec3({ 2.0, 3.0, 4.0 }), VolGridType_Cubic, FALSE);
+	CheckFastPathMatchesGeneral({ 11, 16, 21 }, vec3({ 0.3, -2.0, 1.0 }), vec3({ 2.0, 3.0, 4.0 }), VolGridType_Cubic, TRUE);
+}
+
+void RunVolExtentTests()
+{
+	TestGridTypes();
+	TestOrthogonalMatchesGeneral();
+	TestCubicMatchesGeneral();
+}
@@ -68,6 +68,23 @@ struct CalcVarsOptions_s{
 
 void CalcVars(CalcVarsOptions_s & Opt);
 
+/*
+*	The single sweep CalcVars() uses for ordered volume zones: every
+*	variable flagged in DoCalc (indexed by CalcVar_e) for all nodes,
+*	written to OutPtrs (also indexed by CalcVar_e).
+*/
+const Boolean_t CalcVarsForVolumeNodes(const vector<Boolean_t> & DoCalc,
+	const CalcVarsOptions_s & Opt,
+	const vector<int> & MaxIJK,
+	const vec3 & DelXYZ,
+	const Boolean_t & IsPeriodic,
+	const FieldDataPointer_c & RhoPtr,
+	const vector<FieldDataPointer_c> & GradReadPtrs,
+	const vector<FieldDataPointer_c> & HessReadPtrs,
+	const vector<FieldDataPointer_c> & EigSysReadPtrs,
+	const vector<vector<FieldDataPointer_c> > & OutPtrs,
+	const string & StatusStr);
+
 void CalcGradGradMagForDataset(Boolean_t IsPeriodic, const AddOn_pa & AddOnID);
 
 const Boolean_t CalcGradForRegularVar(const vector<int> & IJKMax,
@@ -99,7 +116,7 @@ void CalcGradForNode(const int & ii,
 
 void CalcGradForPoint(const vec3 & Point,
 	const vec3 & DelXYZ,
-	VolExtentIndexWeights_s & VolInfo,
+	const VolExtentInfo_s & VolInfo,
 	const mat33 & DirVects,
 	const int & StartDir,
 	const Boolean_t & IsPeriodic,
@@ -123,7 +140,7 @@ void CalcHessForNode(const int & ii,
 
 void CalcHessForPoint(const vec3 & Point,
 	const vec3 & DelXYZ,
-	VolExtentIndexWeights_s & VolInfo,
+	const VolExtentInfo_s & VolInfo,
 	const mat33 & DirVects,
 	const Boolean_t & IsPeriodic,
 	mat & OutValues,
@@ -133,7 +150,7 @@ void CalcHessForPoint(const vec3 & Point,
 
 void CalcHessFor3DPoint(const vec3 & Point,
 	const vec3 & DelXYZ,
-	VolExtentIndexWeights_s & VolInfo,
+	const VolExtentInfo_s & VolInfo,
 	const Boolean_t & IsPeriodic,
 	mat33 & Hess,
 	const vector<FieldDataPointer_c> & VarReadPtrs,
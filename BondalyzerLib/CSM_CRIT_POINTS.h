@@ -10,6 +10,9 @@
 #include "CSM_DATA_TYPES.h"
 
 #include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 
 #include <armadillo>
 using namespace arma;
@@ -19,6 +22,14 @@ using namespace arma;
 #define MaxCPIter 100
 #define CheckPosIter 0
 #define DefaultCellSpacing 0.2
+#define NewtonMaxHalvings 4
+#define CPSearchCurvatureSafety 2.0
+#define CPSearchMinCoarseCells 4
+#define CPSearchCacheBlockCells 16
+#define CPSearchCacheRhoFloor 1e-6
+#define CPTopologyMaxRefinements 2
+#define CPTopologyRegionCells 3
+#define CPTopologyDegenerateRatio 0.1
 
 using std::vector;
 
@@ -63,9 +74,9 @@ public:
 	CritPoints_c();
 	// Specify a cutoff value during construction
 	CritPoints_c(const double & RhoCutoff, const int & NumDimensions);
-	// Construct from a set of other CritPoints_c's
+	// Construct from a set of other CritPoints_c's (taking the first lattice set on any of them)
 	CritPoints_c(const vector<CritPoints_c> & CPLists);
-	// Construct from existing CP zone
+	// Construct from existing CP zone; the lattice is set from MR's volume if it's periodic
 	CritPoints_c(const int & CPZoneNum, 
 		const vector<int> & XYZVarNums,
 		const int & CPTypeVarNum,
@@ -116,10 +127,44 @@ public:
 
 	const Boolean_t IsValid() const;
 
+	/*
+	*	Poincare-Hopf sum, nuclear - bond + ring - cage (far field CPs
+	*	aren't counted). With no CPs missing or extra it's 1 for an
+	*	isolated molecule and 0 for a periodic system.
+	*/
+	const int PoincareHopfSum() const { return m_NumCPs[0] - m_NumCPs[1] + m_NumCPs[2] - m_NumCPs[3]; }
+	const Boolean_t SatisfiesPoincareHopf(const Boolean_t & IsPeriodic) const { return PoincareHopfSum() == (IsPeriodic ? 0 : 1); }
+
+	/*
+	*	Spatial queries, answered from a uniform grid over the CP
+	*	positions that's built on first use and dropped whenever the
+	*	CPs change, so they cost about the same for ten CPs or ten
+	*	thousand.
+	*	TypeNums limits the search to those CP type numbers (all types
+	*	if empty) and ExcludeTotOffset skips one CP, typically the one
+	*	a path started from. CPPos is the position of the CP found,
+	*	or of its nearest image if a lattice has been set.
+	*	Each returns the total offset of the CP found, or -1.
+	*/
+	// The first CP (lowest total offset) within Radius of Point
+	const int GetFirstCPInRadius(const vec3 & Point, const double & Radius, vec3 & CPPos, const vector<int> & TypeNums = vector<int>(), const int & ExcludeTotOffset = -1);
+	// The closest CP to Point, and its distance
+	const int GetClosestCP(const vec3 & Point, double & Dist, vec3 & CPPos, const vector<int> & TypeNums = vector<int>(), const int & ExcludeTotOffset = -1);
+	// All CPs within Radius of Point, in order of total offset; returns how many
+	const int GetCPsInRadius(const vec3 & Point, const double & Radius, vector<int> & TotOffsets, const vector<int> & TypeNums = vector<int>(), const int & ExcludeTotOffset = -1);
+
 	/*
 		*	Setter methods
 		*/
 	void SetMinCPDist(const double & MinCPDist){ m_MinCPDist = MinCPDist; }
+	/*
+	*	Make the spatial queries (and RemoveSpuriousCPs()) periodic, using
+	*	minimum-image distances for the cell spanned by the columns of
+	*	LatticeVectors (for a periodic volume, PeriodicLatticeVectors()
+	*	rather than its BasisVectors). Append() (and +=) takes the lattice of the CPs
+	*	appended if there isn't one already.
+	*/
+	void SetSpatialIndexLattice(const mat33 & LatticeVectors);
 	const Boolean_t AddPoint(const double & Rho,
 		const vec3 & Pos,
 		const vec3 & PrincDir,
@@ -135,11 +180,25 @@ public:
 
 	const Boolean_t FindMinCPDist(const vector<CPType_e> & CPTypes);
 	void RemoveSpuriousCPs(const double & CheckDist = SpuriousCPCheckDistance);
+
+	const Boolean_t BuildSpatialIndex();
+	void ClearSpatialIndex(){ m_IndexBuilt = FALSE; }
 	
 	const vector<int> SaveAsOrderedZone(const vector<int> & XYZVarNum, const int & RhoVarNum = -1, const Boolean_t & SaveCPTypeZones = FALSE);
 
 private:
 
+	const Boolean_t SpatialIndexIsReady();
+	void SearchSpatialIndex(const vec3 & Point,
+		const double & Radius,
+		const vector<int> & TypeNums,
+		const int & ExcludeTotOffset,
+		const Boolean_t & ByDistance,
+		int & BestTotOffset,
+		double & BestDistSqr,
+		vec3 & BestPos,
+		vector<int> * AllTotOffsets = NULL) const;
+	vec3 NearestImage(const vec3 & Pt, const vec3 & RefPt) const;
 
 	/*
 		*	m_Rho, m_XYZ, m_PrincDir, and m_NumCPs are length 6 so they store
@@ -155,12 +214,140 @@ private:
 	double m_RhoCutoff;
 
 	vector<CPType_e> m_MinDistCPTypes;
+
+	/*
+	*	Spatial index: CP positions sorted into cells of a uniform grid
+	*	over their bounding box, with the CPs of cell c at
+	*	m_IndexCellStart[c] to m_IndexCellStart[c+1]-1 of the
+	*	m_Index* lists, in order of total offset.
+	*/
+	Boolean_t m_IndexBuilt;
+	vec3 m_IndexMinXYZ, m_IndexMaxXYZ;
+	double m_IndexCellSize;
+	int m_IndexDims[3];
+	vector<int> m_IndexCellStart, m_IndexTotOffsets;
+	vector<char> m_IndexTypeNums;
+	vector<vec3> m_IndexXYZ;
+	Boolean_t m_HasLattice;
+	mat33 m_LatticeVectors;
 };
 
 void SetCPZone(const int & ZoneNum);
 
+/*
+*	Newton's method for F(x) = 0 in N dimensions on fixed-size stack
+*	arrays, in place of gsl_multiroot_fdfsolver_newton (no gsl_vector,
+*	solver allocation or callbacks through void*).
+*
+*	FDF(x, F, J) fills F and its Jacobian J[i][j] = dF_i/dx_j and returns
+*	FALSE if x is outside the volume. Each iteration solves for the
+*	Newton step by Gaussian elimination with partial pivoting, then
+*	halves it (up to NewtonMaxHalvings times) until it reduces |F|; if
+*	no fraction does, the full step is taken, as plain Newton would.
+*	After each step KeepGoing(x) is called, and the iteration stops if
+*	it returns false (e.g. x has left the cell being searched).
+*	Converged, as gsl_multiroot_test_residual(), when sum |F_i| < ResidualTol.
+*
+*	Returns GSL_SUCCESS, GSL_CONTINUE if not converged by MaxIter or
+*	stopped by KeepGoing(), GSL_EDOM if J is singular, or GSL_EBADFUNC if
+*	FDF() fails. x is always the last point FDF() succeeded at.
+*/
+template <int N, typename FDFFunc, typename CheckFunc>
+const int NewtonSolve(double (&x)[N],
+	FDFFunc FDF,
+	CheckFunc KeepGoing,
+	const double & ResidualTol,
+	const int & MaxIter,
+	int & Iter)
+{
+	double F[N], J[N][N];
+	Iter = 0;
+
+	if (!FDF(x, F, J))
+		return GSL_EBADFUNC;
+
+	int Status = GSL_CONTINUE;
+	while (Status == GSL_CONTINUE && Iter < MaxIter){
+		++Iter;
+
+		/*
+		*	Solve J dx = -F.
+		*/
+		double A[N][N + 1];
+		for (int i = 0; i < N; ++i){
+			for (int j = 0; j < N; ++j)
+				A[i][j] = J[i][j];
+			A[i][N] = -F[i];
+		}
+		for (int c = 0; c < N; ++c){
+			int Pivot = c;
+			for (int r = c + 1; r < N; ++r)
+				if (std::abs(A[r][c]) > std::abs(A[Pivot][c]))
+					Pivot = r;
+			if (A[Pivot][c] == 0.0)
+				return GSL_EDOM;
+			if (Pivot != c)
+				for (int j = c; j <= N; ++j)
+					std::swap(A[c][j], A[Pivot][j]);
+			for (int r = c + 1; r < N; ++r){
+				double Factor = A[r][c] / A[c][c];
+				for (int j = c; j <= N; ++j)
+					A[r][j] -= Factor * A[c][j];
+			}
+		}
+		double dx[N];
+		for (int i = N - 1; i >= 0; --i){
+			dx[i] = A[i][N];
+			for (int j = i + 1; j < N; ++j)
+				dx[i] -= A[i][j] * dx[j];
+			dx[i] /= A[i][i];
+		}
+
+		double Residual = 0.0;
+		for (int i = 0; i < N; ++i)
+			Residual += std::abs(F[i]);
+
+		double xNew[N], FNew[N], JNew[N][N];
+		bool Accepted = false;
+		double Scale = 1.0;
+		for (int h = 0; h <= NewtonMaxHalvings && !Accepted; ++h, Scale *= 0.5){
+			for (int i = 0; i < N; ++i)
+				xNew[i] = x[i] + Scale * dx[i];
+			if (FDF(xNew, FNew, JNew)){
+				double NewResidual = 0.0;
+				for (int i = 0; i < N; ++i)
+					NewResidual += std::abs(FNew[i]);
+				Accepted = (NewResidual < Residual);
+			}
+		}
+		if (!Accepted){
+			for (int i = 0; i < N; ++i)
+				xNew[i] = x[i] + dx[i];
+			if (!FDF(xNew, FNew, JNew))
+				return GSL_EBADFUNC;
+		}
+
+		double NewResidual = 0.0;
+		for (int i = 0; i < N; ++i){
+			x[i] = xNew[i];
+			F[i] = FNew[i];
+			for (int j = 0; j < N; ++j)
+				J[i][j] = JNew[i][j];
+			NewResidual += std::abs(F[i]);
+		}
+
+		if (NewResidual < ResidualTol)
+			Status = GSL_SUCCESS;
+
+		if (!KeepGoing(x))
+			break;
+	}
+
+	return Status;
+}
+
 const Boolean_t FindCPs(CritPoints_c & CPs,
-	VolExtentIndexWeights_s VolInfo,
+	const VolExtentInfo_s & VolInfo,
 	const Boolean_t & IsPeriodic,
 	const vector<int> & StartIJK,
 	const vector<int> & EndIJK,
@@ -168,14 +355,179 @@ const Boolean_t FindCPs(CritPoints_c & CPs,
 	const vector<FieldDataPointer_c> & GradPtrs,
 	const vector<FieldDataPointer_c> & HessPtrs);
 
+/*
+*	Search a lattice of cells CellSpacing apart. Only cells where every
+*	gradient component changes sign across the corners get a Newton
+*	search; SkippedCellFraction gets the fraction of cells that didn't.
+*/
 const Boolean_t FindCPs(CritPoints_c & CPs,
-	const VolExtentIndexWeights_s & VolInfo,
+	const VolExtentInfo_s & VolInfo,
+	const double & CellSpacing,
+	double & RhoCutoff,
+	const Boolean_t & IsPeriodic,
+	FieldDataPointer_c & RhoPtr,
+	vector<FieldDataPointer_c> & GradXYZPtrs,
+	vector<FieldDataPointer_c> & HessPtrs,
+	const NodeRecordCache_c * NodeCache = NULL,
+	double * SkippedCellFraction = NULL);
+
+/*
+*	What FindCPsCoarseToFine() searched, as fractions of the lattice
+*	cells FindCPs() would have searched. RuledOutFraction[l] of them
+*	were ruled out on level l (coarsest first) and SearchedFraction
+*	were searched at full resolution, so together they account for
+*	every cell. NewtonFraction of them got a Newton search.
+*/
+struct CPSearchCoverage_s{
+	int NumLevels = 0;
+	vector<double> RuledOutFraction;
+	double SearchedFraction = 0.0;
+	double NewtonFraction = 0.0;
+};
+
+/*
+*	As above, but coarse to fine: blocks of 2^NumCoarseLevels cells are
+*	checked first, and only the blocks (then half blocks, and so on)
+*	that a bound on the curvature of rho can't prove free of CPs above
+*	the rho cutoff are refined down to cells and searched.
+*/
+const Boolean_t FindCPsCoarseToFine(CritPoints_c & CPs,
+	const VolExtentInfo_s & VolInfo,
 	const double & CellSpacing,
+	const int & NumCoarseLevels,
 	double & RhoCutoff,
 	const Boolean_t & IsPeriodic,
 	FieldDataPointer_c & RhoPtr,
 	vector<FieldDataPointer_c> & GradXYZPtrs,
-	vector<FieldDataPointer_c> & HessPtrs);
+	vector<FieldDataPointer_c> & HessPtrs,
+	const NodeRecordCache_c * NodeCache = NULL,
+	CPSearchCoverage_s * Coverage = NULL);
+
+/*
+*	Lattice CP search results kept per block of lattice cells, with the
+*	settings that produced them, so the search can be rerun on the same
+*	volume (e.g. over part of it, or over more of it, or with another
+*	rho cutoff) without searching it all again.
+*
+*	FindCPs() is the lattice FindCPs() above, over the lattice cells
+*	StartCell to EndCell - 1 (the whole lattice if they're empty).
+*	Cells are searched as in FindCPs(), but down to
+*	CPSearchCacheRhoFloor (or the rho cutoff, if that's lower) rather
+*	than the cutoff, and CPs under the cutoff are dropped when the
+*	blocks are merged. So blocks searched before with the same volume
+*	data and settings are reused for any cutoff at or above the one
+*	they were searched at; the rest are searched and stored.
+*	That matches FindCPs() except for a cage whose path from a lattice
+*	minimum reaches the cutoff before the minimum: FindCPs() keeps it
+*	where the path stopped, and this drops it.
+*	Anything else (different data, spacing, grad/Hessian variables,
+*	etc.) starts the cache over. The volume data is only rehashed when
+*	its pointers change, so call Clear() if it's changed in place.
+*/
+class CPSearchCache_c{
+public:
+	CPSearchCache_c(){}
+
+	const Boolean_t FindCPs(CritPoints_c & CPs,
+		const VolExtentInfo_s & VolInfo,
+		const double & CellSpacing,
+		double & RhoCutoff,
+		const Boolean_t & IsPeriodic,
+		FieldDataPointer_c & RhoPtr,
+		vector<FieldDataPointer_c> & GradXYZPtrs,
+		vector<FieldDataPointer_c> & HessPtrs,
+		const NodeRecordCache_c * NodeCache = NULL,
+		const vector<int> & StartCell = vector<int>(),
+		const vector<int> & EndCell = vector<int>());
+
+	void Clear();
+
+	const int NumBlocks() const { return static_cast<int>(m_Blocks.size()); }
+	// Blocks reused and searched by the last FindCPs()
+	const int NumBlocksReused() const { return m_NumBlocksReused; }
+	const int NumBlocksSearched() const { return m_NumBlocksSearched; }
+
+private:
+	const uint64_t VolumeKey(const FieldDataPointer_c & RhoPtr,
+		const vector<FieldDataPointer_c> & GradXYZPtrs,
+		const vector<FieldDataPointer_c> & HessPtrs);
+	const uint64_t SettingsKey(const VolExtentInfo_s & VolInfo,
+		const double & CellSpacing,
+		const Boolean_t & IsPeriodic,
+		const FieldDataPointer_c & RhoPtr,
+		const vector<FieldDataPointer_c> & GradXYZPtrs,
+		const vector<FieldDataPointer_c> & HessPtrs,
+		const NodeRecordCache_c * NodeCache);
+
+	/*
+	*	A CP found in lattice cell CellIJK.
+	*/
+	struct CachedCP_s{
+		int CellIJK[3];
+		double Rho;
+		vec3 XYZ, PrincDir;
+		char Type;
+	};
+	// RhoCutoff is the one the block was searched at
+	struct Block_s{
+		Boolean_t IsSearched = FALSE;
+		double RhoCutoff = 0.0;
+		vector<CachedCP_s> CPs;
+	};
+
+	uint64_t m_Key = 0;
+	// Volume hash, and the data pointers and sizes it was computed for
+	uint64_t m_VolKey = 0;
+	vector<const void*> m_VolKeyPtrs;
+	vector<unsigned int> m_VolKeySizes;
+	int m_NumBlocksXYZ[3];
+	vector<Block_s> m_Blocks;
+	int m_NumBlocksReused = 0, m_NumBlocksSearched = 0;
+};
+
+/*
+*	What CheckCPTopology() found and did.
+*/
+struct CPTopologyCheck_s{
+	int ExpectedSum = 1;
+	int StartSum = 0, EndSum = 0;
+	// Focused searches run, the suspect regions they covered and the CPs they added
+	int NumRefinements = 0;
+	int NumRegions = 0;
+	int NumCPsAdded = 0;
+};
+
+/*
+*	Check CPs found by FindCPs() (at CellSpacing) against the
+*	Poincare-Hopf rule and, if it isn't met, search again at a finer
+*	spacing only where CPs are likely missing, rather than rerunning the
+*	whole search.
+*	Suspect regions come from gradient paths out of the bond and ring
+*	CPs: where a bond (ring) path stalls short of any nuclear (cage) CP,
+*	at bond (ring) CPs whose two paths end at the same CP, and halfway
+*	from a nuclear CP no bond path reaches to its nearest neighbor.
+*	Near-degenerate bond and ring CPs, where a second CP may be close
+*	by, are suspect too.
+*	The lattice cells out to CPTopologyRegionCells cells of each region
+*	are searched at half the spacing. CPs found there that aren't within
+*	SpuriousCPCheckDistance of one already in CPs are added, if that
+*	brings the sum closer to what it should be; existing CPs are never
+*	removed. That's repeated, halving the spacing each time, up to
+*	CPTopologyMaxRefinements times or until the rule is met.
+*	Returns TRUE if CPs meets the rule at the end.
+*/
+const Boolean_t CheckCPTopology(CritPoints_c & CPs,
+	const VolExtentInfo_s & VolInfo,
+	const double & CellSpacing,
+	double & RhoCutoff,
+	const Boolean_t & IsPeriodic,
+	FieldDataPointer_c & RhoPtr,
+	vector<FieldDataPointer_c> & GradXYZPtrs,
+	vector<FieldDataPointer_c> & HessPtrs,
+	const NodeRecordCache_c * NodeCache = NULL,
+	CPTopologyCheck_s * Check = NULL);
+
+const double RhoByCurrentIndexAndWeights(const MultiRootParams_s & RootParams);
 
 const Boolean_t CritPointInCell(const vector<int> & IJK,
 	vec3 & Point,
@@ -183,8 +535,7 @@ const Boolean_t CritPointInCell(const vector<int> & IJK,
 	double & RhoValue,
 	const double & RhoCutoff,
 	char & Type,
-	MultiRootParams_s & RootParams,
-	MultiRootObjects_s & MR);
+	MultiRootParams_s & RootParams);
 
 const Boolean_t CritPointInCell(
 	const vec3 & CellMinXYZ,
@@ -194,7 +545,6 @@ const Boolean_t CritPointInCell(
 	double & RhoValue,
 	const double & RhoCutoff,
 	char & Type,
-	MultiRootParams_s & RootParams,
-	MultiRootObjects_s & MR);
+	MultiRootParams_s & RootParams);
 
 #endif
\ No newline at end of file
@@ -350,7 +350,7 @@ template <class T>
 const int VectorGetElementNum(const vector<T> & SearchVec, const T & Item){
 	int ElemNum;
 
-	vector<T>::const_iterator itr = std::find(SearchVec.cbegin(), SearchVec.cend(), Item);
+	typename vector<T>::const_iterator itr = std::find(SearchVec.cbegin(), SearchVec.cend(), Item);
 
 	if (itr == SearchVec.cend()) return -1;
 
@@ -404,6 +404,11 @@ const vector<vec3> ZoneXYZVarGetMinMax_Ordered3DZone(const vector<int> & XYZVarN
 void ZoneXYZVarGetMinMax_Ordered3DZone(const vector<int> & XYZVarNums, const int & ZoneNum, vec3 & MinXYZ, vec3 & MaxXYZ);
 void ZoneXYZVarGetBasisVectors_Ordered3DZone(const vector<int> & XYZVarNums, const int & ZoneNum, mat33 & BasisVectors, vec3 & BVExtent);
 
+/*
+*	Headless mode makes the status functions no-ops, for running
+*	outside of Tecplot (e.g. BondalyzerCLI).
+*/
+void StatusSetHeadless(const Boolean_t & IsHeadless);
 void StatusLaunch(const string & StatusStr, const AddOn_pa & AddOnID, const Boolean_t & ShowScale = TRUE, const Boolean_t & ShowButton = TRUE);
 void StatusDrop(const AddOn_pa & AddOnID);
 const Boolean_t StatusUpdate(unsigned int CurrentNum, 
@@ -2,9 +2,25 @@
 #ifndef CSMDATATYPES_H_
 #define CSMDATATYPES_H_
 
+#ifndef CSM_NO_GSL
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_multiroots.h>
+#else
+/*
+*	Built without GSL (headless builds only), so define the
+*	gsl_errno.h status codes the ODE and root-finding code returns.
+*/
+enum {
+	GSL_SUCCESS = 0,
+	GSL_CONTINUE = -2,
+	GSL_EDOM = 1,
+	GSL_EFAILED = 5,
+	GSL_ESANITY = 7,
+	GSL_EBADFUNC = 9,
+	GSL_ENOPROG = 27
+};
+#endif
 
 #include <vector>
 
@@ -175,7 +191,22 @@ enum GPType_e
 /*
 *	Struct for parameters for GSL multidimensional root finder
 */
+struct VolExtentInfo_s;
+struct IndexWeights_s;
 struct VolExtentIndexWeights_s;
+class NodeRecordCache_c;
+
+/*
+*	Power-basis coefficients of the tricubic interpolant for one
+*	cell of a volume zone, so that repeated lookups in the same
+*	cell don't refetch the 4x4x4 node neighborhood.
+*	Per thread/path, like IndexWeights_s.
+*/
+struct TricubicCell_s{
+	int CellIndex = -1;
+	const void * Source = NULL;
+	double Coefs[64];
+};
 
 struct MultiRootParams_s{
 	GPType_e CalcType = GPType_Invalid;
@@ -186,6 +217,13 @@ struct MultiRootParams_s{
 	const FieldDataPointer_c * RhoPtr = NULL;
 	const vector<FieldDataPointer_c> * GradPtrs = NULL;
 	const vector<FieldDataPointer_c> * HessPtrs = NULL;
+	const NodeRecordCache_c * NodeCache = NULL;
+	/*
+	*	Without gradient variables, use the tricubic interpolant's
+	*	analytic derivatives of rho instead of finite differences.
+	*/
+	Boolean_t UseTricubic = TRUE;
+	TricubicCell_s TricubicCell;
 	const mat33 * BasisVectors = NULL;
 	vec3 * Origin = NULL;
 	vec3 * EquilPos = NULL;
@@ -194,13 +232,6 @@ struct MultiRootParams_s{
 	double KDisp = 0.0, KGrad = 0.0;
 };
 
-struct MultiRootObjects_s{
-	gsl_multiroot_function_fdf Func;
-	gsl_vector * pos;
-	const gsl_multiroot_fdfsolver_type * T;
-	gsl_multiroot_fdfsolver * s;
-};
-
 enum CompDir_e{
 	LessThan = 1,
 	GreaterThan
@@ -68,6 +68,7 @@ public:
 	const int GetNumSides() const { return m_GPList.size(); }
 	const int GetGPZoneNum(const int & i) const { REQUIRE(0 <= i && i < m_GPList.size()); return m_GPList[i].GetZoneNum(); }
 	const Boolean_t IsMade() const { return m_FEVolumeMade; }
+	const vector<vec3> & GetXYZList() const { return m_XYZList; }
 	const Boolean_t IntResultsReady() const { return m_IntegrationResultsReady; }
 	const vector<double> GetIntResults() const;
 	const int GetZoneNum() const { return m_ZoneNum; }
@@ -92,6 +93,11 @@ public:
 		const vector<vec> & stuW2 = vector<vec>());
 // 	const Boolean_t DoIntegration(const int & ResolutionScale, const Boolean_t & IntegrateVolume);
 	const Boolean_t DoIntegrationNew(const int & ResolutionScale, const Boolean_t & IntegrateVolume);
+	/*
+	*	Optional interleaved copy of the integration variables, in the same
+	*	order as the IntVarNums used to make the volume. Not owned.
+	*/
+	void SetIntVarCache(const NodeRecordCache_c * IntVarCache){ m_IntVarCache = IntVarCache; }
 
 	const Boolean_t GQIntegration(const int & NumGQPts, const vector<FieldDataPointer_c> & InIntFDPtrs, const Boolean_t & IntegrateVolume);
 
@@ -100,6 +106,9 @@ public:
 	const vector<mat> GetIntegrationPointsWeights(const vector<vec> & stuW) const;
 
 	const Boolean_t MakeGradientBundle(vector<GradPath_c*> GPs);
+	const Boolean_t MakeGradientBundle(const GradPathSet_c & GPs, const vector<int> & PathNums);
+	// Sampling each compact path at NumGPPts points evenly spaced along it.
+	const Boolean_t MakeGradientBundle(const vector<const CompactGradPath_c*> & GPs, const int & NumGPPts);
 	const Boolean_t MakeFromGPs(vector<GradPath_c*> GPs, const bool ConnectBeginningAndEndGPs = false);
 
 	const Boolean_t Refine();
@@ -161,7 +170,9 @@ private:
 	const vector<int> TriangleEdgeMidPointSubdivide(const int & TriNum);
 	void RefineTriElems(const vector<int> & TriNumList);
 	void TriPolyLines(const bool ConnectBeginningAndEndGPs = true);
+	void TriangulateGradientBundle();
 	void RemoveDupicateNodes();
+	const Boolean_t IntVarCacheIsValid() const;
 
 
 	vector<GradPath_c> m_GPList;
@@ -180,6 +191,7 @@ private:
 	vector<FieldDataPointer_c> m_XYZPtrs;
 
 	vector<FieldDataPointer_c> m_IntVarPtrs;
+	const NodeRecordCache_c * m_IntVarCache = NULL;
 
 #ifdef _DEBUG
 	vector<vec3> m_InteriorPts, m_CheckPts, m_InteriorSubPts, m_CheckSubPts;
@@ -10,6 +10,17 @@ using namespace arma;
 
 struct VolExtentIndexWeights_s;
 
+/*
+*	Maps a raw storage type to the corresponding Tecplot field data type.
+*/
+template <typename T> struct FieldDataTypeOf_s{ static const FieldDataType_e Type = FieldDataType_Invalid; };
+template <> struct FieldDataTypeOf_s<float_t>{ static const FieldDataType_e Type = FieldDataType_Float; };
+template <> struct FieldDataTypeOf_s<double_t>{ static const FieldDataType_e Type = FieldDataType_Double; };
+template <> struct FieldDataTypeOf_s<Int32_t>{ static const FieldDataType_e Type = FieldDataType_Int32; };
+template <> struct FieldDataTypeOf_s<Int16_t>{ static const FieldDataType_e Type = FieldDataType_Int16; };
+template <> struct FieldDataTypeOf_s<Byte_t>{ static const FieldDataType_e Type = FieldDataType_Byte; };
+template <> struct FieldDataTypeOf_s<bool>{ static const FieldDataType_e Type = FieldDataType_Bit; };
+
 class FieldDataPointer_c{
 public:
 	FieldDataPointer_c(){}
@@ -22,9 +33,22 @@ public:
 	const Boolean_t Write(const unsigned int & i, const double & Val) const;
 	const Boolean_t GetReadPtr(const int & ZoneNum, const int & VarNum);
 	const Boolean_t GetWritePtr(const int & ZoneNum, const int & VarNum);
+	/*
+	*	In-memory backend: point at an existing array (not copied, so
+	*	it must outlive the pointer) as a nodal ordered zone with
+	*	MaxIJK nodes, I fastest. Needs no Tecplot session, and
+	*	ZoneNum()/VarNum() are -1.
+	*/
+	template <typename T> const Boolean_t GetReadPtr(const T * Data, const vector<int> & MaxIJK){
+		return SetArrayPtr(const_cast<T*>(Data), FieldDataTypeOf_s<T>::Type, MaxIJK, TRUE);
+	}
+	template <typename T> const Boolean_t GetWritePtr(T * Data, const vector<int> & MaxIJK){
+		return SetArrayPtr(Data, FieldDataTypeOf_s<T>::Type, MaxIJK, FALSE);
+	}
 	void Close();
 
 	const Boolean_t IsReady() const { return m_IsReady; }
+	const Boolean_t IsArrayPtr() const { return m_IsReady && m_Zone < 0; }
 	const unsigned int Size() const { return m_Size; }
 	const vector<int> MaxIJK() const { return vector<int>(m_MaxIJK, m_MaxIJK + 3); }
 	const int VarNum() const { return m_Var; }
@@ -33,23 +57,33 @@ public:
 	const bool ZoneIsOrdered() const { return (m_ZoneType == ZoneType_Invalid); }
 	const FieldDataType_e FDType() const { return m_FDType; }
 	const ValueLocation_e ValueLocation() const { return m_ValueLocation; }
+	const void * VoidPtr() const { return m_VoidPtr; }
+
+	/*
+	*	Typed raw pointers. T must match the storage type of the
+	*	variable (see FieldDataTypeOf_s), so hot loops can switch
+	*	on FDType() once and then read without any per-element
+	*	type checks.
+	*/
+	template <typename T> const T* TypedReadPtr() const{
+		REQUIRE(m_IsReady && m_FDType == FieldDataTypeOf_s<T>::Type);
+		return reinterpret_cast<const T*>(m_VoidPtr);
+	}
+	template <typename T> T* TypedWritePtr() const{
+		REQUIRE(m_IsReady && !m_IsReadPtr && m_FDType == FieldDataTypeOf_s<T>::Type);
+		return reinterpret_cast<T*>(m_VoidPtr);
+	}
 private:
+	const Boolean_t SetArrayPtr(void * Data, const FieldDataType_e FDType, const vector<int> & MaxIJK, const Boolean_t & IsReadPtr);
+
+	/*
+	*	The storage type is resolved once when the pointer is opened.
+	*	Typed access goes through TypedReadPtr<T>()/TypedWritePtr<T>(),
+	*	which just reinterpret m_VoidPtr, so there's only one copy of
+	*	the raw pointer regardless of type or read/write access.
+	*/
 	void* m_VoidPtr = NULL;
 
-	const bool* m_ReadBitPtr = NULL;
-	const Byte_t* m_ReadBytePtr = NULL;
-	const Int16_t* m_ReadInt16Ptr = NULL;
-	const Int32_t* m_ReadInt32Ptr = NULL;
-	const float_t* m_ReadFltPtr = NULL;
-	const double_t* m_ReadDblPtr = NULL;
-
-	bool* m_WriteBitPtr = NULL;
-	Byte_t* m_WriteBytePtr = NULL;
-	Int16_t* m_WriteInt16Ptr = NULL;
-	Int32_t* m_WriteInt32Ptr = NULL;
-	float_t* m_WriteFltPtr = NULL;
-	double_t* m_WriteDblPtr = NULL;
-
 	int m_MaxIJK[3];
 	unsigned int m_Size = 0;
 
@@ -57,12 +91,42 @@ private:
 	int m_Var = -1;
 
 	Boolean_t m_IsReady = FALSE;
-	Boolean_t m_IsReadPtr;
+	Boolean_t m_IsReadPtr = TRUE;
 	FieldDataType_e m_FDType = FieldDataType_Invalid;
 	ValueLocation_e m_ValueLocation = ValueLocation_Invalid;
 	ZoneType_e m_ZoneType = ZoneType_Invalid;
 };
 
+/*
+*	Kept inline since it's used in many inner loops.
+*	Only one switch on the storage type per access now.
+*/
+inline const double FieldDataPointer_c::operator[](const unsigned int & i) const{
+	REQUIRE(m_IsReady && i < m_Size);
+	switch (m_FDType){
+		case FieldDataType_Double:
+			return static_cast<double>(reinterpret_cast<const double_t*>(m_VoidPtr)[i]);
+		case FieldDataType_Float:
+			return static_cast<double>(reinterpret_cast<const float_t*>(m_VoidPtr)[i]);
+		case FieldDataType_Int32:
+			return static_cast<double>(reinterpret_cast<const Int32_t*>(m_VoidPtr)[i]);
+		case FieldDataType_Int16:
+			return static_cast<double>(reinterpret_cast<const Int16_t*>(m_VoidPtr)[i]);
+		case FieldDataType_Byte:
+			return static_cast<double>(reinterpret_cast<const Byte_t*>(m_VoidPtr)[i]);
+		case FieldDataType_Bit:
+			return static_cast<double>(reinterpret_cast<const bool*>(m_VoidPtr)[i]);
+		default:
+			return 0.0;
+	}
+}
+
+/*
+*	Returns the storage type shared by all the pointers, or
+*	FieldDataType_Invalid if they differ or any aren't ready.
+*/
+const FieldDataType_e CommonFDType(const vector<FieldDataPointer_c> & Ptrs);
+
 class FieldVecPointer_c{
 public:
 	FieldVecPointer_c(){}
@@ -3,6 +3,7 @@
 #define CSMGRADPATH_H_
 
 #include <vector>
+#include <memory>
 
 #include "CSM_DATA_TYPES.h"
 #include "CSM_DATA_SET_INFO.h"
@@ -19,9 +20,18 @@ using std::vector;
 #define GP_StallPointCount			10
 #define GP_StallNumPointsToCheck	10
 #define GP_StallPointDistTol		1e-3
+#define GP_StallWindow				64
+#define GP_LoopDispRatio			0.25
+#define GP_LoopTurnAngle			(4.0 * PI)
 #define GP_MaxNumPoints				10000
 #define GP_PlaneCPStallCount		30
 #define GP_PlaneCPMaxIter			100
+#define GP_ODE_AbsTol				1e-12
+#define GP_ODE_RelTol				1e-12
+#define GP_BatchWidth				32
+#define GP_CompactTol				1e-4
+#define GP_CompactRhoTol			1e-3
+#define GP_BenchmarkEndPointTol		0.1
 
 class CritPoints_c;
 
@@ -37,6 +47,78 @@ enum GPTerminate_e
 	GPTerminate_Invalid = -1
 };
 
+/*
+*	Why a seeded path stopped, from GradPath_c::GetEndReason().
+*	Terminated is reaching its HowTerminate condition (or the rho
+*	cutoff). Stalled and Looping are from GPStallDetector_s.
+*/
+enum GPEndReason_e
+{
+	GPEnd_Terminated = 0,
+	GPEnd_Boundary,
+	GPEnd_Stalled,
+	GPEnd_Looping,
+	GPEnd_MaxNumPoints,
+	GPEnd_Failed,
+
+	GPEnd_NumReasons,
+	GPEnd_Invalid = -1
+};
+
+/*
+*	Number of paths seeded (in each direction) that ended for each
+*	GPEndReason_e, over all threads, since the last reset.
+*	Paths add to the counts atomically, but getting or resetting them
+*	isn't synchronised with that, so call these outside parallel regions.
+*/
+void GetGradPathEndCounts(vector<long long> & Counts);
+void ResetGradPathEndCounts();
+
+/*
+*	Incremental check for a path that has stopped making progress,
+*	updated in constant time per step from a ring buffer of the last
+*	GP_StallWindow points.
+*	Stalled: GP_StallPointCount steps in a row have moved less than
+*	GP_StallPointDistTol (or the step size) per step over the last
+*	GP_StallNumPointsToCheck steps.
+*	Looping: over the whole window the path has turned through more than
+*	GP_LoopTurnAngle while its net displacement is under GP_LoopDispRatio
+*	of the distance it travelled, so it's orbiting in a flat region or
+*	circling rather than heading anywhere. Gradient paths don't do that
+*	near a nondegenerate CP, since the Hessian there is symmetric.
+*/
+struct GPStallDetector_s{
+	GPStallDetector_s(){ Reset(); }
+
+	void Reset();
+	// Add the point stepped to; returns GPEnd_Stalled, GPEnd_Looping or GPEnd_Invalid to carry on.
+	const GPEndReason_e AddPoint(const vec3 & Pt, const double & StepSize);
+
+	vec3 Pts[GP_StallWindow];
+	double StepLen[GP_StallWindow], Turn[GP_StallWindow];
+	int Last, Num;
+	double PathLen, TurnSum;
+	vec3 LastDir;
+	Boolean_t HasDir;
+	unsigned int NumStalledPoints;
+};
+
+/*
+*	ODE integrator used to seed gradient paths.
+*	DormandPrince is an embedded 5(4) Runge-Kutta pair that reuses
+*	the gradient at the end of a step as the first stage of the next
+*	(FSAL) and keeps all its state on the stack.
+*	GSLRK4 is the original GSL rk4 stepper with a y-error controller,
+*	kept as a reference.
+*/
+enum GPIntegrator_e
+{
+	GPIntegrator_DormandPrince = 0,
+	GPIntegrator_GSLRK4,
+
+	GPIntegrator_Invalid = -1
+};
+
 struct GradPathParams_s{
 	/*
 	*	Raw pointers to Tec360 field data.
@@ -48,26 +130,65 @@ struct GradPathParams_s{
 	vector<FieldDataPointer_c> GradPtrs;
 	Boolean_t HasGrad;
 	FieldDataPointer_c RhoPtr;
+	/*
+	*	Optional interleaved copy of rho/grad/Hessian, used
+	*	instead of the pointers above when set.
+	*/
+	const NodeRecordCache_c * NodeCache = NULL;
+	/*
+	*	Without gradient variables, take the gradient analytically
+	*	from the tricubic interpolant of rho instead of by finite
+	*	differences. TricubicCell holds the current cell's coefficients.
+	*/
+	Boolean_t UseTricubic = TRUE;
+	TricubicCell_s TricubicCell;
 
-	VolExtentIndexWeights_s VolZoneInfo;
+	/*
+	*	Grid geometry is read-only and shared between all
+	*	paths (and copies of paths) set up with the same
+	*	descriptor; only the interpolation stencil is per path.
+	*/
+	std::shared_ptr<const VolExtentInfo_s> VolZoneInfo;
+	IndexWeights_s Stencil;
 
 	StreamDir_e Direction;
 
+	/*
+	*	Integrator and its absolute/relative error tolerances
+	*	on the path position.
+	*/
+	GPIntegrator_e Integrator = GPIntegrator_DormandPrince;
+	double AbsTol = GP_ODE_AbsTol;
+	double RelTol = GP_ODE_RelTol;
+
 	GradPathParams_s & operator=(const GradPathParams_s & rhs);
 	const Boolean_t operator==(const GradPathParams_s & rhs) const;
 };
 
 
+typedef int(*GPODEFunc_t)(double, const double[], double[], void*);
+
 /*
 *	Function for GSL ODE solver.
 *	This is not a member function because it's a pain to use
 *	member function with GSL.
 */
 int GP_ODE_GradFunction(double t, const double pos[], double dydt[], void* params);
+/*
+*	Same, but reads the gradient through typed raw pointers.
+*	SeedInDirection() picks the instantiation that matches the
+*	gradient storage type once per path, falling back to
+*	GP_ODE_GradFunction() for mixed types or no gradient.
+*/
+template <typename T>
+int GP_ODE_GradFunctionTyped(double t, const double pos[], double dydt[], void* params);
 
 
 class GradPathBase_c
 {
+	friend class GradPathSet_c;
+	friend class GradPathCache_c;
+	friend class CompactGradPath_c;
 public:
 	GradPathBase_c();
 	~GradPathBase_c();
@@ -184,6 +305,8 @@ protected:
 class GradPath_c : public GradPathBase_c
 {
 	friend class FESurface_c;
+	friend class GradPathBatch_c;
+	friend class GradPathCache_c;
 public:
 	/*
 		*	Constructors and destructors
@@ -225,8 +348,22 @@ public:
 		const vector<FieldDataPointer_c> & HessPtrs,
 		const vector<FieldDataPointer_c> & GradPtrs,
 		const FieldDataPointer_c & RhoPtr);
+	// Sharing VolInfo rather than copying it, as SetupGradPath() below.
+	GradPath_c(const vec3 & StartPoint,
+		const StreamDir_e & Direction,
+		const int & NumGPPoints,
+		const GPType_e & GPType,
+		const GPTerminate_e & HowTerminate,
+		vec3 * TermPoint,
+		CritPoints_c * CPs,
+		double * TermPointRadius,
+		double * TermValue,
+		const std::shared_ptr<const VolExtentInfo_s> & VolInfo,
+		const vector<FieldDataPointer_c> & HessPtrs,
+		const vector<FieldDataPointer_c> & GradPtrs,
+		const FieldDataPointer_c & RhoPtr);
 
-	GradPath_c::GradPath_c(EntIndex_t ZoneNum,
+	GradPath_c(EntIndex_t ZoneNum,
 		const vector<EntIndex_t> & XYZRhoVarNums,
 		const AddOn_pa & AddOnID);
 
@@ -281,7 +418,43 @@ public:
 		const vector<FieldDataPointer_c> & GradPtrs,
 		const FieldDataPointer_c & RhoPtr);
 
+	/*
+	*	Same as above, but the path holds onto VolInfo rather than
+	*	making its own copy, so many paths can share one grid.
+	*/
+	const Boolean_t SetupGradPath(const vec3 & StartPoint,
+		const StreamDir_e & Direction,
+		const int & NumGPPoints,
+		const GPType_e & GPType,
+		const GPTerminate_e & HowTerminate,
+		vec3 * TermPoint,
+		CritPoints_c * CPs,
+		double * TermPointRadius,
+		double * TermValue,
+		const std::shared_ptr<const VolExtentInfo_s> & VolInfo,
+		const vector<FieldDataPointer_c> & HessPtrs,
+		const vector<FieldDataPointer_c> & GradPtrs,
+		const FieldDataPointer_c & RhoPtr);
+
 	const Boolean_t Seed(const bool DoResample = true);
+	// Why the last Seed() stopped.
+	const GPEndReason_e GetEndReason() const { return m_EndReason; }
+	/*
+	*	Read rho and gradient from an interleaved node cache built for
+	*	the same zone as the read pointers. Set before seeding.
+	*/
+	void SetNodeCache(const NodeRecordCache_c * NodeCache){ m_ODE_Data.NodeCache = NodeCache; }
+	void SetUseTricubic(const Boolean_t & UseTricubic){ m_ODE_Data.UseTricubic = UseTricubic; }
+	void SetIntegrator(const GPIntegrator_e & Integrator){ m_ODE_Data.Integrator = Integrator; }
+	const Boolean_t SetODETolerances(const double & AbsTol, const double & RelTol){
+		if (AbsTol < 0.0 || RelTol < 0.0 || AbsTol + RelTol <= 0.0)
+			return FALSE;
+
+		m_ODE_Data.AbsTol = AbsTol;
+		m_ODE_Data.RelTol = RelTol;
+
+		return TRUE;
+	}
 	const Boolean_t SetMixingFactor(const double & MixFactor){
 		if (MixFactor >= 0.0 && MixFactor <= 1.0)
 			m_DirMixFactor = MixFactor;
@@ -296,6 +469,20 @@ private:
 	const double RhoByCurrentIndexAndWeights();
 	const Boolean_t SeedInDirection(const StreamDir_e & Direction);
 
+	/*
+	*	Pieces of SeedInDirection() that GradPathBatch_c uses
+	*	too, so batched paths terminate exactly the same way.
+	*/
+	GPODEFunc_t ODEFunction() const;
+	const Boolean_t BeginSeedInDirection(GPStallDetector_s & Stall);
+	const Boolean_t AddStepPoint(const vec3 & PtI,
+		vec3 & PtIm1,
+		const double & StepSize,
+		int & Status,
+		GPStallDetector_s & Stall,
+		Boolean_t & IsOk);
+	const Boolean_t EndSeedInDirection(const vec3 & PtI, const int & Status, const Boolean_t & PathIsOk);
+
 	/*
 		* Special gradient path algorithm functions
 		*/
@@ -333,16 +520,298 @@ private:
 
 	GPTerminate_e m_HowTerminate;
 	vec3 m_StartPoint;
+
+	GPEndReason_e m_EndReason = GPEnd_Invalid;
 };
 
 
 
+/*
+*	Seeds many classic gradient paths side by side.
+*	Up to Width() paths are integrated in lockstep, with their state
+*	(position, step size and Dormand-Prince stages) stored as
+*	structure of arrays so the arithmetic of each stage runs over
+*	contiguous lanes. Each round every lane attempts one step;
+*	lanes whose path terminated (rho cutoff, boundary, point or CP
+*	radius, stall or GP_MaxNumPoints) are compacted out and refilled
+*	with the next path, so the lanes stay dense.
+*	When the lanes share an orthogonal or cubic grid and read the
+*	gradient from the same node cache or raw pointers, the gradient
+*	lookups are lane-wise too (EvalStage()); otherwise each lane calls
+*	its path's ODE function.
+*
+*	Results are the same as calling Seed() on each path. Paths seeded
+*	in both directions, special gradient paths and paths using the GSL
+*	integrator are passed to Seed() instead.
+*
+*	Lane storage is kept between calls, so keep one batch per thread.
+*/
+class GradPathBatch_c{
+public:
+	GradPathBatch_c(const int & Width = GP_BatchWidth);
+
+	/*
+	*	Seed paths already set up with SetupGradPath().
+	*	Returns FALSE if any of them failed.
+	*/
+	const Boolean_t Seed(const vector<GradPath_c*> & GPs, const bool DoResample = true);
+
+	const int Width() const { return m_Width; }
+
+private:
+	const Boolean_t CanBatch(const GradPath_c & GP) const;
+	const Boolean_t LoadLane(const int & Lane, GradPath_c * GP);
+	const int EvalLane(const int & Lane, const double * Pos, const int & Stage);
+	const Boolean_t LanesShareGrid(const int & NumLanes) const;
+	void EvalStage(const int & NumActiveLanes, const double * Pos, const int & Stage);
+	void EvalLanes(const int & NumLanes, const double * Pos, const int & Stage, const Boolean_t & ShareGrid);
+	void MoveLane(const int & From, const int & To);
+	const Boolean_t Advance(const bool DoResample);
+
+	int m_Width;
+	int m_NumActive = 0;
+
+	/*
+	*	Lane l of component d is at [d * m_Width + l],
+	*	and of stage s at [(s * 3 + d) * m_Width + l].
+	*/
+	vector<double> m_Y, m_Pos, m_K;
+	vector<double> m_H, m_T, m_ErrRatio, m_AbsTol, m_RelTol;
+	vector<int> m_Status, m_Step;
+	vector<GPStallDetector_s> m_Stall;
+	vector<Boolean_t> m_HasK, m_Eval;
+	vector<double> m_DirSign;
+
+	/*
+	*	EvalStage() scratch, also structure of arrays: corner c of
+	*	lane l is at [c * m_Width + l], and axis d at [d * m_Width + l].
+	*/
+	vector<int> m_IJK, m_Index, m_OutOfBounds, m_IsBad;
+	vector<double> m_OneMinusRST, m_OnePlusRST, m_Weights, m_Grad;
+	vector<vec3> m_PtIm1;
+	vector<GPODEFunc_t> m_Func;
+	vector<GradPath_c*> m_GP;
+};
+
+/*
+*	A collection of finished gradient paths sharing one block of storage.
+*	The points of every path are kept in flat X, Y, Z and rho arrays, and
+*	each path is a span (offset and count) of them, so a collection of
+*	thousands of paths takes a handful of allocations rather than a few
+*	per path. Clear() keeps the storage, so reuse a set for the next
+*	collection (e.g. the next GBA sphere) instead of making a new one.
+*
+*	Resize() gives every path a slot of fixed size, and paths can then be
+*	stored in their slots from several threads at once with SetPath().
+*	AddPath() appends a path of any length, from one thread only.
+*
+*	Sets can be moved but not copied, since a copy is a copy of every path.
+*/
+class GradPathSet_c
+{
+	friend class GradPathCache_c;
+public:
+	GradPathSet_c(){}
+	GradPathSet_c(GradPathSet_c && rhs){ *this = std::move(rhs); }
+	GradPathSet_c & operator=(GradPathSet_c && rhs);
+	GradPathSet_c(const GradPathSet_c &) = delete;
+	GradPathSet_c & operator=(const GradPathSet_c &) = delete;
+
+	// Remove all paths, keeping the storage.
+	void Clear();
+	// Remove all paths and make NumPaths empty ones with room for MaxPointsPerPath points each.
+	void Resize(const int & NumPaths, const int & MaxPointsPerPath);
+	/*
+	*	Store a copy of GP in slot PathNum. If NumPoints is given and GP
+	*	has more points than that, GP is resampled on the way in exactly
+	*	as GradPathBase_c::Resample() would, without touching GP.
+	*	Paths that weren't made are stored empty.
+	*/
+	const Boolean_t SetPath(const int & PathNum, const GradPathBase_c & GP, const int & NumPoints = -1);
+	// Append a copy of GP, returning its path number.
+	const int AddPath(const GradPathBase_c & GP);
+	// Copy path PathNum out to GP, for code that needs a GradPathBase_c.
+	const Boolean_t GetPath(const int & PathNum, GradPathBase_c & GP) const;
+
+	const int NumPaths() const { return static_cast<int>(m_Count.size()); }
+	const int GetCount(const int & PathNum) const { return m_Count[PathNum]; }
+	const Boolean_t IsMade(const int & PathNum) const { return m_Count[PathNum] > 0; }
+	const vec3 XYZAt(const int & PathNum, const int & i) const;
+	const double RhoAt(const int & PathNum, const int & i) const { return m_Rho[m_Offset[PathNum] + i]; }
+	const int GetStartEndCPNum(const int & PathNum, const unsigned int & i) const { REQUIRE(i < 2); return m_StartEndCPNum[2 * PathNum + i]; }
+
+	const Boolean_t Reverse(const int & PathNum);
+	const vec3 ClosestPoint(const int & PathNum, const vec3 & CheckPt, int & PtNum) const;
+	// Returns the new zone's number, or -1.
+	const EntIndex_t SaveAsOrderedZone(const int & PathNum, const string & ZoneName = "Gradient Path", const ColorIndex_t MeshColor = Black_C) const;
+
+private:
+	vector<double> m_X, m_Y, m_Z, m_Rho;
+	vector<int> m_Offset, m_Count, m_MaxCount;
+	vector<int> m_StartEndCPNum;
+};
+
+/*
+*	A bounding volume hierarchy over the segments of one or more gradient
+*	paths, for many closest-point queries against the same paths.
+*	Distances are to the closest point on a segment rather than to the
+*	closest path point, so they don't depend on the point spacing.
+*	The tree keeps its own copy of the segments, so the paths can
+*	change or go away once it's built.
+*	Each path gets its own subtree, so one tree over a set of paths
+*	also answers queries against any one of them.
+*/
+class GradPathSegmentTree_c
+{
+public:
+	GradPathSegmentTree_c(){}
+
+	// Build over the segments of GP, which is path 0.
+	const Boolean_t Build(const GradPathBase_c & GP);
+	// Build over paths PathNums of GPs (all of them if empty), which keep their numbers.
+	const Boolean_t Build(const GradPathSet_c & GPs, const vector<int> & PathNums = vector<int>());
+	// Build over the segments of each of GPs, which are paths 0 to GPs.size() - 1.
+	const Boolean_t Build(const vector<GradPath_c> & GPs);
+	void Clear();
+	const Boolean_t HasPath(const int & PathNum) const { return PathNum >= 0 && PathNum < static_cast<int>(m_PathRoots.size()) && m_PathRoots[PathNum] >= 0; }
+	const Boolean_t IsBuilt() const { return !m_Nodes.empty(); }
+
+	/*
+	*	The closest point to CheckPt on any of the paths. It's on path
+	*	PathNum between points PtNum and PtNum + 1, and Dist from CheckPt.
+	*/
+	const vec3 ClosestPoint(const vec3 & CheckPt, int & PathNum, int & PtNum, double & Dist) const;
+	// ClosestPoint() for each of CheckPts, in parallel.
+	void ClosestPoints(const vector<vec3> & CheckPts,
+		vector<vec3> & ClosestPts,
+		vector<int> & PathNums,
+		vector<int> & PtNums,
+		vector<double> & Dists) const;
+	/*
+	*	The closest point to CheckPt on path PathNum only, which is
+	*	between points PtNum and PtNum + 1 and Dist from CheckPt.
+	*	Dist is -1 if the tree doesn't have the path.
+	*/
+	const vec3 ClosestPointOnPath(const vec3 & CheckPt, const int & PathNum, int & PtNum, double & Dist) const;
+	// ClosestPointOnPath() for each of CheckPts against path OnPathNums[i], in parallel.
+	void ClosestPointsOnPaths(const vector<vec3> & CheckPts,
+		const vector<int> & OnPathNums,
+		vector<vec3> & ClosestPts,
+		vector<int> & PtNums,
+		vector<double> & Dists) const;
+
+private:
+	/*
+	*	A node's bounding box holds segments m_Seg*[Beg] to m_Seg*[End - 1].
+	*	Leaves have Child < 0, otherwise the children are nodes Child and
+	*	Child + 1.
+	*	The nodes above the path roots split the set of paths, and the
+	*	nodes below them split the segments of one path.
+	*/
+	struct Node_s{
+		double Min[3], Max[3];
+		int Beg, End, Child;
+	};
+
+	const Boolean_t BuildTree();
+	void BuildPathNode(const int & NodeNum, const int & Beg, const int & End, vector<int> & PathOrder, const vector<vec3> & PathCenters);
+	void BuildNode(const int & NodeNum, vector<vec3> & Centroids, vector<int> & SegNums);
+	const vec3 ClosestPointFrom(const int & RootNum, const vec3 & CheckPt, int & PathNum, int & PtNum, double & Dist) const;
+
+	vector<Node_s> m_Nodes;
+	vector<vec3> m_SegBeg, m_SegEnd;
+	vector<int> m_SegPathNum, m_SegPtNum;
+	// Root node of each path's subtree by path number, or -1.
+	vector<int> m_PathRoots;
+};
+
+/*
+*	A finished gradient path stored as only the points needed to
+*	reproduce it, and evaluated anywhere along it by cubic Hermite
+*	interpolation in arc length.
+*
+*	Build() drops points where the path is straight and rho changes
+*	steadily, and keeps them where it curves or rho changes quickly
+*	(near CPs), so a path usually needs far fewer points than a
+*	fixed-count resample and loses less where it matters. Positions use
+*	Catmull-Rom tangents. Rho uses monotone (Fritsch-Butland) slopes, so
+*	it stays monotone between points and ArcLengthAtRho() is well defined.
+*	Arc lengths are those of the original path.
+*/
+class CompactGradPath_c
+{
+public:
+	CompactGradPath_c(){ m_StartEndCPNum[0] = m_StartEndCPNum[1] = -1; }
+
+	/*
+	*	Keep enough points of GP (or path PathNum of GPs) that
+	*	interpolating linearly between kept points puts every dropped
+	*	point within Tol times the path length of where it was, and its
+	*	rho within RhoTol times its rho. Paths that weren't made give an
+	*	empty compact path.
+	*/
+	const Boolean_t Build(const GradPathBase_c & GP, const double & Tol = GP_CompactTol, const double & RhoTol = GP_CompactRhoTol);
+	const Boolean_t Build(const GradPathSet_c & GPs, const int & PathNum, const double & Tol = GP_CompactTol, const double & RhoTol = GP_CompactRhoTol);
+	void Clear();
+
+	const Boolean_t IsMade() const { return m_S.size() > 1; }
+	// Number of points kept.
+	const int GetCount() const { return static_cast<int>(m_S.size()); }
+	const double GetLength() const { return IsMade() ? m_S.back() : 0.0; }
+	const int GetStartEndCPNum(const unsigned int & i) const { REQUIRE(i < 2); return m_StartEndCPNum[i]; }
+
+	/*
+	*	Position and rho at a distance ArcLength along the path, which
+	*	is clamped to the path. O(log n).
+	*/
+	const vec3 XYZAt(const double & ArcLength) const;
+	const double RhoAt(const double & ArcLength) const;
+	// Distance along the path where rho is Rho, or -1 if it's outside the path's range of rho.
+	const double ArcLengthAtRho(const double & Rho) const;
+
+	/*
+	*	NumPoints points evenly spaced in arc length, like
+	*	GradPathBase_c::Resample() gives.
+	*/
+	const Boolean_t Sample(const int & NumPoints, vector<vec3> & XYZList, vector<double> & RhoList) const;
+	const Boolean_t Sample(const int & NumPoints, GradPathBase_c & GP) const;
+
+private:
+	template <typename GetPointFunc>
+	const Boolean_t BuildFromPoints(const int & Count, GetPointFunc GetPoint, const double & Tol, const double & RhoTol);
+	const int Interval(const double & ArcLength) const;
+	void Eval(const int & k, const double & ArcLength, vec3 * Pt, double * Rho) const;
+
+	vector<double> m_S, m_X, m_Y, m_Z, m_Rho;
+	int m_StartEndCPNum[2];
+};
+
+/*
+*	Time GradPath_c::Seed() for NumGPs paths, seeded at the same random
+*	points in the volume, with each integrator in GPIntegrator_e at the
+*	default tolerances. SeedTimes gets the wall times in seconds
+*	(GSL rk4 first), NumSteps the total number of path points, and
+*	MaxEndPointDiff the largest distance between a path's end points
+*	and those of the GSL rk4 run. Paths that failed in the GSL rk4 run
+*	aren't compared. NumOverTol counts the paths whose end points moved
+*	more than GP_BenchmarkEndPointTol times the smallest grid spacing.
+*/
+const Boolean_t BenchmarkGradPathIntegrators(const std::shared_ptr<const VolExtentInfo_s> & VolInfo,
+	const FieldDataPointer_c & RhoPtr,
+	const vector<FieldDataPointer_c> & GradPtrs,
+	const int & NumGPs,
+	vector<double> & SeedTimes,
+	vector<int> & NumSteps,
+	vector<double> & MaxEndPointDiff,
+	vector<int> & NumOverTol,
+	const AddOn_pa * AddOnID = NULL);
+
 const Boolean_t GPsStraddleIB(const GradPath_c & GP1,
 	const GradPath_c & GP2,
 	const double & IBCheckAngle,
 	const double & IBCheckDistRatio);
 
-const Boolean_t CPInNormalPlane(vec3 & StartPt, const vec3 & PlaneBasis, MultiRootObjects_s & MR);
+const Boolean_t CPInNormalPlane(vec3 & StartPt, const vec3 & PlaneBasis, MultiRootParams_s & Params);
 
 
 class NEBGradPath_c : public GradPathBase_c
@@ -355,13 +824,47 @@ public:
 		const vec3 & EndPt, 
 		const unsigned int & NumPts);
 
+	/*
+	*	Relax the interior images until they move less than Tol in total.
+	*	Images are relaxed in two sweeps per iteration (odd then even),
+	*	and the images in a sweep don't depend on each other, so each
+	*	sweep runs in parallel.
+	*/
 	const Boolean_t Relax(const double & StepRatio,
 		const double & Tol, 
 		const unsigned int MaxIter,
 		MultiRootParams_s & Params);
 
+	/*
+	*	Climbing image: once StartIter iterations have been done, the
+	*	highest-rho interior image is freed from its spring and moved
+	*	uphill along the band instead, so it converges to the maximum
+	*	(i.e. the saddle) rather than staying evenly spaced.
+	*/
+	void SetClimbingImage(const Boolean_t & DoClimb, const unsigned int StartIter = 3){ m_ClimbingImage = DoClimb; m_ClimbStartIter = StartIter; }
+	const int GetClimbingImage() const { return m_ClimbIndex; }
+
 private:
+	NEBGradPath_c(const NEBGradPath_c &) = delete;
+	NEBGradPath_c & operator=(const NEBGradPath_c &) = delete;
+
+	/*
+	*	Per-thread parameters, kept between calls to Relax().
+	*/
+	struct Workspace_s{
+		MultiRootParams_s Params;
+		VolExtentIndexWeights_s VolInfo;
+	};
+
+	void SetupWorkspaces(const int & NumThreads, const MultiRootParams_s & Params);
+	void ClimbImage(const int & i, Workspace_s & WS);
+
+	vector<Workspace_s> m_Workspaces;
+	vector<vec3> m_OldXYZ, m_EquilPos;
 
+	Boolean_t m_ClimbingImage = FALSE;
+	unsigned int m_ClimbStartIter = 3;
+	int m_ClimbIndex = -1;
 };
 
 
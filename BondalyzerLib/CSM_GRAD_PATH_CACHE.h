@@ -0,0 +1,144 @@
+#pragma once
+#ifndef CSMGRADPATHCACHE_H_
+#define CSMGRADPATHCACHE_H_
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+#include "CSM_DATA_TYPES.h"
+#include "CSM_FIELD_DATA_POINTER.h"
+#include "CSM_VOL_EXTENT_INDEX_WEIGHTS.h"
+#include "CSM_GRAD_PATH.h"
+
+#include <armadillo>
+using namespace arma;
+
+using std::vector;
+using std::string;
+
+/*
+*	If this environment variable names a directory, GBA keeps a
+*	gradient path cache there.
+*/
+#define GPCache_DirEnvVar		"BONDALYZER_GP_CACHE_DIR"
+#define GPCache_FileExtension	".gpc"
+
+/*
+*	64-bit hash, fed any number of values or blocks of memory.
+*	Not cryptographic; just well enough mixed that different volumes
+*	or settings won't collide in practice.
+*/
+class CacheHash_c{
+public:
+	CacheHash_c(){}
+
+	void Add(const void * Data, const size_t & NumBytes);
+	template <typename T> void Add(const T & Value){ Add(&Value, sizeof(T)); }
+	void Add(const vec3 & Vec){ Add(Vec.memptr(), 3 * sizeof(double)); }
+	void Add(const mat33 & Mat){ Add(Mat.memptr(), 9 * sizeof(double)); }
+	void Add(const vector<int> & Vec){ Add(static_cast<int>(Vec.size())); if (!Vec.empty()) Add(Vec.data(), Vec.size() * sizeof(int)); }
+	// The values the pointer points to, and their type and dimensions.
+	void Add(const FieldDataPointer_c & Ptr);
+
+	const uint64_t Value() const { return m_Hash; }
+
+private:
+	uint64_t m_Hash = 0xcbf29ce484222325ULL;
+};
+
+/*
+*	On-disk cache of finished (resampled) gradient paths.
+*
+*	A gradient path depends only on the volume data, its seed point and
+*	its SetupGradPath() settings (direction, number of points, termination,
+*	integrator and so on), so for a given volume and settings the cache
+*	maps seed points to paths. Each volume and settings pair gets its own
+*	file in the cache directory, named by the hash of the volume data and
+*	the settings, so reruns with other settings never see stale paths.
+*
+*	Files are a short header then one record per path: the seed point,
+*	start and end CP numbers, the number of points, then the X, Y, Z and rho
+*	arrays. Open() reads the whole file in one go and indexes it by seed;
+*	Add() buffers new paths and Flush() appends them. Paths that couldn't
+*	be made are cached too (with no points), so they aren't retried.
+*
+*	The file is read rather than memory mapped. A rerun looks up every
+*	path in it, so mapping wouldn't save any reading, and the file is
+*	small next to the volume data. Holding it in memory also lets
+*	Flush() append to it, or write over a damaged file, without
+*	remapping, and needs no platform specific code.
+*
+*	Find() may be called from several threads at once, as may Add(),
+*	but the two shouldn't be mixed between Open() and Flush(). Several
+*	processes shouldn't write the same file at the same time.
+*/
+class GradPathCache_c{
+public:
+	GradPathCache_c(){}
+	~GradPathCache_c(){ Close(); }
+
+	/*
+	*	Open (or start) the cache file in CacheDir for paths set up like
+	*	SetupGP; only its settings and volume are used, not its seed.
+	*	The volume hash is kept, so opening again for the same volume
+	*	(e.g. the next GBA sphere) doesn't rehash it.
+	*/
+	const Boolean_t Open(const string & CacheDir, const GradPath_c & SetupGP);
+	// Write any new paths and close the file.
+	void Close();
+	const Boolean_t IsOpen() const { return m_IsOpen; }
+
+	/*
+	*	Copy the cached path seeded at SeedPt into slot PathNum of GPs,
+	*	or into GP. Returns FALSE if it isn't cached.
+	*/
+	const Boolean_t Find(const vec3 & SeedPt, GradPathSet_c & GPs, const int & PathNum) const;
+	const Boolean_t Find(const vec3 & SeedPt, GradPathBase_c & GP) const;
+
+	// Buffer path PathNum of GPs, or GP, seeded at SeedPt, for the next Flush().
+	void Add(const vec3 & SeedPt, const GradPathSet_c & GPs, const int & PathNum);
+	void Add(const vec3 & SeedPt, const GradPathBase_c & GP);
+
+	// Append the buffered paths to the file.
+	const Boolean_t Flush();
+
+	const int NumPaths() const { return static_cast<int>(m_Index.size()); }
+	const string & FileName() const { return m_FileName; }
+
+private:
+	const uint64_t VolumeKey(const GradPath_c & SetupGP);
+	const uint64_t SettingsKey(const GradPath_c & SetupGP) const;
+	const size_t FindRecord(const vec3 & SeedPt) const;
+	void AddRecord(const vec3 & SeedPt,
+		const int StartEndCPNum[2],
+		const int & Count,
+		const double * X, const double * Y, const double * Z, const double * Rho);
+
+	Boolean_t m_IsOpen = FALSE;
+	string m_FileName;
+	uint64_t m_Key = 0;
+
+	/*
+	*	Contents of the file when opened (valid records only), and the
+	*	offset in it of each record, by hash of its seed point.
+	*	m_FileIsGood is false if the file has to be rewritten rather
+	*	than appended to (it was missing, or ended in a partial record).
+	*/
+	vector<char> m_Data;
+	std::unordered_multimap<uint64_t, size_t> m_Index;
+	Boolean_t m_FileIsGood = FALSE;
+
+	// Records added since the last Flush(), in file format.
+	vector<char> m_NewData;
+
+	/*
+	*	Volume hash, and what it was computed for.
+	*/
+	uint64_t m_VolKey = 0;
+	vector<const void*> m_VolKeyPtrs;
+	vector<unsigned int> m_VolKeySizes;
+};
+
+#endif
@@ -0,0 +1,222 @@
+#pragma once
+#ifndef CSMNODERECORDCACHE_H_
+#define CSMNODERECORDCACHE_H_
+
+#include <vector>
+#include <memory>
+
+#include "CSM_FIELD_DATA_POINTER.h"
+#include "CSM_VOL_EXTENT_INDEX_WEIGHTS.h"
+
+using std::vector;
+
+#define NodeRecordCache_Alignment	64
+#define NodeRecordCache_MaxNumBytes	4e9
+#define NodeRecordCache_BrickDim	4
+#define NodeRecordCache_MortonTileDim	16
+
+/*
+*	Order of the records in memory.
+*	Linear is Tecplot's IJK order, so a step in K jumps MaxI*MaxJ records.
+*	Bricked stores BrickDim^3 blocks of nodes contiguously (IJK order
+*	within and between bricks), so the 8 corners of a cell are at most
+*	a few pages apart.
+*	Morton orders nodes along a Z-order curve within MortonTileDim^3
+*	tiles (IJK order between tiles), so grids aren't padded up to a
+*	power of two in each dimension.
+*/
+enum NodeRecordLayout_e
+{
+	NodeRecordLayout_Linear = 0,
+	NodeRecordLayout_Bricked,
+	NodeRecordLayout_Morton,
+
+	NodeRecordLayout_Invalid = -1
+};
+
+/*
+*	Opt-in, interleaved copy of several nodal variables of an ordered zone.
+*	Tecplot stores each variable in its own array, so a trilinear lookup
+*	of rho, gradient and Hessian touches 8 nodes in each of 10 arrays.
+*	Here all variables for a node are stored contiguously
+*	(array of structures), so the same lookup touches 8 records of
+*	one or two cache lines each.
+*
+*	Values are stored as double regardless of the source storage type,
+*	or optionally as float (SinglePrecision) to halve the footprint and
+*	the bandwidth of lookups. Interpolation is always done in double.
+*	The cache costs NumVars * 8 (or 4) bytes per node, so Build() refuses
+*	(returns FALSE) above NodeRecordCache_MaxNumBytes, and users
+*	should carry on with the FieldDataPointer_c's in that case.
+*
+*	Records are always looked up by the linear node index that
+*	GetIndexAndWeightsForPoint() gives, so the layout is invisible
+*	to users of the cache. Non-linear layouts need an ordered zone.
+*/
+class NodeRecordCache_c{
+public:
+	NodeRecordCache_c(){}
+	~NodeRecordCache_c(){ Clear(); }
+
+	/*
+	*	Pack an arbitrary list of variables. Record offsets match the
+	*	order of Ptrs.
+	*/
+	const Boolean_t Build(const vector<FieldDataPointer_c> & Ptrs,
+		const AddOn_pa * AddOnID = NULL,
+		const NodeRecordLayout_e & Layout = NodeRecordLayout_Linear,
+		const Boolean_t & SinglePrecision = FALSE);
+	/*
+	*	Pack rho, gradient (if 3 pointers) and Hessian (if 6 pointers)
+	*	in that order. Offsets are available from RhoOffset(),
+	*	GradOffset() and HessOffset().
+	*/
+	const Boolean_t Build(const FieldDataPointer_c & RhoPtr,
+		const vector<FieldDataPointer_c> & GradPtrs,
+		const vector<FieldDataPointer_c> & HessPtrs,
+		const AddOn_pa * AddOnID = NULL,
+		const NodeRecordLayout_e & Layout = NodeRecordLayout_Linear,
+		const Boolean_t & SinglePrecision = FALSE);
+	void Clear();
+
+	const Boolean_t IsReady() const { return m_IsReady; }
+	const int NumVars() const { return m_NumVars; }
+	const unsigned int NumNodes() const { return m_NumNodes; }
+	const Boolean_t HasRho() const { return m_RhoOffset >= 0; }
+	const Boolean_t HasGrad() const { return m_GradOffset >= 0; }
+	const Boolean_t HasHess() const { return m_HessOffset >= 0; }
+	const int RhoOffset() const { return m_RhoOffset; }
+	const int GradOffset() const { return m_GradOffset; }
+	const int HessOffset() const { return m_HessOffset; }
+	const NodeRecordLayout_e Layout() const { return m_Layout; }
+	const Boolean_t IsSinglePrecision() const { return m_DataFlt != NULL; }
+
+	/*
+	*	Position of a node's record given its linear (IJK) index.
+	*	The per-axis tables work for both bricks and Morton order
+	*	because both offsets are sums of independent I, J and K terms.
+	*/
+	const size_t RecordIndex(const unsigned int & NodeIndex) const{
+		if (m_Layout == NodeRecordLayout_Linear)
+			return static_cast<size_t>(NodeIndex);
+
+		unsigned int K = NodeIndex / m_NumNodesIJ;
+		unsigned int Rem = NodeIndex - K * m_NumNodesIJ;
+		unsigned int J = Rem / m_MaxIJK[0];
+		unsigned int I = Rem - J * m_MaxIJK[0];
+
+		return m_AxisOffsets[0][I] + m_AxisOffsets[1][J] + m_AxisOffsets[2][K];
+	}
+
+	/*
+	*	All NumVars() values of a single node.
+	*/
+	void ValsAtNode(const unsigned int & NodeIndex, double * Vals) const{
+		if (m_DataFlt != NULL) CopyRecord(m_DataFlt, NodeIndex, Vals);
+		else CopyRecord(m_Data, NodeIndex, Vals);
+	}
+	/*
+	*	Interpolate all NumVars() variables into Vals using the stencil.
+	*/
+	void ValsByIndexAndWeights(const IndexWeights_s & Stencil, double * Vals) const{
+		ValsByIndexAndWeights(Stencil, 0, m_NumVars, Vals);
+	}
+	/*
+	*	Interpolate NumVals consecutive variables starting at Offset.
+	*/
+	void ValsByIndexAndWeights(const IndexWeights_s & Stencil, const int & Offset, const int & NumVals, double * Vals) const{
+		if (m_DataFlt != NULL) GatherRecords(m_DataFlt, Stencil, Offset, NumVals, Vals);
+		else GatherRecords(m_Data, Stencil, Offset, NumVals, Vals);
+	}
+	const double ValByIndexAndWeights(const IndexWeights_s & Stencil, const int & Offset) const{
+		double Value;
+		ValsByIndexAndWeights(Stencil, Offset, 1, &Value);
+		return Value;
+	}
+	/*
+	*	ValsByIndexAndWeights() for NumLanes stencils at once, stored as
+	*	structure of arrays: corner c of lane l is Index[c * Stride + l]
+	*	with weight Weights[c * Stride + l], and variable v of lane l
+	*	goes to Vals[v * Stride + l].
+	*/
+	void LaneValsByIndexAndWeights(const int * Index, const double * Weights, const int & Stride, const int & NumLanes, const int & Offset, const int & NumVals, double * Vals) const{
+		if (m_DataFlt != NULL) GatherLaneRecords(m_DataFlt, Index, Weights, Stride, NumLanes, Offset, NumVals, Vals);
+		else GatherLaneRecords(m_Data, Index, Weights, Stride, NumLanes, Offset, NumVals, Vals);
+	}
+
+private:
+	template <typename T>
+	void CopyRecord(const T * Data, const unsigned int & NodeIndex, double * Vals) const{
+		const T * Rec = Data + RecordIndex(NodeIndex) * m_NumVars;
+		for (int v = 0; v < m_NumVars; ++v) Vals[v] = static_cast<double>(Rec[v]);
+	}
+	template <typename T>
+	void GatherRecords(const T * Data, const IndexWeights_s & Stencil, const int & Offset, const int & NumVals, double * Vals) const{
+		for (int v = 0; v < NumVals; ++v) Vals[v] = 0.0;
+		for (int i = 0; i < 8; ++i){
+			const T * Rec = Data + RecordIndex(Stencil.Index[i]) * m_NumVars + Offset;
+			const double Weight = Stencil.Weights[i];
+			for (int v = 0; v < NumVals; ++v) Vals[v] += Weight * static_cast<double>(Rec[v]);
+		}
+	}
+	template <typename T>
+	void GatherLaneRecords(const T * Data, const int * Index, const double * Weights, const int & Stride, const int & NumLanes, const int & Offset, const int & NumVals, double * Vals) const{
+		for (int v = 0; v < NumVals; ++v){
+			for (int l = 0; l < NumLanes; ++l) Vals[v * Stride + l] = 0.0;
+		}
+		for (int i = 0; i < 8; ++i){
+			const int * IndexI = Index + i * Stride;
+			const double * WeightsI = Weights + i * Stride;
+			for (int l = 0; l < NumLanes; ++l){
+				const T * Rec = Data + RecordIndex(IndexI[l]) * m_NumVars + Offset;
+				for (int v = 0; v < NumVals; ++v) Vals[v * Stride + l] += WeightsI[l] * static_cast<double>(Rec[v]);
+			}
+		}
+	}
+
+	/*
+	*	Not copyable; share it by pointer.
+	*/
+	NodeRecordCache_c(const NodeRecordCache_c &);
+	NodeRecordCache_c & operator=(const NodeRecordCache_c &);
+
+	const size_t SetupLayout(const vector<int> & MaxIJK, const NodeRecordLayout_e & Layout);
+
+	vector<double> m_Buffer;
+	double * m_Data = NULL;
+	vector<float> m_BufferFlt;
+	float * m_DataFlt = NULL;
+
+	int m_NumVars = 0;
+	unsigned int m_NumNodes = 0;
+
+	int m_RhoOffset = -1;
+	int m_GradOffset = -1;
+	int m_HessOffset = -1;
+
+	NodeRecordLayout_e m_Layout = NodeRecordLayout_Linear;
+	unsigned int m_MaxIJK[3];
+	unsigned int m_NumNodesIJ = 0;
+	vector<size_t> m_AxisOffsets[3];
+
+	Boolean_t m_IsReady = FALSE;
+};
+
+/*
+*	Time GradPath_c::Seed() for NumGPs paths, seeded at the same random
+*	points in the volume, once without a cache and once for each layout
+*	in NodeRecordLayout_e. SeedTimes gets the wall times in seconds
+*	(uncached first), and MaxEndPointDiff the largest distance between
+*	a path's end points and those of the uncached run; paths that failed
+*	in the uncached run aren't compared. Layouts that
+*	couldn't be built get -1 for both and are skipped.
+*/
+const Boolean_t BenchmarkNodeRecordLayouts(const std::shared_ptr<const VolExtentInfo_s> & VolInfo,
+	const FieldDataPointer_c & RhoPtr,
+	const vector<FieldDataPointer_c> & GradPtrs,
+	const int & NumGPs,
+	vector<double> & SeedTimes,
+	vector<double> & MaxEndPointDiff,
+	const AddOn_pa * AddOnID = NULL);
+
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef CSMVOLUMEDATA_H_
+#define CSMVOLUMEDATA_H_
+
+#include <vector>
+#include <string>
+
+#include "CSM_FIELD_DATA_POINTER.h"
+#include "CSM_VOL_EXTENT_INDEX_WEIGHTS.h"
+
+using std::vector;
+using std::string;
+
+/*
+*	Volumetric data held in memory rather than in a Tecplot dataset,
+*	so that the numerics (FindCPs(), GradPath_c, ...) can run without
+*	Tecplot through FieldDataPointer_c's array backend.
+*
+*	Variables are stored as double in Tecplot's IJK order (I fastest).
+*	The grid is described the same way as an ordered zone: Origin is
+*	the first node and the columns of BasisVectors span the grid from
+*	the first to the last node along I, J and K.
+*	For periodic files (CHGCAR) the nodes don't repeat the first plane,
+*	so the last node is one step short of the next cell.
+*/
+class VolumeData_c{
+public:
+	VolumeData_c(){}
+
+	/*
+	*	Formatted Gaussian cube file. All the value blocks in the file
+	*	(e.g. density and gradient components, or several MOs) become
+	*	separate variables. Coordinates are left in the file's units.
+	*/
+	const Boolean_t ReadCubeFile(const string & FileName);
+	/*
+	*	VASP CHGCAR (or AECCAR/PARCHG) file. The first data block is the
+	*	charge density, divided by the cell volume as in DataLoader.
+	*	A spin density block, if present, becomes a second variable.
+	*/
+	const Boolean_t ReadCHGCARFile(const string & FileName);
+	void Clear();
+
+	const Boolean_t AddVar(const string & Name, const vector<double> & Values);
+
+	const Boolean_t IsReady() const { return m_VarData.size() > 0; }
+	const Boolean_t IsPeriodic() const { return m_IsPeriodic; }
+	const int NumVars() const { return static_cast<int>(m_VarData.size()); }
+	const int VarIndex(const string & Name) const;
+	const string & VarName(const int & VarIndex) const { REQUIRE(VarIndex >= 0 && VarIndex < m_VarNames.size()); return m_VarNames[VarIndex]; }
+	const vector<int> & MaxIJK() const { return m_MaxIJK; }
+	const vec3 & Origin() const { return m_Origin; }
+	const mat33 & BasisVectors() const { return m_BasisVectors; }
+	const unsigned int NumNodes() const { return m_MaxIJK[0] * m_MaxIJK[1] * m_MaxIJK[2]; }
+
+	/*
+	*	Atomic numbers from cube files. CHGCAR files only list atom
+	*	types, so there these are the (1-based) type numbers.
+	*/
+	const vector<int> & AtomicNumbers() const { return m_AtomicNumbers; }
+	const vector<vec3> & AtomPositions() const { return m_AtomPositions; }
+
+	const Boolean_t GetReadPtr(const int & VarIndex, FieldDataPointer_c & Ptr) const;
+	const Boolean_t GetVolInfo(VolExtentInfo_s & VolInfo) const;
+
+private:
+	vector<int> m_MaxIJK = vector<int>(3, 0);
+	vec3 m_Origin;
+	mat33 m_BasisVectors;
+	Boolean_t m_IsPeriodic = FALSE;
+
+	vector<vector<double> > m_VarData;
+	vector<string> m_VarNames;
+
+	vector<int> m_AtomicNumbers;
+	vector<vec3> m_AtomPositions;
+};
+
+#endif
@@ -14,8 +14,33 @@ using std::string;
 #include <armadillo>
 using namespace arma;
 
+#define VolInfo_MaxGatherVars	16
+#define VolInfo_OrthogonalTol	1e-10
 
-struct VolExtentIndexWeights_s{
+/*
+*	Shape of the lattice, found by GetVolInfo().
+*	Orthogonal grids have basis vectors along X, Y and Z, so a point's
+*	cell is found by scaling each coordinate independently.
+*	Cubic grids are orthogonal with the same spacing along all three axes.
+*	Anything else (or a VolExtentInfo_s not filled by GetVolInfo())
+*	is General and goes through BasisInverse.
+*/
+enum VolGridType_e
+{
+	VolGridType_General = 0,
+	VolGridType_Orthogonal,
+	VolGridType_Cubic,
+
+	VolGridType_Invalid = -1
+};
+
+/*
+*	Geometry of an ordered volume zone.
+*	Doesn't change once GetVolInfo() has filled it, so a single
+*	instance can be shared (const) by any number of threads or
+*	gradient paths.
+*/
+struct VolExtentInfo_s{
 	vector<int> MaxIJK;
 	vec3 MaxXYZ;
 	vec3 MinXYZ;
@@ -26,14 +51,43 @@ struct VolExtentIndexWeights_s{
 	vec3 BasisExtent;
 	Boolean_t IsPeriodic;
 
+	VolGridType_e GridType = VolGridType_General;
+	/*
+	*	Nodes per unit length along each axis, i.e. (MaxIJK - 1) / extent.
+	*	Only meaningful for orthogonal and cubic grids.
+	*/
+	double IJKPerXYZ[3] = { 0., 0., 0. };
+
 	AddOn_pa AddOnID;
 
+	VolExtentInfo_s(){
+		MaxIJK.resize(3);
+	}
+	void SetGridType();
+	const Boolean_t operator==(const VolExtentInfo_s & rhs) const;
+};
+
+/*
+*	Interpolation stencil for a single point: the indices of
+*	the 8 surrounding nodes and their trilinear weights.
+*	Small enough to live on the stack of whoever does the lookup.
+*/
+struct IndexWeights_s{
 	int Index[8];
 	double Weights[8];
 
-	VolExtentIndexWeights_s(){ 
-		MaxIJK.resize(3); 
-	}
+	const Boolean_t operator==(const IndexWeights_s & rhs) const;
+};
+
+/*
+*	Grid plus "current" stencil, as used by the older interfaces
+*	(MultiRootParams_s, FESurface_c, etc.). New code that only
+*	needs the grid should take a const VolExtentInfo_s and keep
+*	its own IndexWeights_s.
+*/
+struct VolExtentIndexWeights_s : public VolExtentInfo_s, public IndexWeights_s{
+	VolExtentIndexWeights_s(){}
+	VolExtentIndexWeights_s(const VolExtentInfo_s & rhs) : VolExtentInfo_s(rhs){}
 	VolExtentIndexWeights_s & operator=(const VolExtentIndexWeights_s & rhs);
 	const Boolean_t operator==(const VolExtentIndexWeights_s & rhs) const;
 
@@ -42,14 +96,104 @@ struct VolExtentIndexWeights_s{
 const Boolean_t GetVolInfo(const int & VolZoneNum,
 	const vector<int> & XYZVarNums,
 	const Boolean_t & IsPeriodic,
-	VolExtentIndexWeights_s & VolInfo);
+	VolExtentInfo_s & VolInfo);
+/*
+*	Same, for a grid that isn't a Tecplot zone (e.g. read by
+*	VolumeData_c). BasisVectors columns span the grid from the first
+*	to the last node along I, J and K, and Origin is the first node.
+*/
+const Boolean_t GetVolInfo(const vector<int> & MaxIJK,
+	const vec3 & Origin,
+	const mat33 & BasisVectors,
+	const Boolean_t & IsPeriodic,
+	VolExtentInfo_s & VolInfo);
+
+/*
+*	Lattice vectors of a periodic grid. Periodic data (e.g. CHGCAR)
+*	doesn't repeat the first plane of nodes, so the period along each
+*	axis is MaxIJK node steps, one more than BasisVectors spans.
+*/
+const mat33 PeriodicLatticeVectors(const VolExtentInfo_s & VolInfo);
 
+const Boolean_t GetIndexAndWeightsForPoint(vec3 Point, const VolExtentInfo_s & VolInfo, IndexWeights_s & Stencil);
+/*
+*	Point location for a known grid type, so a kernel that handles many
+*	points can switch on VolInfo.GridType once instead of per point.
+*	Instantiated for all three grid types in csm_vol_extent_index_weights.cpp.
+*/
+template <VolGridType_e GridType>
+const Boolean_t GetIndexAndWeightsForPointOnGrid(const vec3 & Point, const VolExtentInfo_s & VolInfo, IndexWeights_s & Stencil);
+void GetGridCoordsForPoint(const vec3 & Point, const VolExtentInfo_s & VolInfo, double * Coords);
 const Boolean_t SetIndexAndWeightsForPoint(vec3 Point, VolExtentIndexWeights_s & SysInfo);
-const vector<int> GetIJKForPoint(vec3 & Point, VolExtentIndexWeights_s & VolZoneInfo);
+const vector<int> GetIJKForPoint(vec3 & Point, const VolExtentInfo_s & VolZoneInfo);
 void GetCellCornerIndices(const int & CornerNum, int & i, int & j, int & k);
 
-const double ValByCurrentIndexAndWeightsFromRawPtr(const VolExtentIndexWeights_s & VolZoneInfo, const FieldDataPointer_c & FDPtr);
+/*
+*	Trilinear interpolation from a raw pointer of known type
+*	using the current index and weights.
+*	ValByCurrentIndexAndWeightsFromRawPtr() switches on the storage
+*	type once and calls this, so the 8 reads are branch-free.
+*/
+template <typename T>
+inline const double ValByCurrentIndexAndWeights(const IndexWeights_s & Stencil, const T * Ptr)
+{
+	double Value = 0.0;
+	for (int i = 0; i < 8; ++i){
+		Value += Stencil.Weights[i] * static_cast<double>(Ptr[Stencil.Index[i]]);
+	}
+	return Value;
+}
+
+const double ValByCurrentIndexAndWeightsFromRawPtr(const IndexWeights_s & Stencil, const FieldDataPointer_c & FDPtr);
+
+/*
+*	Batched version of the above for several variables at the same point.
+*	Corners are the outer loop so the index and weight are loaded once
+*	and all variables are read from the same node together.
+*/
+template <typename T>
+inline void ValsByCurrentIndexAndWeights(const IndexWeights_s & Stencil, const T * const * Ptrs, const int & NumVars, double * Vals)
+{
+	for (int v = 0; v < NumVars; ++v) Vals[v] = 0.0;
+	for (int i = 0; i < 8; ++i){
+		const int Ind = Stencil.Index[i];
+		const double Weight = Stencil.Weights[i];
+		for (int v = 0; v < NumVars; ++v){
+			Vals[v] += Weight * static_cast<double>(Ptrs[v][Ind]);
+		}
+	}
+}
+
+/*
+*	Interpolate NumPtrs variables (at most VolInfo_MaxGatherVars) using
+*	a single pass over the current stencil. Vals must hold NumPtrs values.
+*	Falls back to one gather per variable if the storage types differ.
+*/
+void ValsByCurrentIndexAndWeightsFromRawPtrs(const IndexWeights_s & Stencil,
+	const FieldDataPointer_c * const * FDPtrs,
+	const int & NumPtrs,
+	double * Vals);
+void ValsByCurrentIndexAndWeightsFromRawPtrs(const IndexWeights_s & Stencil,
+	const vector<FieldDataPointer_c> & FDPtrs,
+	double * Vals);
 
 const double ValAtPointByPtr(vec3 & Point, VolExtentIndexWeights_s & VolZoneInfo, const FieldDataPointer_c & FDPtr);
 
+/*
+*	Tricubic (Catmull-Rom, i.e. Hermite with central difference
+*	derivatives) interpolation of FDPtr at Point, which is C1 across
+*	cells, unlike the trilinear interpolant.
+*	Value, gradient and Hessian all come from the same 64 coefficients,
+*	which are kept in Cell and only recomputed when Point moves to a
+*	different cell (or FDPtr changes).
+*	Grad and Hess are optional and in XYZ (not IJK) coordinates.
+*/
+const Boolean_t TricubicValGradHessForPoint(vec3 Point,
+	const VolExtentInfo_s & VolInfo,
+	const FieldDataPointer_c & FDPtr,
+	TricubicCell_s & Cell,
+	double & Value,
+	vec3 * Grad = NULL,
+	mat33 * Hess = NULL);
+
 #endif
\ No newline at end of file
@@ -7,15 +7,18 @@
 #include <omp.h>
 
 //#include <gsl/gsl_math.h>
+#ifndef CSM_NO_GSL
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_eigen.h>
+#endif
 
 #include "TECADDON.h"
 #include "CSM_DATA_TYPES.h"
 #include "CSM_CRIT_POINTS.h"
 #include "CSM_DATA_SET_INFO.h"
 #include "CSM_VOL_EXTENT_INDEX_WEIGHTS.h"
+#include "CSM_NODE_RECORD_CACHE.h"
 
 #include "CSM_CALC_VARS.h"
 
@@ -312,112 +315,132 @@ const Boolean_t CalcMagForRegularVectorVar(const vector<int> & IJKMax,
 	return !TaskQuit;
 }
 
-void CalcGradForNode(const int & ii,
+/*
+*	Derivative along Dir at node ii, jj, kk of the values returned by
+*	GetVal(I, J, K), where I, J, K can be up to two past the edge of a
+*	periodic zone.
+*	Shared by CalcGradForNode(), which gets the values from a field data
+*	pointer, and CalcVarsForVolumeNodes(), which gets them from a buffer.
+*/
+template <typename GetVal_t>
+static const double FiniteDiffForNode(const int & ii,
 	const int & jj,
 	const int & kk,
+	const int & Dir,
 	const vec3 & DelXYZx2,
 	const vec3 & DelXYZx12,
 	vector<double> & Vals,
 	vector<int> & DirInd,
-	const int & StartDir,
 	const vector<int> & IJKMax,
 	const Boolean_t & IsPeriodic,
-	const FieldDataPointer_c & VarReadPtr,
-	vec3 & OutValues)
+	const GetVal_t & GetVal)
 {
-	for (int Dir = 0; Dir < 3; ++Dir){
-		/*
-		*	Use a combination of four potential methods for approximating
-		*	derivative:
-		*		0. High accuracy centered divided difference
-		*		1. Centered divided difference
-		*		2. High accuracy forward divided difference
-		*		3. High accuracy backward divided difference
-		*	Which is used depends on how close the point is to the system
-		*	boundary (only for non-periodic systems, periodic always get
-		*	high accuracy centered).
-		*	If not periodic:
-		*		Points on the boundary get the high accuracy forward or
-		*			backward method
-		*		Points 1 away from the boundary get the regular centered
-		*		Points 2 or more away from the boundary get the centered
-		*			high accuracy method
-		*/
+	/*
+	*	Use a combination of four potential methods for approximating
+	*	derivative:
+	*		0. High accuracy centered divided difference
+	*		1. Centered divided difference
+	*		2. High accuracy forward divided difference
+	*		3. High accuracy backward divided difference
+	*	Which is used depends on how close the point is to the system
+	*	boundary (only for non-periodic systems, periodic always get
+	*	high accuracy centered).
+	*	If not periodic:
+	*		Points on the boundary get the high accuracy forward or
+	*			backward method
+	*		Points 1 away from the boundary get the regular centered
+	*		Points 2 or more away from the boundary get the centered
+	*			high accuracy method
+	*/
 
-		int Method = 0;
-		/*
-		*	The 5 elements of DirInd of I,J,K are for the
-		*	minus 2, minus 1, plus 0, plus 1, plus 2
-		*	respectively.
-		*/
+	int Method = 0;
+	/*
+	*	The 5 elements of DirInd of I,J,K are for the
+	*	minus 2, minus 1, plus 0, plus 1, plus 2
+	*	respectively.
+	*/
 
-		switch (Dir){
-			case 0:
-				for (int i = 0; i < 5; ++i)
-					DirInd[i] = ii + i - 2;
-				break;
-			case 1:
-				for (int i = 0; i < 5; ++i)
-					DirInd[i] = jj + i - 2;
-				break;
-			case 2:
-				for (int i = 0; i < 5; ++i)
-					DirInd[i] = kk + i - 2;
-				break;
-		}
+	switch (Dir){
+		case 0:
+			for (int i = 0; i < 5; ++i)
+				DirInd[i] = ii + i - 2;
+			break;
+		case 1:
+			for (int i = 0; i < 5; ++i)
+				DirInd[i] = jj + i - 2;
+			break;
+		case 2:
+			for (int i = 0; i < 5; ++i)
+				DirInd[i] = kk + i - 2;
+			break;
+	}
 
-		if (!IsPeriodic && (DirInd[2] <= 2 || DirInd[2] >= IJKMax[Dir] - 1)){
-			if (DirInd[2] == 1){
-				Method = 2;
-			}
-			else if (DirInd[2] == IJKMax[Dir]){
-				Method = 3;
-			}
-			else{ // point is 1 away from boundary
-				Method = 1;
-			}
+	if (!IsPeriodic && (DirInd[2] <= 2 || DirInd[2] >= IJKMax[Dir] - 1)){
+		if (DirInd[2] == 1){
+			Method = 2;
+		}
+		else if (DirInd[2] == IJKMax[Dir]){
+			Method = 3;
 		}
+		else{ // point is 1 away from boundary
+			Method = 1;
+		}
+	}
 
-		/*
-		*	Get the values for the current of the variable at the points found.
-		*
-		*	Elements of Vals[] correspond to the
-		*	minus 2, minus 1, plus 0, plus 1, plus 2
-		*	points in the current direction.
-		*/
+	/*
+	*	Get the values for the current of the variable at the points found.
+	*
+	*	Elements of Vals[] correspond to the
+	*	minus 2, minus 1, plus 0, plus 1, plus 2
+	*	points in the current direction.
+	*/
 
-		switch (Dir){
-			case 0:
-				for (const int & i : ValInds[Method])
-					Vals[i] = VarReadPtr[IndexFromIJK(DirInd[i], jj, kk, IJKMax[0], IJKMax[1], IJKMax[2], IsPeriodic) - 1];
-				break;
-			case 1:
-				for (const int & i : ValInds[Method])
-					Vals[i] = VarReadPtr[IndexFromIJK(ii, DirInd[i], kk, IJKMax[0], IJKMax[1], IJKMax[2], IsPeriodic) - 1];
-				break;
-			case 2:
-				for (const int & i : ValInds[Method])
-					Vals[i] = VarReadPtr[IndexFromIJK(ii, jj, DirInd[i], IJKMax[0], IJKMax[1], IJKMax[2], IsPeriodic) - 1];
-				break;
-		}
+	switch (Dir){
+		case 0:
+			for (const int & i : ValInds[Method])
+				Vals[i] = GetVal(DirInd[i], jj, kk);
+			break;
+		case 1:
+			for (const int & i : ValInds[Method])
+				Vals[i] = GetVal(ii, DirInd[i], kk);
+			break;
+		case 2:
+			for (const int & i : ValInds[Method])
+				Vals[i] = GetVal(ii, jj, DirInd[i]);
+			break;
+	}
+
+	if (DelXYZx12[Dir] != 0){
+		switch (Method){
+			case 0: // High accuracy centered divided difference
+				return (-Vals[4] + 8.0 * (Vals[3] - Vals[1]) + Vals[0]) / DelXYZx12[Dir];
+			case 1: // Centered divided difference
+				return (Vals[3] - Vals[1]) / DelXYZx2[Dir];
+			case 2: // High accuracy forward divided difference
+				return (-Vals[4] + 4.0 * Vals[3] - 3.0 * Vals[2]) / DelXYZx2[Dir];
+			case 3: // High accuracy backward divided difference
+				return (3.0 * Vals[2] - 4.0 * Vals[1] + Vals[0]) / DelXYZx2[Dir];
+		}
+	}
+	return 0.;
+}
 
-		if (DelXYZx12[Dir] != 0){
-			switch (Method){
-				case 0: // High accuracy centered divided difference
-					OutValues[Dir] = (-Vals[4] + 8.0 * (Vals[3] - Vals[1]) + Vals[0]) / DelXYZx12[Dir];
-					break;
-				case 1: // Centered divided difference
-					OutValues[Dir] = (Vals[3] - Vals[1]) / DelXYZx2[Dir];
-					break;
-				case 2: // High accuracy forward divided difference
-					OutValues[Dir] = (-Vals[4] + 4.0 * Vals[3] - 3.0 * Vals[2]) / DelXYZx2[Dir];
-					break;
-				case 3: // High accuracy backward divided difference
-					OutValues[Dir] = (3.0 * Vals[2] - 4.0 * Vals[1] + Vals[0]) / DelXYZx2[Dir];
-					break;
-			}
-		}
-		else OutValues[Dir] = 0.;
+void CalcGradForNode(const int & ii,
+	const int & jj,
+	const int & kk,
+	const vec3 & DelXYZx2,
+	const vec3 & DelXYZx12,
+	vector<double> & Vals,
+	vector<int> & DirInd,
+	const int & StartDir,
+	const vector<int> & IJKMax,
+	const Boolean_t & IsPeriodic,
+	const FieldDataPointer_c & VarReadPtr,
+	vec3 & OutValues)
+{
+	for (int Dir = 0; Dir < 3; ++Dir){
+		OutValues[Dir] = FiniteDiffForNode(ii, jj, kk, Dir, DelXYZx2, DelXYZx12, Vals, DirInd, IJKMax, IsPeriodic,
+			[&](const int & I, const int & J, const int & K){ return VarReadPtr[IndexFromIJK(I, J, K, IJKMax[0], IJKMax[1], IJKMax[2], IsPeriodic) - 1]; });
 
 		/*
 		*	Here's the previous implementation, which uses a
@@ -466,7 +489,7 @@ void CalcGradForNode(const int & ii,
 
 void CalcGradForPoint(const vec3 & Point,
 	const vec3 & DelXYZ,
-	VolExtentIndexWeights_s & VolInfo,
+	const VolExtentInfo_s & VolInfo,
 	const mat33 & DirVects,
 	const int & StartDir,
 	const Boolean_t & IsPeriodic,
@@ -478,6 +501,7 @@ void CalcGradForPoint(const vec3 & Point,
 	double Vals[5];
 	vec3 Points[5];
 	vec3 DelXYZx2 = DelXYZ * 2, DelXYZx12 = DelXYZ * 12;
+	IndexWeights_s Stencil;
 
 	int NumDirs = sqrt(DirVects.size());
 
@@ -554,8 +578,8 @@ void CalcGradForPoint(const vec3 & Point,
 				case GPType_NEB:
 					Vals[i] = NEBForceFunction(Points[i], *reinterpret_cast<MultiRootParams_s*>(Params));
 				default:
-					SetIndexAndWeightsForPoint(Points[i], VolInfo);
-					Vals[i] = ValByCurrentIndexAndWeightsFromRawPtr(VolInfo, VarReadPtr);
+					GetIndexAndWeightsForPoint(Points[i], VolInfo, Stencil);
+					Vals[i] = ValByCurrentIndexAndWeightsFromRawPtr(Stencil, VarReadPtr);
 					break;
 			}
 		}
@@ -736,7 +760,7 @@ void CalcHessForNode(const int & ii,
 
 void CalcHessForPoint(const vec3 & Point,
 	const vec3 & DelXYZ,
-	VolExtentIndexWeights_s & VolInfo,
+	const VolExtentInfo_s & VolInfo,
 	const mat33 & DirVects,
 	const Boolean_t & IsPeriodic,
 	mat & OutValues,
@@ -852,7 +876,7 @@ void CalcHessForPoint(const vec3 & Point,
 
 void CalcHessFor3DPoint(const vec3 & Point,
 	const vec3 & DelXYZ,
-	VolExtentIndexWeights_s & VolInfo,
+	const VolExtentInfo_s & VolInfo,
 	const Boolean_t & IsPeriodic,
 	mat33 & Hess,
 	const vector<FieldDataPointer_c> & VarReadPtrs,
@@ -1236,13 +1260,19 @@ const Boolean_t CalcEigenSystemForPoint(vec3 & Point,
 			{ 2, 4, 5 }
 		};
 
+		double HessVals[6];
+		if (RootParams.Index >= 0){
+			for (int i = 0; i < 6; ++i)
+				HessVals[i] = RootParams.HessPtrs->at(i)[RootParams.Index];
+		}
+		else if (RootParams.NodeCache != NULL && RootParams.NodeCache->HasHess())
+			RootParams.NodeCache->ValsByIndexAndWeights(*RootParams.VolInfo, RootParams.NodeCache->HessOffset(), 6, HessVals);
+		else
+			ValsByCurrentIndexAndWeightsFromRawPtrs(*RootParams.VolInfo, *RootParams.HessPtrs, HessVals);
+
 		for (int i = 0; i < 3; ++i)
 		for (int j = 0; j < 3; ++j)
-		if (RootParams.Index >= 0)
-			Hessian.at(i, j) = RootParams.HessPtrs->at(HessIndices[i][j])[RootParams.Index];
-		// 					gsl_matrix_set(Hess, i, j, RootParams.HessPtrs->at(HessIndices[i][j])[RootParams.Index]);
-		else
-			Hessian.at(i, j) = ValByCurrentIndexAndWeightsFromRawPtr(*RootParams.VolInfo, RootParams.HessPtrs->at(HessIndices[i][j]));
+			Hessian.at(i, j) = HessVals[HessIndices[i][j]];
 		// 					gsl_matrix_set(Hess, i, j, ValByCurrentIndexAndWeightsFromRawPtr(*RootParams.VolInfo, RootParams.HessPtrs->at(HessIndices[i][j])));
 	}
 	else{
@@ -1251,7 +1281,18 @@ const Boolean_t CalcEigenSystemForPoint(vec3 & Point,
 		*	Need to do it manually, since the GSL solver doesn't know not to
 		*	go beyond the bounds of the system.
 		*/
-		if (!RootParams.HasGrad){
+		if (!RootParams.HasGrad && RootParams.UseTricubic){
+			/*
+			*	Analytic Hessian of the tricubic interpolant, projected
+			*	onto the basis directions.
+			*/
+			double Rho;
+			mat33 CartHessian;
+			if (!TricubicValGradHessForPoint(Point, *RootParams.VolInfo, *RootParams.RhoPtr, RootParams.TricubicCell, Rho, NULL, &CartHessian))
+				return FALSE;
+			Hessian = RootParams.BasisVectors->t() * CartHessian * *RootParams.BasisVectors;
+		}
+		else if (!RootParams.HasGrad){
 			CalcHessForPoint(Point,
 				RootParams.VolInfo->DelXYZ,
 				*RootParams.VolInfo,
@@ -2253,6 +2294,273 @@ void MapAllVarsToAllZones(const AddOn_pa & AddOnID)
 }
 
 
+/*
+*	Calculate every variable flagged in DoCalc (indexed by CalcVar_e) for
+*	all the nodes of an ordered volume zone in a single sweep, writing to
+*	OutPtrs (also indexed by CalcVar_e, each with as many pointers as the
+*	variable has components).
+*	The zone is done a k plane at a time. The gradient of each plane is
+*	computed once into a buffer that holds the two planes either side,
+*	which is all the Hessian stencil needs, and then each node's Hessian,
+*	eigen system and everything derived from them are calculated in
+*	registers and all outputs written together.
+*	Gradient, Hessian or eigen system variables already in the dataset
+*	are used instead of recalculating when their read pointers are ready
+*	and they aren't in DoCalc.
+*	The eigenvectors used for the eigenvector/gradient products and the
+*	Eberly functions are oriented as they are when read back from the
+*	eigen system variables if those are being written or are present,
+*	so the results match those of calculating the variables one at a time.
+*/
+const Boolean_t CalcVarsForVolumeNodes(const vector<Boolean_t> & DoCalc,
+	const CalcVarsOptions_s & Opt,
+	const vector<int> & MaxIJK,
+	const vec3 & DelXYZ,
+	const Boolean_t & IsPeriodic,
+	const FieldDataPointer_c & RhoPtr,
+	const vector<FieldDataPointer_c> & GradReadPtrs,
+	const vector<FieldDataPointer_c> & HessReadPtrs,
+	const vector<FieldDataPointer_c> & EigSysReadPtrs,
+	const vector<vector<FieldDataPointer_c> > & OutPtrs,
+	const string & StatusStr)
+{
+	Boolean_t IsOk = TRUE;
+
+	const int HessIndices[3][3] = {
+		{ 0, 1, 2 },
+		{ 1, 3, 4 },
+		{ 2, 4, 5 }
+	};
+
+	Boolean_t ReadGrad = (!DoCalc[CalcGradientVectors] && GradReadPtrs.size() == 3),
+		ReadHess = (!DoCalc[CalcHessian] && HessReadPtrs.size() == 6),
+		ReadEigSys = (!DoCalc[CalcEigenSystem] && EigSysReadPtrs.size() == 12);
+	for (const auto & i : GradReadPtrs) ReadGrad = (ReadGrad && i.IsReady());
+	for (const auto & i : HessReadPtrs) ReadHess = (ReadHess && i.IsReady());
+	for (const auto & i : EigSysReadPtrs) ReadEigSys = (ReadEigSys && i.IsReady());
+
+	Boolean_t NeedEigSys = FALSE;
+	for (int i = CalcEigenSystem; i <= CalcEigenRank; ++i)
+		NeedEigSys = (NeedEigSys || DoCalc[i]);
+
+	const Boolean_t CalcEigSys = DoCalc[CalcEigenSystem] || (NeedEigSys && !ReadEigSys),
+		CalcHess = DoCalc[CalcHessian] || (CalcEigSys && !ReadHess),
+		NeedGrad = DoCalc[CalcGradientVectors] || DoCalc[CalcGradientMagnitude] || DoCalc[CalcEigenVectorsDotGradient]
+			|| DoCalc[CalcEberly1Ridge] || DoCalc[CalcEberly2Ridge] || CalcHess,
+		EigSysIsStored = DoCalc[CalcEigenSystem] || ReadEigSys;
+
+	const int IMax = MaxIJK[0], JMax = MaxIJK[1], KMax = MaxIJK[2],
+		PlaneSize = IMax * JMax;
+	const vec3 DelXYZx2 = DelXYZ * 2,
+		DelXYZx12 = DelXYZ * 12;
+
+	/*
+	*	Gradient for the plane being done and, if the Hessian is needed,
+	*	the two planes either side. Plane K is in slot K mod NumSlots, so
+	*	moving up a plane only needs the gradient of one new plane.
+	*	A periodic zone starts with the buffer holding its last two planes
+	*	as planes -1 and 0.
+	*/
+	const int Halo = (CalcHess ? 2 : 0),
+		NumSlots = 2 * Halo + 1;
+	vector<vec3> GradBuf(NeedGrad ? NumSlots * PlaneSize : 0);
+
+	/*
+	*	Gradient at buffered node I, J, K, where the indices can be up to
+	*	two past the edge of a periodic zone.
+	*/
+	auto BufGrad = [&](int I, int J, const int & K) -> const vec3 & {
+		if (I < 1) I += IMax;
+		else if (I > IMax) I -= IMax;
+		if (J < 1) J += JMax;
+		else if (J > JMax) J -= JMax;
+		return GradBuf[((K + NumSlots) % NumSlots) * PlaneSize + (J - 1) * IMax + I - 1];
+	};
+
+	for (int kk = 1 - (IsPeriodic ? 2 : 1) * Halo; kk <= KMax && IsOk; ++kk){
+		/*
+		*	Fill the buffer for the plane Halo above this one.
+		*/
+		int kFill = kk + Halo;
+		if (NeedGrad && (IsPeriodic || kFill <= KMax)){
+			int kWrap = kFill;
+			if (kWrap > KMax) kWrap -= KMax;
+			else if (kWrap < 1) kWrap += KMax;
+#ifndef _DEBUG
+#pragma omp parallel for
+#endif
+			for (int jj = 1; jj <= JMax; ++jj){
+				vector<double> Vals(5);
+				vector<int> DirInd(5);
+				vec3 * Grad = &GradBuf[((kFill + NumSlots) % NumSlots) * PlaneSize + (jj - 1) * IMax];
+				for (int ii = 1; ii <= IMax; ++ii){
+					if (ReadGrad){
+						int Index = IndexFromIJK(ii, jj, kWrap, IMax, JMax) - 1;
+						for (int i = 0; i < 3; ++i)
+							Grad[ii - 1][i] = GradReadPtrs[i][Index];
+					}
+					else
+						CalcGradForNode(ii, jj, kWrap, DelXYZx2, DelXYZx12, Vals, DirInd, 0, MaxIJK, IsPeriodic, RhoPtr, Grad[ii - 1]);
+				}
+			}
+		}
+
+		if (kk < 1)
+			continue;
+
+		/*
+		*	Now everything else for the nodes of this plane.
+		*/
+#ifndef _DEBUG
+#pragma omp parallel for
+#endif
+		for (int jj = 1; jj <= JMax; ++jj){
+			vector<double> Vals(5);
+			vector<int> DirInd(5);
+			vec3 Grad, EigVals;
+			mat33 Hess, EigVecs;
+			double Dots[3];
+
+			for (int ii = 1; ii <= IMax; ++ii){
+				int Index = IndexFromIJK(ii, jj, kk, IMax, JMax) - 1;
+
+				if (NeedGrad)
+					Grad = BufGrad(ii, jj, kk);
+
+				if (CalcHess){
+					/*
+					*	Row i of the Hessian is the derivative of the ith gradient
+					*	component, with the lower triangle copied from the upper.
+					*/
+					for (int i = 0; i < 3; ++i){
+						for (int j = i; j < 3; ++j)
+							Hess.at(i, j) = FiniteDiffForNode(ii, jj, kk, j, DelXYZx2, DelXYZx12, Vals, DirInd, MaxIJK, IsPeriodic,
+								[&](const int & I, const int & J, const int & K){ return BufGrad(I, J, K)[i]; });
+						for (int j = 0; j < i; ++j)
+							Hess.at(i, j) = Hess.at(j, i);
+					}
+				}
+				else if (CalcEigSys){
+					for (int i = 0; i < 3; ++i)
+						for (int j = 0; j < 3; ++j)
+							Hess.at(i, j) = HessReadPtrs[HessIndices[i][j]][Index];
+				}
+
+				if (CalcEigSys){
+					eig_sym(EigVals, EigVecs, Hess);
+					EigVecs = mat33(normalise(EigVecs, 2, 1));
+				}
+				else if (NeedEigSys){
+					for (int i = 0; i < 3; ++i){
+						for (int j = 0; j < 3; ++j)
+							EigVecs.at(i, j) = EigSysReadPtrs[3 * i + j][Index];
+						EigVals[i] = EigSysReadPtrs[9 + i][Index];
+					}
+				}
+
+				if (DoCalc[CalcGradientVectors])
+					for (int i = 0; i < 3; ++i)
+						OutPtrs[CalcGradientVectors][i].Write(Index, Grad[i]);
+
+				if (DoCalc[CalcGradientMagnitude])
+					OutPtrs[CalcGradientMagnitude][0].Write(Index, norm(Grad));
+
+				if (DoCalc[CalcHessian])
+					for (int i = 0; i < 3; ++i)
+						for (int j = i; j < 3; ++j)
+							OutPtrs[CalcHessian][HessIndices[i][j]].Write(Index, Hess.at(i, j));
+
+				if (DoCalc[CalcEigenSystem]){
+					for (int i = 0; i < 3; ++i){
+						for (int j = 0; j < 3; ++j)
+							OutPtrs[CalcEigenSystem][3 * j + i].Write(Index, EigVecs.at(i, j));
+						OutPtrs[CalcEigenSystem][9 + i].Write(Index, EigVals[i]);
+					}
+				}
+
+				/*
+				*	Eigenvectors as the rest would have read them back from
+				*	the eigen system variables.
+				*/
+				if (CalcEigSys && EigSysIsStored)
+					EigVecs = mat33(EigVecs.t());
+
+				if (DoCalc[CalcLaplacian]){
+					double Lap = 0.0;
+					for (int i = 0; i < 3; ++i)
+						Lap += EigVals[i];
+					OutPtrs[CalcLaplacian][0].Write(Index, Lap);
+				}
+
+				if (DoCalc[CalcGaussianCurvature]){
+					double Curvature = EigVals[0];
+					for (int i = 1; i < 3; ++i)
+						Curvature *= EigVals[i];
+					OutPtrs[CalcGaussianCurvature][0].Write(Index, Curvature);
+				}
+
+				if (DoCalc[CalcEigenVectorsDotGradient])
+					for (int i = 0; i < 3; ++i)
+						OutPtrs[CalcEigenVectorsDotGradient][i].Write(Index, dot(EigVecs.row(i), Grad));
+
+				if (DoCalc[CalcEberly1Ridge] || DoCalc[CalcEberly2Ridge]){
+					for (int i = 0; i < 3; ++i)
+						Dots[i] = abs(dot(EigVecs.col(i), Grad));
+					std::sort(Dots, Dots + 3);
+
+					for (int r = 0; r < 2; ++r){
+						if (!DoCalc[CalcEberly1Ridge + r])
+							continue;
+						double Val = 0.0;
+						if (!Opt.EberlyUseCutoff[r] || RhoPtr[Index] >= Opt.EberlyCutoff[r]){
+							if (r == 0)
+								Val = Dots[0] + Dots[1];
+							else
+								Val = Dots[0];
+						}
+						OutPtrs[CalcEberly1Ridge + r][0].Write(Index, Val);
+					}
+				}
+
+				if (DoCalc[CalcEigenRank]){
+					double Rank = 0;
+					for (int i = 0; i < 3; ++i){
+						if (EigVals[i] >= 0)
+							++Rank;
+						else
+							--Rank;
+					}
+					OutPtrs[CalcEigenRank][0].Write(Index, Rank);
+				}
+			}
+		}
+
+		IsOk = StatusUpdate(kk - 1, KMax, StatusStr, Opt.AddOnID);
+	}
+
+	return IsOk;
+}
+
+/*
+*	TRUE if any of the variables has a non-zero value in the zone.
+*/
+static const Boolean_t ZoneVarsAreNonZero(const int & ZoneNum, const vector<EntIndex_t> & VarNums)
+{
+	Boolean_t IsNonZero = FALSE;
+	for (int i = 0; i < VarNums.size() && !IsNonZero; ++i){
+		FieldDataPointer_c TmpPtr;
+		if (TmpPtr.GetReadPtr(ZoneNum, VarNums[i])){
+			int jMax = TmpPtr.Size();
+#pragma omp parallel for
+			for (int j = 0; j < jMax; ++j){
+				if (!IsNonZero && TmpPtr[j] != 0.0)
+					IsNonZero = TRUE;
+			}
+		}
+	}
+	return IsNonZero;
+}
+
 void CalcVars(CalcVarsOptions_s & Opt)
 {
 	SYSTEM_INFO sysinfo;
@@ -2427,6 +2735,37 @@ void CalcVars(CalcVarsOptions_s & Opt)
 
 	Boolean_t ShowRequiredVarsMessage = TRUE;
 
+	/*
+	*	Ordered volume zones are skipped in the per-variable loop below,
+	*	and instead get all the requested variables in a single sweep by
+	*	CalcVarsForVolumeNodes() once the variables have been created.
+	*	It needs to know which gradient, Hessian and eigen system
+	*	variables were already in the dataset before any were created.
+	*/
+	vector<Boolean_t> DoCalc(CalcEigenRank + 1, FALSE);
+	for (const CalcVar_e & i : Opt.CalcVarList)
+		if (i > CalcInvalidVar && i <= CalcEigenRank)
+			DoCalc[i] = TRUE;
+
+	auto VarNumsByName = [](const vector<string> & Names){
+		vector<EntIndex_t> VarNums;
+		for (const string & Name : Names){
+			EntIndex_t VarNum = VarNumByName(Name);
+			if (VarNum <= 0)
+				return vector<EntIndex_t>();
+			VarNums.push_back(VarNum);
+		}
+		return VarNums;
+	};
+
+	vector<EntIndex_t> SrcGradVarNums, SrcHessVarNums, SrcEigSysVarNums;
+	if (!DoCalc[CalcGradientVectors])
+		SrcGradVarNums = (Opt.HasGrad ? Opt.GradVarNums : VarNumsByName(GradVarNames));
+	if (!DoCalc[CalcHessian])
+		SrcHessVarNums = (Opt.HasHess ? Opt.HessVarNums : VarNumsByName(HessVarNames));
+	if (!DoCalc[CalcEigenSystem])
+		SrcEigSysVarNums = VarNumsByName(EigSysVarNames);
+
 	/*
 	*	Loop over each variable that needs to be calculated
 	*/
@@ -2811,6 +3150,15 @@ void CalcVars(CalcVarsOptions_s & Opt)
 						Params[i].VolInfo = &VI[i];
 					}
 				}
+
+				/*
+				*	Volume zones are done below, all variables at once.
+				*/
+				if (IsVolZone){
+					if (!Opt.CalcForAllZones)
+						break;
+					continue;
+				}
 			}
 
 			if (IsOk && (Opt.CalcForAllZones || ZoneNum == Opt.CalcZoneNum))
@@ -3494,6 +3842,86 @@ void CalcVars(CalcVarsOptions_s & Opt)
 		IterNum++;
 	}
 
+	/*
+	*	Now all the variables exist, calculate them for the volume zones.
+	*/
+	if (IsOk){
+		vector<vector<EntIndex_t> > OutVarNums(CalcEigenRank + 1);
+		OutVarNums[CalcGradientVectors] = Opt.GradVarNums;
+		OutVarNums[CalcGradientMagnitude] = { GradMagVarNum };
+		OutVarNums[CalcHessian] = Opt.HessVarNums;
+		OutVarNums[CalcEigenSystem] = EigSysVarNums;
+		OutVarNums[CalcLaplacian] = { LapVarNum };
+		OutVarNums[CalcGaussianCurvature] = { GaussCurvatureVarNum };
+		OutVarNums[CalcEigenVectorsDotGradient] = EigVecDotGradVarNums;
+		OutVarNums[CalcEberly1Ridge] = { EberlyFuncVarNums[0] };
+		OutVarNums[CalcEberly2Ridge] = { EberlyFuncVarNums[1] };
+		OutVarNums[CalcEigenRank] = { EigenRankVarNum };
+
+		string StatusStr = "Calculating variables for volume zone";
+		StatusLaunch(StatusStr.c_str(), VolInfo.AddOnID, TRUE);
+
+		for (EntIndex_t ZoneNum = 1; ZoneNum <= NumZones && IsOk; ++ZoneNum){
+			if (!(Opt.CalcForAllZones || ZoneNum == Opt.CalcZoneNum) || !TecUtilZoneIsOrdered(ZoneNum))
+				continue;
+			vector<int> IJK(3);
+			TecUtilZoneGetIJK(ZoneNum, &IJK[0], &IJK[1], &IJK[2]);
+			if (IJK[2] <= 1)
+				continue;
+
+			VolExtentIndexWeights_s ZoneVolInfo;
+			GetVolInfo(ZoneNum, XYZVarNums, (ZoneNum == VolZoneNum ? Opt.IsPeriodic : FALSE), ZoneVolInfo);
+
+			TecUtilDataLoadBegin();
+
+			FieldDataPointer_c ZoneRhoPtr;
+			vector<FieldDataPointer_c> SrcGradPtrs(3),
+				SrcHessPtrs(6),
+				SrcEigSysPtrs(12);
+			vector<vector<FieldDataPointer_c> > OutPtrs(CalcEigenRank + 1);
+
+			IsOk = ZoneRhoPtr.GetReadPtr(ZoneNum, Opt.RhoVarNum);
+
+			if (IsOk && SrcGradVarNums.size() == 3 && ZoneVarsAreNonZero(ZoneNum, SrcGradVarNums))
+				for (int i = 0; i < 3 && IsOk; ++i)
+					IsOk = SrcGradPtrs[i].GetReadPtr(ZoneNum, SrcGradVarNums[i]);
+			if (IsOk && SrcHessVarNums.size() == 6 && ZoneVarsAreNonZero(ZoneNum, SrcHessVarNums))
+				for (int i = 0; i < 6 && IsOk; ++i)
+					IsOk = SrcHessPtrs[i].GetReadPtr(ZoneNum, SrcHessVarNums[i]);
+			if (IsOk && SrcEigSysVarNums.size() == 12 && ZoneVarsAreNonZero(ZoneNum, SrcEigSysVarNums))
+				for (int i = 0; i < 12 && IsOk; ++i)
+					IsOk = SrcEigSysPtrs[i].GetReadPtr(ZoneNum, SrcEigSysVarNums[i]);
+
+			for (int v = 0; v <= CalcEigenRank && IsOk; ++v){
+				if (DoCalc[v]){
+					OutPtrs[v].resize(OutVarNums[v].size());
+					for (int i = 0; i < OutVarNums[v].size() && IsOk; ++i)
+						IsOk = OutPtrs[v][i].GetWritePtr(ZoneNum, OutVarNums[v][i]);
+				}
+			}
+
+			if (IsOk)
+				IsOk = CalcVarsForVolumeNodes(DoCalc,
+					Opt,
+					ZoneVolInfo.MaxIJK,
+					ZoneVolInfo.DelXYZ,
+					ZoneVolInfo.IsPeriodic,
+					ZoneRhoPtr,
+					SrcGradPtrs,
+					SrcHessPtrs,
+					SrcEigSysPtrs,
+					OutPtrs,
+					StatusStr);
+
+			TecUtilDataLoadEnd();
+
+			if (ZoneNum == Opt.CalcZoneNum && !Opt.CalcForAllZones)
+				break;
+		}
+
+		StatusDrop(VolInfo.AddOnID);
+	}
+
 	TecUtilLockFinish(Opt.AddOnID);
 }
 
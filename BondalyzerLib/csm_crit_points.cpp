@@ -1,5 +1,6 @@
 #include <vector>
 #include <string>
+#include <algorithm>
 
 #include "omp.h"
 
@@ -9,8 +10,10 @@
 #include "CSM_VOL_EXTENT_INDEX_WEIGHTS.h"
 #include "CSM_CALC_VARS.h"
 #include "CSM_GRAD_PATH.h"
+#include "CSM_GRAD_PATH_CACHE.h"
 
 #include "CSM_CRIT_POINTS.h"
+#include "CSM_NODE_RECORD_CACHE.h"
 
 using std::vector;
 using std::string;
@@ -33,6 +36,8 @@ CritPoints_c::CritPoints_c()
 
 	m_MinCPDist = -1;
 	m_MinCPDistFound = FALSE;
+	m_IndexBuilt = FALSE;
+	m_HasLattice = FALSE;
 	m_RhoCutoff = -1;
 	m_Dimensions = -1;
 }
@@ -50,6 +55,8 @@ CritPoints_c::CritPoints_c(const double & RhoCutoff, const int & NumDimensions){
 
 	m_MinCPDist = -1;
 	m_MinCPDistFound = FALSE;
+	m_IndexBuilt = FALSE;
+	m_HasLattice = FALSE;
 }
 
 CritPoints_c::CritPoints_c(const vector<CritPoints_c> & CPLists){
@@ -57,11 +64,13 @@ CritPoints_c::CritPoints_c(const vector<CritPoints_c> & CPLists){
 	for (int i = 0; i < 6; ++i)
 		m_NumCPs[i] = 0;
 
-	for (auto Beg = CPLists.cbegin(), End = CPLists.cend(); Beg != End; Beg++)
-		this->Append(*Beg);
-
 	m_MinCPDist = -1;
 	m_MinCPDistFound = FALSE;
+	m_IndexBuilt = FALSE;
+	m_HasLattice = FALSE;
+
+	for (auto Beg = CPLists.cbegin(), End = CPLists.cend(); Beg != End; Beg++)
+		this->Append(*Beg);
 }
 
 CritPoints_c::CritPoints_c(const int & CPZoneNum,
@@ -126,6 +135,9 @@ CritPoints_c::CritPoints_c(const int & CPZoneNum,
 		m_NumCPs[i] = m_Rho[i].size();
 		m_TotNumCPs += m_Rho[i].size();
 	}
+
+	if (MR != NULL && MR->IsPeriodic && MR->VolInfo != NULL)
+		SetSpatialIndexLattice(PeriodicLatticeVectors(*MR->VolInfo));
 }
 
 CritPoints_c::~CritPoints_c()
@@ -157,21 +169,13 @@ const double CritPoints_c::GetMinCPDist(const vector<CPType_e> & CPTypes){
 
 
 const double CritPoints_c::GetMinCPDist(const int & CPTypeInd, const int & CPOffset, const vector<CPType_e> & CPTypes){
-	double MinDistSqr = DBL_MAX;
-
 	vector<int> TypeIndList;
 	for (const auto & i : CPTypes) TypeIndList.push_back(VectorGetElementNum(CPTypeList, i));
 
-	for (const int & t : TypeIndList){
-		for (const vec3 & pt : m_XYZ[t]){
-			if (t != CPTypeInd || sum(GetXYZ(CPTypeInd, CPOffset) == pt) < 3){
-				double TmpDistSqr = DistSqr(GetXYZ(CPTypeInd, CPOffset), pt);
-				if (TmpDistSqr < MinDistSqr) MinDistSqr = TmpDistSqr;
-			}
-		}
-	}
-
-	if (MinDistSqr != DBL_MAX) return sqrt(MinDistSqr);
+	double MinDist;
+	vec3 CPPos;
+	if (GetClosestCP(GetXYZ(CPTypeInd, CPOffset), MinDist, CPPos, TypeIndList, GetTotOffsetFromTypeNumOffset(CPTypeInd, CPOffset)) >= 0)
+		return MinDist;
 	else return -1;
 }
 
@@ -253,11 +257,17 @@ const Boolean_t CritPoints_c::AddPoint(const double & Rho,
 		}
 	}
 
+	if (IsOk)
+		ClearSpatialIndex();
+
 	return IsOk;
 }
 
 void CritPoints_c::Append(const CritPoints_c & rhs)
 {
+	if (!m_HasLattice && rhs.m_HasLattice)
+		SetSpatialIndexLattice(rhs.m_LatticeVectors);
+
 	for (int i = 0; i < 6; ++i){
 		m_Rho[i].insert(m_Rho[i].end(), rhs.m_Rho[i].cbegin(), rhs.m_Rho[i].cend());
 		m_XYZ[i].insert(m_XYZ[i].end(), rhs.m_XYZ[i].cbegin(), rhs.m_XYZ[i].cend());
@@ -281,48 +291,27 @@ const Boolean_t CritPoints_c::FindMinCPDist(const vector<CPType_e> & CPTypes){
 	m_MinDistCPTypes = CPTypes;
 	for (const auto & i : CPTypes) TypeIndList.push_back(VectorGetElementNum(CPTypeList, i));
 
-	int MinI = -1, MinJ = -1, MinII = -1, MinJJ = -1;
-	double TmpDbl;
-
 	m_MinCPDist = DBL_MAX;
 
 	if (IsOk){
-		for (int i = 0; i < TypeIndList.size() - 1; ++i){
-			for (int j = i; j < TypeIndList.size(); ++j){
-				for (int ii = 0; ii < NumCPs(TypeIndList[i]); ++ii){
-					for (int jj = 0; jj < NumCPs(TypeIndList[j]); ++jj){
-						if (i != j || ii != jj){
-							TmpDbl = DistSqr(GetXYZ(TypeIndList[i], ii), GetXYZ(TypeIndList[j], jj));
-							if (TmpDbl < m_MinCPDist){
-								m_MinCPDist = TmpDbl;
-								MinI = i;
-								MinII = ii;
-								MinJ = j;
-								MinJJ = jj;
-							}
-						}
-					}
-				}
+		/*
+		*	Same pairs of types as before (each type with itself and
+		*	those after it, but not the last type with itself), with the
+		*	closest partner of each CP coming from the spatial index.
+		*/
+		for (int i = 0; i < static_cast<int>(TypeIndList.size()) - 1; ++i){
+			vector<int> OtherTypeInds(TypeIndList.begin() + i, TypeIndList.end());
+			for (int ii = 0; ii < NumCPs(TypeIndList[i]); ++ii){
+				double TmpDbl;
+				vec3 CPPos;
+				if (GetClosestCP(GetXYZ(TypeIndList[i], ii), TmpDbl, CPPos, OtherTypeInds, GetTotOffsetFromTypeNumOffset(TypeIndList[i], ii)) >= 0 && TmpDbl < m_MinCPDist)
+					m_MinCPDist = TmpDbl;
 			}
 		}
-		IsOk = (MinI >= 0 && MinJ >= 0 && MinII >= 0 && MinJJ >= 0);
-
-		// 		for (int i = 0; i < m_TotNumCPs; ++i){
-		// 			for (int j = i + 1; j < m_TotNumCPs; ++j){
-		// 				TmpDbl = DistSqr(GetXYZ(i), GetXYZ(j));
-		// 				if (TmpDbl < m_MinCPDist){
-		// 					m_MinCPDist = TmpDbl;
-		// 					MinI = i;
-		// 					MinJ = j;
-		// 				}
-		// 			}
-		// 		}
-		// 		IsOk = (MinI >= 0 && MinJ >= 0);
+		IsOk = (m_MinCPDist < DBL_MAX);
 	}
 
 	if (IsOk){
-		// 		m_MinCPDist = Distance(GetXYZ(MinI), GetXYZ(MinJ));
-		m_MinCPDist = Distance(GetXYZ(TypeIndList[MinI], MinII), GetXYZ(TypeIndList[MinJ], MinJJ));
 		m_MinCPDistFound = TRUE;
 	}
 
@@ -330,17 +319,26 @@ const Boolean_t CritPoints_c::FindMinCPDist(const vector<CPType_e> & CPTypes){
 }
 
 void CritPoints_c::RemoveSpuriousCPs(const double & CheckDist){
-	double CheckDistSqr = CheckDist * CheckDist;
-
-
-	// Cycle through all CP types and use a distance (squared) criteria 
+	// Cycle through all CP types and use a distance criteria 
 	// to check for duplicates.
 	// CP types have priority according to type index, so if
 	// a bond is too close to a nuclear CP, the bond CP is removed.
 	// Duplicate CPs of same type will be replaced with a single CP
 	// with the average (midpoint) values of the duplicates.
+	//
+	// Neighbors within CheckDist come from the spatial index (so
+	// minimum-image distances if a lattice is set), rather than
+	// checking every pair of CPs.
 	// 
 	// Do one pass to fix the spurious groups within each CP type
+
+	ClearSpatialIndex();
+
+	vector<int> Neighbors;
+	vector<vec3> NewXYZ[6], NewPD[6], NewEigVals[6];
+	vector<mat33> NewEigVecs[6];
+	vector<double> NewRho[6];
+
 	for (int t = 0; t < 6; ++t){
 		if (m_XYZ[t].size() > 0){
 			// First do check within same type, replacing spurious 
@@ -353,7 +351,7 @@ void CritPoints_c::RemoveSpuriousCPs(const double & CheckDist){
 			vector<bool> IsSpurious(m_XYZ[t].size(), false);
 
 			/*
-			*	Each CP i gets checked against the [i+1, max].
+			*	Each CP i gets checked against its neighbors in [i+1, max].
 			*	The first CP in a spurious neighbor group is the one that
 			*	keeps the full list of CPs in the group.
 			*	This is done by using the first position in DuplicateNeighbors[i]
@@ -363,10 +361,15 @@ void CritPoints_c::RemoveSpuriousCPs(const double & CheckDist){
 			*	location indicated by its parent.
 			*/
 
+			const vector<int> TypeNums(1, t);
+			const int TypeStart = GetTotOffsetFromTypeNumOffset(t, 0);
+
 			for (int i = 0; i < m_XYZ[t].size(); ++i){
 				if (!IsSpurious[i]) DuplicateNeighbors[i].push_back(i);
-				for (int j = i + 1; j < m_XYZ[t].size(); ++j){
-					if (DistSqr(m_XYZ[t][i], m_XYZ[t][j]) <= CheckDistSqr){
+				GetCPsInRadius(m_XYZ[t][i], CheckDist, Neighbors, TypeNums, TypeStart + i);
+				for (const int & n : Neighbors){
+					int j = n - TypeStart;
+					if (j > i){
 						IsSpurious[j] = true;
 						DuplicateNeighbors[DuplicateNeighbors[i][0]].push_back(j);
 						DuplicateNeighbors[j].push_back(DuplicateNeighbors[i][0]);
@@ -374,70 +377,86 @@ void CritPoints_c::RemoveSpuriousCPs(const double & CheckDist){
 				}
 			}
 
-			vector<vec3> NewXYZ, NewPD, NewEigVals;
-			vector<mat33> NewEigVecs;
-			vector<double> NewRho;
 			for (int i = 0; i < m_XYZ[t].size(); ++i){
 				if (!IsSpurious[i]){
-					NewXYZ.push_back(zeros(3));
-					if (i < m_PrincDir[t].size()) NewPD.push_back(zeros(3));
-					if (i < m_EigVals[t].size()) NewEigVals.push_back(zeros(3));
-					if (i < m_EigVecs[t].size()) NewEigVecs.push_back(zeros(3, 3));
-					if (i < m_Rho[t].size()) NewRho.push_back(0);
+					NewXYZ[t].push_back(zeros(3));
+					if (i < m_PrincDir[t].size()) NewPD[t].push_back(zeros(3));
+					if (i < m_EigVals[t].size()) NewEigVals[t].push_back(zeros(3));
+					if (i < m_EigVecs[t].size()) NewEigVecs[t].push_back(zeros(3, 3));
+					if (i < m_Rho[t].size()) NewRho[t].push_back(0);
 
 					for (int & j : DuplicateNeighbors[i]){
-						NewXYZ.back() += m_XYZ[t][j];
-						if (j < m_PrincDir[t].size()) NewPD.back() += m_PrincDir[t][j];
-						if (j < m_EigVals[t].size()) NewEigVals.back() += m_EigVals[t][j];
-						if (j < m_EigVecs[t].size()) NewEigVecs.back() += m_EigVecs[t][j];
-						if (j < m_Rho[t].size()) NewRho.back() += m_Rho[t][j];
+						// Average over the images nearest the group's parent
+						NewXYZ[t].back() += NearestImage(m_XYZ[t][j], m_XYZ[t][i]);
+						if (j < m_PrincDir[t].size()) NewPD[t].back() += m_PrincDir[t][j];
+						if (j < m_EigVals[t].size()) NewEigVals[t].back() += m_EigVals[t][j];
+						if (j < m_EigVecs[t].size()) NewEigVecs[t].back() += m_EigVecs[t][j];
+						if (j < m_Rho[t].size()) NewRho[t].back() += m_Rho[t][j];
 					}
 
 					if (DuplicateNeighbors[i].size() > 1){
-						NewXYZ.back() /= (double)DuplicateNeighbors[i].size();
-						if (NewPD.size() > 0) NewPD.back() /= (double)DuplicateNeighbors[i].size();
-						if (NewEigVals.size() > 0) NewEigVals.back() /= (double)DuplicateNeighbors[i].size();
-						if (NewEigVecs.size() > 0) NewEigVecs.back() /= (double)DuplicateNeighbors[i].size();
-						if (NewRho.size() > 0) NewRho.back() /= (double)DuplicateNeighbors[i].size();
+						NewXYZ[t].back() /= (double)DuplicateNeighbors[i].size();
+						if (NewPD[t].size() > 0) NewPD[t].back() /= (double)DuplicateNeighbors[i].size();
+						if (NewEigVals[t].size() > 0) NewEigVals[t].back() /= (double)DuplicateNeighbors[i].size();
+						if (NewEigVecs[t].size() > 0) NewEigVecs[t].back() /= (double)DuplicateNeighbors[i].size();
+						if (NewRho[t].size() > 0) NewRho[t].back() /= (double)DuplicateNeighbors[i].size();
 					}
 				}
 			}
+		}
+	}
+
+	// The spatial index refers to total offsets, so only replace the
+	// CPs once every type has been checked.
 
-			m_NumCPs[t] = NewXYZ.size();
-			m_TotNumCPs += m_NumCPs[t];
+	m_TotNumCPs = 0;
+	for (int t = 0; t < 6; ++t){
+		if (m_XYZ[t].size() > 0){
+			m_NumCPs[t] = NewXYZ[t].size();
 
-			m_XYZ[t] = NewXYZ;
-			m_PrincDir[t] = NewPD;
-			m_EigVals[t] = NewEigVals;
-			m_EigVecs[t] = NewEigVecs;
-			m_Rho[t] = NewRho;
+			m_XYZ[t].swap(NewXYZ[t]);
+			m_PrincDir[t].swap(NewPD[t]);
+			m_EigVals[t].swap(NewEigVals[t]);
+			m_EigVecs[t].swap(NewEigVecs[t]);
+			m_Rho[t].swap(NewRho[t]);
 		}
+		m_TotNumCPs += m_NumCPs[t];
 	}
 
-	// Now do a second pass where CPs are checked against the CPs of other types
+	ClearSpatialIndex();
 
-	m_TotNumCPs = 0;
+	// Now do a second pass where CPs are checked against the CPs of other types
 
 	// For marking each CP as duplicate or not
 	vector<vector<bool> > IsSpurious(6);
 	for (int t = 0; t < 6; ++t) IsSpurious[t].resize(m_XYZ[t].size(), false);
 
-	for (int ti = 0; ti < 6; ++ti){
+	for (int ti = 0; ti < 5; ++ti){
 		if (m_XYZ[ti].size() > 0){
-			for (int tj = ti + 1; tj < 6; ++tj){
-
-				for (int i = 0; i < m_XYZ[ti].size(); ++i){
-					if (!IsSpurious[ti][i]){
-						for (int j = 0; j < m_XYZ[tj].size(); ++j){
-							if (!IsSpurious[tj][j] && DistSqr(m_XYZ[ti][i], m_XYZ[tj][j]) <= CheckDistSqr){
-								// Spurious CP found. The j cp is always removed because i cp has higher priority
-								IsSpurious[tj][j] = true;
-							}
-						}
+			// Only the CPs of lower priority (higher type index) get checked
+			vector<int> LowerTypeNums;
+			for (int tj = ti + 1; tj < 6; ++tj)
+				if (m_XYZ[tj].size() > 0) LowerTypeNums.push_back(tj);
+			if (LowerTypeNums.empty())
+				continue;
+
+			for (int i = 0; i < m_XYZ[ti].size(); ++i){
+				if (!IsSpurious[ti][i]){
+					GetCPsInRadius(m_XYZ[ti][i], CheckDist, Neighbors, LowerTypeNums);
+					for (const int & n : Neighbors){
+						// Spurious CP found. The j cp is always removed because i cp has higher priority
+						vector<int> TypeOffset = GetTypeNumOffsetFromTotOffset(n);
+						IsSpurious[TypeOffset[0]][TypeOffset[1]] = true;
 					}
 				}
 			}
+		}
+	}
 
+	m_TotNumCPs = 0;
+
+	for (int ti = 0; ti < 6; ++ti){
+		if (m_XYZ[ti].size() > 0){
 			vector<vec3> NewXYZ, NewPD, NewEigVals;
 			vector<mat33> NewEigVecs;
 			vector<double> NewRho;
@@ -462,8 +481,7 @@ void CritPoints_c::RemoveSpuriousCPs(const double & CheckDist){
 		}
 	}
 
-
-
+	ClearSpatialIndex();
 }
 
 vector<int> CritPoints_c::GetTypeNumOffsetFromTotOffset(const int & TotOffset) const{
@@ -507,10 +525,291 @@ const int CritPoints_c::GetTotOffsetFromTypeNumOffset(const int & TypeNum, const
 }
 
 
+void CritPoints_c::SetSpatialIndexLattice(const mat33 & LatticeVectors){
+	m_LatticeVectors = LatticeVectors;
+	m_HasLattice = TRUE;
+}
+
+/*
+*	The image of Pt (shifted by a combination of -1, 0 or 1 of each
+*	lattice vector) closest to RefPt, or Pt itself if there's no lattice.
+*/
+vec3 CritPoints_c::NearestImage(const vec3 & Pt, const vec3 & RefPt) const{
+	vec3 BestPt = Pt;
+	if (m_HasLattice){
+		double BestDistSqr = DistSqr(Pt, RefPt);
+		for (int s = 0; s < 27; ++s){
+			vec3 Shift = zeros<vec>(3);
+			for (int d = 0, Div = 1; d < 3; ++d, Div *= 3)
+				Shift += m_LatticeVectors.col(d) * static_cast<double>((s / Div) % 3 - 1);
+			double TmpDistSqr = DistSqr(Pt + Shift, RefPt);
+			if (TmpDistSqr < BestDistSqr){
+				BestDistSqr = TmpDistSqr;
+				BestPt = Pt + Shift;
+			}
+		}
+	}
+
+	return BestPt;
+}
+
+/*
+*	Sort the CPs into a uniform grid over their bounding box.
+*	Cells are sized for a couple of CPs each, but no smaller than the
+*	spurious CP distance, since CPs are at least that far apart.
+*/
+const Boolean_t CritPoints_c::BuildSpatialIndex(){
+	m_IndexBuilt = FALSE;
+	if (m_TotNumCPs <= 0)
+		return FALSE;
+
+	m_IndexTotOffsets.clear();
+	m_IndexTypeNums.clear();
+	m_IndexXYZ.clear();
+	m_IndexTotOffsets.reserve(m_TotNumCPs);
+	m_IndexTypeNums.reserve(m_TotNumCPs);
+	m_IndexXYZ.reserve(m_TotNumCPs);
+
+	m_IndexMinXYZ.fill(DBL_MAX);
+	m_IndexMaxXYZ.fill(-DBL_MAX);
+	for (int t = 0; t < 6; ++t){
+		for (const vec3 & Pt : m_XYZ[t]){
+			for (int d = 0; d < 3; ++d){
+				m_IndexMinXYZ[d] = MIN(m_IndexMinXYZ[d], Pt[d]);
+				m_IndexMaxXYZ[d] = MAX(m_IndexMaxXYZ[d], Pt[d]);
+			}
+		}
+	}
+
+	vec3 Extent = m_IndexMaxXYZ - m_IndexMinXYZ;
+	double Vol = 1.0;
+	for (int d = 0; d < 3; ++d)
+		Vol *= Extent[d] + SpuriousCPCheckDistance;
+	m_IndexCellSize = MAX(cbrt(2.0 * Vol / static_cast<double>(m_TotNumCPs)), SpuriousCPCheckDistance);
+
+	int NumCells;
+	while (true){
+		NumCells = 1;
+		for (int d = 0; d < 3; ++d){
+			m_IndexDims[d] = static_cast<int>(Extent[d] / m_IndexCellSize) + 1;
+			NumCells *= m_IndexDims[d];
+		}
+		if (NumCells <= 8 * m_TotNumCPs + 64)
+			break;
+		m_IndexCellSize *= 1.5;
+	}
+
+	/*
+	*	Counting sort into cells, keeping total offset order within each.
+	*/
+	vector<int> CellNums;
+	CellNums.reserve(m_TotNumCPs);
+	m_IndexCellStart.assign(NumCells + 1, 0);
+	for (int t = 0; t < 6; ++t){
+		for (const vec3 & Pt : m_XYZ[t]){
+			int IJK[3];
+			for (int d = 0; d < 3; ++d)
+				IJK[d] = MIN(static_cast<int>((Pt[d] - m_IndexMinXYZ[d]) / m_IndexCellSize), m_IndexDims[d] - 1);
+			CellNums.push_back(IJK[0] + m_IndexDims[0] * (IJK[1] + m_IndexDims[1] * IJK[2]));
+			m_IndexCellStart[CellNums.back() + 1]++;
+		}
+	}
+	for (int c = 0; c < NumCells; ++c)
+		m_IndexCellStart[c + 1] += m_IndexCellStart[c];
+
+	m_IndexTotOffsets.resize(m_TotNumCPs);
+	m_IndexTypeNums.resize(m_TotNumCPs);
+	m_IndexXYZ.resize(m_TotNumCPs);
+	vector<int> CellFill(m_IndexCellStart.begin(), m_IndexCellStart.end() - 1);
+	int TotOffset = 0;
+	for (int t = 0; t < 6; ++t){
+		for (const vec3 & Pt : m_XYZ[t]){
+			int Entry = CellFill[CellNums[TotOffset]]++;
+			m_IndexTotOffsets[Entry] = TotOffset;
+			m_IndexTypeNums[Entry] = t;
+			m_IndexXYZ[Entry] = Pt;
+			TotOffset++;
+		}
+	}
+
+	/*
+	*	The index has to be visible before the flag; see SpatialIndexIsReady().
+	*/
+#pragma omp flush
+	m_IndexBuilt = TRUE;
+#pragma omp flush
+
+	return TRUE;
+}
+
+const int CritPoints_c::GetFirstCPInRadius(const vec3 & Point, const double & Radius, vec3 & CPPos, const vector<int> & TypeNums, const int & ExcludeTotOffset){
+	int TotOffset = -1;
+	double FoundDistSqr;
+	if (SpatialIndexIsReady())
+		SearchSpatialIndex(Point, Radius, TypeNums, ExcludeTotOffset, FALSE, TotOffset, FoundDistSqr, CPPos);
+
+	return TotOffset;
+}
+
+const int CritPoints_c::GetCPsInRadius(const vec3 & Point, const double & Radius, vector<int> & TotOffsets, const vector<int> & TypeNums, const int & ExcludeTotOffset){
+	TotOffsets.clear();
+
+	int TotOffset = -1;
+	double FoundDistSqr;
+	vec3 CPPos;
+	if (SpatialIndexIsReady()){
+		SearchSpatialIndex(Point, Radius, TypeNums, ExcludeTotOffset, FALSE, TotOffset, FoundDistSqr, CPPos, &TotOffsets);
+		std::sort(TotOffsets.begin(), TotOffsets.end());
+		TotOffsets.erase(std::unique(TotOffsets.begin(), TotOffsets.end()), TotOffsets.end());
+	}
+
+	return static_cast<int>(TotOffsets.size());
+}
+
+/*
+*	Search spheres of doubling radius until one contains a CP. Anything
+*	found in a sphere is the closest, since every cell the sphere
+*	touches was checked.
+*/
+const int CritPoints_c::GetClosestCP(const vec3 & Point, double & Dist, vec3 & CPPos, const vector<int> & TypeNums, const int & ExcludeTotOffset){
+	int TotOffset = -1;
+	Dist = -1;
+	if (!SpatialIndexIsReady())
+		return TotOffset;
+
+	/*
+	*	Radius that reaches every CP (and image of one) from Point.
+	*/
+	double MaxRadius = 0.0;
+	for (int d = 0; d < 3; ++d){
+		double Outside = MAX(0.0, MAX(m_IndexMinXYZ[d] - Point[d], Point[d] - m_IndexMaxXYZ[d]));
+		MaxRadius += Outside * Outside + (m_IndexMaxXYZ[d] - m_IndexMinXYZ[d]) * (m_IndexMaxXYZ[d] - m_IndexMinXYZ[d]);
+	}
+	MaxRadius = 2.0 * sqrt(MaxRadius);
+	if (m_HasLattice){
+		for (int d = 0; d < 3; ++d)
+			MaxRadius += norm(m_LatticeVectors.col(d));
+	}
+
+	for (double Radius = m_IndexCellSize; TotOffset < 0; Radius *= 2.0){
+		double FoundDistSqr;
+		SearchSpatialIndex(Point, Radius, TypeNums, ExcludeTotOffset, TRUE, TotOffset, FoundDistSqr, CPPos);
+		if (TotOffset >= 0)
+			Dist = sqrt(FoundDistSqr);
+		else if (Radius > MaxRadius)
+			break;
+	}
+
+	return TotOffset;
+}
+
 /*
 *	Private methods
 */
 
+/*
+*	Build the spatial index if it isn't already. Gradient paths seeded in
+*	parallel share a CritPoints_c, so the first one in builds it for all.
+*	m_IndexBuilt is read outside the critical section, so it's fenced
+*	with flushes (OpenMP 2.0 has no atomic reads): BuildSpatialIndex()
+*	flushes the index before setting it, and here it's read after a
+*	flush and the index only after another.
+*/
+const Boolean_t CritPoints_c::SpatialIndexIsReady(){
+	Boolean_t IsBuilt;
+#pragma omp flush
+	IsBuilt = m_IndexBuilt;
+	if (!IsBuilt && m_TotNumCPs > 0){
+#pragma omp critical(CritPointsSpatialIndex)
+		{
+			if (!m_IndexBuilt)
+				BuildSpatialIndex();
+			IsBuilt = m_IndexBuilt;
+		}
+	}
+#pragma omp flush
+
+	return IsBuilt;
+}
+
+/*
+*	Check the CPs in the cells within Radius of Point (and of Point's
+*	shifts by each lattice vector combination, for a periodic index).
+*	Keeps the CP with
+*	the lowest total offset, or the closest CP if ByDistance, in
+*	BestTotOffset/BestDistSqr/BestPos, and collects every CP within
+*	Radius in AllTotOffsets if given.
+*/
+void CritPoints_c::SearchSpatialIndex(const vec3 & Point,
+	const double & Radius,
+	const vector<int> & TypeNums,
+	const int & ExcludeTotOffset,
+	const Boolean_t & ByDistance,
+	int & BestTotOffset,
+	double & BestDistSqr,
+	vec3 & BestPos,
+	vector<int> * AllTotOffsets) const
+{
+	bool UseType[6];
+	for (int t = 0; t < 6; ++t)
+		UseType[t] = TypeNums.empty();
+	for (const int & t : TypeNums)
+		if (t >= 0 && t < 6) UseType[t] = true;
+
+	const double RadiusSqr = Radius * Radius;
+	const int NumShifts = (m_HasLattice ? 27 : 1);
+
+	for (int s = 0; s < NumShifts; ++s){
+		vec3 Shift = zeros<vec>(3);
+		if (m_HasLattice){
+			for (int d = 0, Div = 1; d < 3; ++d, Div *= 3)
+				Shift += m_LatticeVectors.col(d) * static_cast<double>((s / Div) % 3 - 1);
+		}
+		vec3 QueryPt = Point - Shift;
+
+		int MinIJK[3], MaxIJK[3];
+		bool InRange = true;
+		for (int d = 0; d < 3 && InRange; ++d){
+			double Lo = (QueryPt[d] - Radius - m_IndexMinXYZ[d]) / m_IndexCellSize,
+				Hi = (QueryPt[d] + Radius - m_IndexMinXYZ[d]) / m_IndexCellSize;
+			InRange = (Hi >= 0.0 && Lo < static_cast<double>(m_IndexDims[d]));
+			if (InRange){
+				MinIJK[d] = MAX(static_cast<int>(Lo), 0);
+				MaxIJK[d] = MIN(static_cast<int>(Hi), m_IndexDims[d] - 1);
+			}
+		}
+		if (!InRange)
+			continue;
+
+		for (int k = MinIJK[2]; k <= MaxIJK[2]; ++k){
+			for (int j = MinIJK[1]; j <= MaxIJK[1]; ++j){
+				int CellNum = m_IndexDims[0] * (j + m_IndexDims[1] * k);
+				for (int Entry = m_IndexCellStart[CellNum + MinIJK[0]]; Entry < m_IndexCellStart[CellNum + MaxIJK[0] + 1]; ++Entry){
+					int TotOffset = m_IndexTotOffsets[Entry];
+					if (TotOffset == ExcludeTotOffset || !UseType[m_IndexTypeNums[Entry]])
+						continue;
+
+					double TmpDistSqr = DistSqr(QueryPt, m_IndexXYZ[Entry]);
+					if (TmpDistSqr > RadiusSqr)
+						continue;
+
+					if (AllTotOffsets != NULL)
+						AllTotOffsets->push_back(TotOffset);
+
+					if (BestTotOffset < 0
+						|| (ByDistance && (TmpDistSqr < BestDistSqr || (TmpDistSqr == BestDistSqr && TotOffset < BestTotOffset)))
+						|| (!ByDistance && (TotOffset < BestTotOffset || (TotOffset == BestTotOffset && TmpDistSqr < BestDistSqr))))
+					{
+						BestTotOffset = TotOffset;
+						BestDistSqr = TmpDistSqr;
+						BestPos = m_IndexXYZ[Entry] + Shift;
+					}
+				}
+			}
+		}
+	}
+}
+
 
 /*
 *	Mutators and other methods
@@ -722,131 +1021,180 @@ void SetCPZone(const int & ZoneNum){
 }
 
 /*
-*	Functions for the GSL MultiRoots root finder
+*	Rho at the current index and weights, from the node
+*	cache if there is one.
 */
+const double RhoByCurrentIndexAndWeights(const MultiRootParams_s & RootParams){
+	if (RootParams.NodeCache != NULL && RootParams.NodeCache->HasRho())
+		return RootParams.NodeCache->ValByIndexAndWeights(*RootParams.VolInfo, RootParams.NodeCache->RhoOffset());
+
+	return ValByCurrentIndexAndWeightsFromRawPtr(*RootParams.VolInfo, *RootParams.RhoPtr);
+}
 
 /*
-*	Function to return the actual function (gradient) value
+*	Gradient and Hessian of rho at Pos (the function and Jacobian
+*	for the CP Newton search), from analytic gradient and Hessian
+*	variables if there are any, else the tricubic interpolant or
+*	finite differences. Returns FALSE if Pos is outside the volume.
 */
+const Boolean_t FDF3D(const double (&Pos)[3], MultiRootParams_s & RootParams, double (&Grad)[3], double (&Hess)[3][3]){
+	vec3 Point;
+	for (int i = 0; i < 3; ++i) Point[i] = Pos[i];
 
+	if (!SetIndexAndWeightsForPoint(Point, *RootParams.VolInfo))
+		return FALSE;
 
+	int HessIndices[3][3] = {
+		{ 0, 1, 2 },
+		{ 1, 3, 4 },
+		{ 2, 4, 5 }
+	};
 
-int F3D(const gsl_vector * pos, void * params, gsl_vector * GradValues){
-
-	MultiRootParams_s * RootParams = reinterpret_cast<MultiRootParams_s*>(params);
-
-	vec3 Point(pos->data);
-
-	if (!SetIndexAndWeightsForPoint(Point, *RootParams->VolInfo))
-		return GSL_ESANITY;
-
-	// 	for (int i = 0; i < 3; ++i)
-	// 		Point[i] = ValByCurrentIndexAndWeightsFromRawPtr(*RootParams->VolInfo, RootParams->GradPtrs->at(i));
-	// 
-	// 	if (RootParams->HasHess)
-	// 		Point *= 0.1;
+	if (RootParams.HasGrad && RootParams.HasHess){
+		/*
+		*	Both analytical, so get gradient and Hessian with one
+		*	stencil lookup and one gather.
+		*/
+		double Vals[9];
+		const NodeRecordCache_c * NodeCache = RootParams.NodeCache;
+		if (NodeCache != NULL && NodeCache->HasGrad() && NodeCache->HessOffset() == NodeCache->GradOffset() + 3){
+			/*
+			*	Gradient and Hessian are adjacent in each record.
+			*/
+			NodeCache->ValsByIndexAndWeights(*RootParams.VolInfo, NodeCache->GradOffset(), 9, Vals);
+		}
+		else{
+			const FieldDataPointer_c * Ptrs[9];
+			for (int i = 0; i < 3; ++i) Ptrs[i] = &RootParams.GradPtrs->at(i);
+			for (int i = 0; i < 6; ++i) Ptrs[3 + i] = &RootParams.HessPtrs->at(i);
 
-	// 	if (RootParams->HasHess){
-	// 		for (int i = 0; i < 3; ++i)
-	// 			gsl_vector_set(GradValues, i, ValByCurrentIndexAndWeightsFromRawPtr(*RootParams->VolInfo, RootParams->GradPtrs->at(i)));
-	// 	}
-	// 	else{
+			ValsByCurrentIndexAndWeightsFromRawPtrs(*RootParams.VolInfo, Ptrs, 9, Vals);
+		}
 
-	if (RootParams->HasGrad) for (int i = 0; i < 3; ++i){
-		gsl_vector_set(GradValues, i, ValByCurrentIndexAndWeightsFromRawPtr(*RootParams->VolInfo, RootParams->GradPtrs->at(i)));
-	}
-	else{
-		vec3 Grad;
-		CalcGradForPoint(Point, RootParams->VolInfo->DelXYZ, *RootParams->VolInfo, eye<mat>(3, 3), 0, RootParams->IsPeriodic, Grad, *RootParams->RhoPtr, GPType_Invalid, params);
 		for (int i = 0; i < 3; ++i){
-			gsl_vector_set(GradValues, i, Grad[i]);
+			Grad[i] = Vals[i];
+			for (int j = 0; j < 3; ++j)
+				Hess[i][j] = Vals[3 + HessIndices[j][i]];
 		}
-	}
-	// 	}
-
-	return GSL_SUCCESS;
-}
-
-/*
-*	Function to return the derivatives (jacobian matrix of gradient, ie Hessian of rho)
-*/
-
-int DF3D(const gsl_vector * pos, void * params, gsl_matrix * Jacobian){
-
-	MultiRootParams_s * RootParams = reinterpret_cast<MultiRootParams_s*>(params);
 
-	vec3 Point(pos->data);
-
-	if (!SetIndexAndWeightsForPoint(Point, *RootParams->VolInfo))
-		return GSL_ESANITY;
-
-	if (RootParams->HasHess){
+		return TRUE;
+	}
+	else if (!RootParams.HasGrad && RootParams.UseTricubic){
 		/*
-		*	Analytical Hessian available, so use that.
+		*	Gradient and Hessian from one set of tricubic coefficients.
 		*/
+		vec3 G;
+		mat33 H;
+		double Rho;
 
-		int HessIndices[3][3] = {
-			{ 0, 1, 2 },
-			{ 1, 3, 4 },
-			{ 2, 4, 5 }
-		};
+		if (!TricubicValGradHessForPoint(Point, *RootParams.VolInfo, *RootParams.RhoPtr, RootParams.TricubicCell, Rho, &G, &H))
+			return FALSE;
 
 		for (int i = 0; i < 3; ++i){
-			for (int j = 0; j < 3; ++j){
-				if (j >= i)
-					gsl_matrix_set(Jacobian, i, j, ValByCurrentIndexAndWeightsFromRawPtr(*RootParams->VolInfo, RootParams->HessPtrs->at(HessIndices[j][i])));
-				else
-					gsl_matrix_set(Jacobian, i, j, gsl_matrix_get(Jacobian, j, i));
-			}
+			Grad[i] = G[i];
+			for (int j = 0; j < 3; ++j)
+				Hess[i][j] = H.at(i, j);
 		}
+
+		return TRUE;
+	}
+
+	/*
+	*	Gradient
+	*/
+	if (RootParams.HasGrad){
+		if (RootParams.NodeCache != NULL && RootParams.NodeCache->HasGrad())
+			RootParams.NodeCache->ValsByIndexAndWeights(*RootParams.VolInfo, RootParams.NodeCache->GradOffset(), 3, Grad);
+		else
+			ValsByCurrentIndexAndWeightsFromRawPtrs(*RootParams.VolInfo, *RootParams.GradPtrs, Grad);
+	}
+	else{
+		vec3 G;
+		CalcGradForPoint(Point, RootParams.VolInfo->DelXYZ, *RootParams.VolInfo, eye<mat>(3, 3), 0, RootParams.IsPeriodic, G, *RootParams.RhoPtr, GPType_Invalid, &RootParams);
+		for (int i = 0; i < 3; ++i)
+			Grad[i] = G[i];
+	}
+
+	/*
+	*	Hessian
+	*/
+	if (!SetIndexAndWeightsForPoint(Point, *RootParams.VolInfo))
+		return FALSE;
+
+	if (RootParams.HasHess){
+		double H[6];
+		if (RootParams.NodeCache != NULL && RootParams.NodeCache->HasHess())
+			RootParams.NodeCache->ValsByIndexAndWeights(*RootParams.VolInfo, RootParams.NodeCache->HessOffset(), 6, H);
+		else
+			ValsByCurrentIndexAndWeightsFromRawPtrs(*RootParams.VolInfo, *RootParams.HessPtrs, H);
+
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 3; ++j)
+				Hess[i][j] = H[HessIndices[j][i]];
 	}
 	else{
 		/*
 		*	No analytical Hessian, so need to find derivative numerically.
-		*	Need to do it manually, since the GSL solver doesn't know not to
-		*	go beyond the bounds of the system.
 		*/
-		mat33 Hess;
-		if (RootParams->HasGrad){
+		mat33 H;
+		if (RootParams.HasGrad){
 			CalcHessFor3DPoint(Point,
-				RootParams->VolInfo->DelXYZ,
-				*RootParams->VolInfo,
-				RootParams->IsPeriodic,
-				Hess,
-				*RootParams->GradPtrs,
+				RootParams.VolInfo->DelXYZ,
+				*RootParams.VolInfo,
+				RootParams.IsPeriodic,
+				H,
+				*RootParams.GradPtrs,
 				GPType_Invalid,
-				params);
+				&RootParams);
 		}
 		else{
 			CalcHessForPoint(Point,
-				RootParams->VolInfo->DelXYZ,
-				*RootParams->VolInfo,
+				RootParams.VolInfo->DelXYZ,
+				*RootParams.VolInfo,
 				eye<mat>(3, 3),
-				RootParams->IsPeriodic,
-				Hess,
-				*RootParams->RhoPtr,
+				RootParams.IsPeriodic,
+				H,
+				*RootParams.RhoPtr,
 				GPType_Invalid,
-				params);
+				&RootParams);
 		}
 
-		for (int i = 0; i < 3; ++i) for (int j = 0; j < 3; ++j) gsl_matrix_set(Jacobian, i, j, Hess.at(i, j));
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 3; ++j)
+				Hess[i][j] = H.at(i, j);
 	}
 
-	return GSL_SUCCESS;
+	return TRUE;
 }
 
 /*
-*	Function to return both grad and dgrad (function and derivatives)
+*	Newton search for a CP inside the cell from CellMinXYZ to CellMaxXYZ
+*	(in the coordinates InCell() compares in), starting at Point.
+*	Same outcome as the GSL loop it replaced: the search stops when it
+*	converges, fails, runs out of iterations or leaves the cell, and
+*	the point it ends at is kept if it's in the cell.
 */
+template <typename InCellFunc>
+static const Boolean_t NewtonCPInCell(vec3 & Point, const double & ResidualTol, MultiRootParams_s & RootParams, InCellFunc InCell){
+	double x[3] = { Point[0], Point[1], Point[2] };
+	Boolean_t CPInCell = TRUE;
+	int Iter;
 
-int FDF3D(const gsl_vector * pos, void * params, gsl_vector * GradValues, gsl_matrix * Jacobian){
-
-	int Status = F3D(pos, params, GradValues);
+	NewtonSolve<3>(x,
+		[&](const double (&Pos)[3], double (&Grad)[3], double (&Hess)[3][3]){ return FDF3D(Pos, RootParams, Grad, Hess) == TRUE; },
+		[&](const double (&Pos)[3]){
+			if (Iter > CheckPosIter || Iter >= MaxCPIter){
+				vec3 Pt;
+				for (int i = 0; i < 3; ++i) Pt[i] = Pos[i];
+				CPInCell = InCell(Pt);
+			}
+			return CPInCell == TRUE;
+		},
+		ResidualTol, MaxCPIter, Iter);
 
-	if (Status == GSL_SUCCESS)
-		Status = DF3D(pos, params, Jacobian);
+	for (int i = 0; i < 3; ++i) Point[i] = x[i];
 
-	return Status;
+	return InCell(Point);
 }
 
 
@@ -856,16 +1204,13 @@ const Boolean_t CritPointInCell(const vector<int> & IJK,
 	double & RhoValue,
 	const double & RhoCutoff,
 	char & Type,
-	MultiRootParams_s & RootParams,
-	MultiRootObjects_s & MR)
+	MultiRootParams_s & RootParams)
 {
 	// 	TecUtilDialogMessageBox(string("CritPointInCell, rho ptr good " + to_string(RootParams.RhoPtr->IsReady())).c_str(), MessageBoxType_Information);
 
 	Boolean_t CPInCell = TRUE;
 
 	Type = 0;
-	int Status = GSL_SUCCESS;
-	int Iter = 0;
 
 	vec3 MinCellXYZ, MaxCellXYZ;
 
@@ -873,7 +1218,6 @@ const Boolean_t CritPointInCell(const vector<int> & IJK,
 		MinCellXYZ[i] = RootParams.VolInfo->DelXYZ[i] * static_cast<double>(IJK[i]) + RootParams.VolInfo->MinXYZ[i];
 		MaxCellXYZ[i] = MinCellXYZ[i] + RootParams.VolInfo->DelXYZ[i];
 		Point[i] = MinCellXYZ[i] + RootParams.VolInfo->DelXYZ[i] * 0.5;
-		gsl_vector_set(MR.pos, i, Point[i]);
 	}
 
 	// 	TecUtilDialogMessageBox("start point set", MessageBoxType_Information);
@@ -881,48 +1225,20 @@ const Boolean_t CritPointInCell(const vector<int> & IJK,
 	CPInCell = SetIndexAndWeightsForPoint(Point, *RootParams.VolInfo);
 	// 	TecUtilDialogMessageBox("initial point indexed", MessageBoxType_Information);
 	if (CPInCell){
-		RhoValue = ValByCurrentIndexAndWeightsFromRawPtr(*RootParams.VolInfo, *RootParams.RhoPtr);
+		RhoValue = RhoByCurrentIndexAndWeights(RootParams);
 		CPInCell = (RhoValue >= RhoCutoff);
 	}
 
 	// 	TecUtilDialogMessageBox("initial point checked", MessageBoxType_Information);
 
 	if (CPInCell){
-		gsl_multiroot_fdfsolver_set(MR.s, &MR.Func, MR.pos);
-
-
-		// 		TecUtilDialogMessageBox("solver set", MessageBoxType_Information);
-
-		do
-		{
-			++Iter;
-
-			// 			string str = "iteration " + to_string(Iter);
-			// 			TecUtilDialogMessageBox(str.c_str(), MessageBoxType_Information);
-
-			Status = gsl_multiroot_fdfsolver_iterate(MR.s);
-
-			if (Status != GSL_CONTINUE && Status != GSL_SUCCESS)
-				break;
-
-			Point = MR.s->x->data;
-
-			Status = gsl_multiroot_test_residual(MR.s->f, 1e-7);
-
-			if (Iter > CheckPosIter || Iter >= MaxCPIter){
-				CPInCell = sum(Point >= MinCellXYZ) == 3 && sum(Point <= MaxCellXYZ) == 3;
-			}
-
-		} while (CPInCell && Status == GSL_CONTINUE && Iter < MaxCPIter);
-
-		Point = MR.s->x->data;
-
-		CPInCell = sum(Point >= MinCellXYZ) == 3 && sum(Point <= MaxCellXYZ) == 3;
+		CPInCell = NewtonCPInCell(Point, 1e-7, RootParams,
+			[&](const vec3 & Pt){ return sum(Pt >= MinCellXYZ) == 3 && sum(Pt <= MaxCellXYZ) == 3; });
 
 		RhoValue = 0.0;
 		if (CPInCell){
 			CPInCell = SetIndexAndWeightsForPoint(Point, *RootParams.VolInfo);
-			RhoValue = ValByCurrentIndexAndWeightsFromRawPtr(*RootParams.VolInfo, *RootParams.RhoPtr);
+			RhoValue = RhoByCurrentIndexAndWeights(RootParams);
 		}
 
 		if (CPInCell && RhoValue >= RhoCutoff){
@@ -958,21 +1274,16 @@ const Boolean_t CritPointInCell(
 	double & RhoValue,
 	const double & RhoCutoff,
 	char & Type,
-	MultiRootParams_s & RootParams,
-	MultiRootObjects_s & MR)
+	MultiRootParams_s & RootParams)
 {
 	// 	TecUtilDialogMessageBox(string("CritPointInCell, rho ptr good " + to_string(RootParams.RhoPtr->IsReady())).c_str(), MessageBoxType_Information);
 
 	Boolean_t CPInCell = TRUE;
 
 	Type = 0;
-	int Status = GSL_SUCCESS;
-	int Iter = 0;
 
 	Point = (CellMaxXYZ + CellMinXYZ) * 0.5;
-	for (int i = 0; i < 3; ++i) gsl_vector_set(MR.pos, i, Point[i]);
 
-	vec3 CheckPt;
 	vec3 CellMinCheck = RootParams.VolInfo->BasisInverse * (CellMinXYZ - RootParams.VolInfo->MinXYZ),
 		CellMaxCheck = RootParams.VolInfo->BasisInverse * (CellMaxXYZ - RootParams.VolInfo->MinXYZ);
 
@@ -981,52 +1292,23 @@ const Boolean_t CritPointInCell(
 	CPInCell = SetIndexAndWeightsForPoint(Point, *RootParams.VolInfo);
 	// 	TecUtilDialogMessageBox("initial point indexed", MessageBoxType_Information);
 	if (CPInCell){
-		RhoValue = ValByCurrentIndexAndWeightsFromRawPtr(*RootParams.VolInfo, *RootParams.RhoPtr);
+		RhoValue = RhoByCurrentIndexAndWeights(RootParams);
 		CPInCell = (RhoValue >= RhoCutoff);
 	}
 
 	// 	TecUtilDialogMessageBox("initial point checked", MessageBoxType_Information);
 
 	if (CPInCell){
-		gsl_multiroot_fdfsolver_set(MR.s, &MR.Func, MR.pos);
-
-
-		// 		TecUtilDialogMessageBox("solver set", MessageBoxType_Information);
-
-		do
-		{
-			++Iter;
-
-			// 			string str = "iteration " + to_string(Iter);
-			// 			TecUtilDialogMessageBox(str.c_str(), MessageBoxType_Information);
-
-			Status = gsl_multiroot_fdfsolver_iterate(MR.s);
-
-			if (Status != GSL_CONTINUE && Status != GSL_SUCCESS)
-				break;
-
-			Point = MR.s->x->data;
-
-			Status = gsl_multiroot_test_residual(MR.s->f, 1e-12);
-
-			if (Iter > CheckPosIter || Iter >= MaxCPIter){
-				CheckPt = RootParams.VolInfo->BasisInverse * (Point - RootParams.VolInfo->MinXYZ);
-				CPInCell = sum(CheckPt >= CellMinCheck) == 3 && sum(CheckPt <= CellMaxCheck) == 3;
-			}
-
-		} while (CPInCell && Status == GSL_CONTINUE && Iter < MaxCPIter);
-
-		if (CPInCell){
-			Point = MR.s->x->data;
-
-			CheckPt = RootParams.VolInfo->BasisInverse * (Point - RootParams.VolInfo->MinXYZ);
-			CPInCell = sum(CheckPt >= CellMinCheck) == 3 && sum(CheckPt <= CellMaxCheck) == 3;
-		}
+		CPInCell = NewtonCPInCell(Point, 1e-12, RootParams,
+			[&](const vec3 & Pt){
+				vec3 CheckPt = RootParams.VolInfo->BasisInverse * (Pt - RootParams.VolInfo->MinXYZ);
+				return sum(CheckPt >= CellMinCheck) == 3 && sum(CheckPt <= CellMaxCheck) == 3;
+			});
 
 		if (CPInCell){
 			RhoValue = 0.0;
 			CPInCell = SetIndexAndWeightsForPoint(Point, *RootParams.VolInfo);
-			RhoValue = ValByCurrentIndexAndWeightsFromRawPtr(*RootParams.VolInfo, *RootParams.RhoPtr);
+			RhoValue = RhoByCurrentIndexAndWeights(RootParams);
 		}
 
 		if (CPInCell && RhoValue >= RhoCutoff){
@@ -1061,7 +1343,7 @@ const Boolean_t CritPointInCell(
 *	for critical points.
 */
 const Boolean_t FindCPs(CritPoints_c & CPs,
-	VolExtentIndexWeights_s VolInfo,
+	const VolExtentInfo_s & VolInfo,
 	const Boolean_t & IsPeriodic,
 	const vector<int> & StartIJK,
 	const vector<int> & EndIJK,
@@ -1079,8 +1361,10 @@ const Boolean_t FindCPs(CritPoints_c & CPs,
 	double TmpRho;
 	char TmpType;
 
+	VolExtentIndexWeights_s ThreadVolInfo(VolInfo);
+
 	MultiRootParams_s RootParams;
-	RootParams.VolInfo = &VolInfo;
+	RootParams.VolInfo = &ThreadVolInfo;
 	RootParams.IsPeriodic = IsPeriodic;
 	RootParams.RhoPtr = &RhoPtr;
 	RootParams.GradPtrs = &GradXYZPtrs;
@@ -1098,13 +1382,6 @@ const Boolean_t FindCPs(CritPoints_c & CPs,
 	for (int i = 0; i < 6 && RootParams.HasHess; ++i)
 		RootParams.HasHess = RootParams.HessPtrs->at(i).IsReady();
 
-	MultiRootObjects_s MR;
-
-	MR.Func = { &F3D, &DF3D, &FDF3D, 3, &RootParams };
-	MR.pos = gsl_vector_alloc(3);
-	MR.T = gsl_multiroot_fdfsolver_newton;
-	MR.s = gsl_multiroot_fdfsolver_alloc(MR.T, 3);
-
 	string StatusStr = "Finding critical points";
 	int Range = EndIJK[2] - StartIJK[2];
 	int kNum = 0;
@@ -1125,7 +1402,7 @@ const Boolean_t FindCPs(CritPoints_c & CPs,
 				// 				string str = "{i,j,k} = {";
 				// 				for (int i = 0; i < 3; ++i) str += to_string(IJK[i]) + ", ";
 				// 				TecUtilDialogMessageBox(str.c_str(), MessageBoxType_Information);
-				if (CritPointInCell(IJK, TmpPoint, PrincDir, TmpRho, CPs.GetRhoCutoff(), TmpType, RootParams, MR)
+				if (CritPointInCell(IJK, TmpPoint, PrincDir, TmpRho, CPs.GetRhoCutoff(), TmpType, RootParams)
 					&& TmpType != 0)
 				{
 					IsOk = CPs.AddPoint(TmpRho, TmpPoint, PrincDir, TmpType);
@@ -1137,54 +1414,244 @@ const Boolean_t FindCPs(CritPoints_c & CPs,
 	if (StartIJK[2] == 1)
 		StatusDrop(VolInfo.AddOnID);
 
-	if (MR.s != NULL)
-		gsl_multiroot_fdfsolver_free(MR.s);
-	// 	if (MR.pos != NULL)
-	// 		gsl_vector_free(MR.pos);
-
 	return IsOk;
 }
 
 
 
 /*
-*	Function for searching a subzone (ordered IJK)
-*	for critical points using aribrary cells.
+*	Interpolate values onto the regular lattice used by FindCPs().
+*	Instantiated per storage type and grid type so the inner loop
+*	has no type switch. If Mask is given, only the lattice points
+*	where it's nonzero are sampled.
 */
-const Boolean_t FindCPs(CritPoints_c & CPs,
-	const VolExtentIndexWeights_s & VolInfo,
-	const double & CellSpacing,
-	double & RhoCutoff,
-	const Boolean_t & IsPeriodic,
-	FieldDataPointer_c & RhoPtr,
-	vector<FieldDataPointer_c> & GradXYZPtrs,
-	vector<FieldDataPointer_c> & HessPtrs)
+template <typename T, VolGridType_e GridType>
+void SampleValsOnLatticeOnGrid(cube & Vals,
+	const T * Ptr,
+	const vec3 & Origin,
+	const mat33 & LatticeVector,
+	vector<VolExtentIndexWeights_s> & VolInfoList,
+	const uchar_cube * Mask)
 {
-	Boolean_t IsOk = ((GradXYZPtrs.size() == 3 || GradXYZPtrs.size() == 0)
-		&& (HessPtrs.size() == 0 || HessPtrs.size() == 6));
-
-	if (!IsOk) return IsOk;
-
-	int NumThreads = omp_get_num_procs();
-
-	vector<VolExtentIndexWeights_s> VolInfoList(NumThreads, VolInfo);
+	int NumPtsXYZ[3] = { (int)Vals.n_rows, (int)Vals.n_cols, (int)Vals.n_slices };
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int zi = 0; zi < NumPtsXYZ[2]; ++zi){
+		VolExtentIndexWeights_s & ThreadVolInfo = VolInfoList[omp_get_thread_num()];
+		for (int yi = 0; yi < NumPtsXYZ[1]; ++yi){
+			for (int xi = 0; xi < NumPtsXYZ[0]; ++xi){
+				if (Mask != NULL && !Mask->at(xi, yi, zi))
+					continue;
+				vec3 iXYZ;
+				iXYZ << xi << yi << zi;
+				vec3 Pt = Origin + LatticeVector * iXYZ;
+				if (GetIndexAndWeightsForPointOnGrid<GridType>(Pt, ThreadVolInfo, ThreadVolInfo))
+					Vals(xi, yi, zi) = ValByCurrentIndexAndWeights(ThreadVolInfo, Ptr);
+				else
+					Vals(xi, yi, zi) = -1.0;
+			}
+		}
+	}
+}
 
-	// 	vector<vec3> BV(3);
-	// 	BV[0] << 1 << 0 << 0;
-	// 	BV[1] << 0 << 1 << 0;
-	// 	BV[2] << 0 << 0 << 1;
+template <typename T>
+void SampleValsOnLattice(cube & Vals,
+	const T * Ptr,
+	const vec3 & Origin,
+	const mat33 & LatticeVector,
+	vector<VolExtentIndexWeights_s> & VolInfoList,
+	const uchar_cube * Mask)
+{
+	switch (VolInfoList[0].GridType){
+		case VolGridType_Orthogonal:
+			SampleValsOnLatticeOnGrid<T, VolGridType_Orthogonal>(Vals, Ptr, Origin, LatticeVector, VolInfoList, Mask);
+			break;
+		case VolGridType_Cubic:
+			SampleValsOnLatticeOnGrid<T, VolGridType_Cubic>(Vals, Ptr, Origin, LatticeVector, VolInfoList, Mask);
+			break;
+		default:
+			SampleValsOnLatticeOnGrid<T, VolGridType_General>(Vals, Ptr, Origin, LatticeVector, VolInfoList, Mask);
+			break;
+	}
+}
 
-	vector<MultiRootParams_s> RootParams(NumThreads);
-	mat33 I = eye<mat>(3, 3);
-	for (int r = 0; r < NumThreads; ++r){
-		RootParams[r].CalcType = GPType_Classic;
-		RootParams[r].VolInfo = &VolInfoList[r];
+/*
+*	Sample rho, whatever its storage type, onto the lattice.
+*/
+static const Boolean_t SampleRhoOnLattice(cube & RhoVals,
+	const FieldDataPointer_c & RhoPtr,
+	const vec3 & Origin,
+	const mat33 & LatticeVector,
+	vector<VolExtentIndexWeights_s> & VolInfoList,
+	const uchar_cube * Mask = NULL)
+{
+	switch (RhoPtr.FDType()){
+		case FieldDataType_Double:
+			SampleValsOnLattice(RhoVals, RhoPtr.TypedReadPtr<double_t>(), Origin, LatticeVector, VolInfoList, Mask);
+			break;
+		case FieldDataType_Float:
+			SampleValsOnLattice(RhoVals, RhoPtr.TypedReadPtr<float_t>(), Origin, LatticeVector, VolInfoList, Mask);
+			break;
+		case FieldDataType_Int32:
+			SampleValsOnLattice(RhoVals, RhoPtr.TypedReadPtr<Int32_t>(), Origin, LatticeVector, VolInfoList, Mask);
+			break;
+		case FieldDataType_Int16:
+			SampleValsOnLattice(RhoVals, RhoPtr.TypedReadPtr<Int16_t>(), Origin, LatticeVector, VolInfoList, Mask);
+			break;
+		case FieldDataType_Byte:
+			SampleValsOnLattice(RhoVals, RhoPtr.TypedReadPtr<Byte_t>(), Origin, LatticeVector, VolInfoList, Mask);
+			break;
+		case FieldDataType_Bit:
+			SampleValsOnLattice(RhoVals, RhoPtr.TypedReadPtr<bool>(), Origin, LatticeVector, VolInfoList, Mask);
+			break;
+		default:
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/*
+*	Mark the lattice cells that could hold a CP, so FindCPs() can skip
+*	the Newton search everywhere else. A CP of a trilinear field needs
+*	every gradient component to change sign (or be zero) across the
+*	cell's eight corners. The gradient here is the centered difference
+*	of the lattice rho rather than the interpolant the Newton search
+*	uses, so the marked cells are grown by one cell each way to cover
+*	the difference. Corners where rho couldn't be sampled count as any
+*	sign. Candidates(xi, yi, zi) is nonzero for cell xi..xi+1, etc.
+*/
+static void MarkCPCandidateCells(const cube & RhoVals, const Boolean_t & IsPeriodic, uchar_cube & Candidates)
+{
+	int N[3] = { (int)RhoVals.n_rows, (int)RhoVals.n_cols, (int)RhoVals.n_slices };
+
+	/*
+	*	Per lattice point, bit d is set if gradient component d is >= 0
+	*	and bit d + 3 if it's <= 0.
+	*/
+	uchar_cube SignBits(N[0], N[1], N[2]);
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int zi = 0; zi < N[2]; ++zi){
+		int Z[2] = { zi - 1, zi + 1 };
+		for (int yi = 0; yi < N[1]; ++yi){
+			int Y[2] = { yi - 1, yi + 1 };
+			for (int j = 0; j < 2; ++j){
+				if (IsPeriodic){
+					Z[j] = (Z[j] + N[2]) % N[2];
+					Y[j] = (Y[j] + N[1]) % N[1];
+				}
+				else{
+					Z[j] = MIN(MAX(Z[j], 0), N[2] - 1);
+					Y[j] = MIN(MAX(Y[j], 0), N[1] - 1);
+				}
+			}
+			const double * Row = RhoVals.slice(zi).colptr(yi);
+			const double * RowYm = RhoVals.slice(zi).colptr(Y[0]), * RowYp = RhoVals.slice(zi).colptr(Y[1]);
+			const double * RowZm = RhoVals.slice(Z[0]).colptr(yi), * RowZp = RhoVals.slice(Z[1]).colptr(yi);
+			unsigned char * Bits = SignBits.slice(zi).colptr(yi);
+			for (int xi = 0; xi < N[0]; ++xi){
+				int Xm = xi - 1, Xp = xi + 1;
+				if (IsPeriodic){
+					Xm = (Xm + N[0]) % N[0];
+					Xp = Xp % N[0];
+				}
+				else{
+					Xm = MAX(Xm, 0);
+					Xp = MIN(Xp, N[0] - 1);
+				}
+				double G[3] = { Row[Xp] - Row[Xm], RowYp[xi] - RowYm[xi], RowZp[xi] - RowZm[xi] };
+				unsigned char b = 0;
+				for (int d = 0; d < 3; ++d)
+					b |= ((G[d] >= 0.0) << d) | ((G[d] <= 0.0) << (d + 3));
+				if (Row[xi] < 0.0 || Row[Xp] < 0.0 || Row[Xm] < 0.0 || RowYp[xi] < 0.0 || RowYm[xi] < 0.0 || RowZp[xi] < 0.0 || RowZm[xi] < 0.0)
+					b = 0x3F;
+				Bits[xi] = b;
+			}
+		}
+	}
+
+	/*
+	*	A cell straddles zero in every component if its corners
+	*	have both sign bits set for all three.
+	*/
+	uchar_cube Marked(N[0], N[1], N[2]);
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int zi = 0; zi < N[2]; ++zi){
+		int Z[2] = { zi, IsPeriodic ? (zi + 1) % N[2] : MIN(zi + 1, N[2] - 1) };
+		for (int yi = 0; yi < N[1]; ++yi){
+			int Y[2] = { yi, IsPeriodic ? (yi + 1) % N[1] : MIN(yi + 1, N[1] - 1) };
+			const unsigned char * Corners[4] = {
+				SignBits.slice(Z[0]).colptr(Y[0]), SignBits.slice(Z[0]).colptr(Y[1]),
+				SignBits.slice(Z[1]).colptr(Y[0]), SignBits.slice(Z[1]).colptr(Y[1]) };
+			unsigned char * Out = Marked.slice(zi).colptr(yi);
+			for (int xi = 0; xi < N[0]; ++xi){
+				int Xp = IsPeriodic ? (xi + 1) % N[0] : MIN(xi + 1, N[0] - 1);
+				unsigned char b = 0;
+				for (int c = 0; c < 4; ++c)
+					b |= Corners[c][xi] | Corners[c][Xp];
+				Out[xi] = ((b & (b >> 3) & 0x7) == 0x7);
+			}
+		}
+	}
+
+	/*
+	*	Grow by one cell, one direction at a time.
+	*/
+	Candidates = Marked;
+	for (int Dir = 0; Dir < 3; ++Dir){
+		Marked = Candidates;
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+		for (int zi = 0; zi < N[2]; ++zi){
+			for (int yi = 0; yi < N[1]; ++yi){
+				for (int xi = 0; xi < N[0]; ++xi){
+					int IJK[3] = { xi, yi, zi };
+					unsigned char b = Marked(xi, yi, zi);
+					for (int j = -1; j <= 1 && !b; j += 2){
+						int Nbr[3] = { xi, yi, zi };
+						Nbr[Dir] = IJK[Dir] + j;
+						if (IsPeriodic)
+							Nbr[Dir] = (Nbr[Dir] + N[Dir]) % N[Dir];
+						else if (Nbr[Dir] < 0 || Nbr[Dir] >= N[Dir])
+							continue;
+						b = Marked(Nbr[0], Nbr[1], Nbr[2]);
+					}
+					Candidates(xi, yi, zi) = b;
+				}
+			}
+		}
+	}
+}
+
+/*
+*	Per-thread parameters for the lattice CP searches.
+*/
+static void SetupCPSearchParams(vector<MultiRootParams_s> & RootParams,
+	vector<VolExtentIndexWeights_s> & VolInfoList,
+	const mat33 & BasisVectors,
+	const Boolean_t & IsPeriodic,
+	FieldDataPointer_c & RhoPtr,
+	vector<FieldDataPointer_c> & GradXYZPtrs,
+	vector<FieldDataPointer_c> & HessPtrs,
+	const NodeRecordCache_c * NodeCache)
+{
+	RootParams.resize(VolInfoList.size());
+	for (int r = 0; r < RootParams.size(); ++r){
+		RootParams[r].CalcType = GPType_Classic;
+		RootParams[r].VolInfo = &VolInfoList[r];
 		RootParams[r].IsPeriodic = IsPeriodic;
 		RootParams[r].RhoPtr = &RhoPtr;
 		RootParams[r].GradPtrs = &GradXYZPtrs;
 		RootParams[r].HessPtrs = &HessPtrs;
+		RootParams[r].NodeCache = NodeCache;
 
-		RootParams[r].BasisVectors = &I;
+		RootParams[r].BasisVectors = &BasisVectors;
 
 		RootParams[r].HasGrad = GradXYZPtrs.size() == 3;
 		RootParams[r].HasHess = HessPtrs.size() == 6;
@@ -1195,19 +1662,193 @@ const Boolean_t FindCPs(CritPoints_c & CPs,
 		for (int i = 0; i < 6 && RootParams[r].HasHess; ++i)
 			RootParams[r].HasHess = RootParams[r].HessPtrs->at(i).IsReady();
 	}
+}
+
+/*
+*	Search lattice cell xi, yi, zi (from lattice point xi, yi, zi to
+*	xi + 1, ...) for CPs, adding any found to ThreadCPs.
+*	A lattice point that's a local max/min of RhoVals gets a gradient
+*	path up/down to the nuclear/cage CP. Otherwise, if IsCandidate,
+*	the cell gets a Newton search.
+*/
+static void SearchCPLatticeCell(const int & xi,
+	const int & yi,
+	const int & zi,
+	const vector<int> & NumPtsXYZ,
+	const cube & RhoVals,
+	const Boolean_t & IsCandidate,
+	const VolExtentInfo_s & VolInfo,
+	const mat33 & LatticeVector,
+	double & RhoCutoff,
+	const NodeRecordCache_c * NodeCache,
+	MultiRootParams_s & RootParams,
+	CritPoints_c & ThreadCPs)
+{
+	vec3 iXYZ, CellMinXYZ, CellMaxXYZ;
+	iXYZ << xi << yi << zi;
+	CellMinXYZ = VolInfo.MinXYZ + LatticeVector * iXYZ;
+	for (int d = 0; d < 3; ++d) {
+		if (iXYZ[d] < NumPtsXYZ[d] - 1){
+			CellMaxXYZ[d] = CellMinXYZ[d];
+			for (int di = 0; di < 3; ++di) CellMaxXYZ[d] += LatticeVector.at(d, di);
+		}
+		else{
+			CellMaxXYZ[d] = VolInfo.MinXYZ[d];
+			for (int di = 0; di < 3; ++di) CellMaxXYZ[d] += VolInfo.BasisVectors.at(d, di);
+		}
+	}
+
+	/*
+	*	Check for local Min/Max. Not below the rho cutoff, where no CP
+	*	is kept (and where a periodic system's minima are, with nothing
+	*	for the path from it to follow).
+	*/
+	bool IsMaxMin = false;
+	vector<double> Signs = { 1, -1 };
+	double CellRho = RhoVals(xi, yi, zi);
+	for (int s = 0; s < 2 && CellRho >= RhoCutoff; ++s){
+		IsMaxMin = true;
+		vec3 CompPt;
+		for (int xj = xi - 1; xj <= xi + 1 && IsMaxMin; ++xj){
+			int xk = xj;
+			if (xk < 0){
+				if (VolInfo.IsPeriodic) xk = NumPtsXYZ[0] - 1;
+				else continue;
+			}
+			else if (xk >= NumPtsXYZ[0]){
+				if (VolInfo.IsPeriodic) xk = 0;
+				else continue;
+			}
+			for (int yj = yi - 1; yj <= yi + 1 && IsMaxMin; ++yj){
+				int yk = yj;
+				if (yk < 0){
+					if (VolInfo.IsPeriodic) yk = NumPtsXYZ[1] - 1;
+					else continue;
+				}
+				else if (yk >= NumPtsXYZ[1]){
+					if (VolInfo.IsPeriodic) yk = 0;
+					else continue;
+				}
+				for (int zj = zi - 1; zj <= zi + 1 && IsMaxMin; ++zj){
+					int zk = zj;
+					if (zk < 0){
+						if (VolInfo.IsPeriodic) zk = NumPtsXYZ[2] - 1;
+						else continue;
+					}
+					else if (zk >= NumPtsXYZ[2]){
+						if (VolInfo.IsPeriodic) zk = 0;
+						else continue;
+					}
+					if (xi != xk || yi != yk || zi != zk){
+						double CompVal = RhoVals(xk, yk, zk);
+						IsMaxMin = IsMaxMin && (Signs[s] * CellRho >= Signs[s] * CompVal);
+					}
+				}
+			}
+		}
+		if (IsMaxMin){
+			GradPath_c GP(
+				CellMinXYZ,
+				(StreamDir_e)s,
+				100,
+				GPType_Classic,
+				GPTerminate_AtRhoValue,
+				NULL,
+				&ThreadCPs,
+				NULL,
+				&RhoCutoff,
+				*RootParams.VolInfo,
+				*RootParams.HessPtrs,
+				*RootParams.GradPtrs,
+				*RootParams.RhoPtr);
+
+			GP.SetNodeCache(NodeCache);
+
+			GP.Seed(false);
+
+			if (GP.IsMade() && GP[-1].is_finite()){
+#ifdef _DEBUG
+				GP.SaveAsOrderedZone();
+#endif
+
+				CompPt = GP[-1];
+				vec3 EigVals, PrincDir;
+				mat33 EigVecs;
+				char Type = 0;
+
+				CalcEigenSystemForPoint(CompPt,
+					EigVals,
+					EigVecs,
+					RootParams);
+
+				for (int i = 0; i < 3; ++i){
+					if (EigVals[i] > 0)
+						Type++;
+					else
+						Type--;
+				}
+				if (Type == CPType_Nuclear || Type == CPType_Ring)
+					PrincDir = EigVecs.row(0).t();
+				else
+					PrincDir = EigVecs.row(2).t();
 
-	vector<MultiRootObjects_s> MR(NumThreads);
+				IsMaxMin = (Type == CPType_Nuclear || Type == CPType_Cage);
+
+				// 						if (IsMaxMin)
+				// 						ThreadCPs.AddPoint(GP.RhoAt(-1), CompPt, PrincDir, Type);
+				ThreadCPs.AddPoint(GP.RhoAt(-1), CompPt, PrincDir, (s == 0 ? CPType_Nuclear : CPType_Cage));
+			}
 
-	for (int m = 0; m < NumThreads; ++m){
-		MR[m].Func = { &F3D, &DF3D, &FDF3D, 3, &RootParams[m] };
-		MR[m].pos = gsl_vector_alloc(3);
-		MR[m].T = gsl_multiroot_fdfsolver_newton;
-		MR[m].s = gsl_multiroot_fdfsolver_alloc(MR[m].T, 3);
+			break;
+		}
+	}
+	/*
+	*	Rigorous check using Newton-Raphson method,
+	*	in cells the prefilter couldn't rule out
+	*/
+	vec3 Point, PrincDir;
+	double Rho;
+	char Type;
+	if (!IsMaxMin && IsCandidate && CritPointInCell(CellMinXYZ,
+		CellMaxXYZ,
+		Point,
+		PrincDir,
+		Rho,
+		RhoCutoff,
+		Type,
+		RootParams))
+	{
+		ThreadCPs.AddPoint(Rho, Point, PrincDir, Type);
 	}
+}
+
+/*
+*	Function for searching a subzone (ordered IJK)
+*	for critical points using aribrary cells.
+*/
+const Boolean_t FindCPs(CritPoints_c & CPs,
+	const VolExtentInfo_s & VolInfo,
+	const double & CellSpacing,
+	double & RhoCutoff,
+	const Boolean_t & IsPeriodic,
+	FieldDataPointer_c & RhoPtr,
+	vector<FieldDataPointer_c> & GradXYZPtrs,
+	vector<FieldDataPointer_c> & HessPtrs,
+	const NodeRecordCache_c * NodeCache,
+	double * SkippedCellFraction)
+{
+	Boolean_t IsOk = ((GradXYZPtrs.size() == 3 || GradXYZPtrs.size() == 0)
+		&& (HessPtrs.size() == 0 || HessPtrs.size() == 6));
 
-	vector<vec3> TmpPoint(NumThreads), PrincDir(NumThreads), CellMinXYZ(NumThreads), CellMaxXYZ(NumThreads);
-	vector<double> TmpRho(NumThreads);
-	vector<char> TmpType(NumThreads);
+	if (!IsOk) return IsOk;
+
+	int NumThreads = omp_get_num_procs();
+
+	vector<VolExtentIndexWeights_s> VolInfoList(NumThreads, VolInfo);
+
+	vector<MultiRootParams_s> RootParams;
+	mat33 I = eye<mat>(3, 3);
+	SetupCPSearchParams(RootParams, VolInfoList, I, IsPeriodic, RhoPtr, GradXYZPtrs, HessPtrs, NodeCache);
 
 	string StatusStr = "Finding critical points";
 
@@ -1232,23 +1873,26 @@ const Boolean_t FindCPs(CritPoints_c & CPs,
 	StatusLaunch((StatusStr + " (Loading data...)").c_str(), VolInfo.AddOnID, TRUE);
 
 	mat33 LatticeVector = VolInfo.BasisNormalized * CellSpacing;
-	mat33 LatticeInverse = VolInfo.BasisNormalized * CellSpacing;
 
 	cube RhoVals(NumPtsXYZ[0], NumPtsXYZ[1], NumPtsXYZ[2]);
-#ifndef _DEBUG
-#pragma omp parallel for schedule(dynamic)
-#endif
-	for (int zi = 0; zi < NumPtsXYZ[2]; ++zi){
-		int ThreadNum = omp_get_thread_num();
-		for (int yi = 0; yi < NumPtsXYZ[1]; ++yi){
-			for (int xi = 0; xi < NumPtsXYZ[0]; ++xi){
-				vec3 iXYZ;
-				iXYZ << xi << yi << zi;
-				vec3 Pt = VolInfo.MinXYZ + LatticeVector * iXYZ;
-				double CellRho = RhoPtr.At(Pt, *RootParams[ThreadNum].VolInfo);
-				RhoVals(xi, yi, zi) = CellRho;
+	IsOk = SampleRhoOnLattice(RhoVals, RhoPtr, VolInfo.MinXYZ, LatticeVector, VolInfoList);
+
+	uchar_cube CPCandidates;
+	if (IsOk){
+		MarkCPCandidateCells(RhoVals, VolInfo.IsPeriodic, CPCandidates);
+
+		double NumCells = 0.0, NumCandidates = 0.0;
+		for (int zi = StartPt[2]; zi < EndPt[2]; ++zi){
+			for (int yi = StartPt[1]; yi < EndPt[1]; ++yi){
+				for (int xi = StartPt[0]; xi < EndPt[0]; ++xi){
+					NumCells += 1.0;
+					if (CPCandidates(xi, yi, zi))
+						NumCandidates += 1.0;
+				}
 			}
 		}
+		if (SkippedCellFraction != NULL)
+			*SkippedCellFraction = (NumCells > 0.0 ? 1.0 - NumCandidates / NumCells : 0.0);
 	}
 
 #ifndef _DEBUG
@@ -1261,190 +1905,1198 @@ const Boolean_t FindCPs(CritPoints_c & CPs,
 #pragma omp flush (IsOk)
 		}
 #pragma omp flush (IsOk)
-		// 		CellMinXYZ[ThreadNum][2] = VolInfo.MinXYZ[2] + static_cast<double>(zi)* CellSpacing;
-		// 		if (zi < NumPtsXYZ[2] - 1) CellMaxXYZ[ThreadNum][2] = CellMinXYZ[ThreadNum][2] + CellSpacing;
-		// 		else CellMaxXYZ[ThreadNum][2] = VolInfo.MaxXYZ[2];
-		// 
-		// 		CellMinXYZ[ThreadNum][1] = VolInfo.MinXYZ[1];
-
 		for (int yi = StartPt[1]; yi < EndPt[1] && IsOk; ++yi){
-			// 			if (yi < NumPtsXYZ[1] - 1) CellMaxXYZ[ThreadNum][1] = CellMinXYZ[ThreadNum][1] + CellSpacing;
-			// 			else CellMaxXYZ[ThreadNum][1] = VolInfo.MaxXYZ[1];
-			// 
-			// 			CellMinXYZ[ThreadNum][0] = VolInfo.MinXYZ[0];
-
 			for (int xi = StartPt[0]; xi < EndPt[0] && IsOk; ++xi){
-				// 				if (xi < NumPtsXYZ[0] - 1) CellMaxXYZ[ThreadNum][0] = CellMinXYZ[ThreadNum][0] + CellSpacing;
-				// 				else CellMaxXYZ[ThreadNum][0] = VolInfo.MaxXYZ[0];
+				SearchCPLatticeCell(xi, yi, zi, NumPtsXYZ, RhoVals, CPCandidates(xi, yi, zi),
+					VolInfo, LatticeVector, RhoCutoff, NodeCache, RootParams[ThreadNum], ThreadCPs[ThreadNum]);
+			}
+		}
+	}
 
-				vec3 iXYZ;
-				iXYZ << xi << yi << zi;
-				CellMinXYZ[ThreadNum] = VolInfo.MinXYZ + LatticeVector * iXYZ;
-				for (int d = 0; d < 3; ++d) {
-					if (iXYZ[d] < NumPtsXYZ[d] - 1){
-						CellMaxXYZ[ThreadNum][d] = CellMinXYZ[ThreadNum][d];
-						for (int di = 0; di < 3; ++di) CellMaxXYZ[ThreadNum][d] += LatticeVector.at(d, di);
-					}
-					else{
-						CellMaxXYZ[ThreadNum][d] = VolInfo.MinXYZ[d];
-						for (int di = 0; di < 3; ++di) CellMaxXYZ[ThreadNum][d] += VolInfo.BasisVectors.at(d, di);
+	StatusDrop(VolInfo.AddOnID);
+
+	if (IsOk){
+		CPs = CritPoints_c(ThreadCPs);
+		if (IsPeriodic)
+			CPs.SetSpatialIndexLattice(PeriodicLatticeVectors(VolInfo));
+		CPs.RemoveSpuriousCPs();
+	}
+
+	return IsOk;
+}
+
+/*
+*	One level of the coarse-to-fine search: the lattice points Stride
+*	apart on the FindCPs() lattice, plus its last point if the volume
+*	isn't periodic. Cell I of the level spans the lattice cells
+*	I * Stride to I * Stride + Stride - 1.
+*/
+struct CPSearchLevel_s{
+	int Stride;
+	int NumLatticePts[3], NumLatticeCells[3];
+	int NumPts[3], NumCells[3];
+	Boolean_t IsPeriodic;
+
+	void Setup(const vector<int> & NumPtsXYZ, const int & InStride, const Boolean_t & InIsPeriodic){
+		Stride = InStride;
+		IsPeriodic = InIsPeriodic;
+		for (int d = 0; d < 3; ++d){
+			NumLatticePts[d] = NumPtsXYZ[d];
+			NumLatticeCells[d] = NumPtsXYZ[d] - (IsPeriodic ? 0 : 1);
+			NumCells[d] = (NumLatticeCells[d] + Stride - 1) / Stride;
+			NumPts[d] = NumCells[d] + (IsPeriodic ? 0 : 1);
+		}
+	}
+	// Lattice point of level point I
+	const int LatticePt(const int & d, const int & I) const {
+		return MIN(I * Stride, NumLatticePts[d] - 1);
+	}
+	// Level point I + Dir, wrapped or clamped
+	const int NbrPt(const int & d, const int & I, const int & Dir) const {
+		if (IsPeriodic)
+			return (I + Dir + 2 * NumPts[d]) % NumPts[d];
+		return MIN(MAX(I + Dir, 0), NumPts[d] - 1);
+	}
+	/*
+	*	Lattice points from level point I to level point I + Dir, wrapped
+	*	or clamped, so 0 where I + Dir is clamped to I. Usually Stride,
+	*	but less at the end of a volume that isn't a whole number of
+	*	Strides across.
+	*/
+	const int Offset(const int & d, const int & I, const int & Dir) const {
+		int Off = LatticePt(d, NbrPt(d, I, Dir)) - LatticePt(d, I);
+		if (IsPeriodic && Off * Dir < 0)
+			Off += Dir * NumLatticePts[d];
+		return Off;
+	}
+	/*
+	*	Centered difference gradient (in lattice coordinates, not
+	*	scaled by the point spacing) at level point IJK.
+	*	FALSE if rho couldn't be sampled there or at a neighbor.
+	*/
+	const Boolean_t Gradient(const cube & RhoVals, const int (&IJK)[3], double (&Grad)[3]) const {
+		int Pt[3];
+		for (int d = 0; d < 3; ++d)
+			Pt[d] = LatticePt(d, IJK[d]);
+		if (RhoVals(Pt[0], Pt[1], Pt[2]) < 0.0)
+			return FALSE;
+		for (int d = 0; d < 3; ++d){
+			int Hi[3] = { Pt[0], Pt[1], Pt[2] }, Lo[3] = { Pt[0], Pt[1], Pt[2] };
+			Hi[d] = LatticePt(d, NbrPt(d, IJK[d], 1));
+			Lo[d] = LatticePt(d, NbrPt(d, IJK[d], -1));
+			double RhoHi = RhoVals(Hi[0], Hi[1], Hi[2]), RhoLo = RhoVals(Lo[0], Lo[1], Lo[2]);
+			if (RhoHi < 0.0 || RhoLo < 0.0)
+				return FALSE;
+			Grad[d] = RhoHi - RhoLo;
+		}
+		return TRUE;
+	}
+};
+
+/*
+*	Mark the points of Level at and around the corners of the Active
+*	cells (from the point before each cell to the second after it),
+*	which are the points MarkCPCellsOnLevel() and the local max/min
+*	check of SearchCPLatticeCell() read. Grown from cells to points one
+*	direction at a time.
+*/
+static void MarkLevelPtsAroundCells(const CPSearchLevel_s & Level,
+	const uchar_cube & Active,
+	uchar_cube & PtMask)
+{
+	uchar_cube In = Active, Out;
+	int Dims[3] = { Level.NumCells[0], Level.NumCells[1], Level.NumCells[2] };
+	for (int Dir = 0; Dir < 3; ++Dir){
+		int OutDims[3] = { Dims[0], Dims[1], Dims[2] };
+		OutDims[Dir] = Level.NumPts[Dir];
+		Out.zeros(OutDims[0], OutDims[1], OutDims[2]);
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+		for (int zi = 0; zi < OutDims[2]; ++zi){
+			for (int yi = 0; yi < OutDims[1]; ++yi){
+				for (int xi = 0; xi < OutDims[0]; ++xi){
+					int IJK[3] = { xi, yi, zi };
+					unsigned char b = 0;
+					for (int k = -2; k <= 1 && !b; ++k){
+						int Nbr[3] = { xi, yi, zi };
+						Nbr[Dir] = IJK[Dir] + k;
+						if (Level.IsPeriodic)
+							Nbr[Dir] = (Nbr[Dir] + 2 * Dims[Dir]) % Dims[Dir];
+						else if (Nbr[Dir] < 0 || Nbr[Dir] >= Dims[Dir])
+							continue;
+						b = In(Nbr[0], Nbr[1], Nbr[2]);
 					}
+					Out(xi, yi, zi) = b;
 				}
+			}
+		}
+		In = Out;
+		Dims[Dir] = OutDims[Dir];
+	}
 
-				/*
-				*	Check for local Min/Max
-				*/
-				bool IsMaxMin;
-				vector<double> Signs = { 1, -1 };
-				// 				double CellRho = RhoPtr.At(CellMinXYZ[ThreadNum], *RootParams[ThreadNum].VolInfo);
-				double CellRho = RhoVals(xi, yi, zi);
-				for (int s = 0; s < 2; ++s){
-					IsMaxMin = true;
-					vec3 CompPt;
-					for (int xj = xi - 1; xj <= xi + 1 && IsMaxMin; ++xj){
-						int xk = xj;
-						if (xk < 0){
-							if (VolInfo.IsPeriodic) xk = NumPtsXYZ[0] - 1;
-							else continue;
-						}
-						else if (xk >= NumPtsXYZ[0]){
-							if (VolInfo.IsPeriodic) xk = 0;
-							else continue;
-						}
-						for (int yj = yi - 1; yj <= yi + 1 && IsMaxMin; ++yj){
-							int yk = yj;
-							if (yk < 0){
-								if (VolInfo.IsPeriodic) yk = NumPtsXYZ[1] - 1;
-								else continue;
-							}
-							else if (yk >= NumPtsXYZ[1]){
-								if (VolInfo.IsPeriodic) yk = 0;
-								else continue;
-							}
-							for (int zj = zi - 1; zj <= zi + 1 && IsMaxMin; ++zj){
-								int zk = zj;
-								if (zk < 0){
-									if (VolInfo.IsPeriodic) zk = NumPtsXYZ[2] - 1;
-									else continue;
-								}
-								else if (zk >= NumPtsXYZ[2]){
-									if (VolInfo.IsPeriodic) zk = 0;
-									else continue;
-								}
-								if (xi != xk || yi != yk || zi != zk){
-									// 									iXYZ << xj << yj << zj;
-									// 									CompPt = VolInfo.MinXYZ + LatticeVector * iXYZ;
-									// 									double CompVal = RhoPtr.At(CompPt, *RootParams[ThreadNum].VolInfo);
-									double CompVal = RhoVals(xk, yk, zk);
-									IsMaxMin = IsMaxMin && (Signs[s] * CellRho >= Signs[s] * CompVal);
-								}
-							}
-						}
+	PtMask = In;
+}
+
+/*
+*	Grow the marked cells of Level by one cell each way, one direction
+*	at a time.
+*/
+static void GrowCellsOnLevel(const CPSearchLevel_s & Level, uchar_cube & Cells)
+{
+	const int * N = Level.NumCells;
+	uchar_cube In;
+	for (int Dir = 0; Dir < 3; ++Dir){
+		In = Cells;
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+		for (int zi = 0; zi < N[2]; ++zi){
+			for (int yi = 0; yi < N[1]; ++yi){
+				for (int xi = 0; xi < N[0]; ++xi){
+					int IJK[3] = { xi, yi, zi };
+					unsigned char b = 0;
+					for (int k = -1; k <= 1 && !b; ++k){
+						int Nbr[3] = { xi, yi, zi };
+						Nbr[Dir] = IJK[Dir] + k;
+						if (Level.IsPeriodic)
+							Nbr[Dir] = (Nbr[Dir] + N[Dir]) % N[Dir];
+						else if (Nbr[Dir] < 0 || Nbr[Dir] >= N[Dir])
+							continue;
+						b = In(Nbr[0], Nbr[1], Nbr[2]);
 					}
-					if (IsMaxMin){
-						GradPath_c GP(
-							CellMinXYZ[ThreadNum],
-							(StreamDir_e)s,
-							100,
-							GPType_Classic,
-							GPTerminate_AtRhoValue,
-							NULL,
-							&ThreadCPs[ThreadNum],
-							NULL,
-							&RhoCutoff,
-							*RootParams[ThreadNum].VolInfo,
-							*RootParams[ThreadNum].HessPtrs,
-							*RootParams[ThreadNum].GradPtrs,
-							*RootParams[ThreadNum].RhoPtr);
-
-						// 						const vector<FieldDataPointer_c> * junkPtrs = NULL;
-						// 						GradPath_c GP(
-						// 							CellMinXYZ[ThreadNum],
-						// 							(StreamDir_e)s,
-						// 							100,
-						// 							GPType_Classic,
-						// 							GPTerminate_AtRhoValue,
-						// 							NULL,
-						// 							&ThreadCPs[ThreadNum],
-						// 							NULL,
-						// 							&RhoCutoff,
-						// 							*RootParams[ThreadNum].VolInfo,
-						// 							*junkPtrs,
-						// 							*junkPtrs,
-						// 							*RootParams[ThreadNum].RhoPtr);
-
-						GP.Seed(false);
-
-						if (GP.IsMade()){
-#ifdef _DEBUG
-							GP.SaveAsOrderedZone();
+					Cells(xi, yi, zi) = b;
+				}
+			}
+		}
+	}
+}
+
+/*
+*	Mark the cells of Level, of those set in Active, that could hold a
+*	CP, using rho at the level's points in RhoVals.
+*	As in MarkCPCandidateCells(), that's a cell where every gradient
+*	component changes sign across the corners, and the marked cells are
+*	grown by one cell each way, within Active.
+*/
+static void MarkCPCellsOnLevel(const CPSearchLevel_s & Level,
+	const cube & RhoVals,
+	const uchar_cube & Active,
+	uchar_cube & Marked)
+{
+	const int * NP = Level.NumPts, * N = Level.NumCells;
+
+	/*
+	*	Per level point, bit d is set if gradient component d is >= 0
+	*	and bit d + 3 if it's <= 0 (both where rho couldn't be sampled).
+	*/
+	uchar_cube SignBits(NP[0], NP[1], NP[2]);
+
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int zi = 0; zi < NP[2]; ++zi){
+		for (int yi = 0; yi < NP[1]; ++yi){
+			for (int xi = 0; xi < NP[0]; ++xi){
+				int IJK[3] = { xi, yi, zi };
+				double Grad[3];
+				unsigned char b = 0x3F;
+				if (Level.Gradient(RhoVals, IJK, Grad)){
+					b = 0;
+					for (int d = 0; d < 3; ++d)
+						b |= ((Grad[d] >= 0.0) << d) | ((Grad[d] <= 0.0) << (d + 3));
+				}
+				SignBits(xi, yi, zi) = b;
+			}
+		}
+	}
+
+	Marked.zeros(N[0], N[1], N[2]);
+
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
 #endif
+	for (int zi = 0; zi < N[2]; ++zi){
+		for (int yi = 0; yi < N[1]; ++yi){
+			for (int xi = 0; xi < N[0]; ++xi){
+				if (!Active(xi, yi, zi))
+					continue;
 
-							CompPt = GP[-1];
-							vec3 EigVals, PrincDir;
-							mat33 EigVecs;
-							char Type = 0;
-
-							CalcEigenSystemForPoint(CompPt,
-								EigVals,
-								EigVecs,
-								RootParams[ThreadNum]);
-
-							for (int i = 0; i < 3; ++i){
-								if (EigVals[i] > 0)
-									Type++;
-								else
-									Type--;
-							}
-							if (Type == CPType_Nuclear || Type == CPType_Ring)
-								PrincDir = EigVecs.row(0).t();
-							else
-								PrincDir = EigVecs.row(2).t();
+				unsigned char b = 0;
+				for (int c = 0; c < 8; ++c)
+					b |= SignBits(Level.NbrPt(0, xi, c & 1), Level.NbrPt(1, yi, (c >> 1) & 1), Level.NbrPt(2, zi, c >> 2));
+
+				Marked(xi, yi, zi) = ((b & (b >> 3) & 0x7) == 0x7);
+			}
+		}
+	}
 
-							IsMaxMin = (Type == CPType_Nuclear || Type == CPType_Cage);
+	GrowCellsOnLevel(Level, Marked);
+	Marked %= Active;
+}
 
-							// 						if (IsMaxMin)
-							// 						ThreadCPs[ThreadNum].AddPoint(GP.RhoAt(-1), CompPt, PrincDir, Type);
-							ThreadCPs[ThreadNum].AddPoint(GP.RhoAt(-1), CompPt, PrincDir, (s == 0 ? CPType_Nuclear : CPType_Cage));
-						}
+/*
+*	Mark the cells of Level, of those set in Active, that are proven to
+*	hold no CP that the lattice search would keep, using rho at the
+*	level's points in RhoVals.
+*	Within a cell of sides h_e, a function f differs from the trilinear
+*	interpolant of its corner values by at most
+*		E(f) = sum_e h_e^2 / 8 * max |d^2 f / dx_e^2|,
+*	and that interpolant lies between the corner values. So the cell
+*	has no CP if some gradient component g_d has the same sign at all
+*	corners and |g_d| > E(g_d) at each, and nothing above the rho
+*	cutoff if max(rho) + E(rho) at the corners is below it.
+*	d^2 g_d / dx_e^2 = dH_ee / dx_d is the change of the Hessian
+*	diagonal along the cell's edges in direction d, and d^2 rho / dx_e^2
+*	is H_ee at the corners, both from three point differences of the
+*	level's points (one sided at the edges of a nonperiodic volume) and
+*	times CPSearchCurvatureSafety for what the differences miss between
+*	them. Being second order in h, unlike a bound from the Hessian
+*	alone, this rules out most blocks away from CPs where rho falls off
+*	exponentially.
+*	Cells with a corner whose neighbors weren't all sampled are never
+*	ruled out.
+*/
+static void MarkCPFreeCellsOnLevel(const CPSearchLevel_s & Level,
+	const cube & RhoVals,
+	const uchar_cube & Active,
+	const double & RhoCutoff,
+	uchar_cube & IsCPFree)
+{
+	const int * NP = Level.NumPts, * N = Level.NumCells;
+
+	/*
+	*	Per level point, the gradient and the Hessian diagonal, in
+	*	lattice cell units.
+	*/
+	uchar_cube IsValid(NP[0], NP[1], NP[2], fill::zeros);
+	cube Grads[3], HessDiag[3];
+	for (int d = 0; d < 3; ++d){
+		Grads[d].set_size(NP[0], NP[1], NP[2]);
+		HessDiag[d].set_size(NP[0], NP[1], NP[2]);
+	}
 
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int zi = 0; zi < NP[2]; ++zi){
+		for (int yi = 0; yi < NP[1]; ++yi){
+			for (int xi = 0; xi < NP[0]; ++xi){
+				int IJK[3] = { xi, yi, zi };
+				Boolean_t PtIsValid = TRUE;
+				for (int d = 0; d < 3 && PtIsValid; ++d){
+					/*
+					*	Three level points along d: the point and its two
+					*	neighbors, or its two neighbors on the one side it
+					*	has them at the edge of a nonperiodic volume, at
+					*	lattice offsets t from it.
+					*/
+					int Dirs[3] = { -1, 0, 1 };
+					if (Level.Offset(d, IJK[d], -1) == 0){
+						Dirs[0] = 0; Dirs[1] = 1; Dirs[2] = 2;
+					}
+					else if (Level.Offset(d, IJK[d], 1) == 0){
+						Dirs[0] = -2; Dirs[1] = -1; Dirs[2] = 0;
+					}
+					double t[3], f[3];
+					for (int k = 0; k < 3 && PtIsValid; ++k){
+						int Step = (Dirs[k] > 0 ? 1 : -1), Nbr = IJK[d], Off = 0;
+						for (int n = 0; n < std::abs(Dirs[k]); ++n){
+							Off += Level.Offset(d, Nbr, Step);
+							Nbr = Level.NbrPt(d, Nbr, Step);
+						}
+						int Pt[3] = { Level.LatticePt(0, xi), Level.LatticePt(1, yi), Level.LatticePt(2, zi) };
+						Pt[d] = Level.LatticePt(d, Nbr);
+						t[k] = static_cast<double>(Off);
+						f[k] = RhoVals(Pt[0], Pt[1], Pt[2]);
+						PtIsValid = (f[k] >= 0.0);
+					}
+					PtIsValid = (PtIsValid && t[0] < t[1] && t[1] < t[2]);
+					if (!PtIsValid)
 						break;
+
+					/*
+					*	Derivatives at t = 0 of the parabola through the three.
+					*/
+					double w[3];
+					for (int k = 0; k < 3; ++k)
+						w[k] = 1.0 / ((t[k] - t[(k + 1) % 3]) * (t[k] - t[(k + 2) % 3]));
+					double Grad = 0.0, Hess = 0.0;
+					for (int k = 0; k < 3; ++k){
+						Grad -= f[k] * w[k] * (t[(k + 1) % 3] + t[(k + 2) % 3]);
+						Hess += 2.0 * f[k] * w[k];
 					}
-				}
-				/*
-				*	Rigorous check using Newton-Raphson method
-				*/
-				if (!IsMaxMin && CritPointInCell(CellMinXYZ[ThreadNum],
-					CellMaxXYZ[ThreadNum],
-					TmpPoint[ThreadNum],
-					PrincDir[ThreadNum],
-					TmpRho[ThreadNum],
-					RhoCutoff,
-					TmpType[ThreadNum],
-					RootParams[ThreadNum],
-					MR[ThreadNum]))
-				{
-					ThreadCPs[ThreadNum].AddPoint(TmpRho[ThreadNum], TmpPoint[ThreadNum], PrincDir[ThreadNum], TmpType[ThreadNum]);
+					Grads[d](xi, yi, zi) = Grad;
+					HessDiag[d](xi, yi, zi) = Hess;
 				}
 
-				// 				CellMinXYZ[ThreadNum][0] += CellSpacing;
+				IsValid(xi, yi, zi) = PtIsValid;
 			}
-
-			// 			CellMinXYZ[ThreadNum][1] += CellSpacing;
 		}
 	}
 
-	StatusDrop(VolInfo.AddOnID);
-
-	for (auto & m : MR)	if (m.s != NULL) gsl_multiroot_fdfsolver_free(m.s);
-	// 	if (MR.pos != NULL)
-	// 		gsl_vector_free(MR.pos);
+	IsCPFree.zeros(N[0], N[1], N[2]);
 
-	if (IsOk){
-		CPs = CritPoints_c(ThreadCPs);
-		CPs.RemoveSpuriousCPs();
-	}
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int zi = 0; zi < N[2]; ++zi){
+		for (int yi = 0; yi < N[1]; ++yi){
+			for (int xi = 0; xi < N[0]; ++xi){
+				if (!Active(xi, yi, zi))
+					continue;
+
+				int IJK[3] = { xi, yi, zi };
+				int Corners[8][3];
+				Boolean_t CornersValid = TRUE;
+				for (int c = 0; c < 8 && CornersValid; ++c){
+					Corners[c][0] = Level.NbrPt(0, xi, c & 1);
+					Corners[c][1] = Level.NbrPt(1, yi, (c >> 1) & 1);
+					Corners[c][2] = Level.NbrPt(2, zi, c >> 2);
+					CornersValid = IsValid(Corners[c][0], Corners[c][1], Corners[c][2]);
+				}
+				if (!CornersValid)
+					continue;
 
-	return IsOk;
-}
+				double Len[3], ErrFactor[3];
+				for (int d = 0; d < 3; ++d){
+					Len[d] = static_cast<double>(MAX(Level.Offset(d, IJK[d], 1), 1));
+					ErrFactor[d] = CPSearchCurvatureSafety * Len[d] * Len[d] / 8.0;
+				}
 
+				/*
+				*	Largest |H_ee| at the corners, and largest change of H_ee
+				*	along an edge in direction d, per lattice cell.
+				*/
+				double HessDiagMax[3] = { 0.0, 0.0, 0.0 }, HessDiagChange[3][3] = { { 0.0 } };
+				for (int c = 0; c < 8; ++c){
+					for (int e = 0; e < 3; ++e){
+						double H = HessDiag[e](Corners[c][0], Corners[c][1], Corners[c][2]);
+						HessDiagMax[e] = MAX(HessDiagMax[e], std::abs(H));
+						for (int d = 0; d < 3; ++d){
+							if (c & (1 << d))
+								continue;
+							int Other = c | (1 << d);
+							double Change = std::abs(HessDiag[e](Corners[Other][0], Corners[Other][1], Corners[Other][2]) - H) / Len[d];
+							HessDiagChange[d][e] = MAX(HessDiagChange[d][e], Change);
+						}
+					}
+				}
+
+				double RhoMax = 0.0;
+				for (int c = 0; c < 8; ++c)
+					RhoMax = MAX(RhoMax, RhoVals(Level.LatticePt(0, Corners[c][0]), Level.LatticePt(1, Corners[c][1]), Level.LatticePt(2, Corners[c][2])));
+				double RhoErr = 0.0;
+				for (int e = 0; e < 3; ++e)
+					RhoErr += ErrFactor[e] * HessDiagMax[e];
+				Boolean_t CellIsCPFree = (RhoMax + RhoErr < RhoCutoff);
+
+				for (int d = 0; d < 3 && !CellIsCPFree; ++d){
+					double GradMin = DBL_MAX, GradMax = -DBL_MAX;
+					for (int c = 0; c < 8; ++c){
+						double Grad = Grads[d](Corners[c][0], Corners[c][1], Corners[c][2]);
+						GradMin = MIN(GradMin, Grad);
+						GradMax = MAX(GradMax, Grad);
+					}
+					double GradErr = 0.0;
+					for (int e = 0; e < 3; ++e)
+						GradErr += ErrFactor[e] * HessDiagChange[d][e];
+					CellIsCPFree = (GradMin > GradErr || GradMax < -GradErr);
+				}
+
+				IsCPFree(xi, yi, zi) = CellIsCPFree;
+			}
+		}
+	}
+}
+
+/*
+*	Coarse-to-fine version of the lattice FindCPs().
+*	The lattice cells are grouped into blocks 2^NumCoarseLevels cells
+*	across, and each level halves the block size down to single
+*	cells. Rho is sampled only at the points of the current level
+*	that border blocks still being searched, and a block proven to hold
+*	no CP (see MarkCPFreeCellsOnLevel()) is dropped along with all of
+*	its cells. The cells left at the finest level, plus one cell around
+*	them, are searched as in FindCPs().
+*/
+const Boolean_t FindCPsCoarseToFine(CritPoints_c & CPs,
+	const VolExtentInfo_s & VolInfo,
+	const double & CellSpacing,
+	const int & NumCoarseLevels,
+	double & RhoCutoff,
+	const Boolean_t & IsPeriodic,
+	FieldDataPointer_c & RhoPtr,
+	vector<FieldDataPointer_c> & GradXYZPtrs,
+	vector<FieldDataPointer_c> & HessPtrs,
+	const NodeRecordCache_c * NodeCache,
+	CPSearchCoverage_s * Coverage)
+{
+	Boolean_t IsOk = ((GradXYZPtrs.size() == 3 || GradXYZPtrs.size() == 0)
+		&& (HessPtrs.size() == 0 || HessPtrs.size() == 6)
+		&& NumCoarseLevels >= 0);
+
+	if (!IsOk) return IsOk;
+
+	int NumThreads = omp_get_num_procs();
+
+	vector<VolExtentIndexWeights_s> VolInfoList(NumThreads, VolInfo);
+
+	vector<MultiRootParams_s> RootParams;
+	mat33 I = eye<mat>(3, 3);
+	SetupCPSearchParams(RootParams, VolInfoList, I, IsPeriodic, RhoPtr, GradXYZPtrs, HessPtrs, NodeCache);
+
+	string StatusStr = "Finding critical points";
+
+	vector<CritPoints_c> ThreadCPs(NumThreads);
+
+	vector<int> NumPtsXYZ(3);
+	for (int d = 0; d < 3; ++d) NumPtsXYZ[d] = VolInfo.BasisExtent[d] / CellSpacing;
+
+	vector<int> StartPt(3, 0), EndPt = NumPtsXYZ;
+
+	if (!VolInfo.IsPeriodic){
+		for (auto & i : StartPt) i += 1;
+		for (auto & i : EndPt) i -= 1;
+	}
+
+	/*
+	*	Levels, coarsest first, each with half the stride of the last.
+	*	The coarsest keeps a few blocks across the volume.
+	*/
+	int NumLevels = NumCoarseLevels + 1;
+	while (NumLevels > 1 && *std::min_element(NumPtsXYZ.begin(), NumPtsXYZ.end()) < CPSearchMinCoarseCells * (1 << (NumLevels - 1)))
+		NumLevels--;
+
+	vector<CPSearchLevel_s> Levels(NumLevels);
+	for (int l = 0; l < NumLevels; ++l)
+		Levels[l].Setup(NumPtsXYZ, 1 << (NumLevels - 1 - l), VolInfo.IsPeriodic);
+
+	double NumSearchCells = 1.0;
+	for (int d = 0; d < 3; ++d)
+		NumSearchCells *= static_cast<double>(MAX(EndPt[d] - StartPt[d], 0));
+
+	if (Coverage != NULL){
+		Coverage->NumLevels = NumLevels;
+		Coverage->RuledOutFraction.assign(NumLevels - 1, 0.0);
+		Coverage->SearchedFraction = Coverage->NewtonFraction = 0.0;
+	}
+
+	StatusLaunch((StatusStr + " (Loading data...)").c_str(), VolInfo.AddOnID, TRUE);
+
+	mat33 LatticeVector = VolInfo.BasisNormalized * CellSpacing;
+
+	cube RhoVals(NumPtsXYZ[0], NumPtsXYZ[1], NumPtsXYZ[2]);
+	RhoVals.fill(-1.0);
+	uchar_cube IsSampled(NumPtsXYZ[0], NumPtsXYZ[1], NumPtsXYZ[2], fill::zeros), ToSample, PtMask;
+
+	/*
+	*	Level each lattice cell was ruled out on, or NumLevels if it
+	*	wasn't, for the coverage.
+	*/
+	uchar_cube RuledOutLevel;
+	if (Coverage != NULL){
+		RuledOutLevel.set_size(NumPtsXYZ[0], NumPtsXYZ[1], NumPtsXYZ[2]);
+		RuledOutLevel.fill(NumLevels);
+	}
+
+	/*
+	*	Every cell of the coarsest level is searched.
+	*/
+	uchar_cube Active(Levels[0].NumCells[0], Levels[0].NumCells[1], Levels[0].NumCells[2]), Marked;
+	Active.ones();
+
+	for (int l = 0; l < NumLevels && IsOk; ++l){
+		const CPSearchLevel_s & Level = Levels[l];
+
+		/*
+		*	Sample the level points at and around the corners of active
+		*	cells that haven't been already, which is enough for the
+		*	gradient at the corners and for the local max/min check.
+		*/
+		MarkLevelPtsAroundCells(Level, Active, PtMask);
+		ToSample.zeros(NumPtsXYZ[0], NumPtsXYZ[1], NumPtsXYZ[2]);
+		for (int zi = 0; zi < Level.NumPts[2]; ++zi){
+			for (int yi = 0; yi < Level.NumPts[1]; ++yi){
+				for (int xi = 0; xi < Level.NumPts[0]; ++xi){
+					if (!PtMask(xi, yi, zi))
+						continue;
+					int Pt[3] = { Level.LatticePt(0, xi), Level.LatticePt(1, yi), Level.LatticePt(2, zi) };
+					if (!IsSampled(Pt[0], Pt[1], Pt[2])){
+						IsSampled(Pt[0], Pt[1], Pt[2]) = 1;
+						ToSample(Pt[0], Pt[1], Pt[2]) = 1;
+					}
+				}
+			}
+		}
+
+		IsOk = SampleRhoOnLattice(RhoVals, RhoPtr, VolInfo.MinXYZ, LatticeVector, VolInfoList, &ToSample);
+
+		/*
+		*	On the finest level, same test as FindCPs() uses.
+		*/
+		if (IsOk && l == NumLevels - 1)
+			MarkCPCellsOnLevel(Level, RhoVals, Active, Marked);
+
+		if (IsOk && l < NumLevels - 1){
+			/*
+			*	The children of cells not proven CP-free are searched on
+			*	the next level; everything in the others is ruled out.
+			*/
+			uchar_cube IsCPFree;
+			MarkCPFreeCellsOnLevel(Level, RhoVals, Active, RhoCutoff, IsCPFree);
+
+			const CPSearchLevel_s & Next = Levels[l + 1];
+			uchar_cube NextActive(Next.NumCells[0], Next.NumCells[1], Next.NumCells[2], fill::zeros);
+			for (int zi = 0; zi < Level.NumCells[2]; ++zi){
+				for (int yi = 0; yi < Level.NumCells[1]; ++yi){
+					for (int xi = 0; xi < Level.NumCells[0]; ++xi){
+						if (!Active(xi, yi, zi))
+							continue;
+						if (IsCPFree(xi, yi, zi)){
+							if (Coverage != NULL){
+								int Lo[3] = { xi * Level.Stride, yi * Level.Stride, zi * Level.Stride };
+								int Hi[3] = { MIN(Lo[0] + Level.Stride, NumPtsXYZ[0]), MIN(Lo[1] + Level.Stride, NumPtsXYZ[1]), MIN(Lo[2] + Level.Stride, NumPtsXYZ[2]) };
+								RuledOutLevel(span(Lo[0], Hi[0] - 1), span(Lo[1], Hi[1] - 1), span(Lo[2], Hi[2] - 1)).fill(l);
+							}
+							continue;
+						}
+						for (int zj = 2 * zi; zj < MIN(2 * zi + 2, Next.NumCells[2]); ++zj)
+							for (int yj = 2 * yi; yj < MIN(2 * yi + 2, Next.NumCells[1]); ++yj)
+								for (int xj = 2 * xi; xj < MIN(2 * xi + 2, Next.NumCells[0]); ++xj)
+									NextActive(xj, yj, zj) = 1;
+					}
+				}
+			}
+			Active = NextActive;
+
+			/*
+			*	Kept cells are searched with a halo of one lattice cell,
+			*	not a whole block, around them.
+			*/
+			if (l + 1 == NumLevels - 1)
+				GrowCellsOnLevel(Next, Active);
+		}
+	}
+
+	if (IsOk && Coverage != NULL && NumSearchCells > 0.0){
+		double NumSearched = 0.0, NumNewton = 0.0;
+		for (int zi = StartPt[2]; zi < EndPt[2]; ++zi){
+			for (int yi = StartPt[1]; yi < EndPt[1]; ++yi){
+				for (int xi = StartPt[0]; xi < EndPt[0]; ++xi){
+					if (Active(xi, yi, zi)){
+						NumSearched += 1.0;
+						if (Marked(xi, yi, zi))
+							NumNewton += 1.0;
+					}
+					else if (RuledOutLevel(xi, yi, zi) < NumLevels - 1)
+						Coverage->RuledOutFraction[RuledOutLevel(xi, yi, zi)] += 1.0;
+				}
+			}
+		}
+		for (double & f : Coverage->RuledOutFraction)
+			f /= NumSearchCells;
+		Coverage->SearchedFraction = NumSearched / NumSearchCells;
+		Coverage->NewtonFraction = NumNewton / NumSearchCells;
+	}
+
+	int NumThreadPts = NumPtsXYZ[2];
+#ifndef _DEBUG
+	NumThreadPts /= NumThreads;
+#endif
+	int ThreadPtNum = 0;
+
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int zi = StartPt[2]; zi < EndPt[2]; ++zi){
+		int ThreadNum = omp_get_thread_num();
+		if (ThreadNum == 0 && !StatusUpdate(ThreadPtNum++, NumThreadPts, StatusStr, VolInfo.AddOnID)){
+			IsOk = FALSE;
+#pragma omp flush (IsOk)
+		}
+#pragma omp flush (IsOk)
+		for (int yi = StartPt[1]; yi < EndPt[1] && IsOk; ++yi){
+			for (int xi = StartPt[0]; xi < EndPt[0] && IsOk; ++xi){
+				if (Active(xi, yi, zi)){
+					SearchCPLatticeCell(xi, yi, zi, NumPtsXYZ, RhoVals, Marked(xi, yi, zi),
+						VolInfo, LatticeVector, RhoCutoff, NodeCache, RootParams[ThreadNum], ThreadCPs[ThreadNum]);
+				}
+			}
+		}
+	}
+
+	StatusDrop(VolInfo.AddOnID);
+
+	if (IsOk){
+		CPs = CritPoints_c(ThreadCPs);
+		if (IsPeriodic)
+			CPs.SetSpatialIndexLattice(PeriodicLatticeVectors(VolInfo));
+		CPs.RemoveSpuriousCPs();
+	}
+
+	return IsOk;
+}
+
+/*
+*	Begin CPSearchCache_c methods
+*/
+
+void CPSearchCache_c::Clear(){
+	m_Key = m_VolKey = 0;
+	m_VolKeyPtrs.clear();
+	m_VolKeySizes.clear();
+	m_Blocks.clear();
+	m_NumBlocksReused = m_NumBlocksSearched = 0;
+}
+
+/*
+*	Hash of the volume data.
+*	As in GradPathCache_c::VolumeKey(), it's only rehashed when the
+*	data pointers change, so data changed in place behind the same
+*	pointers needs a Clear().
+*/
+const uint64_t CPSearchCache_c::VolumeKey(const FieldDataPointer_c & RhoPtr,
+	const vector<FieldDataPointer_c> & GradXYZPtrs,
+	const vector<FieldDataPointer_c> & HessPtrs)
+{
+	vector<const FieldDataPointer_c*> Ptrs;
+	Ptrs.push_back(&RhoPtr);
+	for (const FieldDataPointer_c & Ptr : GradXYZPtrs)
+		Ptrs.push_back(&Ptr);
+	for (const FieldDataPointer_c & Ptr : HessPtrs)
+		Ptrs.push_back(&Ptr);
+
+	vector<const void*> KeyPtrs;
+	vector<unsigned int> KeySizes;
+	for (const FieldDataPointer_c * Ptr : Ptrs){
+		KeyPtrs.push_back(Ptr->IsReady() ? Ptr->VoidPtr() : NULL);
+		KeySizes.push_back(Ptr->IsReady() ? Ptr->Size() : 0);
+	}
+
+	Boolean_t CanReuse = (m_VolKey != 0 && KeyPtrs == m_VolKeyPtrs && KeySizes == m_VolKeySizes);
+	for (int i = 0; i < Ptrs.size() && CanReuse; ++i)
+		CanReuse = (!Ptrs[i]->IsReady() || KeyPtrs[i] != NULL);
+
+	if (!CanReuse){
+		CacheHash_c Hash;
+		Hash.Add(static_cast<int>(Ptrs.size()));
+		for (const FieldDataPointer_c * Ptr : Ptrs){
+			Hash.Add(Ptr->IsReady());
+			if (Ptr->IsReady())
+				Hash.Add(*Ptr);
+		}
+
+		m_VolKey = Hash.Value();
+		m_VolKeyPtrs = KeyPtrs;
+		m_VolKeySizes = KeySizes;
+	}
+
+	return m_VolKey;
+}
+
+/*
+*	Hash of everything but the rho cutoff and search region that
+*	decides which CPs the lattice search finds in a cell.
+*/
+const uint64_t CPSearchCache_c::SettingsKey(const VolExtentInfo_s & VolInfo,
+	const double & CellSpacing,
+	const Boolean_t & IsPeriodic,
+	const FieldDataPointer_c & RhoPtr,
+	const vector<FieldDataPointer_c> & GradXYZPtrs,
+	const vector<FieldDataPointer_c> & HessPtrs,
+	const NodeRecordCache_c * NodeCache)
+{
+	CacheHash_c Hash;
+	Hash.Add(VolumeKey(RhoPtr, GradXYZPtrs, HessPtrs));
+	Hash.Add(VolInfo.MaxIJK);
+	Hash.Add(VolInfo.MinXYZ);
+	Hash.Add(VolInfo.MaxXYZ);
+	Hash.Add(VolInfo.BasisVectors);
+	Hash.Add(VolInfo.IsPeriodic);
+	Hash.Add(IsPeriodic);
+	Hash.Add(CellSpacing);
+	Hash.Add(NodeCache != NULL && NodeCache->IsSinglePrecision());
+	Hash.Add(CPSearchCacheBlockCells);
+
+	return Hash.Value();
+}
+
+const Boolean_t CPSearchCache_c::FindCPs(CritPoints_c & CPs,
+	const VolExtentInfo_s & VolInfo,
+	const double & CellSpacing,
+	double & RhoCutoff,
+	const Boolean_t & IsPeriodic,
+	FieldDataPointer_c & RhoPtr,
+	vector<FieldDataPointer_c> & GradXYZPtrs,
+	vector<FieldDataPointer_c> & HessPtrs,
+	const NodeRecordCache_c * NodeCache,
+	const vector<int> & StartCell,
+	const vector<int> & EndCell)
+{
+	Boolean_t IsOk = ((GradXYZPtrs.size() == 3 || GradXYZPtrs.size() == 0)
+		&& (HessPtrs.size() == 0 || HessPtrs.size() == 6)
+		&& (StartCell.empty() || StartCell.size() == 3)
+		&& (EndCell.empty() || EndCell.size() == 3));
+
+	if (!IsOk) return IsOk;
+
+	m_NumBlocksReused = m_NumBlocksSearched = 0;
+
+	vector<int> NumPtsXYZ(3);
+	for (int d = 0; d < 3; ++d) NumPtsXYZ[d] = VolInfo.BasisExtent[d] / CellSpacing;
+
+	vector<int> StartPt(3, 0), EndPt = NumPtsXYZ;
+
+	if (!VolInfo.IsPeriodic){
+		for (auto & i : StartPt) i += 1;
+		for (auto & i : EndPt) i -= 1;
+	}
+
+	CPSearchLevel_s Level;
+	Level.Setup(NumPtsXYZ, 1, VolInfo.IsPeriodic);
+
+	uint64_t Key = SettingsKey(VolInfo, CellSpacing, IsPeriodic, RhoPtr, GradXYZPtrs, HessPtrs, NodeCache);
+	if (Key != m_Key || m_Blocks.empty()){
+		m_Key = Key;
+		for (int d = 0; d < 3; ++d)
+			m_NumBlocksXYZ[d] = (Level.NumCells[d] + CPSearchCacheBlockCells - 1) / CPSearchCacheBlockCells;
+		m_Blocks.assign(m_NumBlocksXYZ[0] * m_NumBlocksXYZ[1] * m_NumBlocksXYZ[2], Block_s());
+	}
+
+	/*
+	*	Cells asked for, and the blocks that cover them.
+	*/
+	int RegionStart[3], RegionEnd[3], BlockStart[3], BlockEnd[3];
+	for (int d = 0; d < 3; ++d){
+		RegionStart[d] = (StartCell.empty() ? StartPt[d] : MAX(StartCell[d], StartPt[d]));
+		RegionEnd[d] = (EndCell.empty() ? EndPt[d] : MIN(EndCell[d], EndPt[d]));
+		if (RegionEnd[d] <= RegionStart[d])
+			return FALSE;
+		BlockStart[d] = RegionStart[d] / CPSearchCacheBlockCells;
+		BlockEnd[d] = (RegionEnd[d] - 1) / CPSearchCacheBlockCells + 1;
+	}
+
+	/*
+	*	Blocks are searched down to CPSearchCacheRhoFloor (or the cutoff,
+	*	if that's lower) and the cutoff applied when they're merged, so a
+	*	block can be reused for any cutoff at or above the one it was
+	*	searched at.
+	*/
+	double SearchRhoCutoff = MIN(RhoCutoff, CPSearchCacheRhoFloor);
+
+	vector<int> RegionBlocks, SearchBlocks;
+	for (int bz = BlockStart[2]; bz < BlockEnd[2]; ++bz){
+		for (int by = BlockStart[1]; by < BlockEnd[1]; ++by){
+			for (int bx = BlockStart[0]; bx < BlockEnd[0]; ++bx){
+				int BlockNum = bx + m_NumBlocksXYZ[0] * (by + m_NumBlocksXYZ[1] * bz);
+				RegionBlocks.push_back(BlockNum);
+				if (m_Blocks[BlockNum].IsSearched && m_Blocks[BlockNum].RhoCutoff <= RhoCutoff)
+					m_NumBlocksReused++;
+				else
+					SearchBlocks.push_back(BlockNum);
+			}
+		}
+	}
+	m_NumBlocksSearched = static_cast<int>(SearchBlocks.size());
+
+	if (!SearchBlocks.empty()){
+		int NumThreads = omp_get_num_procs();
+
+		vector<VolExtentIndexWeights_s> VolInfoList(NumThreads, VolInfo);
+
+		vector<MultiRootParams_s> RootParams;
+		mat33 I = eye<mat>(3, 3);
+		SetupCPSearchParams(RootParams, VolInfoList, I, IsPeriodic, RhoPtr, GradXYZPtrs, HessPtrs, NodeCache);
+
+		string StatusStr = "Finding critical points";
+
+		StatusLaunch((StatusStr + " (Loading data...)").c_str(), VolInfo.AddOnID, TRUE);
+
+		mat33 LatticeVector = VolInfo.BasisNormalized * CellSpacing;
+
+		/*
+		*	The cells of the blocks to search, plus one cell around them
+		*	so candidate cells are grown into them as FindCPs() does.
+		*	Rho is sampled at and around the corners of those cells.
+		*/
+		uchar_cube Active(Level.NumCells[0], Level.NumCells[1], Level.NumCells[2], fill::zeros), Marked;
+		for (const int & BlockNum : SearchBlocks){
+			int Block[3] = { BlockNum % m_NumBlocksXYZ[0], (BlockNum / m_NumBlocksXYZ[0]) % m_NumBlocksXYZ[1], BlockNum / (m_NumBlocksXYZ[0] * m_NumBlocksXYZ[1]) };
+			int Lo[3], Hi[3];
+			for (int d = 0; d < 3; ++d){
+				Lo[d] = Block[d] * CPSearchCacheBlockCells - 1;
+				Hi[d] = MIN(Block[d] * CPSearchCacheBlockCells + CPSearchCacheBlockCells, Level.NumCells[d]) + 1;
+			}
+			for (int zi = Lo[2]; zi < Hi[2]; ++zi){
+				for (int yi = Lo[1]; yi < Hi[1]; ++yi){
+					for (int xi = Lo[0]; xi < Hi[0]; ++xi){
+						int IJK[3] = { xi, yi, zi };
+						bool InRange = true;
+						for (int d = 0; d < 3 && InRange; ++d){
+							if (Level.IsPeriodic)
+								IJK[d] = (IJK[d] + Level.NumCells[d]) % Level.NumCells[d];
+							else
+								InRange = (IJK[d] >= 0 && IJK[d] < Level.NumCells[d]);
+						}
+						if (InRange)
+							Active(IJK[0], IJK[1], IJK[2]) = 1;
+					}
+				}
+			}
+		}
+
+		cube RhoVals(NumPtsXYZ[0], NumPtsXYZ[1], NumPtsXYZ[2]);
+		RhoVals.fill(-1.0);
+		uchar_cube ToSample;
+		MarkLevelPtsAroundCells(Level, Active, ToSample);
+
+		IsOk = SampleRhoOnLattice(RhoVals, RhoPtr, VolInfo.MinXYZ, LatticeVector, VolInfoList, &ToSample);
+
+		if (IsOk)
+			MarkCPCellsOnLevel(Level, RhoVals, Active, Marked);
+
+		/*
+		*	Search each block into its own list, noting the cell each
+		*	CP came from.
+		*/
+		vector<CritPoints_c> BlockCPs(SearchBlocks.size());
+		int NumBlocksDone = 0;
+
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+		for (int b = 0; b < SearchBlocks.size(); ++b){
+			int ThreadNum = omp_get_thread_num();
+			if (ThreadNum == 0 && !StatusUpdate(NumBlocksDone, SearchBlocks.size(), StatusStr, VolInfo.AddOnID)){
+				IsOk = FALSE;
+#pragma omp flush (IsOk)
+			}
+#pragma omp flush (IsOk)
+			if (!IsOk)
+				continue;
+
+			int BlockNum = SearchBlocks[b];
+			int Block[3] = { BlockNum % m_NumBlocksXYZ[0], (BlockNum / m_NumBlocksXYZ[0]) % m_NumBlocksXYZ[1], BlockNum / (m_NumBlocksXYZ[0] * m_NumBlocksXYZ[1]) };
+			int Lo[3], Hi[3];
+			for (int d = 0; d < 3; ++d){
+				Lo[d] = MAX(Block[d] * CPSearchCacheBlockCells, StartPt[d]);
+				Hi[d] = MIN(Block[d] * CPSearchCacheBlockCells + CPSearchCacheBlockCells, EndPt[d]);
+			}
+
+			vector<CachedCP_s> NewCPs;
+			for (int zi = Lo[2]; zi < Hi[2]; ++zi){
+				for (int yi = Lo[1]; yi < Hi[1]; ++yi){
+					for (int xi = Lo[0]; xi < Hi[0]; ++xi){
+						int OldNumCPs[6];
+						for (int t = 0; t < 6; ++t)
+							OldNumCPs[t] = BlockCPs[b].NumCPs(t);
+
+						SearchCPLatticeCell(xi, yi, zi, NumPtsXYZ, RhoVals, Marked(xi, yi, zi),
+							VolInfo, LatticeVector, SearchRhoCutoff, NodeCache, RootParams[ThreadNum], BlockCPs[b]);
+
+						for (int t = 0; t < 6; ++t){
+							for (int i = OldNumCPs[t]; i < BlockCPs[b].NumCPs(t); ++i){
+								CachedCP_s CP;
+								CP.CellIJK[0] = xi;
+								CP.CellIJK[1] = yi;
+								CP.CellIJK[2] = zi;
+								CP.Rho = BlockCPs[b].GetRho(t, i);
+								CP.XYZ = BlockCPs[b].GetXYZ(t, i);
+								CP.PrincDir = BlockCPs[b].GetPrincDir(t, i);
+								CP.Type = CPTypeList[t];
+								NewCPs.push_back(CP);
+							}
+						}
+					}
+				}
+			}
+
+			m_Blocks[BlockNum].CPs.swap(NewCPs);
+			m_Blocks[BlockNum].RhoCutoff = SearchRhoCutoff;
+			m_Blocks[BlockNum].IsSearched = TRUE;
+
+#pragma omp atomic
+			NumBlocksDone++;
+		}
+
+		StatusDrop(VolInfo.AddOnID);
+	}
+
+	if (IsOk){
+		/*
+		*	Collect the CPs from the region's cells that are at or above
+		*	the cutoff, then merge duplicates once for the lot.
+		*/
+		CPs = CritPoints_c();
+		for (const int & BlockNum : RegionBlocks){
+			const Block_s & Block = m_Blocks[BlockNum];
+			for (const CachedCP_s & CP : Block.CPs){
+				bool InRegion = (CP.Rho >= RhoCutoff);
+				for (int d = 0; d < 3 && InRegion; ++d)
+					InRegion = (CP.CellIJK[d] >= RegionStart[d] && CP.CellIJK[d] < RegionEnd[d]);
+				if (InRegion)
+					CPs.AddPoint(CP.Rho, CP.XYZ, CP.PrincDir, CP.Type);
+			}
+		}
+
+		if (IsPeriodic)
+			CPs.SetSpatialIndexLattice(PeriodicLatticeVectors(VolInfo));
+		CPs.RemoveSpuriousCPs();
+	}
+
+	return IsOk;
+}
+
+/*
+*	Centers of the regions where CPs are likely missing, from gradient
+*	paths out of the bond and ring CPs of CPs and how near-degenerate
+*	they are (see CheckCPTopology()).
+*	Paths start StartOffset from the CP along its principal direction.
+*	VolInfoList and RootParams are per thread, as set up by
+*	SetupCPSearchParams().
+*/
+static void FindSuspectCPRegions(CritPoints_c & CPs,
+	const double & StartOffset,
+	double & RhoCutoff,
+	const NodeRecordCache_c * NodeCache,
+	vector<VolExtentIndexWeights_s> & VolInfoList,
+	vector<MultiRootParams_s> & RootParams,
+	vector<vec3> & Regions)
+{
+	Regions.clear();
+
+	/*
+	*	Two paths per bond and ring CP, one each way along its principal
+	*	direction; up to nuclear CPs from bonds and down to cages from
+	*	rings. Built now so the paths only read it.
+	*/
+	CPs.BuildSpatialIndex();
+
+	const int NumBonds = CPs.NumBonds(), NumPaths = 2 * (NumBonds + CPs.NumRings());
+	vector<int> EndCPNum(NumPaths, -1);
+	vector<char> IsStalled(NumPaths, 0), IsDegenerate(NumPaths / 2, 0);
+	vector<vec3> EndPts(NumPaths);
+	double TermRadius = 0.2;
+
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int p = 0; p < NumPaths; ++p){
+		int ThreadNum = omp_get_thread_num();
+		int TypeNum = (p < 2 * NumBonds ? 1 : 2),
+			Offset = (p < 2 * NumBonds ? p : p - 2 * NumBonds) / 2;
+		double Dir = (p % 2 == 0 ? -1.0 : 1.0);
+		vec3 CPPt = CPs.GetXYZ(TypeNum, Offset);
+
+		GradPath_c GP(
+			CPPt + CPs.GetPrincDir(TypeNum, Offset) * StartOffset * Dir,
+			(TypeNum == 1 ? StreamDir_Forward : StreamDir_Reverse),
+			100,
+			GPType_Classic,
+			GPTerminate_AtCP,
+			NULL,
+			&CPs,
+			&TermRadius,
+			&RhoCutoff,
+			VolInfoList[ThreadNum],
+			*RootParams[ThreadNum].HessPtrs,
+			*RootParams[ThreadNum].GradPtrs,
+			*RootParams[ThreadNum].RhoPtr);
+
+		GP.SetNodeCache(NodeCache);
+		GP.SetStartEndCPNum(CPs.GetTotOffsetFromTypeNumOffset(TypeNum, Offset), 0);
+		GP.Seed(false);
+
+		if (GP.IsMade()){
+			EndCPNum[p] = GP.GetStartEndCPNum(1);
+			IsStalled[p] = (EndCPNum[p] < 0 && (GP.GetEndReason() == GPEnd_Stalled || GP.GetEndReason() == GPEnd_Looping));
+			EndPts[p] = GP[-1];
+		}
+
+		/*
+		*	Near-degenerate if the Hessian eigenvalue of smallest
+		*	magnitude is small next to the largest.
+		*/
+		if (p % 2 == 0){
+			vec3 EigVals;
+			mat33 EigVecs;
+			if (CalcEigenSystemForPoint(CPPt, EigVals, EigVecs, RootParams[ThreadNum])){
+				vec3 AbsEigVals = abs(EigVals);
+				IsDegenerate[p / 2] = (AbsEigVals.min() < CPTopologyDegenerateRatio * AbsEigVals.max());
+			}
+		}
+	}
+
+	vector<bool> NuclearIsReached(CPs.NumAtoms(), false);
+	for (int p = 0; p < NumPaths; ++p){
+		if (IsStalled[p])
+			Regions.push_back(EndPts[p]);
+		if (p < 2 * NumBonds && EndCPNum[p] >= 0){
+			vector<int> TypeOffset = CPs.GetTypeNumOffsetFromTotOffset(EndCPNum[p]);
+			if (TypeOffset[0] == 0)
+				NuclearIsReached[TypeOffset[1]] = true;
+		}
+		if (p % 2 == 1){
+			int TypeNum = (p < 2 * NumBonds ? 1 : 2),
+				Offset = (p < 2 * NumBonds ? p : p - 2 * NumBonds) / 2;
+			if (IsDegenerate[p / 2] || (EndCPNum[p] >= 0 && EndCPNum[p] == EndCPNum[p - 1]))
+				Regions.push_back(CPs.GetXYZ(TypeNum, Offset));
+		}
+	}
+
+	/*
+	*	Including when no bond CPs were found at all, so none of the
+	*	nuclear CPs is reached.
+	*/
+	for (int i = 0; i < CPs.NumAtoms(); ++i){
+		if (!NuclearIsReached[i]){
+			double Dist;
+			vec3 NbrPt;
+			if (CPs.GetClosestCP(CPs.GetXYZ(0, i), Dist, NbrPt, vector<int>(1, 0), CPs.GetTotOffsetFromTypeNumOffset(0, i)) >= 0)
+				Regions.push_back((CPs.GetXYZ(0, i) + NbrPt) * 0.5);
+		}
+	}
+}
+
+/*
+*	Lattice search, as in FindCPs(), of just the cells within HalfWidth
+*	cells of Pt, on a small lattice of its own (with cells along
+*	LatticeVector) centered there. For the focused searches of
+*	CheckCPTopology().
+*/
+static const Boolean_t FindCPsNearPoint(CritPoints_c & CPs,
+	const vec3 & Pt,
+	const int & HalfWidth,
+	const VolExtentInfo_s & VolInfo,
+	const mat33 & LatticeVector,
+	double & RhoCutoff,
+	const NodeRecordCache_c * NodeCache,
+	vector<VolExtentIndexWeights_s> & VolInfoList,
+	vector<MultiRootParams_s> & RootParams)
+{
+	/*
+	*	Cells 1 to N - 2 are searched, so the points of each have all
+	*	their neighbors for the max/min check, as in a non-periodic
+	*	FindCPs().
+	*/
+	const int N = 2 * HalfWidth + 3;
+	vector<int> NumPtsXYZ(3, N);
+
+	VolExtentInfo_s BoxInfo = VolInfo;
+	vec3 CenterIJK;
+	CenterIJK.fill(0.5 * static_cast<double>(N - 1));
+	BoxInfo.MinXYZ = Pt - LatticeVector * CenterIJK;
+	BoxInfo.IsPeriodic = FALSE;
+
+	cube RhoVals(N, N, N);
+	Boolean_t IsOk = SampleRhoOnLattice(RhoVals, *RootParams[0].RhoPtr, BoxInfo.MinXYZ, LatticeVector, VolInfoList);
+
+	uchar_cube CPCandidates;
+	if (IsOk)
+		MarkCPCandidateCells(RhoVals, FALSE, CPCandidates);
+
+	vector<CritPoints_c> ThreadCPs(RootParams.size());
+
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+	for (int zi = 1; zi < N - 1; ++zi){
+		int ThreadNum = omp_get_thread_num();
+		for (int yi = 1; yi < N - 1 && IsOk; ++yi){
+			for (int xi = 1; xi < N - 1; ++xi){
+				SearchCPLatticeCell(xi, yi, zi, NumPtsXYZ, RhoVals, CPCandidates(xi, yi, zi),
+					BoxInfo, LatticeVector, RhoCutoff, NodeCache, RootParams[ThreadNum], ThreadCPs[ThreadNum]);
+			}
+		}
+	}
+
+	if (IsOk)
+		CPs = CritPoints_c(ThreadCPs);
+
+	return IsOk;
+}
+
+const Boolean_t CheckCPTopology(CritPoints_c & CPs,
+	const VolExtentInfo_s & VolInfo,
+	const double & CellSpacing,
+	double & RhoCutoff,
+	const Boolean_t & IsPeriodic,
+	FieldDataPointer_c & RhoPtr,
+	vector<FieldDataPointer_c> & GradXYZPtrs,
+	vector<FieldDataPointer_c> & HessPtrs,
+	const NodeRecordCache_c * NodeCache,
+	CPTopologyCheck_s * Check)
+{
+	/*
+	*	Periodic images of CPs count as the same CP, both for the
+	*	neighbors found here and for merging the CPs found.
+	*/
+	if (IsPeriodic)
+		CPs.SetSpatialIndexLattice(PeriodicLatticeVectors(VolInfo));
+
+	CPTopologyCheck_s Result;
+	Result.ExpectedSum = (IsPeriodic ? 0 : 1);
+	Result.StartSum = Result.EndSum = CPs.PoincareHopfSum();
+
+	int NumThreads = omp_get_num_procs();
+	vector<VolExtentIndexWeights_s> VolInfoList(NumThreads, VolInfo);
+	vector<MultiRootParams_s> RootParams;
+	mat33 I = eye<mat>(3, 3);
+	SetupCPSearchParams(RootParams, VolInfoList, I, IsPeriodic, RhoPtr, GradXYZPtrs, HessPtrs, NodeCache);
+
+	double Spacing = CellSpacing;
+	for (int r = 0; r < CPTopologyMaxRefinements && Result.EndSum != Result.ExpectedSum; ++r){
+		double StartOffset = 0.5 * Spacing, MinCPDist = CPs.GetMinCPDist();
+		if (MinCPDist > 0.0)
+			StartOffset = MIN(StartOffset, 0.1 * MinCPDist);
+
+		vector<vec3> Regions;
+		FindSuspectCPRegions(CPs, StartOffset, RhoCutoff, NodeCache, VolInfoList, RootParams, Regions);
+		if (Regions.empty())
+			break;
+
+		Result.NumRefinements++;
+		Result.NumRegions += static_cast<int>(Regions.size());
+
+		Spacing *= 0.5;
+		mat33 LatticeVector = VolInfo.BasisNormalized * Spacing;
+
+		CritPoints_c FoundCPs;
+		if (IsPeriodic)
+			FoundCPs.SetSpatialIndexLattice(PeriodicLatticeVectors(VolInfo));
+		for (const vec3 & Pt : Regions){
+			CritPoints_c RegionCPs;
+			if (FindCPsNearPoint(RegionCPs, Pt, 2 * CPTopologyRegionCells, VolInfo, LatticeVector, RhoCutoff, NodeCache, VolInfoList, RootParams))
+				FoundCPs += RegionCPs;
+		}
+
+		/*
+		*	Overlapping regions find the same CPs, so merge those first
+		*	or they'd each count towards the Poincare-Hopf sum.
+		*	Then only CPs that aren't (spuriously) close to one already
+		*	there are added; the ones there are kept as they are.
+		*/
+		FoundCPs.RemoveSpuriousCPs();
+		CritPoints_c NewCPs = CPs;
+		for (int t = 0; t < 6; ++t){
+			for (int i = 0; i < FoundCPs.NumCPs(t); ++i){
+				double Dist;
+				vec3 CPPos;
+				if (CPs.GetClosestCP(FoundCPs.GetXYZ(t, i), Dist, CPPos) < 0 || Dist > SpuriousCPCheckDistance)
+					NewCPs.AddPoint(FoundCPs.GetRho(t, i), FoundCPs.GetXYZ(t, i), FoundCPs.GetPrincDir(t, i), CPTypeList[t]);
+			}
+		}
+
+		if (abs(NewCPs.PoincareHopfSum() - Result.ExpectedSum) < abs(Result.EndSum - Result.ExpectedSum)){
+			Result.NumCPsAdded += NewCPs.NumCPs() - CPs.NumCPs();
+			CPs = NewCPs;
+			Result.EndSum = CPs.PoincareHopfSum();
+		}
+	}
+
+	if (Check != NULL)
+		*Check = Result;
+
+	return (Result.EndSum == Result.ExpectedSum);
+}
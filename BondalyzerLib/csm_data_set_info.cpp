@@ -27,6 +27,12 @@ using std::stringstream;
 int StatusNumValues;
 int StatusMaxNumValues = 20;
 vector<duration<double> > StatusMeanList(StatusMaxNumValues, duration<double>(0));
+/*
+*	When set, the status functions don't touch Tecplot at all
+*	(StatusUpdate() never asks to quit), so the numerics can run
+*	without a Tecplot session.
+*/
+Boolean_t StatusIsHeadless = FALSE;
 
 size_t getTotalSystemMemory()
 {
@@ -629,7 +635,13 @@ void ZoneXYZVarGetMinMax_Ordered3DZone(const vector<int> & XYZVarNums, const int
 	*	Begin other functions
 	*/
 
+void StatusSetHeadless(const Boolean_t & IsHeadless){
+	StatusIsHeadless = IsHeadless;
+}
+
 void StatusLaunch(const string & StatusStr, const AddOn_pa & AddOnID, const Boolean_t & ShowScale, const Boolean_t & ShowButton){
+	if (StatusIsHeadless) return;
+
 	TecUtilLockStart(AddOnID);
 // 	TecUtilDrawGraphics(TRUE);
 	TecUtilStatusSuspend(FALSE);
@@ -646,6 +658,8 @@ void StatusLaunch(const string & StatusStr, const AddOn_pa & AddOnID, const Bool
 }
 
 void StatusDrop(const AddOn_pa & AddOnID){
+	if (StatusIsHeadless) return;
+
 	TecUtilLockStart(AddOnID);
 // 	TecUtilDrawGraphics(TRUE);
 	TecUtilStatusSuspend(FALSE);
@@ -681,6 +695,8 @@ const Boolean_t StatusUpdate(unsigned int CurrentNum,
 	const AddOn_pa & AddOnID,
 	high_resolution_clock::time_point StartTime)
 {
+	if (StatusIsHeadless) return TRUE;
+
 	unsigned int Percent = MAX(0, MIN(static_cast<int>((static_cast<double>(CurrentNum) + 0.5) / static_cast<double>(TotalNum)* 100.), 100));
 
 	TecUtilLockStart(AddOnID);
@@ -16,6 +16,7 @@
 #include "CSM_DATA_TYPES.h"
 #include "CSM_DATA_SET_INFO.h"
 #include "CSM_FE_VOLUME.h"
+#include "CSM_NODE_RECORD_CACHE.h"
 
 // #define RECORD_INT_POINTS
 
@@ -176,38 +177,111 @@ const Boolean_t FESurface_c::MakeGradientBundle(vector<GradPath_c*> GPs)
 			}
 		}
 
-		/*
-		 * Generate triangle list.
-		 */
+		TriangulateGradientBundle();
+	}
+
+	return IsOk;
+}
+
+/*
+	Same, from paths in a GradPathSet_c
+*/
+const Boolean_t FESurface_c::MakeGradientBundle(const GradPathSet_c & GPs, const vector<int> & PathNums)
+{
+	Boolean_t IsOk = TRUE;
+	for (int i = 0; i < PathNums.size() && IsOk; ++i){
+		IsOk = GPs.IsMade(PathNums[i]);
+		if (IsOk && i > 0){
+			IsOk = (GPs.GetCount(PathNums[i]) == GPs.GetCount(PathNums[i - 1]));
+		}
+	}
+
+	if (IsOk){
+		m_NumGPs = PathNums.size();
+		m_NumGPPts = GPs.GetCount(PathNums[0]);
+		m_NumNodes = m_NumGPs * m_NumGPPts;
+		m_NumElems = 2 * (m_NumGPs - 2) + 2 * m_NumGPs * (m_NumGPPts - 1);
+
+		m_XYZList.resize(m_NumGPs * m_NumGPPts);
 
-		vector<int> V(m_NumGPs);
-		for (int i = 0; i < m_NumGPs; ++i){
-			V[i] = i * m_NumGPPts;
-		}
- 
-		Domain_c D(V, this);
-		D.Weight();
- 
-		TriPolyLines();
- 
-		V = vector<int>();
-		V.reserve(m_NumGPs * 2);
-		int OldNumNodes = m_XYZList.size() - m_NumGPs;
 		for (int i = 0; i < m_NumGPs; ++i){
-			V.push_back((i + 1) * m_NumGPPts - 1);
-			V.push_back(OldNumNodes + i);
+			for (int j = 0; j < m_NumGPPts; ++j){
+				m_XYZList[i * m_NumGPPts + j] = GPs.XYZAt(PathNums[i], j);
+			}
 		}
-		D.Setup(V, this);
-		D.Weight();
 
-		m_NumElems = m_ElemList.size();
+		TriangulateGradientBundle();
+	}
 
-		m_FEVolumeMade = TRUE;
+	return IsOk;
+}
+
+/*
+	Same, from compact paths sampled at NumGPPts points each
+*/
+const Boolean_t FESurface_c::MakeGradientBundle(const vector<const CompactGradPath_c*> & GPs, const int & NumGPPts)
+{
+	Boolean_t IsOk = (NumGPPts > 1);
+	for (int i = 0; i < GPs.size() && IsOk; ++i){
+		IsOk = GPs[i]->IsMade();
+	}
+
+	if (IsOk){
+		m_NumGPs = GPs.size();
+		m_NumGPPts = NumGPPts;
+		m_NumNodes = m_NumGPs * m_NumGPPts;
+		m_NumElems = 2 * (m_NumGPs - 2) + 2 * m_NumGPs * (m_NumGPPts - 1);
+
+		m_XYZList.resize(m_NumGPs * m_NumGPPts);
+
+		vector<vec3> XYZList;
+		vector<double> RhoList;
+		for (int i = 0; i < m_NumGPs; ++i){
+			GPs[i]->Sample(m_NumGPPts, XYZList, RhoList);
+			std::copy(XYZList.cbegin(), XYZList.cend(), m_XYZList.begin() + i * m_NumGPPts);
+		}
+
+		TriangulateGradientBundle();
 	}
 
 	return IsOk;
 }
 
+/*
+	Triangulate the sides and ends of a gradient bundle whose
+	m_NumGPs paths of m_NumGPPts points each are in m_XYZList.
+*/
+void FESurface_c::TriangulateGradientBundle()
+{
+	/*
+	 * Generate triangle list.
+	 */
+
+	vector<int> V(m_NumGPs);
+	for (int i = 0; i < m_NumGPs; ++i){
+		V[i] = i * m_NumGPPts;
+	}
+
+	Domain_c D(V, this);
+	D.Weight();
+
+	TriPolyLines();
+
+	V = vector<int>();
+	V.reserve(m_NumGPs * 2);
+	int OldNumNodes = m_XYZList.size() - m_NumGPs;
+	for (int i = 0; i < m_NumGPs; ++i){
+		V.push_back((i + 1) * m_NumGPPts - 1);
+		V.push_back(OldNumNodes + i);
+	}
+	D.Setup(V, this);
+	D.Weight();
+
+	m_NumElems = m_ElemList.size();
+
+	m_FEVolumeMade = TRUE;
+}
+
 /*
 Make FEVolume from vector of pointers to GradPath_c's
 */
@@ -1354,9 +1428,23 @@ const Boolean_t FESurface_c::DoIntegration(const Boolean_t & IntegrateVolume,
 // 	return IsOk;
 // }
 
+/*
+*	The node record cache can only stand in for m_IntVarPtrs if it was
+*	built from the same variables on the same zone.
+*/
+const Boolean_t FESurface_c::IntVarCacheIsValid() const
+{
+	return (m_IntVarCache != NULL
+		&& m_IntVarCache->IsReady()
+		&& m_IntVarCache->NumVars() == m_NumIntVars
+		&& m_NumIntVars > 0
+		&& m_IntVarCache->NumNodes() == m_IntVarPtrs[0].Size());
+}
+
 const Boolean_t FESurface_c::DoIntegrationNew(const int & ResolutionScale, const Boolean_t & IntegrateVolume)
 {
 	Boolean_t IsOk = m_FEVolumeMade;
+	const Boolean_t UseIntVarCache = IntVarCacheIsValid();
 
 	if (IsOk && !m_IntegrationResultsReady){
 // 		m_ZoneMinXYZ = m_VolZoneInfo.MaxXYZ;
@@ -1565,8 +1653,17 @@ const Boolean_t FESurface_c::DoIntegrationNew(const int & ResolutionScale, const
 							SubCellVolume = CellVolume * SubDivideFactor;
 							if (IntegrateVolume)
 								m_IntValues[m_NumIntVars] += SubCellVolume;
-							for (int i = 0; i < m_NumIntVars; ++i){
-								m_IntValues[i] += m_IntVarPtrs[i][VolIndex] * SubCellVolume;
+							if (UseIntVarCache){
+								double Rec[VolInfo_MaxGatherVars];
+								m_IntVarCache->ValsAtNode(VolIndex, Rec);
+								for (int i = 0; i < m_NumIntVars; ++i){
+									m_IntValues[i] += Rec[i] * SubCellVolume;
+								}
+							}
+							else{
+								for (int i = 0; i < m_NumIntVars; ++i){
+									m_IntValues[i] += m_IntVarPtrs[i][VolIndex] * SubCellVolume;
+								}
 							}
 						}
 						else{
@@ -1895,8 +1992,17 @@ const Boolean_t FESurface_c::SubDivideIntegrateCellAtPoint(const vec3 & Point,
 							CellVolume *= DelXYZ[dir];
 						if (IntegrateVolume)
 							m_IntValues[m_NumIntVars] += CellVolume;
-						for (int i = 0; i < m_NumIntVars; ++i){
-							m_IntValues[i] += ValByCurrentIndexAndWeightsFromRawPtr(m_VolZoneInfo, m_IntVarPtrs[i]) * CellVolume;
+						if (IntVarCacheIsValid()){
+							double IntVals[VolInfo_MaxGatherVars];
+							m_IntVarCache->ValsByIndexAndWeights(m_VolZoneInfo, IntVals);
+							for (int i = 0; i < m_NumIntVars; ++i){
+								m_IntValues[i] += IntVals[i] * CellVolume;
+							}
+						}
+						else{
+							for (int i = 0; i < m_NumIntVars; ++i){
+								m_IntValues[i] += ValByCurrentIndexAndWeightsFromRawPtr(m_VolZoneInfo, m_IntVarPtrs[i]) * CellVolume;
+							}
 						}
 					}
 				}
@@ -1909,8 +2015,17 @@ const Boolean_t FESurface_c::SubDivideIntegrateCellAtPoint(const vec3 & Point,
 						CellVolume *= DelXYZ[dir];
 					if (IntegrateVolume)
 						m_IntValues[m_NumIntVars] += CellVolume;
-					for (int i = 0; i < m_NumIntVars; ++i){
-						m_IntValues[i] += ValByCurrentIndexAndWeightsFromRawPtr(m_VolZoneInfo, m_IntVarPtrs[i]) * CellVolume;
+					if (IntVarCacheIsValid()){
+						double IntVals[VolInfo_MaxGatherVars];
+						m_IntVarCache->ValsByIndexAndWeights(m_VolZoneInfo, IntVals);
+						for (int i = 0; i < m_NumIntVars; ++i){
+							m_IntValues[i] += IntVals[i] * CellVolume;
+						}
+					}
+					else{
+						for (int i = 0; i < m_NumIntVars; ++i){
+							m_IntValues[i] += ValByCurrentIndexAndWeightsFromRawPtr(m_VolZoneInfo, m_IntVarPtrs[i]) * CellVolume;
+						}
 					}
 				}
 			}
@@ -13,20 +13,6 @@ using namespace arma;
 const Boolean_t FieldDataPointer_c::operator==(const FieldDataPointer_c & rhs) const{
 	return (m_VoidPtr == rhs.m_VoidPtr
 
-		&& m_ReadBitPtr == rhs.m_ReadBitPtr
-		&& m_ReadBytePtr == rhs.m_ReadBytePtr
-		&& m_ReadInt16Ptr == rhs.m_ReadInt16Ptr
-		&& m_ReadInt32Ptr == rhs.m_ReadInt32Ptr
-		&& m_ReadFltPtr == rhs.m_ReadFltPtr
-		&& m_ReadDblPtr == rhs.m_ReadDblPtr
-
-		&& m_WriteBitPtr == rhs.m_WriteBitPtr
-		&& m_WriteBytePtr == rhs.m_WriteBytePtr
-		&& m_WriteInt16Ptr == rhs.m_WriteInt16Ptr
-		&& m_WriteInt32Ptr == rhs.m_WriteInt32Ptr
-		&& m_WriteFltPtr == rhs.m_WriteFltPtr
-		&& m_WriteDblPtr == rhs.m_WriteDblPtr
-
 		&& m_Size == rhs.m_Size
 		&& m_Zone == rhs.m_Zone
 		&& m_Var == rhs.m_Var
@@ -40,20 +26,7 @@ FieldDataPointer_c & FieldDataPointer_c::operator=(const FieldDataPointer_c & rh
 
 	m_VoidPtr = rhs.m_VoidPtr;
 
-	m_ReadBitPtr = rhs.m_ReadBitPtr;
-	m_ReadBytePtr = rhs.m_ReadBytePtr;
-	m_ReadInt16Ptr = rhs.m_ReadInt16Ptr;
-	m_ReadInt32Ptr = rhs.m_ReadInt32Ptr;
-	m_ReadFltPtr = rhs.m_ReadFltPtr;
-	m_ReadDblPtr = rhs.m_ReadDblPtr;
-
-	m_WriteBitPtr = rhs.m_WriteBitPtr;
-	m_WriteBytePtr = rhs.m_WriteBytePtr;
-	m_WriteInt16Ptr = rhs.m_WriteInt16Ptr;
-	m_WriteInt32Ptr = rhs.m_WriteInt32Ptr;
-	m_WriteFltPtr = rhs.m_WriteFltPtr;
-	m_WriteDblPtr = rhs.m_WriteDblPtr;
-
+	for (int i = 0; i < 3; ++i) m_MaxIJK[i] = rhs.m_MaxIJK[i];
 	m_Size = rhs.m_Size;
 	m_Zone = rhs.m_Zone;
 	m_Var = rhs.m_Var;
@@ -61,63 +34,11 @@ FieldDataPointer_c & FieldDataPointer_c::operator=(const FieldDataPointer_c & rh
 	m_IsReadPtr = rhs.m_IsReadPtr;
 	m_IsReady = rhs.m_IsReady;
 	m_FDType = rhs.m_FDType;
+	m_ValueLocation = rhs.m_ValueLocation;
+	m_ZoneType = rhs.m_ZoneType;
 
 	return *this;
 }
-const double FieldDataPointer_c::operator[](const unsigned int & i) const{
-	double Val = 0.0;
-	REQUIRE(m_IsReady && i < m_Size && i >= 0);
-	if (m_IsReadPtr){
-		switch (m_FDType){
-			case FieldDataType_Float:
-				Val = static_cast<double>(m_ReadFltPtr[i]);
-				break;
-			case FieldDataType_Double:
-				Val = static_cast<double>(m_ReadDblPtr[i]);
-				break;
-			case FieldDataType_Int16:
-				Val = static_cast<double>(m_ReadInt16Ptr[i]);
-				break;
-			case FieldDataType_Int32:
-				Val = static_cast<double>(m_ReadInt32Ptr[i]);
-				break;
-			case FieldDataType_Byte:
-				Val = static_cast<double>(m_ReadBytePtr[i]);
-				break;
-			case FieldDataType_Bit:
-				Val = static_cast<double>(m_ReadBitPtr[i]);
-				break;
-			default:
-				break;
-		}
-	}
-	else{
-		switch (m_FDType){
-			case FieldDataType_Float:
-				Val = static_cast<double>(m_WriteFltPtr[i]);
-				break;
-			case FieldDataType_Double:
-				Val = static_cast<double>(m_WriteDblPtr[i]);
-				break;
-			case FieldDataType_Int16:
-				Val = static_cast<double>(m_WriteInt16Ptr[i]);
-				break;
-			case FieldDataType_Int32:
-				Val = static_cast<double>(m_WriteInt32Ptr[i]);
-				break;
-			case FieldDataType_Byte:
-				Val = static_cast<double>(m_WriteBytePtr[i]);
-				break;
-			case FieldDataType_Bit:
-				Val = static_cast<double>(m_WriteBitPtr[i]);
-				break;
-			default:
-				break;
-		}
-	}
-
-	return Val;
-}
 
 const double FieldDataPointer_c::At(vec3 & Pt, VolExtentIndexWeights_s & VolInfo) const{
 	if (SetIndexAndWeightsForPoint(Pt, VolInfo)){
@@ -134,22 +55,22 @@ const Boolean_t FieldDataPointer_c::Write(const unsigned int & i, const double &
 
 	switch (m_FDType){
 		case FieldDataType_Float:
-			m_WriteFltPtr[i] = static_cast<float_t>(Val);
+			TypedWritePtr<float_t>()[i] = static_cast<float_t>(Val);
 			break;
 		case FieldDataType_Double:
-			m_WriteDblPtr[i] = static_cast<double_t>(Val);
+			TypedWritePtr<double_t>()[i] = static_cast<double_t>(Val);
 			break;
 		case FieldDataType_Int16:
-			m_WriteInt16Ptr[i] = static_cast<Int16_t>(Val);
+			TypedWritePtr<Int16_t>()[i] = static_cast<Int16_t>(Val);
 			break;
 		case FieldDataType_Int32:
-			m_WriteInt32Ptr[i] = static_cast<Int32_t>(Val);
+			TypedWritePtr<Int32_t>()[i] = static_cast<Int32_t>(Val);
 			break;
 		case FieldDataType_Byte:
-			m_WriteBytePtr[i] = static_cast<Byte_t>(Val);
+			TypedWritePtr<Byte_t>()[i] = static_cast<Byte_t>(Val);
 			break;
 		case FieldDataType_Bit:
-			m_WriteBitPtr[i] = static_cast<bool>(Val);
+			TypedWritePtr<bool>()[i] = static_cast<bool>(Val);
 			break;
 		default:
 			break;
@@ -190,22 +111,11 @@ const Boolean_t FieldDataPointer_c::GetReadPtr(const int & ZoneNum, const int &
 
 		switch (m_FDType){
 			case FieldDataType_Float:
-				m_ReadFltPtr = reinterpret_cast<const float_t*>(m_VoidPtr);
-				break;
 			case FieldDataType_Double:
-				m_ReadDblPtr = reinterpret_cast<const double_t*>(m_VoidPtr);
-				break;
 			case FieldDataType_Int16:
-				m_ReadInt16Ptr = reinterpret_cast<const Int16_t*>(m_VoidPtr);
-				break;
 			case FieldDataType_Int32:
-				m_ReadInt32Ptr = reinterpret_cast<const Int32_t*>(m_VoidPtr);
-				break;
 			case FieldDataType_Byte:
-				m_ReadBytePtr = reinterpret_cast<const Byte_t*>(m_VoidPtr);
-				break;
 			case FieldDataType_Bit:
-				m_ReadBitPtr = reinterpret_cast<const bool*>(m_VoidPtr);
 				break;
 			default:
 				m_IsReady = FALSE;
@@ -250,22 +160,11 @@ const Boolean_t FieldDataPointer_c::GetWritePtr(const int & ZoneNum, const int &
 
 		switch (m_FDType){
 			case FieldDataType_Float:
-				m_WriteFltPtr = reinterpret_cast<float_t*>(m_VoidPtr);
-				break;
 			case FieldDataType_Double:
-				m_WriteDblPtr = reinterpret_cast<double_t*>(m_VoidPtr);
-				break;
 			case FieldDataType_Int16:
-				m_WriteInt16Ptr = reinterpret_cast<Int16_t*>(m_VoidPtr);
-				break;
 			case FieldDataType_Int32:
-				m_WriteInt32Ptr = reinterpret_cast<Int32_t*>(m_VoidPtr);
-				break;
 			case FieldDataType_Byte:
-				m_WriteBytePtr = reinterpret_cast<Byte_t*>(m_VoidPtr);
-				break;
 			case FieldDataType_Bit:
-				m_WriteBitPtr = reinterpret_cast<bool*>(m_VoidPtr);
 				break;
 			default:
 				m_IsReady = FALSE;
@@ -278,6 +177,30 @@ const Boolean_t FieldDataPointer_c::GetWritePtr(const int & ZoneNum, const int &
 	return m_IsReady;
 }
 
+const Boolean_t FieldDataPointer_c::SetArrayPtr(void * Data, const FieldDataType_e FDType, const vector<int> & MaxIJK, const Boolean_t & IsReadPtr){
+	Close();
+
+	m_IsReady = (Data != NULL && FDType != FieldDataType_Invalid && MaxIJK.size() == 3);
+	for (int i = 0; i < 3 && m_IsReady; ++i)
+		m_IsReady = (MaxIJK[i] >= 1);
+
+	if (m_IsReady){
+		m_VoidPtr = Data;
+		m_FDType = FDType;
+		for (int i = 0; i < 3; ++i) m_MaxIJK[i] = MaxIJK[i];
+		m_Size = m_MaxIJK[0] * m_MaxIJK[1] * m_MaxIJK[2];
+		m_Zone = -1;
+		m_Var = -1;
+		m_IsReadPtr = IsReadPtr;
+		m_ValueLocation = ValueLocation_Nodal;
+		m_ZoneType = ZoneType_Ordered;
+	}
+
+	REQUIRE(m_IsReady);
+
+	return m_IsReady;
+}
+
 void FieldDataPointer_c::Close(){
 	if (m_IsReady){
 		if (!m_IsReadPtr && m_Zone > 0 && m_Var > 0){
@@ -302,6 +225,19 @@ void FieldDataPointer_c::Close(){
 }
 
 
+const FieldDataType_e CommonFDType(const vector<FieldDataPointer_c> & Ptrs){
+	if (Ptrs.empty()) return FieldDataType_Invalid;
+
+	FieldDataType_e FDType = Ptrs[0].FDType();
+	for (const auto & p : Ptrs){
+		if (!p.IsReady() || p.FDType() != FDType)
+			return FieldDataType_Invalid;
+	}
+
+	return FDType;
+}
+
+
 /*
  *	Begin methods for FieldVecPointer_c
  */
@@ -7,14 +7,20 @@
 
 #include <list>
 #include <vector>
+#include <algorithm>
 #include <string>
 #include <fstream>
 #include <iomanip>
+#include <random>
+#include <chrono>
+#include <omp.h>
 
+#ifndef CSM_NO_GSL
 #include <gsl/gsl_errno.h>
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_odeiv2.h>
 #include <gsl/gsl_multiroots.h>
+#endif
 
 #include "CSM_DATA_TYPES.h"
 #include "CSM_CALC_VARS.h"
@@ -22,6 +28,7 @@
 #include "CSM_VOL_EXTENT_INDEX_WEIGHTS.h"
 #include "CSM_CRIT_POINTS.h"
 #include "CSM_GRAD_PATH.h"
+#include "CSM_NODE_RECORD_CACHE.h"
 
 #include <armadillo>
 using namespace arma;
@@ -30,11 +37,11 @@ using std::list;
 using std::vector;
 using std::string;
 using std::to_string;
+using std::chrono::high_resolution_clock;
+using std::chrono::duration;
 
 
-int F2DGrad(const gsl_vector * pos, void * params, gsl_vector * GradValues);
-int DF2DGrad(const gsl_vector * pos, void * params, gsl_matrix * Jacobian);
-int FDF2DGrad(const gsl_vector * pos, void * params, gsl_vector * GradValues, gsl_matrix * Jacobian);
+static const Boolean_t FDF2DGrad(const double (&Pos)[2], MultiRootParams_s & RootParams, double (&Grad)[2], double (&Hess)[2][2]);
 
 /*
 *	GradPathParams_s methods
@@ -51,8 +58,15 @@ GradPathParams_s & GradPathParams_s::operator=(const GradPathParams_s & rhs)
 	HasHess = rhs.HasHess;
 
 	RhoPtr = rhs.RhoPtr;
+	NodeCache = rhs.NodeCache;
+	UseTricubic = rhs.UseTricubic;
+
+	Integrator = rhs.Integrator;
+	AbsTol = rhs.AbsTol;
+	RelTol = rhs.RelTol;
 
 	VolZoneInfo = rhs.VolZoneInfo;
+	Stencil = rhs.Stencil;
 
 	Direction = rhs.Direction;
 
@@ -69,8 +83,15 @@ const Boolean_t GradPathParams_s::operator==(const GradPathParams_s & rhs) const
 		HasHess == rhs.HasHess &&
 
 		RhoPtr == rhs.RhoPtr &&
+		NodeCache == rhs.NodeCache &&
+		UseTricubic == rhs.UseTricubic &&
 
-		VolZoneInfo == rhs.VolZoneInfo &&
+		Integrator == rhs.Integrator &&
+		AbsTol == rhs.AbsTol &&
+		RelTol == rhs.RelTol &&
+
+		(VolZoneInfo == rhs.VolZoneInfo
+		|| (VolZoneInfo != nullptr && rhs.VolZoneInfo != nullptr && *VolZoneInfo == *rhs.VolZoneInfo)) &&
 
 		Direction == rhs.Direction
 		);
@@ -338,79 +359,91 @@ const vec3 GradPathBase_c::ClosestPoint(const vec3 & CheckPt, int & PtNum) const
 	return ClosestPt;
 }
 
-const Boolean_t GradPathBase_c::Resample(const int & NumPoints){
-	Boolean_t IsOk = m_GradPathMade && NumPoints > 1;
-
-	vector<vec3> NewXYZList;
-	vector<double> NewRhoList;
-
-	int OldCount = GetCount();
-
-	if (IsOk && NumPoints < OldCount){
-// 	if (IsOk){
-		NewXYZList.resize(NumPoints);
-
-		NewRhoList.resize(NumPoints);
+/*
+*	Resample the first OldCount points of XYZ/Rho, whose total length is
+*	Length, to NumPoints points evenly spaced by arc length, passing each
+*	new point to SetPoint(i, XYZ, Rho).
+*	Shared by GradPathBase_c::Resample() and GradPathSet_c::SetPath().
+*/
+template <typename SetPointFunc>
+static void ResampleGradPathPoints(const vector<vec3> & XYZList,
+	const vector<double> & RhoList,
+	const int & OldCount,
+	const double & Length,
+	const int & NumPoints,
+	SetPointFunc SetPoint)
+{
+	double DelLength = Length / static_cast<double>(NumPoints - 1);
 
-		double DelLength = GetLength() / static_cast<double>(NumPoints - 1);
+	double ArcLength = 0.0,
+		ArcLengthI = 0.0,
+		ArcLengthIm1 = 0.0;
 
-		double ArcLength = 0.0,
-			ArcLengthI = 0.0,
-			ArcLengthIm1 = 0.0;
+	vec3 PtI, PtIm1;
+	double RhoI, RhoIm1;
 
-		vec3 PtI, PtIm1;
-		double RhoI, RhoIm1;
+	PtI = XYZList[0];
+	RhoI = RhoList[0];
 
-		PtI = m_XYZList[0];
-		RhoI = m_RhoList[0];
+	SetPoint(0, PtI, RhoI);
 
-		NewXYZList[0] = PtI;
+	int OldI = 0;
 
-		NewRhoList[0] = RhoI;
+	for (int NewI = 1; NewI < NumPoints - 1; ++NewI){
+		ArcLength += DelLength;
 
-		int OldI = 0;
+		while (OldI < OldCount - 1 && ArcLengthI < ArcLength){
+			++OldI;
 
-		for (int NewI = 1; NewI < NumPoints - 1; ++NewI){
-			ArcLength += DelLength;
+			ArcLengthIm1 = ArcLengthI;
+			PtIm1 = PtI;
+			RhoIm1 = RhoI;
 
-			while (OldI < OldCount - 1 && ArcLengthI < ArcLength){
-				++OldI;
+			PtI = XYZList[OldI];
+			RhoI = RhoList[OldI];
 
-				ArcLengthIm1 = ArcLengthI;
-				PtIm1 = PtI;
-				RhoIm1 = RhoI;
+			ArcLengthI += Distance(PtI, PtIm1);
+		}
 
-				PtI = m_XYZList[OldI];
-				RhoI = m_RhoList[OldI];
+		double Ratio = (ArcLength - ArcLengthIm1) / (ArcLengthI - ArcLengthIm1);
+		SetPoint(NewI, PtIm1 + (PtI - PtIm1) * Ratio, RhoIm1 + Ratio * (RhoI - RhoIm1));
 
-				ArcLengthI += Distance(PtI, PtIm1);
+		if (OldI >= OldCount){
+			while (NewI < NumPoints){
+				NewI++;
+				if (NewI < NumPoints){
+					SetPoint(NewI, PtIm1 + (PtI - PtIm1) * Ratio, RhoIm1 + Ratio * (RhoI - RhoIm1));
+				}
 			}
+		}
+	}
 
-			double Ratio = (ArcLength - ArcLengthIm1) / (ArcLengthI - ArcLengthIm1);
-			NewXYZList[NewI] = PtIm1 + (PtI - PtIm1) * Ratio;
+	/*
+	*	Add last point
+	*/
 
-			NewRhoList[NewI] = RhoIm1 + Ratio * (RhoI - RhoIm1);
+	SetPoint(NumPoints - 1, XYZList[OldCount - 1], RhoList[OldCount - 1]);
+}
 
-			if (OldI >= OldCount){
-				while (NewI < NumPoints){
-					NewI++;
-					if (NewI < NumPoints){
-						NewXYZList[NewI] = PtIm1 + (PtI - PtIm1) * Ratio;
+const Boolean_t GradPathBase_c::Resample(const int & NumPoints){
+	Boolean_t IsOk = m_GradPathMade && NumPoints > 1;
 
-						NewRhoList[NewI] = RhoIm1 + Ratio * (RhoI - RhoIm1);
-					}
-				}
-			}
-		}
+	vector<vec3> NewXYZList;
+	vector<double> NewRhoList;
 
-		/*
-		*	Add last point
-		*/
+	int OldCount = GetCount();
 
-		NewXYZList[NumPoints - 1] = m_XYZList[OldCount - 1];
+	if (IsOk && NumPoints < OldCount){
+// 	if (IsOk){
+		NewXYZList.resize(NumPoints);
 
-		NewRhoList[NumPoints - 1] = m_RhoList[OldCount - 1];
+		NewRhoList.resize(NumPoints);
 
+		ResampleGradPathPoints(m_XYZList, m_RhoList, OldCount, GetLength(), NumPoints,
+			[&](const int & i, const vec3 & Pt, const double & Rho){
+				NewXYZList[i] = Pt;
+				NewRhoList[i] = Rho;
+			});
 
 		IsOk = NewXYZList.size() == NumPoints;
 
@@ -855,6 +888,35 @@ GradPath_c::GradPath_c(const vec3 & StartPoint,
 		RhoPtr);
 } //	GradPath_c::GradPath_c()
 
+GradPath_c::GradPath_c(const vec3 & StartPoint,
+	const StreamDir_e & Direction,
+	const int & NumGPPoints,
+	const GPType_e & GPType,
+	const GPTerminate_e & HowTerminate,
+	vec3 * TermPoint,
+	CritPoints_c * CPs,
+	double * TermPointRadius,
+	double * TermValue,
+	const std::shared_ptr<const VolExtentInfo_s> & VolInfo,
+	const vector<FieldDataPointer_c> & HessPtrs,
+	const vector<FieldDataPointer_c> & GradPtrs,
+	const FieldDataPointer_c & RhoPtr)
+{
+	m_GradPathReady = SetupGradPath(StartPoint,
+		Direction,
+		NumGPPoints,
+		GPType,
+		HowTerminate,
+		TermPoint,
+		CPs,
+		TermPointRadius,
+		TermValue,
+		VolInfo,
+		HessPtrs,
+		GradPtrs,
+		RhoPtr);
+} //	GradPath_c::GradPath_c()
+
 GradPath_c::GradPath_c(EntIndex_t ZoneNum,
 	const vector<EntIndex_t> & XYZRhoVarNums,
 	const AddOn_pa & AddOnID) : GradPathBase_c(ZoneNum, XYZRhoVarNums, AddOnID){}
@@ -897,6 +959,7 @@ GradPath_c & GradPath_c::operator=(const GradPath_c & rhs)
 
 	m_HowTerminate = rhs.m_HowTerminate;
 	m_StartPoint = rhs.m_StartPoint;
+	m_EndReason = rhs.m_EndReason;
 
 	return *this;
 }// GradPath_c & GradPath_c::operator=(const GradPath_c & rhs)
@@ -941,6 +1004,43 @@ const Boolean_t GradPath_c::operator==(const GradPath_c & rhs) const
 *	Setter methods
 */
 
+/*
+*	The extent-only descriptor the MaxIJK/MaxXYZ/MinXYZ setup uses.
+*	The last one made is kept and handed to every path set up on the
+*	same extent, so a loop of such paths shares one descriptor rather
+*	than allocating one per path.
+*/
+static const Boolean_t IsLegacyVolInfo(const std::shared_ptr<const VolExtentInfo_s> & VolInfo,
+	const vector<int> & MaxIJK,
+	const vec3 & MaxXYZ,
+	const vec3 & MinXYZ)
+{
+	return (VolInfo != nullptr
+		&& VolInfo->MaxIJK == MaxIJK
+		&& all(VolInfo->MaxXYZ == MaxXYZ)
+		&& all(VolInfo->MinXYZ == MinXYZ));
+}
+
+static const std::shared_ptr<const VolExtentInfo_s> LegacyVolInfo(const vector<int> & MaxIJK,
+	const vec3 & MaxXYZ,
+	const vec3 & MinXYZ)
+{
+	static std::shared_ptr<const VolExtentInfo_s> LastVolInfo;
+	std::shared_ptr<const VolExtentInfo_s> VolInfo;
+#pragma omp critical(LegacyVolInfo)
+	{
+		if (!IsLegacyVolInfo(LastVolInfo, MaxIJK, MaxXYZ, MinXYZ)){
+			VolExtentInfo_s * NewVolInfo = new VolExtentInfo_s;
+			NewVolInfo->MaxIJK = MaxIJK;
+			NewVolInfo->MaxXYZ = MaxXYZ;
+			NewVolInfo->MinXYZ = MinXYZ;
+			LastVolInfo.reset(NewVolInfo);
+		}
+		VolInfo = LastVolInfo;
+	}
+	return VolInfo;
+}
+
 /*
 *	This is basically a constructor for a pre-constructed GP
 *	to assign everything needed for it to make itself.
@@ -960,8 +1060,8 @@ const Boolean_t GradPath_c::SetupGradPath(const vec3 & StartPoint,
 	const vector<FieldDataPointer_c> & GradPtrs,
 	const FieldDataPointer_c & RhoPtr)
 {
-	m_XYZList.swap(vector<vec3>());
-	m_RhoList.swap(vector<double>());
+	m_XYZList.clear();
+	m_RhoList.clear();
 
 	m_NumGPPoints = NumGPPoints;
 
@@ -984,9 +1084,8 @@ const Boolean_t GradPath_c::SetupGradPath(const vec3 & StartPoint,
 	if (TermValue != NULL)
 		m_TermValue = *TermValue;
 
-	m_ODE_Data.VolZoneInfo.MaxIJK = MaxIJK;
-	m_ODE_Data.VolZoneInfo.MaxXYZ = MaxXYZ;
-	m_ODE_Data.VolZoneInfo.MinXYZ = MinXYZ;
+	if (!IsLegacyVolInfo(m_ODE_Data.VolZoneInfo, MaxIJK, MaxXYZ, MinXYZ))
+		m_ODE_Data.VolZoneInfo = LegacyVolInfo(MaxIJK, MaxXYZ, MinXYZ);
 
 	m_ODE_Data.GradPtrs = GradPtrs;
 
@@ -1025,6 +1124,7 @@ const Boolean_t GradPath_c::SetupGradPath(const vec3 & StartPoint,
 	m_StartEndCPNum[0] = m_StartEndCPNum[1] = -1;
 
 	m_GradPathMade = FALSE;
+	m_Length = -1;
 
 	return m_GradPathReady;
 }
@@ -1043,8 +1143,45 @@ const Boolean_t GradPath_c::SetupGradPath(const vec3 & StartPoint,
 	const vector<FieldDataPointer_c> & GradPtrs,
 	const FieldDataPointer_c & RhoPtr)
 {
-	m_XYZList.swap(vector<vec3>());
-	m_RhoList.swap(vector<double>());
+	/*
+	*	Reuse the existing descriptor if this path is being set up
+	*	again on the same grid.
+	*/
+	std::shared_ptr<const VolExtentInfo_s> VolInfoPtr = m_ODE_Data.VolZoneInfo;
+	if (VolInfoPtr == nullptr || !(*VolInfoPtr == VolInfo))
+		VolInfoPtr = std::make_shared<const VolExtentInfo_s>(VolInfo);
+
+	return SetupGradPath(StartPoint,
+		Direction,
+		NumGPPoints,
+		GPType,
+		HowTerminate,
+		TermPoint,
+		CPs,
+		TermPointRadius,
+		TermValue,
+		VolInfoPtr,
+		HessPtrs,
+		GradPtrs,
+		RhoPtr);
+}
+
+const Boolean_t GradPath_c::SetupGradPath(const vec3 & StartPoint,
+	const StreamDir_e & Direction,
+	const int & NumGPPoints,
+	const GPType_e & GPType,
+	const GPTerminate_e & HowTerminate,
+	vec3 * TermPoint,
+	CritPoints_c * CPs,
+	double * TermPointRadius,
+	double * TermValue,
+	const std::shared_ptr<const VolExtentInfo_s> & VolInfo,
+	const vector<FieldDataPointer_c> & HessPtrs,
+	const vector<FieldDataPointer_c> & GradPtrs,
+	const FieldDataPointer_c & RhoPtr)
+{
+	m_XYZList.clear();
+	m_RhoList.clear();
 
 	m_NumGPPoints = NumGPPoints;
 
@@ -1081,7 +1218,7 @@ const Boolean_t GradPath_c::SetupGradPath(const vec3 & StartPoint,
 
 	m_ODE_Data.RhoPtr = RhoPtr;
 
-	m_GradPathReady = (m_ODE_Data.VolZoneInfo.MaxIJK.size() == 3);
+	m_GradPathReady = (m_ODE_Data.VolZoneInfo != nullptr && m_ODE_Data.VolZoneInfo->MaxIJK.size() == 3);
 
 	if (m_GradPathReady){
 		m_GradPathReady = RhoPtr.IsReady();
@@ -1101,6 +1238,7 @@ const Boolean_t GradPath_c::SetupGradPath(const vec3 & StartPoint,
 	m_StartEndCPNum[0] = m_StartEndCPNum[1] = -1;
 
 	m_GradPathMade = FALSE;
+	m_Length = -1;
 
 	if (m_GradPathReady){
 		int GPSize = GP_NumPointsBufferFactor * GP_MaxNumPoints;
@@ -1111,18 +1249,147 @@ const Boolean_t GradPath_c::SetupGradPath(const vec3 & StartPoint,
 	return m_GradPathReady;
 }
 
+/*
+*	Dormand-Prince 5(4) coefficients.
+*	Row s of GP_DP_A gives the stage s position; the last row is also
+*	the 5th order solution, so the gradient at the end of an accepted
+*	step is the first stage of the next one.
+*	GP_DP_E is the difference between the 5th and 4th order weights.
+*/
+static const double GP_DP_C[7] = { 0.0, 1.0 / 5.0, 3.0 / 10.0, 4.0 / 5.0, 8.0 / 9.0, 1.0, 1.0 };
+static const double GP_DP_A[7][6] = {
+	{ 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
+	{ 1.0 / 5.0, 0.0, 0.0, 0.0, 0.0, 0.0 },
+	{ 3.0 / 40.0, 9.0 / 40.0, 0.0, 0.0, 0.0, 0.0 },
+	{ 44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0, 0.0, 0.0, 0.0 },
+	{ 19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0, 0.0, 0.0 },
+	{ 9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0, 0.0 },
+	{ 35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0 }
+};
+static const double GP_DP_E[7] = { 71.0 / 57600.0, 0.0, -71.0 / 16695.0, 71.0 / 1920.0, -17253.0 / 339200.0, 22.0 / 525.0, -1.0 / 40.0 };
+
+/*
+*	Adaptive Dormand-Prince integrator for a single path.
+*	Lives on the stack of SeedInDirection(), so seeding a path
+*	allocates nothing beyond the path's own point lists.
+*	Step size control follows gsl_odeiv2_control_y (error scaled by
+*	AbsTol + RelTol * |y|, shrink above 1.1, grow below 0.5, between
+*	0.2x and 5x), and a failed gradient evaluation (e.g. a stage
+*	outside the volume) halves the step like gsl_odeiv2_evolve_apply,
+*	so paths behave the same at the volume boundaries.
+*/
+struct GPDormandPrince_s{
+	int(*Func)(double, const double[], double[], void*);
+	void * Params;
+	double AbsTol, RelTol;
+
+	double t = 0.0;
+	double K[7][3];
+	double KPos[3];
+	Boolean_t HasK = FALSE;
+
+	/*
+	*	Take one accepted step from y, updating y and the step size h.
+	*	Returns the status of the gradient function if no step could
+	*	be made, leaving y unchanged.
+	*/
+	const int Apply(double * y, double & h){
+		/*
+		*	Reuse the last stage of the previous step unless
+		*	the caller moved the point since.
+		*/
+		if (!HasK || y[0] != KPos[0] || y[1] != KPos[1] || y[2] != KPos[2]){
+			HasK = FALSE;
+			int Status = Func(t, y, K[0], Params);
+			if (Status != GSL_SUCCESS)
+				return Status;
+		}
+
+		double Pos[3];
+		while (true){
+			int Status = GSL_SUCCESS;
+			for (int s = 1; s < 7 && Status == GSL_SUCCESS; ++s){
+				for (int d = 0; d < 3; ++d){
+					double Sum = 0.0;
+					for (int j = 0; j < s; ++j)
+						Sum += GP_DP_A[s][j] * K[j][d];
+					Pos[d] = y[d] + h * Sum;
+				}
+				Status = Func(t + GP_DP_C[s] * h, Pos, K[s], Params);
+			}
+
+			if (Status != GSL_SUCCESS){
+				double hNew = 0.5 * h;
+				if (t + hNew != t){
+					h = hNew;
+					continue;
+				}
+				HasK = FALSE;
+				return Status;
+			}
+
+			double ErrRatio = 0.0;
+			for (int d = 0; d < 3; ++d){
+				double Err = 0.0;
+				for (int j = 0; j < 7; ++j)
+					Err += GP_DP_E[j] * K[j][d];
+				ErrRatio = MAX(ErrRatio, std::abs(h * Err) / (AbsTol + RelTol * std::abs(Pos[d])));
+			}
+
+			if (ErrRatio > 1.1){
+				double hNew = h * MAX(0.2, 0.9 / pow(ErrRatio, 1.0 / 5.0));
+				if (t + hNew != t){
+					h = hNew;
+					continue;
+				}
+			}
+
+			t += h;
+			for (int d = 0; d < 3; ++d){
+				y[d] = KPos[d] = Pos[d];
+				K[0][d] = K[6][d];
+			}
+			HasK = TRUE;
+
+			if (ErrRatio < 0.5)
+				h *= (ErrRatio > 0.0 ? MIN(5.0, MAX(1.0, 0.9 / pow(ErrRatio, 1.0 / 6.0))) : 5.0);
+
+			return GSL_SUCCESS;
+		}
+	}
+};
+
 const Boolean_t GradPath_c::SeedInDirection(const StreamDir_e & Direction){
 	Boolean_t IsOk = m_GradPathReady && !m_GradPathMade;
 
 	StreamDir_e OldDir = m_ODE_Data.Direction;
 	m_ODE_Data.Direction = Direction;
 
-	gsl_odeiv2_system ODESys = { &GP_ODE_GradFunction, NULL, m_ODE_NumDims, &m_ODE_Data };
+	GPODEFunc_t ODEFunc = ODEFunction();
+
+#ifndef CSM_NO_GSL
+	gsl_odeiv2_system ODESys = { ODEFunc, NULL, m_ODE_NumDims, &m_ODE_Data };
+#endif
+
+	GPDormandPrince_s DP;
+	DP.Func = ODEFunc;
+	DP.Params = &m_ODE_Data;
+	DP.AbsTol = m_ODE_Data.AbsTol;
+	DP.RelTol = m_ODE_Data.RelTol;
 
-	const gsl_odeiv2_step_type * T = gsl_odeiv2_step_rk4;
-	gsl_odeiv2_step * s = gsl_odeiv2_step_alloc(T, m_ODE_NumDims);
-	gsl_odeiv2_control * c = gsl_odeiv2_control_y_new(1e-12, 1e-12);
-	gsl_odeiv2_evolve * e = gsl_odeiv2_evolve_alloc(m_ODE_NumDims);
+	/*
+	*	Without GSL, GPIntegrator_GSLRK4 paths use Dormand-Prince too.
+	*/
+#ifndef CSM_NO_GSL
+	gsl_odeiv2_step * s = NULL;
+	gsl_odeiv2_control * c = NULL;
+	gsl_odeiv2_evolve * e = NULL;
+	if (IsOk && m_ODE_Data.Integrator == GPIntegrator_GSLRK4){
+		s = gsl_odeiv2_step_alloc(gsl_odeiv2_step_rk4, m_ODE_NumDims);
+		c = gsl_odeiv2_control_y_new(m_ODE_Data.AbsTol, m_ODE_Data.RelTol);
+		e = gsl_odeiv2_evolve_alloc(m_ODE_NumDims);
+	}
+#endif
 
 	// 	gsl_odeiv2_driver * ODEDriver;
 	// 	ODEDriver = gsl_odeiv2_driver_alloc_yp_new(&ODESys, gsl_odeiv2_step_rk2, 1e-3, 1e-2, 0);
@@ -1137,25 +1404,18 @@ const Boolean_t GradPath_c::SeedInDirection(const StreamDir_e & Direction){
 
 		double y[3] = { m_StartPoint[0], m_StartPoint[1], m_StartPoint[2] };
 
-		vec3 NewPoint, PtIm1 = m_StartPoint, PtI;
-
-		IsOk = SetIndexAndWeightsForPoint(m_StartPoint, m_ODE_Data.VolZoneInfo);
+		vec3 PtIm1 = m_StartPoint, PtI;
 
-		if (IsOk){
-			m_XYZList.push_back(m_StartPoint);
-			m_RhoList.push_back(RhoByCurrentIndexAndWeights());
-		}
+		GPStallDetector_s Stall;
 
-		m_StartEndCPNum[1] = -1;
+		IsOk = BeginSeedInDirection(Stall);
 
 
 		int Status = GSL_SUCCESS;
 		int Step = 1;
 
-		unsigned int NumStalledPoints = 0;
-
-		MultiRootObjects_s MR;
 		MultiRootParams_s Params;
+		VolExtentIndexWeights_s PlaneVolInfo;
 		vec3 StepDir, TmpPt, EigVals, DotPdts;
 		mat33 EigVecs, Hess;
 		vector<vec3> BV(3);
@@ -1173,9 +1433,12 @@ const Boolean_t GradPath_c::SeedInDirection(const StreamDir_e & Direction){
 			Params.HessPtrs = &m_ODE_Data.HessPtrs;
 			for (int i = 0; i < 6 && Params.HasHess; ++i)
 				Params.HasHess = Params.HessPtrs->at(i).IsReady();
-			Params.IsPeriodic = m_ODE_Data.VolZoneInfo.IsPeriodic;
-			Params.VolInfo = &m_ODE_Data.VolZoneInfo;
+			Params.IsPeriodic = m_ODE_Data.VolZoneInfo->IsPeriodic;
+			PlaneVolInfo = *m_ODE_Data.VolZoneInfo;
+			Params.VolInfo = &PlaneVolInfo;
 			Params.RhoPtr = &m_ODE_Data.RhoPtr;
+			Params.NodeCache = m_ODE_Data.NodeCache;
+			Params.UseTricubic = m_ODE_Data.UseTricubic;
 			Params.HasGrad = m_ODE_Data.GradPtrs.size() == 3;
 			Params.GradPtrs = &m_ODE_Data.GradPtrs;
 			for (int i = 0; i < 3 && Params.HasGrad; ++i)
@@ -1183,18 +1446,18 @@ const Boolean_t GradPath_c::SeedInDirection(const StreamDir_e & Direction){
 			Params.BasisVectors = &I;
 			Params.VolInfo->BasisVectors = I;
 			Params.Origin = &BV[0];
-
-			MR.Func = { &F2DGrad, &DF2DGrad, &FDF2DGrad, 2, &Params };
-			MR.pos = gsl_vector_alloc(2);
-			MR.T = gsl_multiroot_fdfsolver_hybridsj;
-			MR.s = gsl_multiroot_fdfsolver_alloc(MR.T, 2);
 		}
 
 		while (IsOk && Status == GSL_SUCCESS && Step < GP_MaxNumPoints){
 
 
 			// 			Status = gsl_odeiv2_driver_apply(ODEDriver, &tInit, tInit + 1e-3, y);
-			Status = gsl_odeiv2_evolve_apply(e, c, s, &ODESys, &tInit, tFinal, &h, y);
+#ifndef CSM_NO_GSL
+			if (e != NULL)
+				Status = gsl_odeiv2_evolve_apply(e, c, s, &ODESys, &tInit, tFinal, &h, y);
+			else
+#endif
+				Status = DP.Apply(y, h);
 
 			if (Status == GSL_SUCCESS || Status == GSL_EDOM){
 				PtI = y;
@@ -1227,7 +1490,7 @@ const Boolean_t GradPath_c::SeedInDirection(const StreamDir_e & Direction){
 
 					if (Step <= 1) StepSize = Distance(PtI, PtIm1);
 					//   					}
-					if (m_GPType != GPType_Classic && m_GPType != GPType_Invalid && CPInNormalPlane(PtI, StepDir, MR)){
+					if (m_GPType != GPType_Classic && m_GPType != GPType_Invalid && CPInNormalPlane(PtI, StepDir, Params)){
 						Params.BasisVectors = &I;
 						PlaneCPIter = 0;
 						SGPFound = FALSE;
@@ -1248,7 +1511,7 @@ const Boolean_t GradPath_c::SeedInDirection(const StreamDir_e & Direction){
 
 							StepDir = normalise((EigVecs.row(MaxDir)));
 
-							SGPFound = CPInNormalPlane(PtI, StepDir, MR);
+							SGPFound = CPInNormalPlane(PtI, StepDir, Params);
 							Params.BasisVectors = &I;
 							PlaneCPDist = Distance(PtI, TmpPt);
 						} while (SGPFound && PlaneCPDist >= 1e-4 && PlaneCPIter < 50);
@@ -1274,142 +1537,13 @@ const Boolean_t GradPath_c::SeedInDirection(const StreamDir_e & Direction){
 					}
 				}
 
-				double Rho = RhoByCurrentIndexAndWeights();
-
-				if (m_HowTerminate == GPTerminate_AtRhoValue && Rho < m_TermValue){
-					double OldRho;
-					OldRho = m_RhoList[m_RhoList.size() - 1];
-
-					NewPoint = PtIm1 + (PtI - PtIm1) * ((m_TermValue - OldRho) / (Rho - OldRho));
-
-					m_XYZList.push_back(NewPoint);
-					m_RhoList.push_back(m_TermValue);
-
-					break;
-				}
-				else if (m_HowTerminate == GPTerminate_AtPoint || m_HowTerminate == GPTerminate_AtPointRadius){
-					double PointRadiusSqr = DistSqr(PtI, (m_TermPoint));
-					if (PointRadiusSqr <= m_TermPointRadiusSqr){
-						if (m_HowTerminate == GPTerminate_AtPointRadius){
-							double OldRadius = Distance(PtIm1, m_TermPoint);
-
-							NewPoint = PtIm1 + (PtI - PtIm1) * ((sqrt(m_TermPointRadiusSqr) - OldRadius) / (sqrt(PointRadiusSqr) - OldRadius));
-						}
-						else
-							NewPoint = m_TermPoint;
-
-						IsOk = SetIndexAndWeightsForPoint(NewPoint, m_ODE_Data.VolZoneInfo);
-						if (IsOk){
-							Rho = RhoByCurrentIndexAndWeights();
-
-							m_XYZList.push_back(NewPoint);
-							m_RhoList.push_back(Rho);
-						}
-
-						break;
-					}
-				}
-				else if (m_HowTerminate == GPTerminate_AtCP || m_HowTerminate == GPTerminate_AtCPRadius){
-					Boolean_t PointFound = FALSE;
-					if (m_CPs == NULL){
-						for (int CPNum = 0; CPNum < m_NumCPs && !PointFound; ++CPNum){
-							if (CPNum != m_StartEndCPNum[0]){
-								for (int i = 0; i < 3; ++i){
-									NewPoint[i] = m_CPXYZPtrs[i][CPNum];
-								}
-								double PointRadiusSqr = DistSqr(PtI, NewPoint);
-								if (PointRadiusSqr <= m_TermPointRadiusSqr){
-									if (m_HowTerminate == GPTerminate_AtCPRadius){
-										double OldRadius = Distance(PtIm1, NewPoint);
-
-										NewPoint = PtIm1 + (PtI - PtIm1) * ((sqrt(m_TermPointRadiusSqr) - OldRadius) / (sqrt(PointRadiusSqr) - OldRadius));
-									}
-
-									IsOk = SetIndexAndWeightsForPoint(NewPoint, m_ODE_Data.VolZoneInfo);
-									if (IsOk){
-										Rho = RhoByCurrentIndexAndWeights();
-
-										m_XYZList.push_back(NewPoint);
-										m_RhoList.push_back(Rho);
-
-										m_StartEndCPNum[1] = CPNum;
-									}
-
-									PointFound = TRUE;
-								}
-							}
-						}
-					}
-					else{
-						for (const auto & SaddleTypeNum : CPSaddleTypeNums){
-							for (int SaddleCPNum = 0; SaddleCPNum < m_CPs->NumCPs(SaddleTypeNum) && !PointFound; ++SaddleCPNum){
-								int TotCPNum = m_CPs->GetTotOffsetFromTypeNumOffset(SaddleTypeNum, SaddleCPNum);
-								if (TotCPNum != m_StartEndCPNum[0]){
-									NewPoint = m_CPs->GetXYZ(SaddleTypeNum, SaddleCPNum);
-									double PointRadiusSqr = DistSqr(PtI, NewPoint);
-									if (PointRadiusSqr <= m_TermPointRadiusSqr){
-										if (m_HowTerminate == GPTerminate_AtCPRadius){
-											double OldRadius = Distance(PtIm1, NewPoint);
-
-											NewPoint = PtIm1 + (PtI - PtIm1) * ((sqrt(m_TermPointRadiusSqr) - OldRadius) / (sqrt(PointRadiusSqr) - OldRadius));
-										}
-
-										IsOk = SetIndexAndWeightsForPoint(NewPoint, m_ODE_Data.VolZoneInfo);
-										if (IsOk){
-											Rho = RhoByCurrentIndexAndWeights();
-
-											m_XYZList.push_back(NewPoint);
-											m_RhoList.push_back(Rho);
-
-											m_StartEndCPNum[1] = TotCPNum;
-										}
-
-										PointFound = TRUE;
-									}
-								}
-							}
-						}
-					}
-					if (PointFound)
-						break;
-				}
-				if (m_TermValue != -1.0 && Rho < m_TermValue){
-					double OldRho;
-					OldRho = m_RhoList.back();
-
-					NewPoint = PtIm1 + (PtI - PtIm1) * ((m_TermValue - OldRho) / (Rho - OldRho));
-
-					m_XYZList.push_back(NewPoint);
-					m_RhoList.push_back(m_TermValue);
-
+				if (AddStepPoint(PtI, PtIm1, h, Status, Stall, IsOk))
 					break;
-				}
-
-				if (IsOk){
-					if (m_XYZList.size() >= GP_StallNumPointsToCheck - 1){
-						double NewPtDistSqr = Distance(PtI, m_XYZList[m_XYZList.size() - GP_StallNumPointsToCheck - NumStalledPoints + 1]);
-						if (NewPtDistSqr < MIN(GP_StallPointDistTol, h) * GP_StallNumPointsToCheck){
-							NumStalledPoints++;
-							if (NumStalledPoints >= GP_StallPointCount && Status == GSL_SUCCESS){
-								Status = GSL_ENOPROG;
-							}
-						}
-						else
-							NumStalledPoints = 0;
-					}
-
-					m_XYZList.push_back(PtI);
-					m_RhoList.push_back(Rho);
-
-					PtIm1 = PtI;
-				}
 			}
 
 			Step++;
 		}
 
-		IsOk = (IsOk && Status == GSL_SUCCESS || Status == GSL_EDOM || Status == GSL_ENOPROG);
-
 		// 		if (Status == GSL_ENOPROG && m_XYZList.size() > GP_StallPointCount){
 		// 			/*
 		// 			*	Grad path stalled, so it was basically bouncing around the same point.
@@ -1436,42 +1570,15 @@ const Boolean_t GradPath_c::SeedInDirection(const StreamDir_e & Direction){
 
 		// 		gsl_odeiv2_driver_free(ODEDriver);
 
-		gsl_odeiv2_evolve_free(e);
-		gsl_odeiv2_control_free(c);
-		gsl_odeiv2_step_free(s);
-
-		if (m_GPType && MR.s != NULL)
-			gsl_multiroot_fdfsolver_free(MR.s);
-		// 	if (m_GPType && MR.pos != NULL)
-		// 		gsl_vector_free(MR.pos);
-
-		if (m_StartEndCPNum[1] < 0 && (m_HowTerminate == GPTerminate_AtCP || m_HowTerminate == GPTerminate_AtCPRadius)){
-			/*
-			*	Check to see if terminating point coincides with a CP
-			*/
-			Boolean_t PointFound = FALSE;
-			for (int CPNum = 0; CPNum < m_NumCPs && !PointFound; ++CPNum){
-				if (CPNum != m_StartEndCPNum[0]){
-					if (m_CPs == NULL){
-						for (int i = 0; i < 3; ++i){
-							NewPoint[i] = m_CPXYZPtrs[i][CPNum];
-						}
-					}
-					else{
-						NewPoint = m_CPs->GetXYZ(CPNum);
-					}
-					double PointRadiusSqr = DistSqr(PtI, NewPoint);
-					if (PointRadiusSqr <= m_TermPointRadiusSqr){
-						m_StartEndCPNum[1] = CPNum;
-						PointFound = TRUE;
-					}
-				}
-			}
+#ifndef CSM_NO_GSL
+		if (e != NULL){
+			gsl_odeiv2_evolve_free(e);
+			gsl_odeiv2_control_free(c);
+			gsl_odeiv2_step_free(s);
 		}
+#endif
 
-		m_GradPathMade = IsOk;
-		if (IsOk && m_GPType)
-			m_SGPMade = TRUE;
+		IsOk = EndSeedInDirection(PtI, Status, IsOk);
 	}
 
 	m_ODE_Data.Direction = OldDir;
@@ -1479,36 +1586,1742 @@ const Boolean_t GradPath_c::SeedInDirection(const StreamDir_e & Direction){
 	return IsOk;
 }
 
-const Boolean_t GradPath_c::Seed(const bool DoResample){
-	Boolean_t IsOk = m_GradPathReady && !m_GradPathMade;
-
-
-	if (m_ODE_Data.Direction != StreamDir_Both){
-		IsOk = SeedInDirection(m_ODE_Data.Direction);
-	}
-	else{
-		int StartCCPNum = m_StartEndCPNum[0];
-		vector<GradPath_c> GPs(2, *this);
-		vector<int> EndCPNums;
-		m_GradPathMade = TRUE;
-		for (int i = 0; i < 2 && IsOk; ++i){
-			GPs[i].SetStartEndCPNum(-1, 0);
-			IsOk = GPs[i].SeedInDirection((StreamDir_e)i);
-			for (int j = 0; j < 2; ++j)
-			if (GPs[i].m_StartEndCPNum[j] >= 0 && VectorGetElementNum(EndCPNums, GPs[i].m_StartEndCPNum[j]) < 0)
-				EndCPNums.push_back(GPs[i].m_StartEndCPNum[j]);
-			*this += GPs[i];
+GPODEFunc_t GradPath_c::ODEFunction() const{
+	if (m_ODE_Data.HasGrad && (m_ODE_Data.NodeCache == NULL || !m_ODE_Data.NodeCache->HasGrad())){
+		switch (CommonFDType(m_ODE_Data.GradPtrs)){
+			case FieldDataType_Double:
+				return &GP_ODE_GradFunctionTyped<double_t>;
+			case FieldDataType_Float:
+				return &GP_ODE_GradFunctionTyped<float_t>;
+			default:
+				break;
 		}
-		std::sort(EndCPNums.begin(), EndCPNums.end());
-		for (int i = 0; i < 2 - EndCPNums.size(); ++i) EndCPNums.push_back(-1);
-		m_StartEndCPNum[0] = EndCPNums.size() > 1 ? EndCPNums[1] : -1;
-		m_StartEndCPNum[1] = EndCPNums[0];
 	}
 
-	if (IsOk && DoResample){
-		Resample(m_NumGPPoints);
+	return &GP_ODE_GradFunction;
+}
+
+static long long GPEndCounts[GPEnd_NumReasons] = { 0 };
+
+void GetGradPathEndCounts(vector<long long> & Counts){
+	Counts.assign(GPEndCounts, GPEndCounts + GPEnd_NumReasons);
+}
+
+void ResetGradPathEndCounts(){
+	for (int i = 0; i < GPEnd_NumReasons; ++i)
+		GPEndCounts[i] = 0;
+}
+
+void GPStallDetector_s::Reset(){
+	Last = -1;
+	Num = 0;
+	PathLen = TurnSum = 0.0;
+	HasDir = FALSE;
+	NumStalledPoints = 0;
+}
+
+/*
+*	StepLen[i] and Turn[i] are the length of the step to Pts[i] and the
+*	angle turned from the previous step. The sums cover every step in
+*	the window except the one to its oldest point.
+*/
+const GPEndReason_e GPStallDetector_s::AddPoint(const vec3 & Pt, const double & StepSize){
+	double NewLen = 0.0, NewTurn = 0.0;
+	if (Num > 0){
+		vec3 Step = Pt - Pts[Last];
+		NewLen = norm(Step);
+		if (NewLen > 0.0){
+			vec3 Dir = Step / NewLen;
+			if (HasDir)
+				NewTurn = acos(MIN(MAX(dot(Dir, LastDir), -1.0), 1.0));
+			LastDir = Dir;
+			HasDir = TRUE;
+		}
+	}
+
+	int Next = (Last + 1) % GP_StallWindow;
+	if (Num == GP_StallWindow){
+		int Oldest = (Next + 1) % GP_StallWindow;
+		PathLen -= StepLen[Oldest];
+		TurnSum -= Turn[Oldest];
+		StepLen[Oldest] = Turn[Oldest] = 0.0;
+	}
+	else
+		Num++;
+
+	Pts[Next] = Pt;
+	StepLen[Next] = NewLen;
+	Turn[Next] = NewTurn;
+	PathLen += NewLen;
+	TurnSum += NewTurn;
+	Last = Next;
+
+	if (Num > GP_StallNumPointsToCheck){
+		const vec3 & CheckPt = Pts[(Last - GP_StallNumPointsToCheck + GP_StallWindow) % GP_StallWindow];
+		if (Distance(Pt, CheckPt) < MIN(GP_StallPointDistTol, StepSize) * GP_StallNumPointsToCheck){
+			NumStalledPoints++;
+			if (NumStalledPoints >= GP_StallPointCount)
+				return GPEnd_Stalled;
+		}
+		else
+			NumStalledPoints = 0;
+	}
+
+	if (Num == GP_StallWindow && TurnSum > GP_LoopTurnAngle
+		&& Distance(Pt, Pts[(Last + 1) % GP_StallWindow]) < GP_LoopDispRatio * PathLen)
+		return GPEnd_Looping;
+
+	return GPEnd_Invalid;
+}
+
+/*
+*	Add the start point.
+*/
+const Boolean_t GradPath_c::BeginSeedInDirection(GPStallDetector_s & Stall){
+	Boolean_t IsOk = GetIndexAndWeightsForPoint(m_StartPoint, *m_ODE_Data.VolZoneInfo, m_ODE_Data.Stencil);
+
+	if (IsOk){
+		m_XYZList.push_back(m_StartPoint);
+		m_RhoList.push_back(RhoByCurrentIndexAndWeights());
+	}
+
+	m_StartEndCPNum[1] = -1;
+	m_EndReason = GPEnd_Invalid;
+
+	Stall.Reset();
+	Stall.AddPoint(m_StartPoint, 0.0);
+
+	return IsOk;
+}
+
+/*
+*	Add the point PtI just stepped to, or the terminal point if
+*	the step from PtIm1 crossed a termination condition.
+*	Relies on the stencil being at PtI, as left by the last
+*	gradient evaluation of the step.
+*	Returns TRUE if the path has terminated.
+*/
+const Boolean_t GradPath_c::AddStepPoint(const vec3 & PtI,
+	vec3 & PtIm1,
+	const double & StepSize,
+	int & Status,
+	GPStallDetector_s & Stall,
+	Boolean_t & IsOk)
+{
+	vec3 NewPoint;
+	double Rho = RhoByCurrentIndexAndWeights();
+
+	if (m_HowTerminate == GPTerminate_AtRhoValue && Rho < m_TermValue){
+		double OldRho;
+		OldRho = m_RhoList[m_RhoList.size() - 1];
+
+		NewPoint = PtIm1 + (PtI - PtIm1) * ((m_TermValue - OldRho) / (Rho - OldRho));
+
+		m_XYZList.push_back(NewPoint);
+		m_RhoList.push_back(m_TermValue);
+		m_EndReason = GPEnd_Terminated;
+
+		return TRUE;
+	}
+	else if (m_HowTerminate == GPTerminate_AtPoint || m_HowTerminate == GPTerminate_AtPointRadius){
+		double PointRadiusSqr = DistSqr(PtI, (m_TermPoint));
+		if (PointRadiusSqr <= m_TermPointRadiusSqr){
+			if (m_HowTerminate == GPTerminate_AtPointRadius){
+				double OldRadius = Distance(PtIm1, m_TermPoint);
+
+				NewPoint = PtIm1 + (PtI - PtIm1) * ((sqrt(m_TermPointRadiusSqr) - OldRadius) / (sqrt(PointRadiusSqr) - OldRadius));
+			}
+			else
+				NewPoint = m_TermPoint;
+
+			IsOk = GetIndexAndWeightsForPoint(NewPoint, *m_ODE_Data.VolZoneInfo, m_ODE_Data.Stencil);
+			if (IsOk){
+				Rho = RhoByCurrentIndexAndWeights();
+
+				m_XYZList.push_back(NewPoint);
+				m_RhoList.push_back(Rho);
+			}
+			m_EndReason = GPEnd_Terminated;
+
+			return TRUE;
+		}
+	}
+	else if (m_HowTerminate == GPTerminate_AtCP || m_HowTerminate == GPTerminate_AtCPRadius){
+		Boolean_t PointFound = FALSE;
+		if (m_CPs == NULL){
+			for (int CPNum = 0; CPNum < m_NumCPs && !PointFound; ++CPNum){
+				if (CPNum != m_StartEndCPNum[0]){
+					for (int i = 0; i < 3; ++i){
+						NewPoint[i] = m_CPXYZPtrs[i][CPNum];
+					}
+					double PointRadiusSqr = DistSqr(PtI, NewPoint);
+					if (PointRadiusSqr <= m_TermPointRadiusSqr){
+						if (m_HowTerminate == GPTerminate_AtCPRadius){
+							double OldRadius = Distance(PtIm1, NewPoint);
+
+							NewPoint = PtIm1 + (PtI - PtIm1) * ((sqrt(m_TermPointRadiusSqr) - OldRadius) / (sqrt(PointRadiusSqr) - OldRadius));
+						}
+
+						IsOk = GetIndexAndWeightsForPoint(NewPoint, *m_ODE_Data.VolZoneInfo, m_ODE_Data.Stencil);
+						if (IsOk){
+							Rho = RhoByCurrentIndexAndWeights();
+
+							m_XYZList.push_back(NewPoint);
+							m_RhoList.push_back(Rho);
+
+							m_StartEndCPNum[1] = CPNum;
+						}
+
+						PointFound = TRUE;
+					}
+				}
+			}
+		}
+		else{
+			/*
+			*	Saddle CPs near the point come from the CPs' spatial index
+			*	rather than checking them all every step.
+			*/
+			int TotCPNum = m_CPs->GetFirstCPInRadius(PtI, sqrt(m_TermPointRadiusSqr), NewPoint, CPSaddleTypeNums, m_StartEndCPNum[0]);
+			if (TotCPNum >= 0){
+				double PointRadiusSqr = DistSqr(PtI, NewPoint);
+				if (m_HowTerminate == GPTerminate_AtCPRadius){
+					double OldRadius = Distance(PtIm1, NewPoint);
+
+					NewPoint = PtIm1 + (PtI - PtIm1) * ((sqrt(m_TermPointRadiusSqr) - OldRadius) / (sqrt(PointRadiusSqr) - OldRadius));
+				}
+
+				IsOk = GetIndexAndWeightsForPoint(NewPoint, *m_ODE_Data.VolZoneInfo, m_ODE_Data.Stencil);
+				if (IsOk){
+					Rho = RhoByCurrentIndexAndWeights();
+
+					m_XYZList.push_back(NewPoint);
+					m_RhoList.push_back(Rho);
+
+					m_StartEndCPNum[1] = TotCPNum;
+				}
+
+				PointFound = TRUE;
+			}
+		}
+		if (PointFound){
+			m_EndReason = GPEnd_Terminated;
+			return TRUE;
+		}
+	}
+	if (m_TermValue != -1.0 && Rho < m_TermValue){
+		double OldRho;
+		OldRho = m_RhoList.back();
+
+		NewPoint = PtIm1 + (PtI - PtIm1) * ((m_TermValue - OldRho) / (Rho - OldRho));
+
+		m_XYZList.push_back(NewPoint);
+		m_RhoList.push_back(m_TermValue);
+		m_EndReason = GPEnd_Terminated;
+
+		return TRUE;
+	}
+
+	if (IsOk){
+		GPEndReason_e StallReason = Stall.AddPoint(PtI, StepSize);
+		if (StallReason != GPEnd_Invalid && Status == GSL_SUCCESS){
+			m_EndReason = StallReason;
+			Status = GSL_ENOPROG;
+		}
+
+		m_XYZList.push_back(PtI);
+		m_RhoList.push_back(Rho);
+
+		PtIm1 = PtI;
+	}
+
+	return FALSE;
+}
+
+/*
+*	Sort out the end CP and whether the path was made,
+*	given the status of the last step.
+*/
+const Boolean_t GradPath_c::EndSeedInDirection(const vec3 & PtI, const int & Status, const Boolean_t & PathIsOk){
+	Boolean_t IsOk = (PathIsOk && Status == GSL_SUCCESS || Status == GSL_EDOM || Status == GSL_ENOPROG);
+	vec3 NewPoint;
+
+	if (m_StartEndCPNum[1] < 0 && (m_HowTerminate == GPTerminate_AtCP || m_HowTerminate == GPTerminate_AtCPRadius)){
+		/*
+		*	Check to see if terminating point coincides with a CP
+		*/
+		if (m_CPs != NULL){
+			int CPNum = m_CPs->GetFirstCPInRadius(PtI, sqrt(m_TermPointRadiusSqr), NewPoint, vector<int>(), m_StartEndCPNum[0]);
+			if (CPNum >= 0)
+				m_StartEndCPNum[1] = CPNum;
+		}
+		else{
+			Boolean_t PointFound = FALSE;
+			for (int CPNum = 0; CPNum < m_NumCPs && !PointFound; ++CPNum){
+				if (CPNum != m_StartEndCPNum[0]){
+					for (int i = 0; i < 3; ++i){
+						NewPoint[i] = m_CPXYZPtrs[i][CPNum];
+					}
+					double PointRadiusSqr = DistSqr(PtI, NewPoint);
+					if (PointRadiusSqr <= m_TermPointRadiusSqr){
+						m_StartEndCPNum[1] = CPNum;
+						PointFound = TRUE;
+					}
+				}
+			}
+		}
+	}
+
+	if (m_EndReason == GPEnd_Invalid){
+		if (Status == GSL_EDOM)
+			m_EndReason = GPEnd_Boundary;
+		else if (IsOk && Status == GSL_SUCCESS)
+			m_EndReason = GPEnd_MaxNumPoints;
+		else
+			m_EndReason = GPEnd_Failed;
+	}
+#pragma omp atomic
+	GPEndCounts[m_EndReason]++;
+
+	m_GradPathMade = IsOk;
+	if (IsOk && m_GPType)
+		m_SGPMade = TRUE;
+
+	return IsOk;
+}
+
+const Boolean_t GradPath_c::Seed(const bool DoResample){
+	Boolean_t IsOk = m_GradPathReady && !m_GradPathMade;
+
+
+	if (m_ODE_Data.Direction != StreamDir_Both){
+		IsOk = SeedInDirection(m_ODE_Data.Direction);
+	}
+	else{
+		int StartCCPNum = m_StartEndCPNum[0];
+		vector<GradPath_c> GPs(2, *this);
+		vector<int> EndCPNums;
+		m_GradPathMade = TRUE;
+		for (int i = 0; i < 2 && IsOk; ++i){
+			GPs[i].SetStartEndCPNum(-1, 0);
+			IsOk = GPs[i].SeedInDirection((StreamDir_e)i);
+			for (int j = 0; j < 2; ++j)
+			if (GPs[i].m_StartEndCPNum[j] >= 0 && VectorGetElementNum(EndCPNums, GPs[i].m_StartEndCPNum[j]) < 0)
+				EndCPNums.push_back(GPs[i].m_StartEndCPNum[j]);
+			*this += GPs[i];
+		}
+		m_EndReason = GPEnd_Terminated;
+		for (int i = 0; i < 2; ++i)
+			if (GPs[i].m_EndReason != GPEnd_Terminated)
+				m_EndReason = GPs[i].m_EndReason;
+		std::sort(EndCPNums.begin(), EndCPNums.end());
+		for (int i = 0; i < 2 - EndCPNums.size(); ++i) EndCPNums.push_back(-1);
+		m_StartEndCPNum[0] = EndCPNums.size() > 1 ? EndCPNums[1] : -1;
+		m_StartEndCPNum[1] = EndCPNums[0];
+	}
+
+	if (IsOk && DoResample){
+		Resample(m_NumGPPoints);
+	}
+
+	return IsOk;
+}
+
+
+/*
+*	GradPathBatch_c methods
+*/
+
+GradPathBatch_c::GradPathBatch_c(const int & Width)
+{
+	REQUIRE(Width > 0);
+
+	m_Width = Width;
+
+	m_Y.resize(3 * Width);
+	m_Pos.resize(3 * Width);
+	m_K.resize(7 * 3 * Width);
+	m_H.resize(Width);
+	m_T.resize(Width);
+	m_ErrRatio.resize(Width);
+	m_AbsTol.resize(Width);
+	m_RelTol.resize(Width);
+	m_Status.resize(Width);
+	m_Step.resize(Width);
+	m_Stall.resize(Width);
+	m_HasK.resize(Width);
+	m_Eval.resize(Width);
+	m_DirSign.resize(Width);
+	m_PtIm1.resize(Width);
+	m_Func.resize(Width);
+	m_GP.resize(Width);
+
+	m_IJK.resize(3 * Width);
+	m_OutOfBounds.resize(Width);
+	m_IsBad.resize(Width);
+	m_Index.resize(8 * Width);
+	m_OneMinusRST.resize(3 * Width);
+	m_OnePlusRST.resize(3 * Width);
+	m_Weights.resize(8 * Width);
+	m_Grad.resize(3 * Width);
+}
+
+const Boolean_t GradPathBatch_c::Seed(const vector<GradPath_c*> & GPs, const bool DoResample){
+	Boolean_t IsOk = TRUE;
+
+	int NextGPNum = 0;
+	m_NumActive = 0;
+
+	while (NextGPNum < GPs.size() || m_NumActive > 0){
+		while (m_NumActive < m_Width && NextGPNum < GPs.size()){
+			GradPath_c * GP = GPs[NextGPNum++];
+			if (GP == NULL)
+				continue;
+			if (!CanBatch(*GP))
+				IsOk = (GP->Seed(DoResample) && IsOk);
+			else if (LoadLane(m_NumActive, GP))
+				m_NumActive++;
+			else
+				IsOk = FALSE;
+		}
+
+		if (m_NumActive > 0)
+			IsOk = (Advance(DoResample) && IsOk);
+	}
+
+	return IsOk;
+}
+
+const Boolean_t GradPathBatch_c::CanBatch(const GradPath_c & GP) const{
+	return ((GP.m_GPType == GPType_Classic || GP.m_GPType == GPType_Invalid)
+		&& (GP.m_ODE_Data.Direction == StreamDir_Forward || GP.m_ODE_Data.Direction == StreamDir_Reverse)
+		&& GP.m_ODE_Data.Integrator == GPIntegrator_DormandPrince);
+}
+
+/*
+*	Start a path in a lane; same setup as SeedInDirection().
+*/
+const Boolean_t GradPathBatch_c::LoadLane(const int & Lane, GradPath_c * GP){
+	if (!GP->m_GradPathReady || GP->m_GradPathMade)
+		return FALSE;
+
+	if (!GP->BeginSeedInDirection(m_Stall[Lane])){
+		GP->EndSeedInDirection(GP->m_StartPoint, GSL_SUCCESS, FALSE);
+		return FALSE;
+	}
+
+	for (int d = 0; d < 3; ++d)
+		m_Y[d * m_Width + Lane] = GP->m_StartPoint[d];
+	m_H[Lane] = 1.0;
+	m_T[Lane] = 0.0;
+	m_AbsTol[Lane] = GP->m_ODE_Data.AbsTol;
+	m_RelTol[Lane] = GP->m_ODE_Data.RelTol;
+	m_Step[Lane] = 1;
+	m_HasK[Lane] = FALSE;
+	m_DirSign[Lane] = (GP->m_ODE_Data.Direction == StreamDir_Reverse ? -1.0 : 1.0);
+	m_PtIm1[Lane] = GP->m_StartPoint;
+	m_Func[Lane] = GP->ODEFunction();
+	m_GP[Lane] = GP;
+
+	return TRUE;
+}
+
+/*
+*	Gradient for one lane at Pos (structure of arrays), into stage Stage.
+*	This also leaves the path's stencil at Pos.
+*/
+const int GradPathBatch_c::EvalLane(const int & Lane, const double * Pos, const int & Stage){
+	double LanePos[3], LaneGrad[3];
+	for (int d = 0; d < 3; ++d)
+		LanePos[d] = Pos[d * m_Width + Lane];
+
+	int Status = m_Func[Lane](m_T[Lane] + GP_DP_C[Stage] * m_H[Lane], LanePos, LaneGrad, &m_GP[Lane]->m_ODE_Data);
+
+	for (int d = 0; d < 3; ++d)
+		m_K[(Stage * 3 + d) * m_Width + Lane] = LaneGrad[d];
+
+	return Status;
+}
+
+/*
+*	Lane-wise ValsByCurrentIndexAndWeights() over raw pointers,
+*	laid out as in NodeRecordCache_c::LaneValsByIndexAndWeights().
+*/
+template <typename T>
+static void LaneValsByIndexAndWeights(const T * const * Ptrs, const int & NumVars, const int * Index, const double * Weights, const int & Stride, const int & NumLanes, double * Vals)
+{
+	for (int v = 0; v < NumVars; ++v){
+		for (int l = 0; l < NumLanes; ++l) Vals[v * Stride + l] = 0.0;
+	}
+	for (int i = 0; i < 8; ++i){
+		const int * IndexI = Index + i * Stride;
+		const double * WeightsI = Weights + i * Stride;
+		for (int v = 0; v < NumVars; ++v){
+			const T * Ptr = Ptrs[v];
+			double * ValsV = Vals + v * Stride;
+			for (int l = 0; l < NumLanes; ++l) ValsV[l] += WeightsI[l] * static_cast<double>(Ptr[IndexI[l]]);
+		}
+	}
+}
+
+/*
+*	EvalStage() does every lane at once, so the lanes have to share an
+*	orthogonal or cubic grid and read the gradient from the same place:
+*	the same node cache, or the same raw pointers of one type.
+*	Anything else (tricubic or finite difference gradients, mixed
+*	types) goes through the paths' own ODE functions.
+*/
+const Boolean_t GradPathBatch_c::LanesShareGrid(const int & NumLanes) const{
+	if (NumLanes <= 0)
+		return FALSE;
+
+	const GradPathParams_s & Data0 = m_GP[0]->m_ODE_Data;
+	if (Data0.VolZoneInfo->GridType != VolGridType_Orthogonal && Data0.VolZoneInfo->GridType != VolGridType_Cubic)
+		return FALSE;
+
+	const GPODEFunc_t Func = m_Func[0];
+	Boolean_t UseCache = (Func == &GP_ODE_GradFunction);
+	if (UseCache){
+		if (Data0.NodeCache == NULL || !Data0.NodeCache->HasGrad())
+			return FALSE;
+	}
+	else if (Func != &GP_ODE_GradFunctionTyped<double_t> && Func != &GP_ODE_GradFunctionTyped<float_t>)
+		return FALSE;
+
+	for (int l = 1; l < NumLanes; ++l){
+		const GradPathParams_s & Data = m_GP[l]->m_ODE_Data;
+		if (m_Func[l] != Func || Data.VolZoneInfo != Data0.VolZoneInfo)
+			return FALSE;
+		if (UseCache){
+			if (Data.NodeCache != Data0.NodeCache)
+				return FALSE;
+		}
+		else{
+			for (int d = 0; d < 3; ++d){
+				if (Data.GradPtrs[d].VoidPtr() != Data0.GradPtrs[d].VoidPtr())
+					return FALSE;
+			}
+		}
+	}
+
+	return TRUE;
+}
+
+/*
+*	Gradient for every lane with m_Eval set, at Pos, into stage Stage.
+*	Same arithmetic as GP_ODE_GradFunction() (and the typed version)
+*	and GetIndexAndWeightsForPointOnGrid(), but each step runs over all
+*	the lanes: locating the cells and the weights, the trilinear gather
+*	of the corner gradients, and the normalization. The paths' stencils
+*	are left at Pos as with EvalLane().
+*	Only call it if LanesShareGrid().
+*/
+void GradPathBatch_c::EvalStage(const int & NumActiveLanes, const double * Pos, const int & Stage){
+	/*
+	*	Local copies, so the compiler knows the stores to the int
+	*	scratch arrays below can't change the loop bounds.
+	*/
+	const int NumLanes = NumActiveLanes;
+	const int W = m_Width;
+	const GradPathParams_s & Data0 = m_GP[0]->m_ODE_Data;
+	const VolExtentInfo_s & Grid = *Data0.VolZoneInfo;
+	const Boolean_t * Eval = m_Eval.data();
+	int * Status = m_Status.data();
+
+	/*
+	*	Cell and natural coordinates of each lane. Lanes that aren't
+	*	evaluated are put at the first node so their gather stays in
+	*	bounds; their results are dropped.
+	*	The loop uses selects rather than branches, and OutOfBounds and
+	*	IsBad collect the GSL_EDOM and GSL_ESANITY cases over the axes.
+	*/
+	int * OutOfBounds = m_OutOfBounds.data(),
+		* IsBad = m_IsBad.data();
+	for (int l = 0; l < NumLanes; ++l)
+		OutOfBounds[l] = IsBad[l] = 0;
+	for (int d = 0; d < 3; ++d){
+		const double * PosD = Pos + d * W;
+		const double Min = Grid.MinXYZ[d],
+			Max = Grid.MaxXYZ[d],
+			Scale = (Grid.GridType == VolGridType_Cubic ? Grid.IJKPerXYZ[0] : Grid.IJKPerXYZ[d]),
+			Extent = static_cast<double>(Grid.MaxIJK[d] - 1);
+		const int MaxI = Grid.MaxIJK[d] - 1;
+		int * IJKD = m_IJK.data() + d * W;
+		double * OneMinusRSTD = m_OneMinusRST.data() + d * W;
+		double * OnePlusRSTD = m_OnePlusRST.data() + d * W;
+		const Boolean_t IsPeriodic = Grid.IsPeriodic;
+		for (int l = 0; l < NumLanes; ++l){
+			double Pt = PosD[l];
+			Pt = (Eval[l] ? Pt : Min);
+			int Below = (Pt < Min),
+				Above = (Pt > Max);
+			Pt = (Below ? Min : (Above ? Max : Pt));
+			OutOfBounds[l] |= (Below | Above);
+
+			double Coord = (Pt - Min) * Scale;
+			Below = (Coord < 0.);
+			Above = (Coord > Extent);
+			double Wrapped = (Below ? Coord + Extent : (Above ? Coord - Extent : Coord)),
+				Clamped = (Below ? 0. : (Above ? Extent : Coord));
+			Coord = (IsPeriodic ? Wrapped : Clamped);
+
+			double TempCoord = 1.0 + Coord;
+			int I = MAX(MIN(static_cast<LgIndex_t>(TempCoord), MaxI), 1);
+			double RST = 2.0 * (TempCoord - static_cast<double>(I)) - 1.0;
+			IsBad[l] |= (RST < -1.0001) | (RST > 1.0001);
+			IJKD[l] = I;
+			OneMinusRSTD[l] = 1.0 - RST;
+			OnePlusRSTD[l] = 1.0 + RST;
+		}
+	}
+	for (int l = 0; l < NumLanes; ++l){
+		if (Eval[l])
+			Status[l] = (IsBad[l] ? GSL_ESANITY : (OutOfBounds[l] ? GSL_EDOM : GSL_SUCCESS));
+	}
+
+	/*
+	*	Corner node indices and trilinear weights, in the corner order
+	*	of GetIndexAndWeightsForPointOnGrid().
+	*/
+	const int DelJ = Grid.MaxIJK[0],
+		DelK = Grid.MaxIJK[0] * Grid.MaxIJK[1];
+	{
+		const int * I = m_IJK.data(), *J = I + W, *K = J + W;
+		const double * M0 = m_OneMinusRST.data(), *M1 = M0 + W, *M2 = M1 + W;
+		const double * P0 = m_OnePlusRST.data(), *P1 = P0 + W, *P2 = P1 + W;
+		int * Index = m_Index.data();
+		double * Weights = m_Weights.data();
+		for (int l = 0; l < NumLanes; ++l){
+			int Ind = (I[l] - 1) + (J[l] - 1) * DelJ + (K[l] - 1) * DelK;
+			Index[l] = Ind;
+			Index[W + l] = Ind + 1;
+			Index[2 * W + l] = Ind + 1 + DelJ;
+			Index[3 * W + l] = Ind + DelJ;
+			Index[4 * W + l] = Ind + DelK;
+			Index[5 * W + l] = Ind + 1 + DelK;
+			Index[6 * W + l] = Ind + 1 + DelJ + DelK;
+			Index[7 * W + l] = Ind + DelJ + DelK;
+
+			Weights[l] = 0.125 * M0[l] * M1[l] * M2[l];
+			Weights[W + l] = 0.125 * P0[l] * M1[l] * M2[l];
+			Weights[2 * W + l] = 0.125 * P0[l] * P1[l] * M2[l];
+			Weights[3 * W + l] = 0.125 * M0[l] * P1[l] * M2[l];
+			Weights[4 * W + l] = 0.125 * M0[l] * M1[l] * P2[l];
+			Weights[5 * W + l] = 0.125 * P0[l] * M1[l] * P2[l];
+			Weights[6 * W + l] = 0.125 * P0[l] * P1[l] * P2[l];
+			Weights[7 * W + l] = 0.125 * M0[l] * P1[l] * P2[l];
+		}
+	}
+
+	if (m_Func[0] == &GP_ODE_GradFunction){
+		Data0.NodeCache->LaneValsByIndexAndWeights(m_Index.data(), m_Weights.data(), W, NumLanes, Data0.NodeCache->GradOffset(), 3, m_Grad.data());
+	}
+	else if (m_Func[0] == &GP_ODE_GradFunctionTyped<double_t>){
+		const double_t * GradPtrs[3];
+		for (int d = 0; d < 3; ++d) GradPtrs[d] = Data0.GradPtrs[d].TypedReadPtr<double_t>();
+		LaneValsByIndexAndWeights(GradPtrs, 3, m_Index.data(), m_Weights.data(), W, NumLanes, m_Grad.data());
+	}
+	else{
+		const float_t * GradPtrs[3];
+		for (int d = 0; d < 3; ++d) GradPtrs[d] = Data0.GradPtrs[d].TypedReadPtr<float_t>();
+		LaneValsByIndexAndWeights(GradPtrs, 3, m_Index.data(), m_Weights.data(), W, NumLanes, m_Grad.data());
+	}
+
+	/*
+	*	Direction and normalization. The norm is summed in the same
+	*	order as Armadillo's, so the result matches normalise() in
+	*	GP_ODE_GradFunction(); a zero or non-finite norm is left
+	*	to normalise() itself.
+	*/
+	const double * GX = m_Grad.data(), *GY = GX + W, *GZ = GY + W;
+	for (int l = 0; l < NumLanes; ++l){
+		if (!Eval[l] || Status[l] == GSL_ESANITY)
+			continue;
+
+		vec3 Grad;
+		Grad[0] = GX[l] * m_DirSign[l];
+		Grad[1] = GY[l] * m_DirSign[l];
+		Grad[2] = GZ[l] * m_DirSign[l];
+		double Norm = std::sqrt((Grad[0] * Grad[0] + Grad[2] * Grad[2]) + Grad[1] * Grad[1]);
+		if (Norm != 0.0 && std::isfinite(Norm))
+			Grad /= Norm;
+		else
+			Grad = normalise(Grad);
+
+		for (int d = 0; d < 3; ++d)
+			m_K[(Stage * 3 + d) * W + l] = Grad[d];
+
+		IndexWeights_s & Stencil = m_GP[l]->m_ODE_Data.Stencil;
+		for (int c = 0; c < 8; ++c){
+			Stencil.Index[c] = m_Index[c * W + l];
+			Stencil.Weights[c] = m_Weights[c * W + l];
+		}
+	}
+}
+
+/*
+*	Evaluate stage Stage at Pos for the lanes with m_Eval set,
+*	putting each lane's ODE status in m_Status.
+*/
+void GradPathBatch_c::EvalLanes(const int & NumLanes, const double * Pos, const int & Stage, const Boolean_t & ShareGrid){
+	if (ShareGrid){
+		EvalStage(NumLanes, Pos, Stage);
+	}
+	else{
+		for (int l = 0; l < NumLanes; ++l){
+			if (m_Eval[l])
+				m_Status[l] = EvalLane(l, Pos, Stage);
+		}
+	}
+}
+
+void GradPathBatch_c::MoveLane(const int & From, const int & To){
+	for (int d = 0; d < 3; ++d){
+		m_Y[d * m_Width + To] = m_Y[d * m_Width + From];
+		for (int s = 0; s < 7; ++s)
+			m_K[(s * 3 + d) * m_Width + To] = m_K[(s * 3 + d) * m_Width + From];
+	}
+	m_H[To] = m_H[From];
+	m_T[To] = m_T[From];
+	m_AbsTol[To] = m_AbsTol[From];
+	m_RelTol[To] = m_RelTol[From];
+	m_Step[To] = m_Step[From];
+	m_Stall[To] = m_Stall[From];
+	m_HasK[To] = m_HasK[From];
+	m_DirSign[To] = m_DirSign[From];
+	m_PtIm1[To] = m_PtIm1[From];
+	m_Func[To] = m_Func[From];
+	m_GP[To] = m_GP[From];
+}
+
+/*
+*	One step attempt for every active lane, following
+*	GPDormandPrince_s::Apply() and the loop in SeedInDirection().
+*	Finished paths are closed off and their lanes compacted out.
+*/
+const Boolean_t GradPathBatch_c::Advance(const bool DoResample){
+	const int NumLanes = m_NumActive;
+	const int W = m_Width;
+	Boolean_t IsOk = TRUE;
+
+	double * Y = m_Y.data();
+	double * Pos = m_Pos.data();
+	double * K = m_K.data();
+	double * H = m_H.data();
+	double * ErrRatio = m_ErrRatio.data();
+
+	const Boolean_t ShareGrid = LanesShareGrid(NumLanes);
+
+	for (int l = 0; l < NumLanes; ++l){
+		m_Status[l] = GSL_SUCCESS;
+		m_Eval[l] = !m_HasK[l];
+	}
+	EvalLanes(NumLanes, Y, 0, ShareGrid);
+	for (int l = 0; l < NumLanes; ++l){
+		if (m_Eval[l])
+			m_HasK[l] = (m_Status[l] == GSL_SUCCESS);
+	}
+
+	for (int s = 1; s < 7; ++s){
+		for (int d = 0; d < 3; ++d){
+			double * PosD = Pos + d * W;
+			const double * YD = Y + d * W;
+			for (int l = 0; l < NumLanes; ++l)
+				PosD[l] = 0.0;
+			for (int j = 0; j < s; ++j){
+				const double A = GP_DP_A[s][j];
+				const double * KJD = K + (j * 3 + d) * W;
+				for (int l = 0; l < NumLanes; ++l)
+					PosD[l] += A * KJD[l];
+			}
+			for (int l = 0; l < NumLanes; ++l)
+				PosD[l] = YD[l] + H[l] * PosD[l];
+		}
+
+		for (int l = 0; l < NumLanes; ++l)
+			m_Eval[l] = (m_Status[l] == GSL_SUCCESS);
+		EvalLanes(NumLanes, Pos, s, ShareGrid);
+	}
+
+	for (int l = 0; l < NumLanes; ++l)
+		ErrRatio[l] = 0.0;
+	for (int d = 0; d < 3; ++d){
+		const double * PosD = Pos + d * W;
+		const double * AbsTol = m_AbsTol.data();
+		const double * RelTol = m_RelTol.data();
+		for (int l = 0; l < NumLanes; ++l){
+			double Err = 0.0;
+			for (int j = 0; j < 7; ++j)
+				Err += GP_DP_E[j] * K[(j * 3 + d) * W + l];
+			ErrRatio[l] = MAX(ErrRatio[l], std::abs(H[l] * Err) / (AbsTol[l] + RelTol[l] * std::abs(PosD[l])));
+		}
+	}
+
+	for (int l = 0; l < NumLanes; ++l){
+		int Status = m_Status[l];
+
+		if (!m_HasK[l]){
+			/*
+			*	Couldn't even get the gradient at the current point.
+			*/
+		}
+		else if (Status != GSL_SUCCESS){
+			double hNew = 0.5 * H[l];
+			if (m_T[l] + hNew != m_T[l]){
+				H[l] = hNew;
+				continue;
+			}
+			m_HasK[l] = FALSE;
+		}
+		else{
+			if (ErrRatio[l] > 1.1){
+				double hNew = H[l] * MAX(0.2, 0.9 / pow(ErrRatio[l], 1.0 / 5.0));
+				if (m_T[l] + hNew != m_T[l]){
+					H[l] = hNew;
+					continue;
+				}
+			}
+
+			m_T[l] += H[l];
+			for (int d = 0; d < 3; ++d){
+				Y[d * W + l] = Pos[d * W + l];
+				K[d * W + l] = K[(6 * 3 + d) * W + l];
+			}
+
+			if (ErrRatio[l] < 0.5)
+				H[l] *= (ErrRatio[l] > 0.0 ? MIN(5.0, MAX(1.0, 0.9 / pow(ErrRatio[l], 1.0 / 6.0))) : 5.0);
+		}
+
+		/*
+		*	A step was taken (or failed for good), so add the point
+		*	and check for termination.
+		*/
+		GradPath_c * GP = m_GP[l];
+		vec3 PtI;
+		for (int d = 0; d < 3; ++d)
+			PtI[d] = Y[d * W + l];
+
+		Boolean_t PathIsOk = TRUE, IsDone = TRUE;
+		if (Status == GSL_SUCCESS || Status == GSL_EDOM)
+			IsDone = GP->AddStepPoint(PtI, m_PtIm1[l], H[l], Status, m_Stall[l], PathIsOk);
+		m_Step[l]++;
+
+		if (IsDone || !PathIsOk || Status != GSL_SUCCESS || m_Step[l] >= GP_MaxNumPoints){
+			PathIsOk = GP->EndSeedInDirection(PtI, Status, PathIsOk);
+			if (PathIsOk && DoResample)
+				GP->Resample(GP->m_NumGPPoints);
+			IsOk = (PathIsOk && IsOk);
+			m_GP[l] = NULL;
+		}
+	}
+
+	m_NumActive = 0;
+	for (int l = 0; l < NumLanes; ++l){
+		if (m_GP[l] != NULL){
+			if (l != m_NumActive)
+				MoveLane(l, m_NumActive);
+			m_NumActive++;
+		}
+	}
+
+	return IsOk;
+}
+
+
+/*
+*	GradPathSet_c methods
+*/
+
+GradPathSet_c & GradPathSet_c::operator=(GradPathSet_c && rhs){
+	if (this != &rhs){
+		m_X.swap(rhs.m_X);
+		m_Y.swap(rhs.m_Y);
+		m_Z.swap(rhs.m_Z);
+		m_Rho.swap(rhs.m_Rho);
+		m_Offset.swap(rhs.m_Offset);
+		m_Count.swap(rhs.m_Count);
+		m_MaxCount.swap(rhs.m_MaxCount);
+		m_StartEndCPNum.swap(rhs.m_StartEndCPNum);
+		rhs.Clear();
+	}
+
+	return *this;
+}
+
+void GradPathSet_c::Clear(){
+	m_X.clear();
+	m_Y.clear();
+	m_Z.clear();
+	m_Rho.clear();
+	m_Offset.clear();
+	m_Count.clear();
+	m_MaxCount.clear();
+	m_StartEndCPNum.clear();
+}
+
+void GradPathSet_c::Resize(const int & NumPaths, const int & MaxPointsPerPath){
+	REQUIRE(NumPaths >= 0 && MaxPointsPerPath >= 0);
+
+	Clear();
+
+	size_t NumPoints = static_cast<size_t>(NumPaths) * MaxPointsPerPath;
+	m_X.resize(NumPoints);
+	m_Y.resize(NumPoints);
+	m_Z.resize(NumPoints);
+	m_Rho.resize(NumPoints);
+
+	m_Offset.resize(NumPaths);
+	for (int i = 0; i < NumPaths; ++i)
+		m_Offset[i] = i * MaxPointsPerPath;
+	m_Count.assign(NumPaths, 0);
+	m_MaxCount.assign(NumPaths, MaxPointsPerPath);
+	m_StartEndCPNum.assign(2 * NumPaths, -1);
+}
+
+const Boolean_t GradPathSet_c::SetPath(const int & PathNum, const GradPathBase_c & GP, const int & NumPoints){
+	REQUIRE(PathNum >= 0 && PathNum < NumPaths());
+
+	m_Count[PathNum] = 0;
+	for (int i = 0; i < 2; ++i)
+		m_StartEndCPNum[2 * PathNum + i] = GP.m_StartEndCPNum[i];
+
+	if (!GP.IsMade())
+		return TRUE;
+
+	int OldCount = GP.GetCount();
+	int Offset = m_Offset[PathNum];
+	double * X = m_X.data() + Offset,
+		* Y = m_Y.data() + Offset,
+		* Z = m_Z.data() + Offset,
+		* Rho = m_Rho.data() + Offset;
+
+	if (NumPoints > 1 && NumPoints < OldCount){
+		if (NumPoints > m_MaxCount[PathNum])
+			return FALSE;
+
+		double Length = GP.m_Length;
+		if (Length < 0){
+			Length = 0.0;
+			for (int i = 0; i < OldCount - 1; ++i)
+				Length += Distance(GP.m_XYZList[i], GP.m_XYZList[i + 1]);
+		}
+
+		ResampleGradPathPoints(GP.m_XYZList, GP.m_RhoList, OldCount, Length, NumPoints,
+			[&](const int & i, const vec3 & Pt, const double & PtRho){
+				X[i] = Pt[0];
+				Y[i] = Pt[1];
+				Z[i] = Pt[2];
+				Rho[i] = PtRho;
+			});
+		m_Count[PathNum] = NumPoints;
+	}
+	else{
+		if (OldCount > m_MaxCount[PathNum])
+			return FALSE;
+
+		for (int i = 0; i < OldCount; ++i){
+			X[i] = GP.m_XYZList[i][0];
+			Y[i] = GP.m_XYZList[i][1];
+			Z[i] = GP.m_XYZList[i][2];
+			Rho[i] = GP.m_RhoList[i];
+		}
+		m_Count[PathNum] = OldCount;
+	}
+
+	return TRUE;
+}
+
+const int GradPathSet_c::AddPath(const GradPathBase_c & GP){
+	int Count = (GP.IsMade() ? GP.GetCount() : 0);
+
+	m_Offset.push_back(static_cast<int>(m_X.size()));
+	m_Count.push_back(0);
+	m_MaxCount.push_back(Count);
+	m_StartEndCPNum.push_back(-1);
+	m_StartEndCPNum.push_back(-1);
+
+	m_X.resize(m_X.size() + Count);
+	m_Y.resize(m_Y.size() + Count);
+	m_Z.resize(m_Z.size() + Count);
+	m_Rho.resize(m_Rho.size() + Count);
+
+	SetPath(NumPaths() - 1, GP);
+
+	return NumPaths() - 1;
+}
+
+const Boolean_t GradPathSet_c::GetPath(const int & PathNum, GradPathBase_c & GP) const{
+	REQUIRE(PathNum >= 0 && PathNum < NumPaths());
+
+	int Count = m_Count[PathNum];
+	GP.m_XYZList.resize(Count);
+	GP.m_RhoList.resize(Count);
+	for (int i = 0; i < Count; ++i){
+		GP.m_XYZList[i] = XYZAt(PathNum, i);
+		GP.m_RhoList[i] = RhoAt(PathNum, i);
+	}
+	for (int i = 0; i < 2; ++i)
+		GP.m_StartEndCPNum[i] = m_StartEndCPNum[2 * PathNum + i];
+	GP.m_NumGPPoints = Count;
+	GP.m_Length = -1;
+	GP.m_GradPathMade = (Count > 0);
+
+	return GP.m_GradPathMade;
+}
+
+const vec3 GradPathSet_c::XYZAt(const int & PathNum, const int & i) const{
+	REQUIRE(i >= 0 && i < m_Count[PathNum]);
+
+	int Ind = m_Offset[PathNum] + i;
+	vec3 Pt;
+	Pt[0] = m_X[Ind];
+	Pt[1] = m_Y[Ind];
+	Pt[2] = m_Z[Ind];
+
+	return Pt;
+}
+
+const Boolean_t GradPathSet_c::Reverse(const int & PathNum){
+	Boolean_t IsOk = IsMade(PathNum);
+	if (IsOk){
+		int Beg = m_Offset[PathNum],
+			End = Beg + m_Count[PathNum];
+		std::reverse(m_X.begin() + Beg, m_X.begin() + End);
+		std::reverse(m_Y.begin() + Beg, m_Y.begin() + End);
+		std::reverse(m_Z.begin() + Beg, m_Z.begin() + End);
+		std::reverse(m_Rho.begin() + Beg, m_Rho.begin() + End);
+
+		int TmpInt = m_StartEndCPNum[2 * PathNum];
+		m_StartEndCPNum[2 * PathNum] = m_StartEndCPNum[2 * PathNum + 1];
+		m_StartEndCPNum[2 * PathNum + 1] = TmpInt;
+	}
+	return IsOk;
+}
+
+const vec3 GradPathSet_c::ClosestPoint(const int & PathNum, const vec3 & CheckPt, int & PtNum) const{
+	vec3 ClosestPt;
+	if (IsMade(PathNum)){
+		ClosestPt = XYZAt(PathNum, 0);
+		double MinSqrDist = DistSqr(ClosestPt, CheckPt);
+		PtNum = 0;
+		int Count = m_Count[PathNum];
+		for (int i = 1; i < Count; ++i){
+			vec3 Pt = XYZAt(PathNum, i);
+			double TempSqrDist = DistSqr(Pt, CheckPt);
+			if (TempSqrDist < MinSqrDist){
+				MinSqrDist = TempSqrDist;
+				ClosestPt = Pt;
+				PtNum = i;
+			}
+		}
+	}
+
+	return ClosestPt;
+}
+
+const EntIndex_t GradPathSet_c::SaveAsOrderedZone(const int & PathNum, const string & ZoneName, const ColorIndex_t MeshColor) const{
+	GradPathBase_c GP;
+	if (GetPath(PathNum, GP) && GP.SaveAsOrderedZone(ZoneName, MeshColor))
+		return GP.GetZoneNum();
+
+	return -1;
+}
+
+
+
+
+/*
+*	GradPathSegmentTree_c methods
+*/
+
+/*
+*	Leaves hold at most this many segments.
+*	Median splits keep both the levels above the path roots and those
+*	below them under 32 deep for any number of paths or segments an int
+*	can count, so a query's node stack can't pass 64.
+*/
+static const int GPSegTreeLeafSize = 4;
+static const int GPSegTreeMaxStack = 64;
+
+/*
+*	Squared distance from Pt to the box Min, Max; 0 if it's inside.
+*/
+static inline double BoxDistSqr(const double * Min, const double * Max, const vec3 & Pt){
+	double DistSqr = 0.0;
+	for (int d = 0; d < 3; ++d){
+		double Del = MAX(Min[d] - Pt[d], Pt[d] - Max[d]);
+		if (Del > 0.0)
+			DistSqr += Del * Del;
+	}
+	return DistSqr;
+}
+
+/*
+*	Closest point to Pt on the segment from Beg to End.
+*/
+static inline vec3 ClosestPointOnSegment(const vec3 & Beg, const vec3 & End, const vec3 & Pt){
+	vec3 SegVec = End - Beg;
+	double LenSqr = dot(SegVec, SegVec);
+	double t = 0.0;
+	if (LenSqr > 0.0)
+		t = MIN(MAX(dot(Pt - Beg, SegVec) / LenSqr, 0.0), 1.0);
+	return Beg + SegVec * t;
+}
+
+const Boolean_t GradPathSegmentTree_c::Build(const GradPathBase_c & GP){
+	Clear();
+
+	if (!GP.IsMade())
+		return FALSE;
+
+	/*
+	*	A single-point path is one segment of zero length.
+	*/
+	int Count = GP.GetCount();
+	int NumSegs = MAX(Count - 1, 1);
+	m_SegBeg.reserve(NumSegs);
+	m_SegEnd.reserve(NumSegs);
+	m_SegPathNum.reserve(NumSegs);
+	m_SegPtNum.reserve(NumSegs);
+	for (int i = 0; i < NumSegs; ++i){
+		m_SegBeg.push_back(GP.XYZAt(i));
+		m_SegEnd.push_back(GP.XYZAt(MIN(i + 1, Count - 1)));
+		m_SegPathNum.push_back(0);
+		m_SegPtNum.push_back(i);
+	}
+
+	return BuildTree();
+}
+
+const Boolean_t GradPathSegmentTree_c::Build(const vector<GradPath_c> & GPs){
+	Clear();
+
+	for (int p = 0; p < static_cast<int>(GPs.size()); ++p){
+		if (GPs[p].IsMade()){
+			int Count = GPs[p].GetCount();
+			int NumSegs = MAX(Count - 1, 1);
+			for (int i = 0; i < NumSegs; ++i){
+				m_SegBeg.push_back(GPs[p].XYZAt(i));
+				m_SegEnd.push_back(GPs[p].XYZAt(MIN(i + 1, Count - 1)));
+				m_SegPathNum.push_back(p);
+				m_SegPtNum.push_back(i);
+			}
+		}
+	}
+
+	return BuildTree();
+}
+
+const Boolean_t GradPathSegmentTree_c::Build(const GradPathSet_c & GPs, const vector<int> & PathNums){
+	Clear();
+
+	int NumPaths = (PathNums.empty() ? GPs.NumPaths() : static_cast<int>(PathNums.size()));
+	for (int p = 0; p < NumPaths; ++p){
+		int PathNum = (PathNums.empty() ? p : PathNums[p]);
+		if (GPs.IsMade(PathNum)){
+			int Count = GPs.GetCount(PathNum);
+			int NumSegs = MAX(Count - 1, 1);
+			for (int i = 0; i < NumSegs; ++i){
+				m_SegBeg.push_back(GPs.XYZAt(PathNum, i));
+				m_SegEnd.push_back(GPs.XYZAt(PathNum, MIN(i + 1, Count - 1)));
+				m_SegPathNum.push_back(PathNum);
+				m_SegPtNum.push_back(i);
+			}
+		}
+	}
+
+	return BuildTree();
+}
+
+void GradPathSegmentTree_c::Clear(){
+	m_Nodes.clear();
+	m_SegBeg.clear();
+	m_SegEnd.clear();
+	m_SegPathNum.clear();
+	m_SegPtNum.clear();
+	m_PathRoots.clear();
+}
+
+/*
+*	The Build() functions add each path's segments together, so a
+*	path's segments are m_Seg*[PathBeg[p]] to m_Seg*[PathBeg[p + 1] - 1].
+*	The paths are split first, down to one path per node, then each
+*	path's segments are split below its node.
+*/
+const Boolean_t GradPathSegmentTree_c::BuildTree(){
+	int NumSegs = static_cast<int>(m_SegBeg.size());
+	if (NumSegs == 0)
+		return FALSE;
+
+	vector<vec3> Centroids(NumSegs);
+	for (int i = 0; i < NumSegs; ++i)
+		Centroids[i] = (m_SegBeg[i] + m_SegEnd[i]) * 0.5;
+
+	vector<int> PathBeg;
+	for (int i = 0; i < NumSegs; ++i){
+		if (i == 0 || m_SegPathNum[i] != m_SegPathNum[i - 1])
+			PathBeg.push_back(i);
+	}
+	int NumPaths = static_cast<int>(PathBeg.size());
+	PathBeg.push_back(NumSegs);
+
+	vector<vec3> PathCenters(NumPaths);
+	vector<int> PathOrder(NumPaths);
+	for (int p = 0; p < NumPaths; ++p){
+		vec3 Min, Max;
+		Min.fill(DBL_MAX);
+		Max.fill(-DBL_MAX);
+		for (int i = PathBeg[p]; i < PathBeg[p + 1]; ++i){
+			for (int d = 0; d < 3; ++d){
+				Min[d] = MIN(Min[d], Centroids[i][d]);
+				Max[d] = MAX(Max[d], Centroids[i][d]);
+			}
+		}
+		PathCenters[p] = (Min + Max) * 0.5;
+		PathOrder[p] = p;
+	}
+
+	m_Nodes.reserve(2 * (NumSegs / GPSegTreeLeafSize + NumPaths));
+	Node_s Root;
+	Root.Child = -1;
+	m_Nodes.push_back(Root);
+	BuildPathNode(0, 0, NumPaths, PathOrder, PathCenters);
+
+	/*
+	*	Nodes above the path roots are the ones made so far, and path roots
+	*	are the ones with Beg set to the path they hold. Lay the paths
+	*	out in tree order and split each one's segments.
+	*/
+	int NumPathNodes = static_cast<int>(m_Nodes.size());
+	vector<int> SegNums;
+	SegNums.reserve(NumSegs);
+	int MaxPathNum = 0;
+	for (int p = 0; p < NumPaths; ++p)
+		MaxPathNum = MAX(MaxPathNum, m_SegPathNum[PathBeg[p]]);
+	m_PathRoots.assign(MaxPathNum + 1, -1);
+
+	for (int n = 0; n < NumPathNodes; ++n){
+		if (m_Nodes[n].Child < 0){
+			int p = m_Nodes[n].Beg;
+			m_Nodes[n].Beg = static_cast<int>(SegNums.size());
+			for (int i = PathBeg[p]; i < PathBeg[p + 1]; ++i)
+				SegNums.push_back(i);
+			m_Nodes[n].End = static_cast<int>(SegNums.size());
+			m_PathRoots[m_SegPathNum[PathBeg[p]]] = n;
+		}
+	}
+	for (int n = 0; n < NumPathNodes; ++n){
+		if (m_Nodes[n].Child < 0)
+			BuildNode(n, Centroids, SegNums);
+	}
+
+	/*
+	*	Children of the nodes above the path roots come after them,
+	*	so their boxes can be filled in from the last one up.
+	*/
+	for (int n = NumPathNodes - 1; n >= 0; --n){
+		Node_s & Node = m_Nodes[n];
+		if (Node.Child >= 0 && Node.Child < NumPathNodes){
+			for (int d = 0; d < 3; ++d){
+				Node.Min[d] = MIN(m_Nodes[Node.Child].Min[d], m_Nodes[Node.Child + 1].Min[d]);
+				Node.Max[d] = MAX(m_Nodes[Node.Child].Max[d], m_Nodes[Node.Child + 1].Max[d]);
+			}
+			Node.Beg = m_Nodes[Node.Child].Beg;
+			Node.End = m_Nodes[Node.Child + 1].End;
+		}
+	}
+
+	/*
+	*	Put the segments in tree order, so each node's segments are contiguous.
+	*/
+	vector<vec3> SegBeg(NumSegs), SegEnd(NumSegs);
+	vector<int> SegPathNum(NumSegs), SegPtNum(NumSegs);
+	for (int i = 0; i < NumSegs; ++i){
+		SegBeg[i] = m_SegBeg[SegNums[i]];
+		SegEnd[i] = m_SegEnd[SegNums[i]];
+		SegPathNum[i] = m_SegPathNum[SegNums[i]];
+		SegPtNum[i] = m_SegPtNum[SegNums[i]];
+	}
+	m_SegBeg.swap(SegBeg);
+	m_SegEnd.swap(SegEnd);
+	m_SegPathNum.swap(SegPathNum);
+	m_SegPtNum.swap(SegPtNum);
+
+	return TRUE;
+}
+
+/*
+*	Split paths PathOrder[Beg] to PathOrder[End - 1] at the median path
+*	center along the longest axis of the centers, until each node has
+*	one path. A one-path node's Beg is left as the path's index for
+*	BuildTree() to replace with its segments.
+*/
+void GradPathSegmentTree_c::BuildPathNode(const int & NodeNum, const int & Beg, const int & End, vector<int> & PathOrder, const vector<vec3> & PathCenters){
+	if (End - Beg == 1){
+		m_Nodes[NodeNum].Beg = PathOrder[Beg];
+		m_Nodes[NodeNum].Child = -1;
+		return;
+	}
+
+	double CMin[3], CMax[3];
+	for (int d = 0; d < 3; ++d){
+		CMin[d] = DBL_MAX;
+		CMax[d] = -DBL_MAX;
+	}
+	for (int i = Beg; i < End; ++i){
+		for (int d = 0; d < 3; ++d){
+			CMin[d] = MIN(CMin[d], PathCenters[PathOrder[i]][d]);
+			CMax[d] = MAX(CMax[d], PathCenters[PathOrder[i]][d]);
+		}
+	}
+	int Axis = 0;
+	for (int d = 1; d < 3; ++d){
+		if (CMax[d] - CMin[d] > CMax[Axis] - CMin[Axis])
+			Axis = d;
+	}
+
+	int Mid = (Beg + End) / 2;
+	std::nth_element(PathOrder.begin() + Beg, PathOrder.begin() + Mid, PathOrder.begin() + End,
+		[&](const int & a, const int & b){ return PathCenters[a][Axis] < PathCenters[b][Axis]; });
+
+	int Child = static_cast<int>(m_Nodes.size());
+	Node_s ChildNode;
+	ChildNode.Child = -1;
+	m_Nodes.push_back(ChildNode);
+	m_Nodes.push_back(ChildNode);
+	m_Nodes[NodeNum].Child = Child;
+
+	BuildPathNode(Child, Beg, Mid, PathOrder, PathCenters);
+	BuildPathNode(Child + 1, Mid, End, PathOrder, PathCenters);
+}
+
+void GradPathSegmentTree_c::BuildNode(const int & NodeNum, vector<vec3> & Centroids, vector<int> & SegNums){
+	int Beg = m_Nodes[NodeNum].Beg,
+		End = m_Nodes[NodeNum].End;
+
+	double Min[3], Max[3], CMin[3], CMax[3];
+	for (int d = 0; d < 3; ++d){
+		Min[d] = CMin[d] = DBL_MAX;
+		Max[d] = CMax[d] = -DBL_MAX;
+	}
+	for (int i = Beg; i < End; ++i){
+		int SegNum = SegNums[i];
+		for (int d = 0; d < 3; ++d){
+			Min[d] = MIN(Min[d], MIN(m_SegBeg[SegNum][d], m_SegEnd[SegNum][d]));
+			Max[d] = MAX(Max[d], MAX(m_SegBeg[SegNum][d], m_SegEnd[SegNum][d]));
+			CMin[d] = MIN(CMin[d], Centroids[SegNum][d]);
+			CMax[d] = MAX(CMax[d], Centroids[SegNum][d]);
+		}
+	}
+	for (int d = 0; d < 3; ++d){
+		m_Nodes[NodeNum].Min[d] = Min[d];
+		m_Nodes[NodeNum].Max[d] = Max[d];
+	}
+
+	if (End - Beg <= GPSegTreeLeafSize)
+		return;
+
+	/*
+	*	Split at the median centroid along the longest axis of the centroids.
+	*/
+	int Axis = 0;
+	for (int d = 1; d < 3; ++d){
+		if (CMax[d] - CMin[d] > CMax[Axis] - CMin[Axis])
+			Axis = d;
+	}
+	if (CMax[Axis] <= CMin[Axis])
+		return;
+
+	int Mid = (Beg + End) / 2;
+	std::nth_element(SegNums.begin() + Beg, SegNums.begin() + Mid, SegNums.begin() + End,
+		[&](const int & a, const int & b){ return Centroids[a][Axis] < Centroids[b][Axis]; });
+
+	int Child = static_cast<int>(m_Nodes.size());
+	Node_s ChildNode;
+	ChildNode.Child = -1;
+	ChildNode.Beg = Beg;
+	ChildNode.End = Mid;
+	m_Nodes.push_back(ChildNode);
+	ChildNode.Beg = Mid;
+	ChildNode.End = End;
+	m_Nodes.push_back(ChildNode);
+	m_Nodes[NodeNum].Child = Child;
+
+	BuildNode(Child, Centroids, SegNums);
+	BuildNode(Child + 1, Centroids, SegNums);
+}
+
+const vec3 GradPathSegmentTree_c::ClosestPoint(const vec3 & CheckPt, int & PathNum, int & PtNum, double & Dist) const{
+	return ClosestPointFrom(0, CheckPt, PathNum, PtNum, Dist);
+}
+
+const vec3 GradPathSegmentTree_c::ClosestPointOnPath(const vec3 & CheckPt, const int & PathNum, int & PtNum, double & Dist) const{
+	int PathNumJunk;
+	return ClosestPointFrom(HasPath(PathNum) ? m_PathRoots[PathNum] : -1, CheckPt, PathNumJunk, PtNum, Dist);
+}
+
+/*
+*	Search the subtree under node RootNum, or nothing if it's negative.
+*/
+const vec3 GradPathSegmentTree_c::ClosestPointFrom(const int & RootNum, const vec3 & CheckPt, int & PathNum, int & PtNum, double & Dist) const{
+	vec3 ClosestPt;
+	PathNum = PtNum = -1;
+	Dist = -1.0;
+	if (!IsBuilt() || RootNum < 0)
+		return ClosestPt;
+
+	double MinDistSqr = DBL_MAX;
+	int BestSegNum = -1;
+
+	int Stack[GPSegTreeMaxStack];
+	int StackSize = 0;
+	Stack[StackSize++] = RootNum;
+
+	while (StackSize > 0){
+		const Node_s & Node = m_Nodes[Stack[--StackSize]];
+		if (BoxDistSqr(Node.Min, Node.Max, CheckPt) >= MinDistSqr)
+			continue;
+
+		if (Node.Child < 0){
+			for (int i = Node.Beg; i < Node.End; ++i){
+				vec3 Pt = ClosestPointOnSegment(m_SegBeg[i], m_SegEnd[i], CheckPt);
+				double TmpDistSqr = DistSqr(Pt, CheckPt);
+				if (TmpDistSqr < MinDistSqr){
+					MinDistSqr = TmpDistSqr;
+					ClosestPt = Pt;
+					BestSegNum = i;
+				}
+			}
+		}
+		else{
+			/*
+			*	Push the farther child first so the nearer one is searched first.
+			*/
+			double ChildDistSqr[2];
+			for (int c = 0; c < 2; ++c)
+				ChildDistSqr[c] = BoxDistSqr(m_Nodes[Node.Child + c].Min, m_Nodes[Node.Child + c].Max, CheckPt);
+			int Near = (ChildDistSqr[1] < ChildDistSqr[0] ? 1 : 0);
+			Stack[StackSize++] = Node.Child + 1 - Near;
+			Stack[StackSize++] = Node.Child + Near;
+		}
+	}
+
+	if (BestSegNum >= 0){
+		PathNum = m_SegPathNum[BestSegNum];
+		PtNum = m_SegPtNum[BestSegNum];
+		Dist = sqrt(MinDistSqr);
+	}
+
+	return ClosestPt;
+}
+
+void GradPathSegmentTree_c::ClosestPoints(const vector<vec3> & CheckPts,
+	vector<vec3> & ClosestPts,
+	vector<int> & PathNums,
+	vector<int> & PtNums,
+	vector<double> & Dists) const
+{
+	int NumPts = static_cast<int>(CheckPts.size());
+	ClosestPts.resize(NumPts);
+	PathNums.resize(NumPts);
+	PtNums.resize(NumPts);
+	Dists.resize(NumPts);
+
+#pragma omp parallel for
+	for (int i = 0; i < NumPts; ++i){
+		ClosestPts[i] = ClosestPoint(CheckPts[i], PathNums[i], PtNums[i], Dists[i]);
+	}
+}
+
+void GradPathSegmentTree_c::ClosestPointsOnPaths(const vector<vec3> & CheckPts,
+	const vector<int> & OnPathNums,
+	vector<vec3> & ClosestPts,
+	vector<int> & PtNums,
+	vector<double> & Dists) const
+{
+	REQUIRE(OnPathNums.size() == CheckPts.size());
+
+	int NumPts = static_cast<int>(CheckPts.size());
+	ClosestPts.resize(NumPts);
+	PtNums.resize(NumPts);
+	Dists.resize(NumPts);
+
+#pragma omp parallel for
+	for (int i = 0; i < NumPts; ++i){
+		ClosestPts[i] = ClosestPointOnPath(CheckPts[i], OnPathNums[i], PtNums[i], Dists[i]);
+	}
+}
+
+
+const Boolean_t CompactGradPath_c::Build(const GradPathBase_c & GP, const double & Tol, const double & RhoTol){
+	Clear();
+	for (int i = 0; i < 2; ++i)
+		m_StartEndCPNum[i] = GP.m_StartEndCPNum[i];
+
+	if (!GP.IsMade() || GP.GetCount() < 2)
+		return FALSE;
+
+	return BuildFromPoints(GP.GetCount(),
+		[&](const int & i, vec3 & Pt, double & Rho){
+			Pt = GP.m_XYZList[i];
+			Rho = GP.m_RhoList[i];
+		}, Tol, RhoTol);
+}
+
+const Boolean_t CompactGradPath_c::Build(const GradPathSet_c & GPs, const int & PathNum, const double & Tol, const double & RhoTol){
+	REQUIRE(PathNum >= 0 && PathNum < GPs.NumPaths());
+
+	Clear();
+	for (int i = 0; i < 2; ++i)
+		m_StartEndCPNum[i] = GPs.GetStartEndCPNum(PathNum, i);
+
+	if (GPs.GetCount(PathNum) < 2)
+		return FALSE;
+
+	return BuildFromPoints(GPs.GetCount(PathNum),
+		[&](const int & i, vec3 & Pt, double & Rho){
+			Pt = GPs.XYZAt(PathNum, i);
+			Rho = GPs.RhoAt(PathNum, i);
+		}, Tol, RhoTol);
+}
+
+void CompactGradPath_c::Clear(){
+	m_S.clear();
+	m_X.clear();
+	m_Y.clear();
+	m_Z.clear();
+	m_Rho.clear();
+	m_StartEndCPNum[0] = m_StartEndCPNum[1] = -1;
+}
+
+/*
+*	Douglas-Peucker style: starting from the two end points, any
+*	span whose worst dropped point is out of tolerance is split there.
+*	A point's error is measured against linear interpolation at its arc
+*	length, so uneven spacing counts as well as distance from the chord.
+*/
+template <typename GetPointFunc>
+const Boolean_t CompactGradPath_c::BuildFromPoints(const int & Count, GetPointFunc GetPoint, const double & Tol, const double & RhoTol){
+	vector<vec3> Pts(Count);
+	vector<double> Rhos(Count), S(Count);
+
+	for (int i = 0; i < Count; ++i)
+		GetPoint(i, Pts[i], Rhos[i]);
+
+	S[0] = 0.0;
+	for (int i = 1; i < Count; ++i)
+		S[i] = S[i - 1] + Distance(Pts[i], Pts[i - 1]);
+
+	double XYZTol = MAX(Tol * S.back(), 1e-12);
+
+	vector<char> Keep(Count, 0);
+	Keep[0] = Keep[Count - 1] = 1;
+
+	vector<std::pair<int, int> > Spans;
+	Spans.push_back(std::make_pair(0, Count - 1));
+	while (!Spans.empty()){
+		int Beg = Spans.back().first,
+			End = Spans.back().second;
+		Spans.pop_back();
+
+		if (End - Beg < 2)
+			continue;
+
+		double SpanLen = S[End] - S[Beg];
+		double MaxErr = 1.0;
+		int MaxI = -1;
+		for (int i = Beg + 1; i < End; ++i){
+			double t = (SpanLen > 0.0 ? (S[i] - S[Beg]) / SpanLen : 0.5);
+			double Err = Distance(Pts[i], Pts[Beg] + (Pts[End] - Pts[Beg]) * t) / XYZTol;
+			double RhoScale = RhoTol * std::abs(Rhos[i]);
+			if (RhoScale > 0.0)
+				Err = MAX(Err, std::abs(Rhos[i] - (Rhos[Beg] + (Rhos[End] - Rhos[Beg]) * t)) / RhoScale);
+			if (Err > MaxErr){
+				MaxErr = Err;
+				MaxI = i;
+			}
+		}
+
+		if (MaxI >= 0){
+			Keep[MaxI] = 1;
+			Spans.push_back(std::make_pair(Beg, MaxI));
+			Spans.push_back(std::make_pair(MaxI, End));
+		}
+	}
+
+	int NumKept = 0;
+	for (int i = 0; i < Count; ++i)
+		NumKept += Keep[i];
+
+	m_S.reserve(NumKept);
+	m_X.reserve(NumKept);
+	m_Y.reserve(NumKept);
+	m_Z.reserve(NumKept);
+	m_Rho.reserve(NumKept);
+
+	for (int i = 0; i < Count; ++i){
+		if (Keep[i]){
+			m_S.push_back(S[i]);
+			m_X.push_back(Pts[i][0]);
+			m_Y.push_back(Pts[i][1]);
+			m_Z.push_back(Pts[i][2]);
+			m_Rho.push_back(Rhos[i]);
+		}
+	}
+
+	return IsMade();
+}
+
+/*
+*	k such that m_S[k] <= ArcLength <= m_S[k + 1].
+*/
+const int CompactGradPath_c::Interval(const double & ArcLength) const{
+	int k = static_cast<int>(std::upper_bound(m_S.cbegin(), m_S.cend(), ArcLength) - m_S.cbegin()) - 1;
+	return MIN(MAX(k, 0), GetCount() - 2);
+}
+
+/*
+*	Evaluate the Hermite cubic on interval k. Slopes at the ends of the
+*	interval come from its neighbours: centered (Catmull-Rom) for
+*	position, and the Fritsch-Butland harmonic mean of the secants for
+*	rho, which is zero at a local extremum so rho can't overshoot.
+*/
+void CompactGradPath_c::Eval(const int & k, const double & ArcLength, vec3 * Pt, double * Rho) const{
+	int N = GetCount();
+	double h = m_S[k + 1] - m_S[k];
+	if (h <= 0.0){
+		if (Pt != NULL) *Pt << m_X[k] << m_Y[k] << m_Z[k];
+		if (Rho != NULL) *Rho = m_Rho[k];
+		return;
+	}
+
+	double t = MIN(MAX((ArcLength - m_S[k]) / h, 0.0), 1.0);
+	double t2 = t * t, t3 = t2 * t;
+	double H00 = 2.0 * t3 - 3.0 * t2 + 1.0,
+		H10 = t3 - 2.0 * t2 + t,
+		H01 = -2.0 * t3 + 3.0 * t2,
+		H11 = t3 - t2;
+
+	int Lo[2] = { MAX(k - 1, 0), k },
+		Hi[2] = { k + 1, MIN(k + 2, N - 1) };
+
+	if (Pt != NULL){
+		const vector<double> * XYZ[3] = { &m_X, &m_Y, &m_Z };
+		for (int d = 0; d < 3; ++d){
+			const vector<double> & V = *XYZ[d];
+			double Slope[2];
+			for (int j = 0; j < 2; ++j)
+				Slope[j] = (V[Hi[j]] - V[Lo[j]]) / (m_S[Hi[j]] - m_S[Lo[j]]);
+			(*Pt)[d] = H00 * V[k] + H10 * h * Slope[0] + H01 * V[k + 1] + H11 * h * Slope[1];
+		}
+	}
+
+	if (Rho != NULL){
+		double Secant = (m_Rho[k + 1] - m_Rho[k]) / h;
+		double Slope[2] = { Secant, Secant };
+		for (int j = 0; j < 2; ++j){
+			int i = k + j;
+			if (i <= 0 || i >= N - 1)
+				continue;
+			double h0 = m_S[i] - m_S[i - 1],
+				h1 = m_S[i + 1] - m_S[i];
+			if (h0 <= 0.0 || h1 <= 0.0)
+				continue;
+			double d0 = (m_Rho[i] - m_Rho[i - 1]) / h0,
+				d1 = (m_Rho[i + 1] - m_Rho[i]) / h1;
+			if (d0 * d1 <= 0.0)
+				Slope[j] = 0.0;
+			else{
+				double w0 = 2.0 * h1 + h0,
+					w1 = h1 + 2.0 * h0;
+				Slope[j] = (w0 + w1) / (w0 / d0 + w1 / d1);
+			}
+		}
+		*Rho = H00 * m_Rho[k] + H10 * h * Slope[0] + H01 * m_Rho[k + 1] + H11 * h * Slope[1];
+	}
+}
+
+const vec3 CompactGradPath_c::XYZAt(const double & ArcLength) const{
+	REQUIRE(IsMade());
+	vec3 Pt;
+	Eval(Interval(ArcLength), ArcLength, &Pt, NULL);
+	return Pt;
+}
+
+const double CompactGradPath_c::RhoAt(const double & ArcLength) const{
+	REQUIRE(IsMade());
+	double Rho;
+	Eval(Interval(ArcLength), ArcLength, NULL, &Rho);
+	return Rho;
+}
+
+/*
+*	Rho is monotone along a gradient path, so binary search the kept
+*	points for the interval, then bisect the interval's cubic.
+*/
+const double CompactGradPath_c::ArcLengthAtRho(const double & Rho) const{
+	if (!IsMade())
+		return -1.0;
+
+	int N = GetCount();
+	double Dir = (m_Rho.back() >= m_Rho.front() ? 1.0 : -1.0);
+	if (Dir * (Rho - m_Rho.front()) < 0.0 || Dir * (m_Rho.back() - Rho) < 0.0)
+		return -1.0;
+
+	int Lo = 0, Hi = N - 1;
+	while (Hi - Lo > 1){
+		int Mid = (Lo + Hi) / 2;
+		if (Dir * (m_Rho[Mid] - Rho) <= 0.0)
+			Lo = Mid;
+		else
+			Hi = Mid;
+	}
+
+	double SLo = m_S[Lo], SHi = m_S[Hi];
+	for (int Iter = 0; Iter < 60 && SHi - SLo > 1e-14 * MAX(m_S.back(), 1.0); ++Iter){
+		double SMid = 0.5 * (SLo + SHi), RhoMid;
+		Eval(Lo, SMid, NULL, &RhoMid);
+		if (Dir * (RhoMid - Rho) <= 0.0)
+			SLo = SMid;
+		else
+			SHi = SMid;
+	}
+
+	return 0.5 * (SLo + SHi);
+}
+
+const Boolean_t CompactGradPath_c::Sample(const int & NumPoints, vector<vec3> & XYZList, vector<double> & RhoList) const{
+	if (!IsMade() || NumPoints < 2)
+		return FALSE;
+
+	XYZList.resize(NumPoints);
+	RhoList.resize(NumPoints);
+
+	int N = GetCount();
+	double DelLength = GetLength() / static_cast<double>(NumPoints - 1);
+	int k = 0;
+	for (int i = 0; i < NumPoints - 1; ++i){
+		double ArcLength = DelLength * static_cast<double>(i);
+		while (k < N - 2 && m_S[k + 1] < ArcLength)
+			++k;
+		Eval(k, ArcLength, &XYZList[i], &RhoList[i]);
 	}
 
+	XYZList.back() << m_X.back() << m_Y.back() << m_Z.back();
+	RhoList.back() = m_Rho.back();
+
+	return TRUE;
+}
+
+const Boolean_t CompactGradPath_c::Sample(const int & NumPoints, GradPathBase_c & GP) const{
+	Boolean_t IsOk = Sample(NumPoints, GP.m_XYZList, GP.m_RhoList);
+
+	for (int i = 0; i < 2; ++i)
+		GP.m_StartEndCPNum[i] = m_StartEndCPNum[i];
+	GP.m_NumGPPoints = GP.GetCount();
+	GP.m_Length = -1;
+	GP.m_GradPathMade = GP.m_GradPathReady = IsOk;
+
 	return IsOk;
 }
 
@@ -1519,6 +3332,48 @@ const Boolean_t GradPath_c::Seed(const bool DoResample){
 *	Private Methods
 */
 
+/*
+*	Shared body of the GP_ODE_GradFunction*() ODE functions: clamp pos to
+*	the volume, set the interpolation stencil there, then have Gather()
+*	replace the position it's given with the gradient at that point
+*	(returning FALSE if it can't), and set dydt to the normalised
+*	gradient, reversed for reverse paths.
+*/
+template <typename GatherFunc>
+static int GP_ODE_GradFunctionBody(const double pos[], double dydt[], GradPathParams_s * ODE_Data, GatherFunc Gather)
+{
+	int Status = GSL_SUCCESS;
+
+	vec3 TmpVec = pos;
+
+	/*
+	*	Check that current position is in system bounds
+	*/
+	for (int i = 0; i < 3; ++i){
+		if (TmpVec[i] < ODE_Data->VolZoneInfo->MinXYZ[i] || TmpVec[i] > ODE_Data->VolZoneInfo->MaxXYZ[i]){
+			TmpVec[i] = MIN(ODE_Data->VolZoneInfo->MaxXYZ[i], MAX(TmpVec[i], ODE_Data->VolZoneInfo->MinXYZ[i]));
+			Status = GSL_EDOM;
+		}
+	}
+
+	if (GetIndexAndWeightsForPoint(TmpVec, *ODE_Data->VolZoneInfo, ODE_Data->Stencil)){
+		if (!Gather(TmpVec))
+			return GSL_ESANITY;
+
+		if (ODE_Data->Direction == StreamDir_Reverse)
+			TmpVec *= -1.0;
+
+		TmpVec = normalise(TmpVec);
+
+		for (int i = 0; i < 3; ++i)
+			dydt[i] = TmpVec[i];
+	}
+	else
+		Status = GSL_ESANITY;
+
+	return Status;
+} //	int GP_ODE_GradFunctionBody()
+
 /*
 *	Function for GSL ODE solver to use.
 *	System of three first-order ODEs;
@@ -1542,63 +3397,50 @@ int GP_ODE_GradFunction(double t, const double pos[], double dydt[], void* param
 {
 	GradPathParams_s *ODE_Data = reinterpret_cast<GradPathParams_s*>(params);
 
-	int Status = GSL_SUCCESS;
-	Boolean_t IsOk = TRUE;
-
-	// 	vec3 TmpVec(pos);
-	vec3 TmpVec = pos;
-
-	/*
-	*	Check that current position is in system bounds
-	*/
-	for (int i = 0; i < 3; ++i){
-		if (TmpVec[i] < ODE_Data->VolZoneInfo.MinXYZ[i] || TmpVec[i] > ODE_Data->VolZoneInfo.MaxXYZ[i]){
-			TmpVec[i] = MIN(ODE_Data->VolZoneInfo.MaxXYZ[i], MAX(TmpVec[i], ODE_Data->VolZoneInfo.MinXYZ[i]));
-			Status = GSL_EDOM;
-		}
-	}
-
-	IsOk = SetIndexAndWeightsForPoint(TmpVec, ODE_Data->VolZoneInfo);
-
-	/*
-	*	Get gradient values at the actual position
-	*/
-	if (IsOk){
+	return GP_ODE_GradFunctionBody(pos, dydt, ODE_Data, [ODE_Data](vec3 & TmpVec) -> Boolean_t {
+		/*
+		*	Get gradient values at the actual position
+		*/
 		vec3 TmpGrad;
-		if (ODE_Data->HasGrad){
-			for (int i = 0; i < 3; ++i){
-				TmpVec[i] = ValByCurrentIndexAndWeightsFromRawPtr(ODE_Data->VolZoneInfo, ODE_Data->GradPtrs[i]);
-			}
+		if (ODE_Data->NodeCache != NULL && ODE_Data->NodeCache->HasGrad()){
+			ODE_Data->NodeCache->ValsByIndexAndWeights(ODE_Data->Stencil, ODE_Data->NodeCache->GradOffset(), 3, TmpVec.memptr());
+		}
+		else if (ODE_Data->HasGrad){
+			ValsByCurrentIndexAndWeightsFromRawPtrs(ODE_Data->Stencil, ODE_Data->GradPtrs, TmpVec.memptr());
+		}
+		else if (ODE_Data->UseTricubic){
+			double Rho;
+			if (!TricubicValGradHessForPoint(TmpVec, *ODE_Data->VolZoneInfo, ODE_Data->RhoPtr, ODE_Data->TricubicCell, Rho, &TmpGrad))
+				return FALSE;
+			TmpVec = TmpGrad;
 		}
 		else{
-			CalcGradForPoint(TmpVec, ODE_Data->VolZoneInfo.DelXYZ, ODE_Data->VolZoneInfo, ODE_Data->VolZoneInfo.BasisNormalized, 0, ODE_Data->VolZoneInfo.IsPeriodic, TmpGrad, ODE_Data->RhoPtr, GPType_Invalid, NULL);
+			CalcGradForPoint(TmpVec, ODE_Data->VolZoneInfo->DelXYZ, *ODE_Data->VolZoneInfo, ODE_Data->VolZoneInfo->BasisNormalized, 0, ODE_Data->VolZoneInfo->IsPeriodic, TmpGrad, ODE_Data->RhoPtr, GPType_Invalid, NULL);
 			TmpVec = TmpGrad;
 		}
+		return TRUE;
+	});
+} //	int GP_ODE_GradFunction()
 
-		if (ODE_Data->Direction == StreamDir_Reverse)
-			TmpVec *= -1.0;
-
-		TmpVec = normalise(TmpVec);
-
-		for (int i = 0; i < 3; ++i)
-			dydt[i] = TmpVec[i];
-	}
-	else
-		Status = GSL_ESANITY;
-
-	params = reinterpret_cast<void*>(ODE_Data);
+template <typename T>
+int GP_ODE_GradFunctionTyped(double t, const double pos[], double dydt[], void* params)
+{
+	GradPathParams_s *ODE_Data = reinterpret_cast<GradPathParams_s*>(params);
 
-	return Status;
-} //	int GP_ODE_GradFunction()
+	return GP_ODE_GradFunctionBody(pos, dydt, ODE_Data, [ODE_Data](vec3 & TmpVec) -> Boolean_t {
+		const T * GradPtrs[3];
+		for (int i = 0; i < 3; ++i) GradPtrs[i] = ODE_Data->GradPtrs[i].TypedReadPtr<T>();
+		ValsByCurrentIndexAndWeights(ODE_Data->Stencil, GradPtrs, 3, TmpVec.memptr());
+		return TRUE;
+	});
+} //	int GP_ODE_GradFunctionTyped()
 
 
 const double GradPath_c::RhoByCurrentIndexAndWeights(){
-	double Rho = 0;
-	for (int i = 0; i < 8; ++i){
-		Rho += m_ODE_Data.VolZoneInfo.Weights[i] * m_ODE_Data.RhoPtr[m_ODE_Data.VolZoneInfo.Index[i]];
-	}
+	if (m_ODE_Data.NodeCache != NULL && m_ODE_Data.NodeCache->HasRho())
+		return m_ODE_Data.NodeCache->ValByIndexAndWeights(m_ODE_Data.Stencil, m_ODE_Data.NodeCache->RhoOffset());
 
-	return Rho;
+	return ValByCurrentIndexAndWeightsFromRawPtr(m_ODE_Data.Stencil, m_ODE_Data.RhoPtr);
 }
 
 /*
@@ -1606,84 +3448,59 @@ const double GradPath_c::RhoByCurrentIndexAndWeights(){
 */
 
 /*
-*	Function to return the actual function (gradient) value
+*	Gradient and Hessian of rho in the plane through *Origin spanned by
+*	the first two columns of *BasisVectors, at Pos in that plane.
+*	Returns FALSE if the point is outside the volume.
 */
-int F2DGrad(const gsl_vector * pos, void * params, gsl_vector * GradValues){
-	MultiRootParams_s * RootParams = reinterpret_cast<MultiRootParams_s*>(params);
+static const Boolean_t FDF2DGrad(const double (&Pos)[2], MultiRootParams_s & RootParams, double (&Grad)[2], double (&Hess)[2][2]){
+	vec2 TwoPoint;
+	TwoPoint << Pos[0] << Pos[1];
+	vec3 ThreePoint = Transform2dTo3d(TwoPoint, *RootParams.BasisVectors, *RootParams.Origin);
 
-	vec3 ThreePoint = Transform2dTo3d(pos->data, *RootParams->BasisVectors, *RootParams->Origin);
+	if (!SetIndexAndWeightsForPoint(ThreePoint, *RootParams.VolInfo))
+		return FALSE;
 
-	if (!SetIndexAndWeightsForPoint(ThreePoint, *RootParams->VolInfo))
-		return GSL_EDOM;
-
-	vec2 Grad;
+	vec2 G;
 
 	CalcGradForPoint(ThreePoint,
-		RootParams->VolInfo->DelXYZ,
-		*RootParams->VolInfo,
-		*RootParams->BasisVectors,
+		RootParams.VolInfo->DelXYZ,
+		*RootParams.VolInfo,
+		*RootParams.BasisVectors,
 		0,
-		RootParams->IsPeriodic,
-		Grad,
-		*RootParams->RhoPtr,
-		RootParams->CalcType, params);
-
-	for (int i = 0; i < 2; ++i)
-		gsl_vector_set(GradValues, i, Grad[i]);
-
-	return GSL_SUCCESS;
-}
-
-/*
-*	Function to return the derivatives (jacobian matrix of gradient, ie Hessian of rho)
-*/
-int DF2DGrad(const gsl_vector * pos, void * params, gsl_matrix * Jacobian){
-	MultiRootParams_s * RootParams = reinterpret_cast<MultiRootParams_s*>(params);
+		RootParams.IsPeriodic,
+		G,
+		*RootParams.RhoPtr,
+		RootParams.CalcType, &RootParams);
 
-	vec3 ThreePoint = Transform2dTo3d(pos->data, *RootParams->BasisVectors, *RootParams->Origin);
-
-	if (!SetIndexAndWeightsForPoint(ThreePoint, *RootParams->VolInfo))
-		return GSL_EDOM;
+	if (!SetIndexAndWeightsForPoint(ThreePoint, *RootParams.VolInfo))
+		return FALSE;
 
 	mat22 J;
 
 	CalcHessForPoint(ThreePoint,
-		RootParams->VolInfo->DelXYZ,
-		*RootParams->VolInfo,
-		*RootParams->BasisVectors,
-		RootParams->IsPeriodic, J,
-		*RootParams->RhoPtr,
-		RootParams->CalcType, params);
-
-	for (int i = 0; i < 2; ++i)
-	for (int j = 0; j < 2; ++j)
-		gsl_matrix_set(Jacobian, i, j, J.at(i, j));
-
-	return GSL_SUCCESS;
-}
-
-/*
-*	Function to return both grad and dgrad (function and derivatives)
-*/
-int FDF2DGrad(const gsl_vector * pos, void * params, gsl_vector * GradValues, gsl_matrix * Jacobian){
-
-	int Status = F2DGrad(pos, params, GradValues);
-
-	if (Status == GSL_SUCCESS)
-		Status = DF2DGrad(pos, params, Jacobian);
+		RootParams.VolInfo->DelXYZ,
+		*RootParams.VolInfo,
+		*RootParams.BasisVectors,
+		RootParams.IsPeriodic, J,
+		*RootParams.RhoPtr,
+		RootParams.CalcType, &RootParams);
+
+	for (int i = 0; i < 2; ++i){
+		Grad[i] = G[i];
+		for (int j = 0; j < 2; ++j)
+			Hess[i][j] = J.at(i, j);
+	}
 
-	return Status;
+	return TRUE;
 }
 
-const Boolean_t CPInNormalPlane(vec3 & StartPt, const vec3 & PlaneBasis, MultiRootObjects_s & MR){
+const Boolean_t CPInNormalPlane(vec3 & StartPt, const vec3 & PlaneBasis, MultiRootParams_s & Params){
 	Boolean_t IsOk = TRUE;
 
 	vector<vec3> BV(2);
 	int Status = GSL_SUCCESS;
 	int Iter = 0;
 
-	MultiRootParams_s* Params = reinterpret_cast<MultiRootParams_s*>(MR.Func.params);
-
 	/*
 	*	Get the two orthonormal vectors to Dir, the grad path step direction
 	*/
@@ -1713,48 +3530,28 @@ const Boolean_t CPInNormalPlane(vec3 & StartPt, const vec3 & PlaneBasis, MultiRo
 	BV3.col(0) = BV[0];
 	BV3.col(1) = BV[1];
 
-	Params->BasisVectors = &BV3;
-	Params->Origin = &StartPt;
-
-	for (int i = 0; i < 2; ++i)
-		gsl_vector_set(MR.pos, i, 0.0);
-
-	gsl_multiroot_fdfsolver_set(MR.s, &MR.Func, MR.pos);
-
-#ifdef _DEBUG
-	vec3 Pos = StartPt;
-#endif
-	double StepDist = 0.0;
-	do
-	{
-		++Iter;
-
-		Status = gsl_multiroot_fdfsolver_iterate(MR.s);
-
-		if (Status != GSL_CONTINUE && Status != GSL_SUCCESS)
-			break;
-
-#ifdef _DEBUG
-		StepDist = Distance(Pos, (Transform2dTo3d(MR.s->x->data, *Params->BasisVectors, StartPt)));
-		Pos = Transform2dTo3d(MR.s->x->data, *Params->BasisVectors, StartPt);
-#endif // _DEBUG
-
-		Status = gsl_multiroot_test_residual(MR.s->f, 1e-9);
-
-	} while (Status == GSL_CONTINUE && Iter < GP_PlaneCPMaxIter);
+	Params.BasisVectors = &BV3;
+	Params.Origin = &StartPt;
 
+	double x[2] = { 0.0, 0.0 };
 
+	Status = NewtonSolve<2>(x,
+		[&](const double (&Pos)[2], double (&Grad)[2], double (&Hess)[2][2]){ return FDF2DGrad(Pos, Params, Grad, Hess) == TRUE; },
+		[](const double (&Pos)[2]){ return true; },
+		1e-9, GP_PlaneCPMaxIter, Iter);
 
 	if (Status == GSL_SUCCESS){
-		vec3 EndPt = Transform2dTo3d(MR.s->x->data, *Params->BasisVectors, StartPt);
+		vec2 TwoPoint;
+		TwoPoint << x[0] << x[1];
+		vec3 EndPt = Transform2dTo3d(TwoPoint, *Params.BasisVectors, StartPt);
 
-		if (Params->CalcType == GPType_NormalPlaneRhoCP){
+		if (Params.CalcType == GPType_NormalPlaneRhoCP){
 			mat33 EigenVectors;
 			vec3 EigenValues;
 			CalcEigenSystemForPoint(EndPt,
 				EigenValues,
 				EigenVectors,
-				*reinterpret_cast<MultiRootParams_s*>(MR.Func.params));
+				Params);
 			char Rank = 0;
 			for (int i = 0; i < 2; ++i){
 				if (EigenValues[i] > 0)
@@ -1772,7 +3569,95 @@ const Boolean_t CPInNormalPlane(vec3 & StartPt, const vec3 & PlaneBasis, MultiRo
 	else {
 		IsOk = FALSE;
 	}
-	MR.Func.params = reinterpret_cast<void*>(Params);
+
+	return IsOk;
+}
+
+const Boolean_t BenchmarkGradPathIntegrators(const std::shared_ptr<const VolExtentInfo_s> & VolInfo,
+	const FieldDataPointer_c & RhoPtr,
+	const vector<FieldDataPointer_c> & GradPtrs,
+	const int & NumGPs,
+	vector<double> & SeedTimes,
+	vector<int> & NumSteps,
+	vector<double> & MaxEndPointDiff,
+	vector<int> & NumOverTol,
+	const AddOn_pa * AddOnID)
+{
+	REQUIRE(VolInfo != nullptr);
+	REQUIRE(RhoPtr.IsReady());
+	REQUIRE(NumGPs > 0);
+
+	const vector<GPIntegrator_e> Integrators = { GPIntegrator_GSLRK4, GPIntegrator_DormandPrince };
+	const vector<string> IntegratorNames = { "GSL rk4", "Dormand-Prince" };
+
+	/*
+	*	Same seed points for every run. Stay a cell away from the
+	*	edges so non-periodic paths get somewhere.
+	*/
+	vector<vec3> SeedPts(NumGPs);
+	std::mt19937 Generator(0);
+	for (int d = 0; d < 3; ++d){
+		std::uniform_real_distribution<double> Distribution(VolInfo->MinXYZ[d] + VolInfo->DelXYZ[d], VolInfo->MaxXYZ[d] - VolInfo->DelXYZ[d]);
+		for (vec3 & Pt : SeedPts)
+			Pt[d] = Distribution(Generator);
+	}
+
+	SeedTimes.assign(Integrators.size(), 0.0);
+	NumSteps.assign(Integrators.size(), 0);
+	MaxEndPointDiff.assign(Integrators.size(), 0.0);
+	NumOverTol.assign(Integrators.size(), 0);
+
+	/*
+	*	Paths whose reference (GSL rk4) run failed have no end points
+	*	to compare against, so they're left out of the comparison.
+	*/
+	vector<vec3> RefEndPts(NumGPs * 2);
+	vector<bool> HasRefEndPts(NumGPs, false);
+	double EndPointTol = GP_BenchmarkEndPointTol * min(VolInfo->DelXYZ);
+	double RhoCutoff = DefaultRhoCutoff;
+	Boolean_t IsOk = TRUE;
+
+	for (int m = 0; m < Integrators.size() && IsOk; ++m){
+		vector<GradPath_c> GPs(NumGPs);
+		for (int i = 0; i < NumGPs && IsOk; ++i){
+			IsOk = GPs[i].SetupGradPath(SeedPts[i], StreamDir_Both, 100, GPType_Classic, GPTerminate_AtRhoValue, NULL, NULL, NULL, &RhoCutoff, VolInfo, vector<FieldDataPointer_c>(), GradPtrs, RhoPtr);
+			GPs[i].SetIntegrator(Integrators[m]);
+		}
+		if (!IsOk)
+			break;
+
+		if (AddOnID != NULL) StatusLaunch("Seeding gradient paths (" + IntegratorNames[m] + ")...", *AddOnID, FALSE);
+
+		high_resolution_clock::time_point StartTime = high_resolution_clock::now();
+
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+		for (int i = 0; i < NumGPs; ++i){
+			GPs[i].Seed(false);
+		}
+
+		SeedTimes[m] = duration<double>(high_resolution_clock::now() - StartTime).count();
+
+		if (AddOnID != NULL) StatusDrop(*AddOnID);
+
+		for (int i = 0; i < NumGPs; ++i){
+			if (GPs[i].GetCount() <= 0) continue;
+			NumSteps[m] += GPs[i].GetCount();
+			vec3 EndPts[2] = { GPs[i].XYZAt(0), GPs[i].XYZAt(GPs[i].GetCount() - 1) };
+			if (m == 0){
+				for (int e = 0; e < 2; ++e)
+					RefEndPts[2 * i + e] = EndPts[e];
+				HasRefEndPts[i] = true;
+			}
+			else if (HasRefEndPts[i]){
+				double Diff = MAX(norm(EndPts[0] - RefEndPts[2 * i]), norm(EndPts[1] - RefEndPts[2 * i + 1]));
+				MaxEndPointDiff[m] = MAX(MaxEndPointDiff[m], Diff);
+				if (Diff > EndPointTol)
+					NumOverTol[m]++;
+			}
+		}
+	}
 
 	return IsOk;
 }
@@ -1847,36 +3732,62 @@ const Boolean_t NEBGradPath_c::Relax(const double & StepRatio,
 	REQUIRE(StepRatio >= 0.0 && StepRatio <= 1.0);
 	REQUIRE(Tol > 0.0);
 	REQUIRE(MaxIter > 1);
+	REQUIRE(Params.VolInfo != NULL && Params.RhoPtr != NULL);
 
 	Boolean_t IsOk;
 
 	m_GradPathReady = m_GradPathMade = TRUE;
 
-	vector<vec3> OldXYZ;
-	vec3 OldPt;
+	int NumPts = static_cast<int>(m_XYZList.size());
 
-	Params.EquilPos = &OldPt;
+	SetupWorkspaces(omp_get_max_threads(), Params);
+	m_EquilPos.resize(NumPts);
+	m_RhoList.resize(NumPts);
+	m_ClimbIndex = -1;
 
 	double Cost;
 	unsigned int Iter = 0;
 
-	MultiRootObjects_s MR;
-
-	MR.Func = { &F2DGrad, &DF2DGrad, &FDF2DGrad, 2, &Params };
-	MR.pos = gsl_vector_alloc(2);
-	MR.T = gsl_multiroot_fdfsolver_hybridsj;
-	MR.s = gsl_multiroot_fdfsolver_alloc(MR.T, 2);
-
 	do
 	{
 		Iter++;
 
-		OldXYZ = m_XYZList;
+		m_OldXYZ = m_XYZList;
+
+		/*
+		*	A sweep only moves the other sweep's images, so every image's
+		*	equilibrium position can be set before either sweep.
+		*/
+		for (int i = 1; i < NumPts - 1; ++i)
+			m_EquilPos[i] = m_XYZList[i] * StepRatio + m_OldXYZ[i] * (1.0 - StepRatio);
+
+		if (m_ClimbingImage && Iter > m_ClimbStartIter){
+#ifndef _DEBUG
+#pragma omp parallel for
+#endif
+			for (int i = 1; i < NumPts - 1; ++i){
+				vec3 Pt = m_XYZList[i];
+				m_RhoList[i] = ValAtPointByPtr(Pt, m_Workspaces[omp_get_thread_num()].VolInfo, *Params.RhoPtr);
+			}
+			m_ClimbIndex = 1;
+			for (int i = 2; i < NumPts - 1; ++i){
+				if (m_RhoList[i] > m_RhoList[m_ClimbIndex])
+					m_ClimbIndex = i;
+			}
+		}
 
 		for (int Offset = 1; Offset <= 2; ++Offset){
-			for (int i = Offset; i < m_XYZList.size() - 1; i += 2){
-				OldPt = m_XYZList[i] * StepRatio + OldXYZ[i] * (1.0 - StepRatio);
-				IsOk = CPInNormalPlane(m_XYZList[i], (m_XYZList[i + 1] - m_XYZList[i - 1]), MR);
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+			for (int i = Offset; i < NumPts - 1; i += 2){
+				Workspace_s & WS = m_Workspaces[omp_get_thread_num()];
+				if (i == m_ClimbIndex)
+					ClimbImage(i, WS);
+				else{
+					WS.Params.EquilPos = &m_EquilPos[i];
+					CPInNormalPlane(m_XYZList[i], (m_XYZList[i + 1] - m_XYZList[i - 1]), WS.Params);
+				}
 			}
 		}
 
@@ -1886,11 +3797,19 @@ const Boolean_t NEBGradPath_c::Relax(const double & StepRatio,
 
 
 		Cost = 0;
-		for (int i = 1; i < m_XYZList.size() - 1; ++i)
-			Cost += DistSqr(m_XYZList[i], OldXYZ[i]);
+		for (int i = 1; i < NumPts - 1; ++i)
+			Cost += DistSqr(m_XYZList[i], m_OldXYZ[i]);
 
 	} while (Cost > Tol && Iter <= MaxIter);
 
+#ifndef _DEBUG
+#pragma omp parallel for
+#endif
+	for (int i = 0; i < NumPts; ++i){
+		vec3 Pt = m_XYZList[i];
+		m_RhoList[i] = ValAtPointByPtr(Pt, m_Workspaces[omp_get_thread_num()].VolInfo, *Params.RhoPtr);
+	}
+
 #ifdef _DEBUG
 	IsOk = SaveAsOrderedZone("NEB Iteration " + to_string(Iter) + " of " + to_string(MaxIter));
 #endif // _DEBUG
@@ -1898,4 +3817,56 @@ const Boolean_t NEBGradPath_c::Relax(const double & StepRatio,
 	IsOk = (Cost <= Tol && Iter <= MaxIter);
 
 	return IsOk;
+}
+
+/*
+*	Move image i to the rho maximum along the band's tangent (from a
+*	parabola through three points, never more than a quarter of the way
+*	to a neighbour), then let it settle in its normal plane with no spring.
+*/
+void NEBGradPath_c::ClimbImage(const int & i, Workspace_s & WS)
+{
+	vec3 Tangent = m_XYZList[i + 1] - m_XYZList[i - 1];
+	double TangentLen = norm(Tangent);
+	double h = 0.25 * MIN(Distance(m_XYZList[i], m_XYZList[i - 1]), Distance(m_XYZList[i], m_XYZList[i + 1]));
+	if (TangentLen <= 0.0 || h <= 0.0)
+		return;
+	Tangent /= TangentLen;
+
+	double Rho[3];
+	for (int j = 0; j < 3; ++j){
+		vec3 Pt = m_XYZList[i] + Tangent * (h * static_cast<double>(j - 1));
+		Rho[j] = ValAtPointByPtr(Pt, WS.VolInfo, *WS.Params.RhoPtr);
+	}
+
+	double Curvature = Rho[0] - 2.0 * Rho[1] + Rho[2];
+	double t = 0.0;
+	if (Curvature < 0.0)
+		t = MAX(-1.0, MIN(1.0, 0.5 * (Rho[0] - Rho[2]) / Curvature));
+	else if (Rho[2] != Rho[0])
+		t = (Rho[2] > Rho[0] ? 1.0 : -1.0);
+
+	m_XYZList[i] += Tangent * (t * h);
+
+	double KDisp = WS.Params.KDisp;
+	WS.Params.KDisp = 0.0;
+	WS.Params.EquilPos = &m_EquilPos[i];
+	CPInNormalPlane(m_XYZList[i], Tangent, WS.Params);
+	WS.Params.KDisp = KDisp;
+}
+
+/*
+*	The plane basis and origin set by CPInNormalPlane() can't be shared
+*	between threads, and nor can the index and weights in VolInfo, so
+*	each thread gets its own.
+*/
+void NEBGradPath_c::SetupWorkspaces(const int & NumThreads, const MultiRootParams_s & Params)
+{
+	m_Workspaces.resize(NumThreads);
+
+	for (Workspace_s & WS : m_Workspaces){
+		WS.Params = Params;
+		WS.VolInfo = *Params.VolInfo;
+		WS.Params.VolInfo = &WS.VolInfo;
+	}
 }
\ No newline at end of file
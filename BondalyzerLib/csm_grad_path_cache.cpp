@@ -0,0 +1,466 @@
+
+#include "TECADDON.h"
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+
+#include "CSM_DATA_TYPES.h"
+#include "CSM_FIELD_DATA_POINTER.h"
+#include "CSM_VOL_EXTENT_INDEX_WEIGHTS.h"
+#include "CSM_NODE_RECORD_CACHE.h"
+#include "CSM_CRIT_POINTS.h"
+#include "CSM_GRAD_PATH.h"
+#include "CSM_GRAD_PATH_CACHE.h"
+
+#include <armadillo>
+using namespace arma;
+
+using std::vector;
+using std::string;
+using std::ifstream;
+using std::ofstream;
+using std::ios;
+
+/*
+*	Bump GPCache_Version whenever a change to path seeding changes the
+*	paths it makes, so old cache files are no longer used.
+*/
+static const char GPCache_Magic[8] = { 'C', 'S', 'M', 'G', 'P', 'C', '0', '1' };
+static const int GPCache_Version = 3;
+static const size_t GPCache_HeaderSize = sizeof(GPCache_Magic) + sizeof(uint64_t);
+/*
+*	Record: seed XYZ, start and end CP numbers, number of points and
+*	padding, then NumPoints each of X, Y, Z and rho.
+*/
+static const size_t GPCache_RecordHeaderSize = 3 * sizeof(double) + 4 * sizeof(int32_t);
+
+static const uint64_t SeedHash(const vec3 & SeedPt){
+	CacheHash_c Hash;
+	Hash.Add(SeedPt);
+	return Hash.Value();
+}
+
+
+/*
+*	CacheHash_c methods
+*/
+
+void CacheHash_c::Add(const void * Data, const size_t & NumBytes){
+	const char * Bytes = reinterpret_cast<const char*>(Data);
+	const uint64_t Mult = 0x9e3779b97f4a7c15ULL;
+	uint64_t Hash = m_Hash;
+
+	size_t NumWords = NumBytes / sizeof(uint64_t);
+	for (size_t i = 0; i < NumWords; ++i){
+		uint64_t Word;
+		memcpy(&Word, Bytes + i * sizeof(uint64_t), sizeof(uint64_t));
+		Hash = (Hash ^ Word) * Mult;
+		Hash ^= Hash >> 32;
+	}
+	for (size_t i = NumWords * sizeof(uint64_t); i < NumBytes; ++i){
+		Hash = (Hash ^ static_cast<unsigned char>(Bytes[i])) * Mult;
+		Hash ^= Hash >> 32;
+	}
+
+	m_Hash = Hash;
+}
+
+void CacheHash_c::Add(const FieldDataPointer_c & Ptr){
+	Add(Ptr.IsReady());
+	if (!Ptr.IsReady())
+		return;
+
+	Add(static_cast<int>(Ptr.FDType()));
+	Add(Ptr.MaxIJK());
+	Add(Ptr.Size());
+
+	size_t ValSize = 0;
+	switch (Ptr.FDType()){
+		case FieldDataType_Double: ValSize = sizeof(double_t); break;
+		case FieldDataType_Float: ValSize = sizeof(float_t); break;
+		case FieldDataType_Int32: ValSize = sizeof(Int32_t); break;
+		case FieldDataType_Int16: ValSize = sizeof(Int16_t); break;
+		case FieldDataType_Byte: ValSize = sizeof(Byte_t); break;
+		default: break;
+	}
+
+	if (Ptr.VoidPtr() != NULL && ValSize > 0){
+		Add(Ptr.VoidPtr(), ValSize * Ptr.Size());
+	}
+	else{
+		for (unsigned int i = 0; i < Ptr.Size(); ++i)
+			Add(Ptr[i]);
+	}
+}
+
+
+/*
+*	GradPathCache_c methods
+*/
+
+const Boolean_t GradPathCache_c::Open(const string & CacheDir, const GradPath_c & SetupGP){
+	Close();
+
+	if (CacheDir.empty() || !SetupGP.IsReady())
+		return FALSE;
+
+	m_Key = SettingsKey(SetupGP);
+
+	std::stringstream ss;
+	ss << std::hex << std::setw(16) << std::setfill('0') << m_Key;
+	char LastChar = CacheDir[CacheDir.size() - 1];
+	m_FileName = CacheDir + ((LastChar == '/' || LastChar == '\\') ? "" : "/") + ss.str() + GPCache_FileExtension;
+
+	/*
+	*	Read the whole file, then keep the header and every whole record.
+	*/
+	m_FileIsGood = FALSE;
+	ifstream In(m_FileName.c_str(), ios::in | ios::binary | ios::ate);
+	if (In.is_open()){
+		std::streamoff FileSize = In.tellg();
+		if (FileSize >= static_cast<std::streamoff>(GPCache_HeaderSize)){
+			m_Data.resize(static_cast<size_t>(FileSize));
+			In.seekg(0, ios::beg);
+			In.read(m_Data.data(), FileSize);
+			if (!In.good())
+				m_Data.clear();
+		}
+		In.close();
+	}
+
+	uint64_t FileKey = 0;
+	if (m_Data.size() >= GPCache_HeaderSize)
+		memcpy(&FileKey, m_Data.data() + sizeof(GPCache_Magic), sizeof(uint64_t));
+
+	if (m_Data.size() >= GPCache_HeaderSize
+		&& memcmp(m_Data.data(), GPCache_Magic, sizeof(GPCache_Magic)) == 0
+		&& FileKey == m_Key)
+	{
+		m_FileIsGood = TRUE;
+		size_t Offset = GPCache_HeaderSize;
+		while (Offset < m_Data.size()){
+			if (Offset + GPCache_RecordHeaderSize > m_Data.size()){
+				m_FileIsGood = FALSE;
+				break;
+			}
+			int32_t Count;
+			memcpy(&Count, m_Data.data() + Offset + 3 * sizeof(double) + 2 * sizeof(int32_t), sizeof(int32_t));
+			size_t RecordSize = GPCache_RecordHeaderSize + 4 * sizeof(double) * static_cast<size_t>(MAX(Count, 0));
+			if (Count < 0 || Offset + RecordSize > m_Data.size()){
+				m_FileIsGood = FALSE;
+				break;
+			}
+
+			vec3 SeedPt;
+			memcpy(SeedPt.memptr(), m_Data.data() + Offset, 3 * sizeof(double));
+			m_Index.insert(std::make_pair(SeedHash(SeedPt), Offset));
+
+			Offset += RecordSize;
+		}
+		m_Data.resize(Offset);
+	}
+	else{
+		m_Data.clear();
+	}
+
+	m_IsOpen = TRUE;
+
+	return TRUE;
+}
+
+void GradPathCache_c::Close(){
+	if (m_IsOpen)
+		Flush();
+
+	m_IsOpen = FALSE;
+	m_FileIsGood = FALSE;
+	m_FileName.clear();
+	m_Key = 0;
+	vector<char>().swap(m_Data);
+	vector<char>().swap(m_NewData);
+	m_Index.clear();
+}
+
+const size_t GradPathCache_c::FindRecord(const vec3 & SeedPt) const{
+	if (!m_IsOpen)
+		return 0;
+
+	auto Range = m_Index.equal_range(SeedHash(SeedPt));
+	for (auto it = Range.first; it != Range.second; ++it){
+		double RecSeed[3];
+		memcpy(RecSeed, m_Data.data() + it->second, 3 * sizeof(double));
+		if (RecSeed[0] == SeedPt[0] && RecSeed[1] == SeedPt[1] && RecSeed[2] == SeedPt[2])
+			return it->second;
+	}
+
+	return 0;
+}
+
+const Boolean_t GradPathCache_c::Find(const vec3 & SeedPt, GradPathSet_c & GPs, const int & PathNum) const{
+	REQUIRE(PathNum >= 0 && PathNum < GPs.NumPaths());
+
+	size_t Offset = FindRecord(SeedPt);
+	if (Offset == 0)
+		return FALSE;
+
+	const char * Rec = m_Data.data() + Offset;
+	int32_t Ints[3];
+	memcpy(Ints, Rec + 3 * sizeof(double), 3 * sizeof(int32_t));
+	int Count = Ints[2];
+	if (Count > GPs.m_MaxCount[PathNum])
+		return FALSE;
+
+	const char * Vals = Rec + GPCache_RecordHeaderSize;
+	size_t ArrSize = Count * sizeof(double);
+	int Beg = GPs.m_Offset[PathNum];
+	if (Count > 0){
+		memcpy(GPs.m_X.data() + Beg, Vals, ArrSize);
+		memcpy(GPs.m_Y.data() + Beg, Vals + ArrSize, ArrSize);
+		memcpy(GPs.m_Z.data() + Beg, Vals + 2 * ArrSize, ArrSize);
+		memcpy(GPs.m_Rho.data() + Beg, Vals + 3 * ArrSize, ArrSize);
+	}
+	GPs.m_Count[PathNum] = Count;
+	for (int i = 0; i < 2; ++i)
+		GPs.m_StartEndCPNum[2 * PathNum + i] = Ints[i];
+
+	return TRUE;
+}
+
+const Boolean_t GradPathCache_c::Find(const vec3 & SeedPt, GradPathBase_c & GP) const{
+	size_t Offset = FindRecord(SeedPt);
+	if (Offset == 0)
+		return FALSE;
+
+	const char * Rec = m_Data.data() + Offset;
+	int32_t Ints[3];
+	memcpy(Ints, Rec + 3 * sizeof(double), 3 * sizeof(int32_t));
+	int Count = Ints[2];
+
+	const char * Vals = Rec + GPCache_RecordHeaderSize;
+	size_t ArrSize = Count * sizeof(double);
+	GP.m_XYZList.resize(Count);
+	GP.m_RhoList.resize(Count);
+	for (int i = 0; i < Count; ++i){
+		double Val[4];
+		for (int j = 0; j < 4; ++j)
+			memcpy(&Val[j], Vals + j * ArrSize + i * sizeof(double), sizeof(double));
+		GP.m_XYZList[i] = vec3({ Val[0], Val[1], Val[2] });
+		GP.m_RhoList[i] = Val[3];
+	}
+	for (int i = 0; i < 2; ++i)
+		GP.m_StartEndCPNum[i] = Ints[i];
+	GP.m_NumGPPoints = Count;
+	GP.m_Length = -1;
+	GP.m_GradPathMade = (Count > 0);
+
+	return TRUE;
+}
+
+void GradPathCache_c::Add(const vec3 & SeedPt, const GradPathSet_c & GPs, const int & PathNum){
+	REQUIRE(PathNum >= 0 && PathNum < GPs.NumPaths());
+
+	int Beg = GPs.m_Offset[PathNum];
+	AddRecord(SeedPt, &GPs.m_StartEndCPNum[2 * PathNum], GPs.m_Count[PathNum],
+		GPs.m_X.data() + Beg, GPs.m_Y.data() + Beg, GPs.m_Z.data() + Beg, GPs.m_Rho.data() + Beg);
+}
+
+void GradPathCache_c::Add(const vec3 & SeedPt, const GradPathBase_c & GP){
+	int Count = (GP.IsMade() ? GP.GetCount() : 0);
+	vector<double> X(Count), Y(Count), Z(Count);
+	for (int i = 0; i < Count; ++i){
+		X[i] = GP.m_XYZList[i][0];
+		Y[i] = GP.m_XYZList[i][1];
+		Z[i] = GP.m_XYZList[i][2];
+	}
+	AddRecord(SeedPt, GP.m_StartEndCPNum, Count, X.data(), Y.data(), Z.data(), GP.m_RhoList.data());
+}
+
+void GradPathCache_c::AddRecord(const vec3 & SeedPt,
+	const int StartEndCPNum[2],
+	const int & Count,
+	const double * X, const double * Y, const double * Z, const double * Rho)
+{
+	if (!m_IsOpen)
+		return;
+
+	size_t ArrSize = Count * sizeof(double);
+	vector<char> Rec(GPCache_RecordHeaderSize + 4 * ArrSize);
+	int32_t Ints[4] = { StartEndCPNum[0], StartEndCPNum[1], Count, 0 };
+	memcpy(Rec.data(), SeedPt.memptr(), 3 * sizeof(double));
+	memcpy(Rec.data() + 3 * sizeof(double), Ints, 4 * sizeof(int32_t));
+	if (Count > 0){
+		char * Vals = Rec.data() + GPCache_RecordHeaderSize;
+		memcpy(Vals, X, ArrSize);
+		memcpy(Vals + ArrSize, Y, ArrSize);
+		memcpy(Vals + 2 * ArrSize, Z, ArrSize);
+		memcpy(Vals + 3 * ArrSize, Rho, ArrSize);
+	}
+
+#pragma omp critical(GradPathCacheAdd)
+	m_NewData.insert(m_NewData.end(), Rec.begin(), Rec.end());
+}
+
+const Boolean_t GradPathCache_c::Flush(){
+	if (!m_IsOpen || m_NewData.empty())
+		return m_IsOpen;
+
+	/*
+	*	Append to a good file, otherwise write it over with
+	*	what was good of it.
+	*/
+	Boolean_t IsOk = TRUE;
+	if (m_Data.empty()){
+		m_Data.resize(GPCache_HeaderSize);
+		memcpy(m_Data.data(), GPCache_Magic, sizeof(GPCache_Magic));
+		memcpy(m_Data.data() + sizeof(GPCache_Magic), &m_Key, sizeof(uint64_t));
+		m_FileIsGood = FALSE;
+	}
+
+	ofstream Out;
+	if (m_FileIsGood){
+		Out.open(m_FileName.c_str(), ios::out | ios::binary | ios::app);
+	}
+	else{
+		Out.open(m_FileName.c_str(), ios::out | ios::binary | ios::trunc);
+		if (Out.is_open())
+			Out.write(m_Data.data(), m_Data.size());
+	}
+	IsOk = Out.is_open();
+	if (IsOk){
+		Out.write(m_NewData.data(), m_NewData.size());
+		IsOk = Out.good();
+		Out.close();
+	}
+	m_FileIsGood = IsOk;
+
+	/*
+	*	Keep the new paths findable.
+	*/
+	size_t Offset = m_Data.size();
+	m_Data.insert(m_Data.end(), m_NewData.begin(), m_NewData.end());
+	while (Offset < m_Data.size()){
+		vec3 SeedPt;
+		int32_t Count;
+		memcpy(SeedPt.memptr(), m_Data.data() + Offset, 3 * sizeof(double));
+		memcpy(&Count, m_Data.data() + Offset + 3 * sizeof(double) + 2 * sizeof(int32_t), sizeof(int32_t));
+		m_Index.insert(std::make_pair(SeedHash(SeedPt), Offset));
+		Offset += GPCache_RecordHeaderSize + 4 * sizeof(double) * static_cast<size_t>(Count);
+	}
+	m_NewData.clear();
+
+	return IsOk;
+}
+
+/*
+*	Hash of the volume data and grid the path reads.
+*	Rehashing gigabytes of data for every sphere would cost more than
+*	it saves, so the hash is reused while the data pointers are the same.
+*/
+const uint64_t GradPathCache_c::VolumeKey(const GradPath_c & SetupGP){
+	const GradPathParams_s & ODE = SetupGP.m_ODE_Data;
+
+	vector<const FieldDataPointer_c*> Ptrs;
+	Ptrs.push_back(&ODE.RhoPtr);
+	if (ODE.HasGrad){
+		for (const FieldDataPointer_c & Ptr : ODE.GradPtrs)
+			Ptrs.push_back(&Ptr);
+	}
+	if (ODE.HasHess){
+		for (const FieldDataPointer_c & Ptr : ODE.HessPtrs)
+			Ptrs.push_back(&Ptr);
+	}
+
+	vector<const void*> KeyPtrs;
+	vector<unsigned int> KeySizes;
+	for (const FieldDataPointer_c * Ptr : Ptrs){
+		KeyPtrs.push_back(Ptr->VoidPtr());
+		KeySizes.push_back(Ptr->Size());
+	}
+
+	Boolean_t CanReuse = (m_VolKey != 0 && KeyPtrs == m_VolKeyPtrs && KeySizes == m_VolKeySizes);
+	for (const void * Ptr : KeyPtrs)
+		CanReuse = (CanReuse && Ptr != NULL);
+
+	if (!CanReuse){
+		CacheHash_c Hash;
+		Hash.Add(static_cast<int>(Ptrs.size()));
+		for (const FieldDataPointer_c * Ptr : Ptrs)
+			Hash.Add(*Ptr);
+
+		m_VolKey = Hash.Value();
+		m_VolKeyPtrs = KeyPtrs;
+		m_VolKeySizes = KeySizes;
+	}
+
+	return m_VolKey;
+}
+
+/*
+*	Hash of everything but the seed point that decides the path.
+*/
+const uint64_t GradPathCache_c::SettingsKey(const GradPath_c & SetupGP) const{
+	const GradPathParams_s & ODE = SetupGP.m_ODE_Data;
+
+	CacheHash_c Hash;
+	Hash.Add(GPCache_Version);
+	Hash.Add(const_cast<GradPathCache_c*>(this)->VolumeKey(SetupGP));
+
+	const VolExtentInfo_s & Vol = *ODE.VolZoneInfo;
+	Hash.Add(Vol.MaxIJK);
+	Hash.Add(Vol.MinXYZ);
+	Hash.Add(Vol.MaxXYZ);
+	Hash.Add(Vol.BasisVectors);
+	Hash.Add(Vol.IsPeriodic);
+
+	Hash.Add(static_cast<int>(SetupGP.m_GPType));
+	if (SetupGP.m_GPType != GPType_Classic)
+		Hash.Add(SetupGP.m_DirMixFactor);
+	Hash.Add(static_cast<int>(ODE.Direction));
+	Hash.Add(SetupGP.m_NumGPPoints);
+
+	Hash.Add(static_cast<int>(ODE.Integrator));
+	Hash.Add(ODE.AbsTol);
+	Hash.Add(ODE.RelTol);
+	Hash.Add(ODE.HasGrad);
+	Hash.Add(ODE.HasHess);
+	Hash.Add(ODE.UseTricubic);
+	Hash.Add(ODE.NodeCache != NULL && ODE.NodeCache->IsSinglePrecision());
+
+	Hash.Add(GP_MaxNumPoints);
+	Hash.Add(GP_StallPointCount);
+	Hash.Add(GP_StallNumPointsToCheck);
+	Hash.Add(GP_StallPointDistTol);
+	Hash.Add(GP_StallWindow);
+	Hash.Add(GP_LoopDispRatio);
+	Hash.Add(GP_LoopTurnAngle);
+
+	/*
+	*	Paths stop at m_TermValue (if it's set) whatever HowTerminate is,
+	*	so it's always part of the key.
+	*/
+	GPTerminate_e HowTerminate = SetupGP.m_HowTerminate;
+	Hash.Add(static_cast<int>(HowTerminate));
+	Hash.Add(SetupGP.m_TermValue);
+	if (HowTerminate == GPTerminate_AtPoint || HowTerminate == GPTerminate_AtPointRadius){
+		Hash.Add(SetupGP.m_TermPoint);
+		Hash.Add(SetupGP.m_TermPointRadiusSqr);
+	}
+	else if (HowTerminate == GPTerminate_AtCP || HowTerminate == GPTerminate_AtCPRadius){
+		Hash.Add(SetupGP.m_TermPointRadiusSqr);
+		if (SetupGP.m_CPs != NULL){
+			Hash.Add(SetupGP.m_CPs->NumCPs());
+			for (int i = 0; i < SetupGP.m_CPs->NumCPs(); ++i)
+				Hash.Add(SetupGP.m_CPs->GetXYZ(i));
+		}
+		else{
+			for (const FieldDataPointer_c & Ptr : SetupGP.m_CPXYZPtrs)
+				Hash.Add(Ptr);
+		}
+	}
+
+	return Hash.Value();
+}
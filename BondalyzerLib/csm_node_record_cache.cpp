@@ -0,0 +1,359 @@
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <random>
+#include <chrono>
+#include <memory>
+
+#include <omp.h>
+
+#include "TECADDON.h"
+#include "CSM_DATA_SET_INFO.h"
+#include "CSM_FIELD_DATA_POINTER.h"
+#include "CSM_GRAD_PATH.h"
+#include "CSM_NODE_RECORD_CACHE.h"
+
+#include <armadillo>
+
+using std::vector;
+using std::string;
+using std::to_string;
+using std::chrono::high_resolution_clock;
+using std::chrono::duration;
+
+using namespace arma;
+
+/*
+*	Copy one variable into its slot of every record.
+*/
+template <typename T, typename TOut>
+void PackVarIntoRecords(const T * Ptr, const NodeRecordCache_c & Cache, const int & Offset, TOut * Data)
+{
+	int NumNodesInt = static_cast<int>(Cache.NumNodes());
+	int Stride = Cache.NumVars();
+#ifndef _DEBUG
+#pragma omp parallel for
+#endif
+	for (int n = 0; n < NumNodesInt; ++n){
+		Data[Cache.RecordIndex(n) * Stride + Offset] = static_cast<TOut>(Ptr[n]);
+	}
+}
+
+/*
+*	Size Buffer for NumVals values, over-allocating so the first record
+*	can start on a cache line, then pack every variable of Ptrs into it.
+*	Returns the aligned start of the records in Data.
+*/
+template <typename TOut>
+const Boolean_t PackVarsIntoBuffer(const vector<FieldDataPointer_c> & Ptrs,
+	const NodeRecordCache_c & Cache,
+	const size_t & NumVals,
+	vector<TOut> & Buffer,
+	TOut *& Data)
+{
+	Boolean_t IsOk = TRUE;
+
+	int Pad = NodeRecordCache_Alignment / sizeof(TOut);
+	Buffer.resize(NumVals + Pad);
+	uintptr_t Addr = reinterpret_cast<uintptr_t>(Buffer.data());
+	Addr = (Addr + NodeRecordCache_Alignment - 1) & ~static_cast<uintptr_t>(NodeRecordCache_Alignment - 1);
+	Data = reinterpret_cast<TOut*>(Addr);
+
+	for (int v = 0; v < Ptrs.size() && IsOk; ++v){
+		switch (Ptrs[v].FDType()){
+			case FieldDataType_Double:
+				PackVarIntoRecords(Ptrs[v].TypedReadPtr<double_t>(), Cache, v, Data);
+				break;
+			case FieldDataType_Float:
+				PackVarIntoRecords(Ptrs[v].TypedReadPtr<float_t>(), Cache, v, Data);
+				break;
+			case FieldDataType_Int32:
+				PackVarIntoRecords(Ptrs[v].TypedReadPtr<Int32_t>(), Cache, v, Data);
+				break;
+			case FieldDataType_Int16:
+				PackVarIntoRecords(Ptrs[v].TypedReadPtr<Int16_t>(), Cache, v, Data);
+				break;
+			case FieldDataType_Byte:
+				PackVarIntoRecords(Ptrs[v].TypedReadPtr<Byte_t>(), Cache, v, Data);
+				break;
+			case FieldDataType_Bit:
+				PackVarIntoRecords(Ptrs[v].TypedReadPtr<bool>(), Cache, v, Data);
+				break;
+			default:
+				IsOk = FALSE;
+				break;
+		}
+	}
+
+	return IsOk;
+}
+
+/*
+*	Spread the bits of Val so that bit b lands on bit 3b + Axis.
+*/
+static const size_t MortonSpreadBits(unsigned int Val, const int & Axis)
+{
+	size_t Out = 0;
+	for (int b = 0; Val > 0; ++b, Val >>= 1){
+		if (Val & 1u)
+			Out |= static_cast<size_t>(1) << (3 * b + Axis);
+	}
+	return Out;
+}
+
+/*
+*	Fill the per-axis offset tables for the layout and return
+*	the number of records needed (including padding).
+*	Bricked and Morton both split the grid into tiles stored one after
+*	another in IJK order; they differ only in the order of the nodes
+*	within a tile (IJK vs. Z-order). Tiles are small, so padding is
+*	at most one partial tile per axis.
+*/
+const size_t NodeRecordCache_c::SetupLayout(const vector<int> & MaxIJK, const NodeRecordLayout_e & Layout)
+{
+	m_Layout = Layout;
+	for (int d = 0; d < 3; ++d){
+		m_MaxIJK[d] = static_cast<unsigned int>(MaxIJK[d]);
+		vector<size_t>().swap(m_AxisOffsets[d]);
+	}
+	m_NumNodesIJ = m_MaxIJK[0] * m_MaxIJK[1];
+
+	size_t NumRecords = static_cast<size_t>(m_NumNodesIJ) * m_MaxIJK[2];
+
+	if (m_Layout == NodeRecordLayout_Bricked || m_Layout == NodeRecordLayout_Morton){
+		const unsigned int B = (m_Layout == NodeRecordLayout_Bricked ? NodeRecordCache_BrickDim : NodeRecordCache_MortonTileDim);
+		unsigned int NumTiles[3];
+		for (int d = 0; d < 3; ++d)
+			NumTiles[d] = (m_MaxIJK[d] + B - 1) / B;
+
+		size_t InTileStride[3] = { 1, B, B * B },
+			TileStride[3];
+		TileStride[0] = B * B * B;
+		TileStride[1] = TileStride[0] * NumTiles[0];
+		TileStride[2] = TileStride[1] * NumTiles[1];
+
+		for (int d = 0; d < 3; ++d){
+			m_AxisOffsets[d].resize(m_MaxIJK[d]);
+			for (unsigned int i = 0; i < m_MaxIJK[d]; ++i){
+				m_AxisOffsets[d][i] = (i / B) * TileStride[d];
+				if (m_Layout == NodeRecordLayout_Bricked)
+					m_AxisOffsets[d][i] += (i % B) * InTileStride[d];
+				else
+					m_AxisOffsets[d][i] += MortonSpreadBits(i % B, d);
+			}
+		}
+
+		NumRecords = TileStride[2] * NumTiles[2];
+	}
+
+	return NumRecords;
+}
+
+const Boolean_t NodeRecordCache_c::Build(const vector<FieldDataPointer_c> & Ptrs,
+	const AddOn_pa * AddOnID,
+	const NodeRecordLayout_e & Layout,
+	const Boolean_t & SinglePrecision)
+{
+	Clear();
+
+	Boolean_t IsOk = (Ptrs.size() > 0 && Ptrs.size() <= VolInfo_MaxGatherVars);
+	for (int v = 0; v < Ptrs.size() && IsOk; ++v){
+		IsOk = (Ptrs[v].IsReady()
+			&& Ptrs[v].ValueLocation() == ValueLocation_Nodal
+			&& Ptrs[v].Size() == Ptrs[0].Size());
+	}
+
+	if (!IsOk) return IsOk;
+
+	m_NumVars = static_cast<int>(Ptrs.size());
+	m_NumNodes = Ptrs[0].Size();
+
+	/*
+	*	Bricks and Morton order only make sense for an ordered IJK zone;
+	*	anything else gets the linear layout.
+	*/
+	vector<int> MaxIJK = Ptrs[0].MaxIJK();
+	NodeRecordLayout_e ActualLayout = Layout;
+	if (Ptrs[0].ZoneType() != ZoneType_Ordered
+		|| static_cast<size_t>(MaxIJK[0]) * MaxIJK[1] * MaxIJK[2] != m_NumNodes)
+	{
+		ActualLayout = NodeRecordLayout_Linear;
+		MaxIJK = { static_cast<int>(m_NumNodes), 1, 1 };
+	}
+	size_t NumRecords = SetupLayout(MaxIJK, ActualLayout);
+
+	/*
+	*	Don't double the memory footprint of very large zones;
+	*	callers fall back to the per-variable pointers.
+	*/
+	IsOk = (static_cast<double>(NumRecords) * m_NumVars * (SinglePrecision ? sizeof(float) : sizeof(double)) <= NodeRecordCache_MaxNumBytes);
+	if (!IsOk){
+		Clear();
+		return IsOk;
+	}
+
+	if (AddOnID != NULL) StatusLaunch("Caching node data...", *AddOnID, FALSE);
+
+	/*
+	*	Only one of m_Data and m_DataFlt is set; lookups branch on that.
+	*/
+	if (SinglePrecision)
+		IsOk = PackVarsIntoBuffer(Ptrs, *this, NumRecords * m_NumVars, m_BufferFlt, m_DataFlt);
+	else
+		IsOk = PackVarsIntoBuffer(Ptrs, *this, NumRecords * m_NumVars, m_Buffer, m_Data);
+
+	if (AddOnID != NULL) StatusDrop(*AddOnID);
+
+	m_IsReady = IsOk;
+	if (!IsOk) Clear();
+
+	return IsOk;
+}
+
+const Boolean_t NodeRecordCache_c::Build(const FieldDataPointer_c & RhoPtr,
+	const vector<FieldDataPointer_c> & GradPtrs,
+	const vector<FieldDataPointer_c> & HessPtrs,
+	const AddOn_pa * AddOnID,
+	const NodeRecordLayout_e & Layout,
+	const Boolean_t & SinglePrecision)
+{
+	vector<FieldDataPointer_c> Ptrs;
+	Ptrs.reserve(10);
+
+	Ptrs.push_back(RhoPtr);
+	int GradOffset = -1, HessOffset = -1;
+	if (GradPtrs.size() == 3){
+		GradOffset = static_cast<int>(Ptrs.size());
+		Ptrs.insert(Ptrs.end(), GradPtrs.begin(), GradPtrs.end());
+	}
+	if (HessPtrs.size() == 6){
+		HessOffset = static_cast<int>(Ptrs.size());
+		Ptrs.insert(Ptrs.end(), HessPtrs.begin(), HessPtrs.end());
+	}
+
+	Boolean_t IsOk = Build(Ptrs, AddOnID, Layout, SinglePrecision);
+
+	if (IsOk){
+		m_RhoOffset = 0;
+		m_GradOffset = GradOffset;
+		m_HessOffset = HessOffset;
+	}
+
+	return IsOk;
+}
+
+void NodeRecordCache_c::Clear()
+{
+	vector<double>().swap(m_Buffer);
+	m_Data = NULL;
+	vector<float>().swap(m_BufferFlt);
+	m_DataFlt = NULL;
+	m_NumVars = 0;
+	m_NumNodes = 0;
+	m_RhoOffset = m_GradOffset = m_HessOffset = -1;
+	m_Layout = NodeRecordLayout_Linear;
+	m_NumNodesIJ = 0;
+	for (int d = 0; d < 3; ++d)
+		vector<size_t>().swap(m_AxisOffsets[d]);
+	m_IsReady = FALSE;
+}
+
+const Boolean_t BenchmarkNodeRecordLayouts(const std::shared_ptr<const VolExtentInfo_s> & VolInfo,
+	const FieldDataPointer_c & RhoPtr,
+	const vector<FieldDataPointer_c> & GradPtrs,
+	const int & NumGPs,
+	vector<double> & SeedTimes,
+	vector<double> & MaxEndPointDiff,
+	const AddOn_pa * AddOnID)
+{
+	REQUIRE(VolInfo != nullptr);
+	REQUIRE(RhoPtr.IsReady());
+	REQUIRE(GradPtrs.size() == 3);
+	REQUIRE(NumGPs > 0);
+
+	const vector<NodeRecordLayout_e> Layouts = {
+		NodeRecordLayout_Invalid,
+		NodeRecordLayout_Linear,
+		NodeRecordLayout_Bricked,
+		NodeRecordLayout_Morton
+	};
+	const vector<string> LayoutNames = { "no cache", "linear", "bricked", "Morton" };
+
+	/*
+	*	Same seed points for every run. Stay a cell away from the
+	*	edges so non-periodic paths get somewhere.
+	*/
+	vector<vec3> SeedPts(NumGPs);
+	std::mt19937 Generator(0);
+	for (int d = 0; d < 3; ++d){
+		std::uniform_real_distribution<double> Distribution(VolInfo->MinXYZ[d] + VolInfo->DelXYZ[d], VolInfo->MaxXYZ[d] - VolInfo->DelXYZ[d]);
+		for (vec3 & Pt : SeedPts)
+			Pt[d] = Distribution(Generator);
+	}
+
+	SeedTimes.assign(Layouts.size(), 0.0);
+	MaxEndPointDiff.assign(Layouts.size(), 0.0);
+
+	/*
+	*	Paths whose reference (uncached) run failed have no end points
+	*	to compare against, so they're left out of the comparison.
+	*/
+	vector<vec3> RefEndPts(NumGPs * 2);
+	vector<bool> HasRefEndPts(NumGPs, false);
+	double RhoCutoff = DefaultRhoCutoff;
+	Boolean_t IsOk = TRUE;
+
+	for (int l = 0; l < Layouts.size() && IsOk; ++l){
+		/*
+		*	A layout that can't be built (e.g. over the size cap) is
+		*	skipped and reported with negative time and difference.
+		*/
+		NodeRecordCache_c NodeCache;
+		if (Layouts[l] != NodeRecordLayout_Invalid){
+			if (!NodeCache.Build(RhoPtr, GradPtrs, vector<FieldDataPointer_c>(), AddOnID, Layouts[l])
+				|| NodeCache.Layout() != Layouts[l])
+			{
+				SeedTimes[l] = MaxEndPointDiff[l] = -1.0;
+				continue;
+			}
+		}
+
+		if (AddOnID != NULL) StatusLaunch("Seeding gradient paths (" + LayoutNames[l] + ")...", *AddOnID, FALSE);
+
+		vector<GradPath_c> GPs(NumGPs);
+		for (int i = 0; i < NumGPs && IsOk; ++i){
+			IsOk = GPs[i].SetupGradPath(SeedPts[i], StreamDir_Both, 100, GPType_Classic, GPTerminate_AtRhoValue, NULL, NULL, NULL, &RhoCutoff, VolInfo, vector<FieldDataPointer_c>(), GradPtrs, RhoPtr);
+			if (NodeCache.IsReady())
+				GPs[i].SetNodeCache(&NodeCache);
+		}
+
+		high_resolution_clock::time_point StartTime = high_resolution_clock::now();
+
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+		for (int i = 0; i < NumGPs; ++i){
+			GPs[i].Seed(false);
+		}
+
+		SeedTimes[l] = duration<double>(high_resolution_clock::now() - StartTime).count();
+
+		if (AddOnID != NULL) StatusDrop(*AddOnID);
+
+		for (int i = 0; i < NumGPs; ++i){
+			if (GPs[i].GetCount() <= 0) continue;
+			vec3 EndPts[2] = { GPs[i].XYZAt(0), GPs[i].XYZAt(GPs[i].GetCount() - 1) };
+			if (l == 0){
+				for (int e = 0; e < 2; ++e)
+					RefEndPts[2 * i + e] = EndPts[e];
+				HasRefEndPts[i] = true;
+			}
+			else if (HasRefEndPts[i]){
+				for (int e = 0; e < 2; ++e)
+					MaxEndPointDiff[l] = MAX(MaxEndPointDiff[l], norm(EndPts[e] - RefEndPts[2 * i + e]));
+			}
+		}
+	}
+
+	return IsOk;
+}
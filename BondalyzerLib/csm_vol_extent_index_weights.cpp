@@ -8,9 +8,11 @@
 #include <omp.h>
 
 //#include <gsl/gsl_math.h>
+#ifndef CSM_NO_GSL
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_matrix.h>
 #include <gsl/gsl_eigen.h>
+#endif
 
 #include "TECADDON.h"
 #include "CSM_DATA_TYPES.h"
@@ -27,30 +29,8 @@ using std::to_string;
 using std::stringstream;
 
 
-VolExtentIndexWeights_s & VolExtentIndexWeights_s::operator = (const VolExtentIndexWeights_s & rhs){
-	if (this == &rhs)
-		return *this;
-
-	MaxIJK = rhs.MaxIJK;
-	MaxXYZ = rhs.MaxXYZ;
-	MinXYZ = rhs.MinXYZ;
-	DelXYZ = rhs.DelXYZ;
-	BasisVectors = rhs.BasisVectors;
-	BasisNormalized = rhs.BasisNormalized;
-	BasisInverse = rhs.BasisInverse;
-	BasisExtent = rhs.BasisExtent;
-	IsPeriodic = rhs.IsPeriodic;
-	AddOnID = rhs.AddOnID;
-
-	for (int i = 0; i < 8; ++i){
-		Index[i] = rhs.Index[i];
-		Weights[i] = rhs.Weights[i];
-	}
-
-	return *this;
-}
-const Boolean_t VolExtentIndexWeights_s::operator == (const VolExtentIndexWeights_s & rhs) const{
-	Boolean_t AreEqual = (
+const Boolean_t VolExtentInfo_s::operator == (const VolExtentInfo_s & rhs) const{
+	return (
 		MaxIJK == rhs.MaxIJK &&
 		sum(MaxXYZ == rhs.MaxXYZ) == 3 &&
 		sum(MinXYZ == rhs.MinXYZ) == 3 &&
@@ -60,25 +40,69 @@ const Boolean_t VolExtentIndexWeights_s::operator == (const VolExtentIndexWeight
 		sum(sum(BasisNormalized == rhs.BasisNormalized)) == 9 &&
 		sum(sum(BasisInverse == rhs.BasisInverse)) == 9 &&
 		IsPeriodic == rhs.IsPeriodic &&
+		GridType == rhs.GridType &&
 		AddOnID == rhs.AddOnID
 		);
+}
 
-	if (AreEqual){
-		for (int i = 0; i < 8 && AreEqual; ++i){
-			AreEqual = (
-				Index[i] == rhs.Index[i] &&
-				Weights[i] == rhs.Weights[i]
-				);
+/*
+*	Classify the lattice from BasisVectors (columns are the lattice
+*	vectors) so point location can skip the matrix product.
+*/
+void VolExtentInfo_s::SetGridType()
+{
+	GridType = VolGridType_General;
+
+	double MaxBasis = abs(BasisVectors).max();
+	if (MaxBasis <= 0.0)
+		return;
+
+	for (int i = 0; i < 3; ++i){
+		for (int j = 0; j < 3; ++j){
+			if (i != j && std::abs(BasisVectors(i, j)) > VolInfo_OrthogonalTol * MaxBasis)
+				return;
 		}
+		if (BasisVectors(i, i) <= 0.0 || MaxIJK[i] < 2)
+			return;
 	}
 
-	return AreEqual;
+	for (int i = 0; i < 3; ++i)
+		IJKPerXYZ[i] = static_cast<double>(MaxIJK[i] - 1) / BasisVectors(i, i);
+
+	GridType = VolGridType_Orthogonal;
+	if (std::abs(IJKPerXYZ[1] - IJKPerXYZ[0]) <= VolInfo_OrthogonalTol * IJKPerXYZ[0]
+		&& std::abs(IJKPerXYZ[2] - IJKPerXYZ[0]) <= VolInfo_OrthogonalTol * IJKPerXYZ[0])
+	{
+		GridType = VolGridType_Cubic;
+	}
+}
+
+const Boolean_t IndexWeights_s::operator == (const IndexWeights_s & rhs) const{
+	for (int i = 0; i < 8; ++i){
+		if (Index[i] != rhs.Index[i] || Weights[i] != rhs.Weights[i])
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+VolExtentIndexWeights_s & VolExtentIndexWeights_s::operator = (const VolExtentIndexWeights_s & rhs){
+	if (this == &rhs)
+		return *this;
+
+	VolExtentInfo_s::operator=(rhs);
+	IndexWeights_s::operator=(rhs);
+
+	return *this;
+}
+const Boolean_t VolExtentIndexWeights_s::operator == (const VolExtentIndexWeights_s & rhs) const{
+	return (VolExtentInfo_s::operator==(rhs) && IndexWeights_s::operator==(rhs));
 }
 
 const Boolean_t GetVolInfo(const int & VolZoneNum,
 	const vector<int> & XYZVarNums,
 	const Boolean_t & IsPeriodic,
-	VolExtentIndexWeights_s & VolInfo)
+	VolExtentInfo_s & VolInfo)
 {
 	TecUtilZoneGetIJK(VolZoneNum, &VolInfo.MaxIJK[0], &VolInfo.MaxIJK[1], &VolInfo.MaxIJK[2]);
 	for (int i = 0; i < 3; ++i) REQUIRE(VolInfo.MaxIJK[i] >= 3); // if less than 3 points, can't do numerical gradients (if necessary)
@@ -89,39 +113,138 @@ const Boolean_t GetVolInfo(const int & VolZoneNum,
 	VolInfo.BasisInverse = mat33(VolInfo.BasisVectors.i());
 	VolInfo.BasisNormalized = mat33(normalise(VolInfo.BasisVectors));
 	VolInfo.IsPeriodic = IsPeriodic;
+	VolInfo.SetGridType();
 
 	return TRUE;
 }
 
-const Boolean_t SetIndexAndWeightsForPoint(vec3 Point, VolExtentIndexWeights_s & VolZoneInfo)
+const Boolean_t GetVolInfo(const vector<int> & MaxIJK,
+	const vec3 & Origin,
+	const mat33 & BasisVectors,
+	const Boolean_t & IsPeriodic,
+	VolExtentInfo_s & VolInfo)
 {
+	REQUIRE(MaxIJK.size() == 3);
+	for (int i = 0; i < 3; ++i) REQUIRE(MaxIJK[i] >= 3);
+
+	VolInfo.MaxIJK = MaxIJK;
+	VolInfo.BasisVectors = BasisVectors;
+	for (int i = 0; i < 3; ++i)
+		VolInfo.BasisExtent[i] = norm(BasisVectors.col(i));
 
-	Boolean_t IsOk = TRUE;
 	/*
-	*	Transform the point into the UVW coordinate system
+	*	Point location is relative to MinXYZ, so it has to be the first
+	*	node; MaxXYZ is the opposite corner of the grid.
 	*/
-	Point = VolZoneInfo.BasisInverse * (Point - VolZoneInfo.MinXYZ);
+	VolInfo.MinXYZ = Origin;
+	VolInfo.MaxXYZ = Origin + sum(BasisVectors, 1);
 
-	if (VolZoneInfo.IsPeriodic){
+	/*
+	*	Distance between the first node and node (2,2,2), as
+	*	GetDelXYZ_Ordered3DZone() does for Tecplot zones.
+	*/
+	VolInfo.DelXYZ.zeros();
+	for (int i = 0; i < 3; ++i)
+		VolInfo.DelXYZ += BasisVectors.col(i) / static_cast<double>(MaxIJK[i] - 1);
+	VolInfo.DelXYZ = abs(VolInfo.DelXYZ);
+
+	VolInfo.BasisInverse = mat33(VolInfo.BasisVectors.i());
+	VolInfo.BasisNormalized = mat33(normalise(VolInfo.BasisVectors));
+	VolInfo.IsPeriodic = IsPeriodic;
+	VolInfo.SetGridType();
+
+	return TRUE;
+}
+
+const mat33 PeriodicLatticeVectors(const VolExtentInfo_s & VolInfo)
+{
+	mat33 LatticeVectors = VolInfo.BasisVectors;
+	for (int i = 0; i < 3; ++i)
+		LatticeVectors.col(i) *= static_cast<double>(VolInfo.MaxIJK[i]) / static_cast<double>(VolInfo.MaxIJK[i] - 1);
+	return LatticeVectors;
+}
+
+const Boolean_t SetIndexAndWeightsForPoint(vec3 Point, VolExtentIndexWeights_s & VolZoneInfo)
+{
+	return GetIndexAndWeightsForPoint(Point, VolZoneInfo, VolZoneInfo);
+}
+
+/*
+*	Node-space coordinates of Point, i.e. 0 at the first node and
+*	MaxIJK - 1 at the last along each axis, wrapped into the zone
+*	for periodic systems and clamped to it otherwise.
+*	General grids need the full BasisInverse product; orthogonal and
+*	cubic grids are a per-axis scale of the offset from MinXYZ.
+*/
+template <VolGridType_e GridType>
+static inline void GridCoordsForPoint(const vec3 & Point, const VolExtentInfo_s & VolZoneInfo, double * Coords)
+{
+	if (GridType == VolGridType_General){
+		/*
+		*	Transform the point into the UVW coordinate system
+		*/
+		vec3 UVW = VolZoneInfo.BasisInverse * (Point - VolZoneInfo.MinXYZ);
 		for (int i = 0; i < 3; ++i){
-			if (Point[i] < 0.){
-				Point[i] += 1.;
+			if (VolZoneInfo.IsPeriodic){
+				if (UVW[i] < 0.) UVW[i] += 1.;
+				else if (UVW[i] > 1.) UVW[i] -= 1.;
 			}
-			else if (Point[i] > 1.){
-				Point[i] -= 1.;
+			else if (UVW[i] < 0. || UVW[i] > 1.){
+				/*
+				*	Keep current position in system bounds
+				*/
+				UVW[i] = MIN(1., MAX(UVW[i], 0.));
 			}
+			Coords[i] = static_cast<double>(VolZoneInfo.MaxIJK[i] - 1) * UVW[i];
 		}
 	}
 	else{
-		/*
-		*	Check that current position is in system bounds
-		*/
 		for (int i = 0; i < 3; ++i){
-			if (Point[i] < 0. || Point[i] > 1.){
-				Point[i] = MIN(1., MAX(Point[i], 0.));
+			double Scale = (GridType == VolGridType_Cubic ? VolZoneInfo.IJKPerXYZ[0] : VolZoneInfo.IJKPerXYZ[i]);
+			double Extent = static_cast<double>(VolZoneInfo.MaxIJK[i] - 1);
+			Coords[i] = (Point[i] - VolZoneInfo.MinXYZ[i]) * Scale;
+			if (VolZoneInfo.IsPeriodic){
+				if (Coords[i] < 0.) Coords[i] += Extent;
+				else if (Coords[i] > Extent) Coords[i] -= Extent;
+			}
+			else if (Coords[i] < 0. || Coords[i] > Extent){
+				Coords[i] = MIN(Extent, MAX(Coords[i], 0.));
 			}
 		}
 	}
+}
+
+void GetGridCoordsForPoint(const vec3 & Point, const VolExtentInfo_s & VolZoneInfo, double * Coords)
+{
+	switch (VolZoneInfo.GridType){
+		case VolGridType_Orthogonal:
+			GridCoordsForPoint<VolGridType_Orthogonal>(Point, VolZoneInfo, Coords);
+			break;
+		case VolGridType_Cubic:
+			GridCoordsForPoint<VolGridType_Cubic>(Point, VolZoneInfo, Coords);
+			break;
+		default:
+			GridCoordsForPoint<VolGridType_General>(Point, VolZoneInfo, Coords);
+			break;
+	}
+}
+
+/*
+*	Find the cell containing Point and fill Stencil with
+*	the cell's node indices and trilinear weights.
+*	VolInfo isn't modified, so it can be shared between threads.
+*	GetIndexAndWeightsForPoint() picks the instantiation for the grid
+*	type; kernels that locate many points on one grid can call the
+*	specialized version directly.
+*/
+template <VolGridType_e GridType>
+const Boolean_t GetIndexAndWeightsForPointOnGrid(const vec3 & Point, const VolExtentInfo_s & VolZoneInfo, IndexWeights_s & Stencil)
+{
+
+	Boolean_t IsOk = TRUE;
+
+	double Coords[3];
+	GridCoordsForPoint<GridType>(Point, VolZoneInfo, Coords);
 
 	/*
 	* FE Brick and ZoneType_Ordered Data:
@@ -148,7 +271,7 @@ const Boolean_t SetIndexAndWeightsForPoint(vec3 Point, VolExtentIndexWeights_s &
 		LgIndex_t IJK[3];
 		for (int i = 0; i < 3; ++i){
 // 			double TempCoord = 1.0 + static_cast<double>(VolZoneInfo.MaxIJK[i] - 1.0) * (Point[i] - VolZoneInfo.MinUVW[i]) / (VolZoneInfo.BasisExtent[i]);
-			double TempCoord = 1.0 + static_cast<double>(VolZoneInfo.MaxIJK[i] - 1) * Point[i];
+			double TempCoord = 1.0 + Coords[i];
 			IJK[i] = MAX(MIN(static_cast<LgIndex_t>(TempCoord), VolZoneInfo.MaxIJK[i] - 1), 1);
 			RST[i] = 2.0 * (TempCoord - static_cast<double>(IJK[i])) - 1.0;
 
@@ -157,14 +280,14 @@ const Boolean_t SetIndexAndWeightsForPoint(vec3 Point, VolExtentIndexWeights_s &
 				break;
 			}
 		}
-		VolZoneInfo.Index[0] = IndexFromIJK(IJK[0], IJK[1], IJK[2], VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
-		VolZoneInfo.Index[1] = IndexFromIJK(IJK[0] + 1, IJK[1], IJK[2], VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
-		VolZoneInfo.Index[2] = IndexFromIJK(IJK[0] + 1, IJK[1] + 1, IJK[2], VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
-		VolZoneInfo.Index[3] = IndexFromIJK(IJK[0], IJK[1] + 1, IJK[2], VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
-		VolZoneInfo.Index[4] = IndexFromIJK(IJK[0], IJK[1], IJK[2] + 1, VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
-		VolZoneInfo.Index[5] = IndexFromIJK(IJK[0] + 1, IJK[1], IJK[2] + 1, VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
-		VolZoneInfo.Index[6] = IndexFromIJK(IJK[0] + 1, IJK[1] + 1, IJK[2] + 1, VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
-		VolZoneInfo.Index[7] = IndexFromIJK(IJK[0], IJK[1] + 1, IJK[2] + 1, VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
+		Stencil.Index[0] = IndexFromIJK(IJK[0], IJK[1], IJK[2], VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
+		Stencil.Index[1] = IndexFromIJK(IJK[0] + 1, IJK[1], IJK[2], VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
+		Stencil.Index[2] = IndexFromIJK(IJK[0] + 1, IJK[1] + 1, IJK[2], VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
+		Stencil.Index[3] = IndexFromIJK(IJK[0], IJK[1] + 1, IJK[2], VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
+		Stencil.Index[4] = IndexFromIJK(IJK[0], IJK[1], IJK[2] + 1, VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
+		Stencil.Index[5] = IndexFromIJK(IJK[0] + 1, IJK[1], IJK[2] + 1, VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
+		Stencil.Index[6] = IndexFromIJK(IJK[0] + 1, IJK[1] + 1, IJK[2] + 1, VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
+		Stencil.Index[7] = IndexFromIJK(IJK[0], IJK[1] + 1, IJK[2] + 1, VolZoneInfo.MaxIJK[0], VolZoneInfo.MaxIJK[1]) - 1;
 	}
 
 	/*
@@ -187,22 +310,38 @@ const Boolean_t SetIndexAndWeightsForPoint(vec3 Point, VolExtentIndexWeights_s &
 			}
 		}
 		if (IsOk){
-			VolZoneInfo.Weights[0] = 0.125 * OneMinusRST[0] * OneMinusRST[1] * OneMinusRST[2];
-			VolZoneInfo.Weights[1] = 0.125 * OnePlusRST[0] * OneMinusRST[1] * OneMinusRST[2];
-			VolZoneInfo.Weights[2] = 0.125 * OnePlusRST[0] * OnePlusRST[1] * OneMinusRST[2];
-			VolZoneInfo.Weights[3] = 0.125 * OneMinusRST[0] * OnePlusRST[1] * OneMinusRST[2];
-			VolZoneInfo.Weights[4] = 0.125 * OneMinusRST[0] * OneMinusRST[1] * OnePlusRST[2];
-			VolZoneInfo.Weights[5] = 0.125 * OnePlusRST[0] * OneMinusRST[1] * OnePlusRST[2];
-			VolZoneInfo.Weights[6] = 0.125 * OnePlusRST[0] * OnePlusRST[1] * OnePlusRST[2];
-			VolZoneInfo.Weights[7] = 0.125 * OneMinusRST[0] * OnePlusRST[1] * OnePlusRST[2];
+			Stencil.Weights[0] = 0.125 * OneMinusRST[0] * OneMinusRST[1] * OneMinusRST[2];
+			Stencil.Weights[1] = 0.125 * OnePlusRST[0] * OneMinusRST[1] * OneMinusRST[2];
+			Stencil.Weights[2] = 0.125 * OnePlusRST[0] * OnePlusRST[1] * OneMinusRST[2];
+			Stencil.Weights[3] = 0.125 * OneMinusRST[0] * OnePlusRST[1] * OneMinusRST[2];
+			Stencil.Weights[4] = 0.125 * OneMinusRST[0] * OneMinusRST[1] * OnePlusRST[2];
+			Stencil.Weights[5] = 0.125 * OnePlusRST[0] * OneMinusRST[1] * OnePlusRST[2];
+			Stencil.Weights[6] = 0.125 * OnePlusRST[0] * OnePlusRST[1] * OnePlusRST[2];
+			Stencil.Weights[7] = 0.125 * OneMinusRST[0] * OnePlusRST[1] * OnePlusRST[2];
 		}
 	}
 
 
 	return IsOk;
-} //	const Boolean_t SetIndexAndWeightsForPoint() 
+} //	const Boolean_t GetIndexAndWeightsForPointOnGrid() 
 
-const vector<int> GetIJKForPoint(vec3 & Point, VolExtentIndexWeights_s & VolZoneInfo)
+template const Boolean_t GetIndexAndWeightsForPointOnGrid<VolGridType_General>(const vec3 &, const VolExtentInfo_s &, IndexWeights_s &);
+template const Boolean_t GetIndexAndWeightsForPointOnGrid<VolGridType_Orthogonal>(const vec3 &, const VolExtentInfo_s &, IndexWeights_s &);
+template const Boolean_t GetIndexAndWeightsForPointOnGrid<VolGridType_Cubic>(const vec3 &, const VolExtentInfo_s &, IndexWeights_s &);
+
+const Boolean_t GetIndexAndWeightsForPoint(vec3 Point, const VolExtentInfo_s & VolZoneInfo, IndexWeights_s & Stencil)
+{
+	switch (VolZoneInfo.GridType){
+		case VolGridType_Orthogonal:
+			return GetIndexAndWeightsForPointOnGrid<VolGridType_Orthogonal>(Point, VolZoneInfo, Stencil);
+		case VolGridType_Cubic:
+			return GetIndexAndWeightsForPointOnGrid<VolGridType_Cubic>(Point, VolZoneInfo, Stencil);
+		default:
+			return GetIndexAndWeightsForPointOnGrid<VolGridType_General>(Point, VolZoneInfo, Stencil);
+	}
+}
+
+const vector<int> GetIJKForPoint(vec3 & Point, const VolExtentInfo_s & VolZoneInfo)
 {
 	Boolean_t IsOk = TRUE;
 
@@ -330,20 +469,294 @@ void GetCellCornerIndices(const int & CornerNum, int & i, int & j, int & k){
 	}
 }
 
-const double ValByCurrentIndexAndWeightsFromRawPtr(const VolExtentIndexWeights_s & VolZoneInfo, const FieldDataPointer_c & FDPtr)
+const double ValByCurrentIndexAndWeightsFromRawPtr(const IndexWeights_s & Stencil, const FieldDataPointer_c & FDPtr)
+{
+	switch (FDPtr.FDType()){
+		case FieldDataType_Double:
+			return ValByCurrentIndexAndWeights(Stencil, FDPtr.TypedReadPtr<double_t>());
+		case FieldDataType_Float:
+			return ValByCurrentIndexAndWeights(Stencil, FDPtr.TypedReadPtr<float_t>());
+		case FieldDataType_Int32:
+			return ValByCurrentIndexAndWeights(Stencil, FDPtr.TypedReadPtr<Int32_t>());
+		case FieldDataType_Int16:
+			return ValByCurrentIndexAndWeights(Stencil, FDPtr.TypedReadPtr<Int16_t>());
+		case FieldDataType_Byte:
+			return ValByCurrentIndexAndWeights(Stencil, FDPtr.TypedReadPtr<Byte_t>());
+		case FieldDataType_Bit:
+			return ValByCurrentIndexAndWeights(Stencil, FDPtr.TypedReadPtr<bool>());
+		default:
+			return 0.0;
+	}
+}
+
+void ValsByCurrentIndexAndWeightsFromRawPtrs(const IndexWeights_s & Stencil,
+	const FieldDataPointer_c * const * FDPtrs,
+	const int & NumPtrs,
+	double * Vals)
 {
-	double Value = 0.0;
+	REQUIRE(NumPtrs > 0 && NumPtrs <= VolInfo_MaxGatherVars);
 
-	for (int i = 0; i < 8; ++i){
-		//TecUtilDialogMessageBox(string("index " + to_string(VolZoneInfo.Index[i]) + ", weight " + to_string(VolZoneInfo.Weights[i]) + ", pointer good " + to_string(FDPtr.IsReady())).c_str(), MessageBoxType_Information);
-		Value += VolZoneInfo.Weights[i] * static_cast<double>(FDPtr[VolZoneInfo.Index[i]]);
+	FieldDataType_e FDType = FDPtrs[0]->FDType();
+	for (int v = 1; v < NumPtrs && FDType != FieldDataType_Invalid; ++v){
+		if (FDPtrs[v]->FDType() != FDType)
+			FDType = FieldDataType_Invalid;
 	}
 
-	return Value;
+	if (FDType == FieldDataType_Double){
+		const double_t * Ptrs[VolInfo_MaxGatherVars];
+		for (int v = 0; v < NumPtrs; ++v) Ptrs[v] = FDPtrs[v]->TypedReadPtr<double_t>();
+		ValsByCurrentIndexAndWeights(Stencil, Ptrs, NumPtrs, Vals);
+	}
+	else if (FDType == FieldDataType_Float){
+		const float_t * Ptrs[VolInfo_MaxGatherVars];
+		for (int v = 0; v < NumPtrs; ++v) Ptrs[v] = FDPtrs[v]->TypedReadPtr<float_t>();
+		ValsByCurrentIndexAndWeights(Stencil, Ptrs, NumPtrs, Vals);
+	}
+	else{
+		for (int v = 0; v < NumPtrs; ++v)
+			Vals[v] = ValByCurrentIndexAndWeightsFromRawPtr(Stencil, *FDPtrs[v]);
+	}
+}
+
+void ValsByCurrentIndexAndWeightsFromRawPtrs(const IndexWeights_s & Stencil,
+	const vector<FieldDataPointer_c> & FDPtrs,
+	double * Vals)
+{
+	REQUIRE(FDPtrs.size() <= VolInfo_MaxGatherVars);
+
+	const FieldDataPointer_c * Ptrs[VolInfo_MaxGatherVars];
+	int NumPtrs = MIN(static_cast<int>(FDPtrs.size()), VolInfo_MaxGatherVars);
+	for (int v = 0; v < NumPtrs; ++v) Ptrs[v] = &FDPtrs[v];
+
+	ValsByCurrentIndexAndWeightsFromRawPtrs(Stencil, Ptrs, NumPtrs, Vals);
 }
 
 const double ValAtPointByPtr(vec3 & Point, VolExtentIndexWeights_s & VolZoneInfo, const FieldDataPointer_c & FDPtr){
 	if (SetIndexAndWeightsForPoint(Point, VolZoneInfo)){
 		return ValByCurrentIndexAndWeightsFromRawPtr(VolZoneInfo, FDPtr);
 	}
-}
\ No newline at end of file
+}
+
+/*
+*	Catmull-Rom basis: row p gives the coefficient of t^p in terms of
+*	the samples at nodes -1, 0, 1, 2 around the cell.
+*/
+static const double TricubicCRBasis[4][4] = {
+	{ 0.0, 1.0, 0.0, 0.0 },
+	{ -0.5, 0.0, 0.5, 0.0 },
+	{ 1.0, -2.5, 2.0, -0.5 },
+	{ -0.5, 1.5, -1.5, 0.5 }
+};
+
+/*
+*	Sample node indices and basis for one axis of a cell.
+*	Periodic systems wrap around like IndexFromIJK().
+*	Otherwise, samples past the edge are linearly extrapolated
+*	(p[-1] = 2p[0] - p[1]), which is folded into the basis so the
+*	out-of-range node is never read.
+*/
+static void TricubicAxisBasis(const int & CellIJK, const int & MaxIJK, const Boolean_t & IsPeriodic, int Nodes[4], double Basis[4][4])
+{
+	for (int p = 0; p < 4; ++p){
+		for (int n = 0; n < 4; ++n)
+			Basis[p][n] = TricubicCRBasis[p][n];
+	}
+	for (int n = 0; n < 4; ++n)
+		Nodes[n] = CellIJK - 1 + n;
+
+	if (IsPeriodic){
+		for (int n = 0; n < 4; ++n){
+			if (Nodes[n] < 0) Nodes[n] += MaxIJK;
+			else if (Nodes[n] >= MaxIJK) Nodes[n] -= MaxIJK;
+		}
+	}
+	else{
+		if (Nodes[0] < 0){
+			for (int p = 0; p < 4; ++p){
+				Basis[p][1] += 2.0 * Basis[p][0];
+				Basis[p][2] -= Basis[p][0];
+				Basis[p][0] = 0.0;
+			}
+			Nodes[0] = Nodes[1];
+		}
+		if (Nodes[3] >= MaxIJK){
+			for (int p = 0; p < 4; ++p){
+				Basis[p][2] += 2.0 * Basis[p][3];
+				Basis[p][1] -= Basis[p][3];
+				Basis[p][3] = 0.0;
+			}
+			Nodes[3] = Nodes[2];
+		}
+	}
+}
+
+template <typename T>
+void TricubicGatherSamples(const T * Ptr, const int Nodes[3][4], const vector<int> & MaxIJK, double Samples[64])
+{
+	const int MaxIJ = MaxIJK[0] * MaxIJK[1];
+	for (int k = 0; k < 4; ++k){
+		for (int j = 0; j < 4; ++j){
+			const int RowIndex = Nodes[1][j] * MaxIJK[0] + Nodes[2][k] * MaxIJ;
+			for (int i = 0; i < 4; ++i){
+				Samples[i + 4 * (j + 4 * k)] = static_cast<double>(Ptr[RowIndex + Nodes[0][i]]);
+			}
+		}
+	}
+}
+
+/*
+*	Fill Cell with the coefficients for the cell with (0-based)
+*	lower corner CellIJK: Coefs[a + 4 * (b + 4 * c)] multiplies
+*	u^a v^b w^c, with u, v, w in [0,1] across the cell.
+*/
+static const Boolean_t TricubicSetCellCoefs(const int CellIJK[3], const VolExtentInfo_s & VolInfo, const FieldDataPointer_c & FDPtr, TricubicCell_s & Cell)
+{
+	int Nodes[3][4];
+	double Basis[3][4][4];
+	for (int d = 0; d < 3; ++d)
+		TricubicAxisBasis(CellIJK[d], VolInfo.MaxIJK[d], VolInfo.IsPeriodic, Nodes[d], Basis[d]);
+
+	double Samples[64];
+	switch (FDPtr.FDType()){
+		case FieldDataType_Double:
+			TricubicGatherSamples(FDPtr.TypedReadPtr<double_t>(), Nodes, VolInfo.MaxIJK, Samples);
+			break;
+		case FieldDataType_Float:
+			TricubicGatherSamples(FDPtr.TypedReadPtr<float_t>(), Nodes, VolInfo.MaxIJK, Samples);
+			break;
+		case FieldDataType_Int32:
+			TricubicGatherSamples(FDPtr.TypedReadPtr<Int32_t>(), Nodes, VolInfo.MaxIJK, Samples);
+			break;
+		case FieldDataType_Int16:
+			TricubicGatherSamples(FDPtr.TypedReadPtr<Int16_t>(), Nodes, VolInfo.MaxIJK, Samples);
+			break;
+		case FieldDataType_Byte:
+			TricubicGatherSamples(FDPtr.TypedReadPtr<Byte_t>(), Nodes, VolInfo.MaxIJK, Samples);
+			break;
+		case FieldDataType_Bit:
+			TricubicGatherSamples(FDPtr.TypedReadPtr<bool>(), Nodes, VolInfo.MaxIJK, Samples);
+			break;
+		default:
+			Cell.CellIndex = -1;
+			return FALSE;
+	}
+
+	/*
+	*	Apply the basis one axis at a time (64 * 4 * 3 multiplies
+	*	rather than 64 * 64).
+	*/
+	double TmpA[64], TmpB[64];
+	for (int c = 0; c < 4; ++c) for (int b = 0; b < 4; ++b) for (int p = 0; p < 4; ++p){
+		double Sum = 0.0;
+		for (int n = 0; n < 4; ++n) Sum += Basis[0][p][n] * Samples[n + 4 * (b + 4 * c)];
+		TmpA[p + 4 * (b + 4 * c)] = Sum;
+	}
+	for (int c = 0; c < 4; ++c) for (int p = 0; p < 4; ++p) for (int a = 0; a < 4; ++a){
+		double Sum = 0.0;
+		for (int n = 0; n < 4; ++n) Sum += Basis[1][p][n] * TmpA[a + 4 * (n + 4 * c)];
+		TmpB[a + 4 * (p + 4 * c)] = Sum;
+	}
+	for (int p = 0; p < 4; ++p) for (int b = 0; b < 4; ++b) for (int a = 0; a < 4; ++a){
+		double Sum = 0.0;
+		for (int n = 0; n < 4; ++n) Sum += Basis[2][p][n] * TmpB[a + 4 * (b + 4 * n)];
+		Cell.Coefs[a + 4 * (b + 4 * p)] = Sum;
+	}
+
+	Cell.CellIndex = CellIJK[0] + VolInfo.MaxIJK[0] * (CellIJK[1] + VolInfo.MaxIJK[1] * CellIJK[2]);
+	Cell.Source = FDPtr.VoidPtr();
+
+	return TRUE;
+}
+
+const Boolean_t TricubicValGradHessForPoint(vec3 Point,
+	const VolExtentInfo_s & VolInfo,
+	const FieldDataPointer_c & FDPtr,
+	TricubicCell_s & Cell,
+	double & Value,
+	vec3 * Grad,
+	mat33 * Hess)
+{
+	REQUIRE(FDPtr.IsReady());
+
+	/*
+	*	Same cell location and clamping as GetIndexAndWeightsForPoint(),
+	*	but with 0-based IJK and UVW in [0,1] across the cell.
+	*/
+	double Coords[3];
+	GetGridCoordsForPoint(Point, VolInfo, Coords);
+
+	int CellIJK[3];
+	double UVW[3];
+	for (int i = 0; i < 3; ++i){
+		double TempCoord = MIN(static_cast<double>(VolInfo.MaxIJK[i] - 1), MAX(Coords[i], 0.));
+		CellIJK[i] = MAX(MIN(static_cast<int>(TempCoord), VolInfo.MaxIJK[i] - 2), 0);
+		UVW[i] = TempCoord - static_cast<double>(CellIJK[i]);
+	}
+
+	int CellIndex = CellIJK[0] + VolInfo.MaxIJK[0] * (CellIJK[1] + VolInfo.MaxIJK[1] * CellIJK[2]);
+	if (CellIndex != Cell.CellIndex || Cell.Source != FDPtr.VoidPtr()){
+		if (!TricubicSetCellCoefs(CellIJK, VolInfo, FDPtr, Cell))
+			return FALSE;
+	}
+
+	/*
+	*	Powers of u, v, w and their first and second derivatives.
+	*/
+	double P[3][4], dP[3][4], ddP[3][4];
+	for (int d = 0; d < 3; ++d){
+		double t = UVW[d];
+		P[d][0] = 1.0;	P[d][1] = t;	P[d][2] = t * t;	P[d][3] = t * t * t;
+		dP[d][0] = 0.0;	dP[d][1] = 1.0;	dP[d][2] = 2.0 * t;	dP[d][3] = 3.0 * t * t;
+		ddP[d][0] = 0.0;	ddP[d][1] = 0.0;	ddP[d][2] = 2.0;	ddP[d][3] = 6.0 * t;
+	}
+
+	double Val = 0.0, G[3] = { 0.0, 0.0, 0.0 }, H[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+	const Boolean_t DoGrad = (Grad != NULL || Hess != NULL),
+		DoHess = (Hess != NULL);
+	for (int c = 0; c < 4; ++c){
+		for (int b = 0; b < 4; ++b){
+			for (int a = 0; a < 4; ++a){
+				const double Coef = Cell.Coefs[a + 4 * (b + 4 * c)];
+				Val += Coef * P[0][a] * P[1][b] * P[2][c];
+				if (DoGrad){
+					G[0] += Coef * dP[0][a] * P[1][b] * P[2][c];
+					G[1] += Coef * P[0][a] * dP[1][b] * P[2][c];
+					G[2] += Coef * P[0][a] * P[1][b] * dP[2][c];
+				}
+				if (DoHess){
+					H[0] += Coef * ddP[0][a] * P[1][b] * P[2][c];
+					H[1] += Coef * dP[0][a] * dP[1][b] * P[2][c];
+					H[2] += Coef * dP[0][a] * P[1][b] * dP[2][c];
+					H[3] += Coef * P[0][a] * ddP[1][b] * P[2][c];
+					H[4] += Coef * P[0][a] * dP[1][b] * dP[2][c];
+					H[5] += Coef * P[0][a] * P[1][b] * ddP[2][c];
+				}
+			}
+		}
+	}
+
+	Value = Val;
+
+	/*
+	*	Chain rule from cell coordinates to XYZ:
+	*	d(uvw)/d(xyz) = diag(MaxIJK - 1) * BasisInverse.
+	*/
+	if (DoGrad){
+		mat33 Jac = VolInfo.BasisInverse;
+		for (int d = 0; d < 3; ++d)
+			Jac.row(d) *= static_cast<double>(VolInfo.MaxIJK[d] - 1);
+
+		if (Grad != NULL)
+			*Grad = Jac.t() * vec3(G);
+
+		if (DoHess){
+			mat33 HessUVW;
+			HessUVW << H[0] << H[1] << H[2] << endr
+				<< H[1] << H[3] << H[4] << endr
+				<< H[2] << H[4] << H[5];
+			*Hess = Jac.t() * HessUVW * Jac;
+		}
+	}
+
+	return TRUE;
+}
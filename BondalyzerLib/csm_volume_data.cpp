@@ -0,0 +1,389 @@
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <cstdlib>
+#include <cmath>
+
+#include "TECADDON.h"
+#include "CSM_DATA_SET_INFO.h"
+#include "CSM_FIELD_DATA_POINTER.h"
+#include "CSM_VOL_EXTENT_INDEX_WEIGHTS.h"
+#include "CSM_VOLUME_DATA.h"
+
+#include <armadillo>
+
+using std::vector;
+using std::string;
+using std::to_string;
+using std::stringstream;
+using std::ifstream;
+
+using namespace arma;
+
+/*
+*	Same as DataLoader's: true for a non-negative integer.
+*/
+static const Boolean_t IsNumber(const string & s)
+{
+	string::const_iterator it = s.begin();
+	while (it != s.end() && isdigit(*it)) ++it;
+	return (!s.empty() && it == s.end());
+}
+
+/*
+*	Read NumVals whitespace separated numbers from InFile, appending
+*	them to Vals. Returns FALSE if the file ran out first, with Vals
+*	holding whatever was read.
+*	Uses strtod on whole lines, which is much faster than operator>>
+*	for the very large data blocks in volumetric files.
+*/
+static const Boolean_t ReadValues(ifstream & InFile, const size_t & NumVals, vector<double> & Vals)
+{
+	size_t v = Vals.size();
+	const size_t NumTotal = v + NumVals;
+	Vals.resize(NumTotal);
+
+	string Line;
+	while (v < NumTotal && getline(InFile, Line)){
+		const char * Pos = Line.c_str();
+		char * End;
+		while (v < NumTotal){
+			double Val = strtod(Pos, &End);
+			if (End == Pos) break;
+			Vals[v++] = Val;
+			Pos = End;
+		}
+	}
+	Vals.resize(v);
+
+	return (v == NumTotal);
+}
+
+void VolumeData_c::Clear()
+{
+	m_MaxIJK.assign(3, 0);
+	m_Origin.zeros();
+	m_BasisVectors.zeros();
+	m_IsPeriodic = FALSE;
+	m_VarData.clear();
+	m_VarNames.clear();
+	m_AtomicNumbers.clear();
+	m_AtomPositions.clear();
+}
+
+const Boolean_t VolumeData_c::ReadCubeFile(const string & FileName)
+{
+	Clear();
+
+	ifstream CubeFile(FileName);
+	if (!CubeFile.is_open())
+		return FALSE;
+
+	/*
+	*	Header lines 1 and 2 are comments; the first usually says
+	*	what's in the file.
+	*/
+	string H1, H2, TmpStr;
+	getline(CubeFile, H1);
+	getline(CubeFile, H2);
+
+	/*
+	*	Line 3: number of atoms (negative if MOs) and origin.
+	*	There could be an extra value at the end of this line.
+	*/
+	int NumAtoms;
+	CubeFile >> NumAtoms;
+	Boolean_t IsMOFile = (NumAtoms < 0);
+	NumAtoms = abs(NumAtoms);
+	for (int i = 0; i < 3; ++i)
+		CubeFile >> m_Origin[i];
+	getline(CubeFile, TmpStr);
+
+	/*
+	*	Lines 4-6: number of points and step vector along each axis.
+	*	The first axis is the slowest in the file, and becomes I here,
+	*	as in DataLoader.
+	*/
+	mat33 StepVectors;
+	for (int i = 0; i < 3; ++i){
+		CubeFile >> m_MaxIJK[i];
+		m_MaxIJK[i] = abs(m_MaxIJK[i]);
+		for (int j = 0; j < 3; ++j)
+			CubeFile >> StepVectors.at(i, j);
+	}
+
+	for (int i = 0; i < NumAtoms; ++i){
+		int ElemNum;
+		double AtomChg;
+		vec3 AtomPos;
+		CubeFile >> ElemNum >> AtomChg;
+		for (int j = 0; j < 3; ++j)
+			CubeFile >> AtomPos[j];
+		m_AtomicNumbers.push_back(ElemNum);
+		m_AtomPositions.push_back(AtomPos);
+	}
+
+	vector<int> MOList;
+	if (IsMOFile){
+		int NumMOs;
+		CubeFile >> NumMOs;
+		MOList.resize(NumMOs);
+		for (int i = 0; i < NumMOs; ++i)
+			CubeFile >> MOList[i];
+	}
+	getline(CubeFile, TmpStr);
+
+	Boolean_t IsOk = (!CubeFile.fail());
+	for (int i = 0; i < 3 && IsOk; ++i)
+		IsOk = (m_MaxIJK[i] >= 3);
+	if (!IsOk){
+		Clear();
+		return FALSE;
+	}
+
+	for (int i = 0; i < 3; ++i)
+		m_BasisVectors.col(i) = StepVectors.row(i).t() * static_cast<double>(m_MaxIJK[i] - 1);
+
+	/*
+	*	The header gives the number of values per point in MO files.
+	*	Otherwise there's one block of NumNodes values per variable,
+	*	so read blocks until the file runs out; a partial block means
+	*	the file is truncated.
+	*/
+	size_t NumNodes = static_cast<size_t>(m_MaxIJK[0]) * m_MaxIJK[1] * m_MaxIJK[2];
+	int NumFileVars = (IsMOFile ? MAX(1, static_cast<int>(MOList.size())) : 1);
+	vector<double> Vals;
+	Vals.reserve(NumNodes * NumFileVars);
+	IsOk = ReadValues(CubeFile, NumNodes * NumFileVars, Vals);
+	if (IsOk && !IsMOFile){
+		while (ReadValues(CubeFile, NumNodes, Vals))
+			NumFileVars++;
+		IsOk = (Vals.size() == NumNodes * NumFileVars);
+	}
+	CubeFile.close();
+
+	if (!IsOk){
+		Clear();
+		return FALSE;
+	}
+
+	m_VarData.resize(NumFileVars, vector<double>(NumNodes));
+
+	/*
+	*	MO files interleave the values at each point.
+	*	Otherwise each (i,j) record holds one run along k per variable.
+	*/
+	size_t v = 0;
+	for (int i = 0; i < m_MaxIJK[0]; ++i){
+		for (int j = 0; j < m_MaxIJK[1]; ++j){
+			if (IsMOFile){
+				for (int k = 0; k < m_MaxIJK[2]; ++k){
+					size_t Index = IndexFromIJK(i + 1, j + 1, k + 1, m_MaxIJK[0], m_MaxIJK[1]) - 1;
+					for (int iVar = 0; iVar < NumFileVars; ++iVar)
+						m_VarData[iVar][Index] = Vals[v++];
+				}
+			}
+			else{
+				for (int iVar = 0; iVar < NumFileVars; ++iVar){
+					for (int k = 0; k < m_MaxIJK[2]; ++k){
+						size_t Index = IndexFromIJK(i + 1, j + 1, k + 1, m_MaxIJK[0], m_MaxIJK[1]) - 1;
+						m_VarData[iVar][Index] = Vals[v++];
+					}
+				}
+			}
+		}
+	}
+
+	/*
+	*	Names follow DataLoader where the header says what's in the file.
+	*/
+	if (IsMOFile && MOList.size() == NumFileVars){
+		for (const int & MO : MOList)
+			m_VarNames.push_back("MO " + to_string(MO));
+	}
+	else if (NumFileVars == 1 && (H1.find("ensity") != string::npos || H1.find("Title Card Required") != string::npos)){
+		m_VarNames.push_back(CSMVarName.Dens);
+	}
+	else if (NumFileVars == 4 && H1.find("radient") != string::npos){
+		m_VarNames.push_back(CSMVarName.Dens);
+		for (int i = 0; i < 3; ++i)
+			m_VarNames.push_back(CSMVarName.DensGradVec[i]);
+	}
+	else{
+		for (int i = 0; i < NumFileVars; ++i)
+			m_VarNames.push_back("Value " + to_string(i + 1));
+	}
+
+	return TRUE;
+}
+
+const Boolean_t VolumeData_c::ReadCHGCARFile(const string & FileName)
+{
+	Clear();
+
+	ifstream InFile(FileName);
+	if (!InFile.is_open())
+		return FALSE;
+
+	string TmpStr;
+	getline(InFile, TmpStr);
+
+	double LatticeConstant = -1.0;
+	InFile >> LatticeConstant;
+
+	/*
+	*	Rows are the lattice vectors.
+	*/
+	mat33 LatticeVector;
+	for (int i = 0; i < 3; ++i){
+		for (int j = 0; j < 3; ++j){
+			InFile >> LatticeVector.at(i, j);
+			LatticeVector.at(i, j) *= LatticeConstant;
+		}
+	}
+
+	/*
+	*	Optional (VASP 5) line of atom types, then the number of each type.
+	*/
+	vector<int> NumAtomList;
+	InFile >> TmpStr;
+	while (!InFile.fail() && !IsNumber(TmpStr))
+		InFile >> TmpStr;
+	while (!InFile.fail() && IsNumber(TmpStr)){
+		NumAtomList.push_back(stoi(TmpStr));
+		InFile >> TmpStr;
+	}
+
+	/*
+	*	TmpStr is now the coordinate mode ("Direct" or "Cartesian").
+	*	Direct (fractional) coordinates get converted.
+	*/
+	Boolean_t IsDirect = (TmpStr.size() > 0 && (TmpStr[0] == 'D' || TmpStr[0] == 'd'));
+	getline(InFile, TmpStr);
+
+	for (int t = 0; t < NumAtomList.size(); ++t){
+		for (int a = 0; a < NumAtomList[t]; ++a){
+			vec3 Pos;
+			for (int k = 0; k < 3; ++k)
+				InFile >> Pos[k];
+			if (IsDirect)
+				Pos = LatticeVector.t() * Pos;
+			else
+				Pos *= LatticeConstant;
+			m_AtomicNumbers.push_back(t + 1);
+			m_AtomPositions.push_back(Pos);
+		}
+	}
+
+	for (int i = 0; i < 3; ++i)
+		InFile >> m_MaxIJK[i];
+	getline(InFile, TmpStr);
+
+	Boolean_t IsOk = (LatticeConstant > 0.0 && NumAtomList.size() > 0 && !InFile.fail());
+	for (int i = 0; i < 3 && IsOk; ++i)
+		IsOk = (m_MaxIJK[i] >= 3);
+	if (!IsOk){
+		Clear();
+		return FALSE;
+	}
+
+	/*
+	*	Data is X fastest, so it's already in IJK order.
+	*	Values are rho * cell volume.
+	*/
+	size_t NumNodes = static_cast<size_t>(m_MaxIJK[0]) * m_MaxIJK[1] * m_MaxIJK[2];
+	double Volume = std::abs(det(LatticeVector));
+
+	vector<double> Charge;
+	IsOk = ReadValues(InFile, NumNodes, Charge);
+	if (!IsOk){
+		Clear();
+		return FALSE;
+	}
+	for (double & Val : Charge) Val /= Volume;
+
+	/*
+	*	A spin-polarized file has augmentation occupancies and then a
+	*	second grid header (same dimensions) before the spin density.
+	*/
+	vector<double> Diff;
+	string Line;
+	while (getline(InFile, Line)){
+		stringstream ss(Line);
+		int Dims[3];
+		string Extra;
+		if (ss >> Dims[0] >> Dims[1] >> Dims[2] && !(ss >> Extra)
+			&& Dims[0] == m_MaxIJK[0] && Dims[1] == m_MaxIJK[1] && Dims[2] == m_MaxIJK[2])
+		{
+			if (ReadValues(InFile, NumNodes, Diff)){
+				for (double & Val : Diff) Val /= Volume;
+			}
+			else
+				Diff.clear();
+			break;
+		}
+	}
+	InFile.close();
+
+	/*
+	*	Periodic grid: node i is at i / MaxI of the lattice vector,
+	*	so the last node is one step short of the next cell.
+	*/
+	m_Origin.zeros();
+	for (int i = 0; i < 3; ++i)
+		m_BasisVectors.col(i) = LatticeVector.row(i).t() * static_cast<double>(m_MaxIJK[i] - 1) / static_cast<double>(m_MaxIJK[i]);
+	m_IsPeriodic = TRUE;
+
+	if (Diff.size() == NumNodes){
+		vector<double> DensA(NumNodes), DensB(NumNodes);
+		for (size_t i = 0; i < NumNodes; ++i){
+			DensA[i] = 0.5 * (Charge[i] + Diff[i]);
+			DensB[i] = 0.5 * (Charge[i] - Diff[i]);
+		}
+		AddVar(CSMVarName.Dens, Charge);
+		AddVar(CSMVarName.Dens + " A", DensA);
+		AddVar(CSMVarName.Dens + " B", DensB);
+	}
+	else
+		AddVar(CSMVarName.Dens, Charge);
+
+	return TRUE;
+}
+
+const Boolean_t VolumeData_c::AddVar(const string & Name, const vector<double> & Values)
+{
+	Boolean_t IsOk = (Values.size() == NumNodes() && Values.size() > 0);
+	if (IsOk){
+		m_VarNames.push_back(Name);
+		m_VarData.push_back(Values);
+	}
+
+	return IsOk;
+}
+
+const int VolumeData_c::VarIndex(const string & Name) const
+{
+	for (int i = 0; i < m_VarNames.size(); ++i){
+		if (m_VarNames[i] == Name)
+			return i;
+	}
+
+	return -1;
+}
+
+const Boolean_t VolumeData_c::GetReadPtr(const int & VarIndex, FieldDataPointer_c & Ptr) const
+{
+	REQUIRE(VarIndex >= 0 && VarIndex < m_VarData.size());
+
+	return Ptr.GetReadPtr(m_VarData[VarIndex].data(), m_MaxIJK);
+}
+
+const Boolean_t VolumeData_c::GetVolInfo(VolExtentInfo_s & VolInfo) const
+{
+	REQUIRE(IsReady());
+
+	VolInfo.AddOnID = NULL;
+
+	return ::GetVolInfo(m_MaxIJK, m_Origin, m_BasisVectors, m_IsPeriodic, VolInfo);
+}
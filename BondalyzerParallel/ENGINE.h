@@ -63,6 +63,9 @@ void GetClosedIsoSurface(const int & IsoZoneNum, const std::vector<FieldDataPoin
 void MakeSliceFromPointSelectionGetUserInfo();
 
 void GradientPathsOnSphereGetUserInfo();
+void BenchmarkNodeRecordLayoutsGetUserInfo();
+void BenchmarkGradPathIntegratorsGetUserInfo();
+void SinglePrecisionErrorReportGetUserInfo();
 
 void BondalyzerGetUserInfo(BondalyzerCalcType_e CalcType, const vector<GuiField_c> PassthroughFields = vector<GuiField_c>());
 
@@ -77,7 +80,12 @@ const Boolean_t FindCritPoints(const int & VolZoneNum,
 	const vector<int> & GradVarNums,
 	const vector<int> & HessVarNums,
 	const Boolean_t & IsPeriodic,
-	const double & CellSpacing);
+	const double & CellSpacing,
+	const Boolean_t & UseNodeCache = FALSE,
+	const Boolean_t & SinglePrecisionCache = FALSE,
+	const double & RhoCutoff = DefaultRhoCutoff,
+	const vector<double> & RegionStart = vector<double>(),
+	const vector<double> & RegionEnd = vector<double>());
 
 void DeleteCPsGetUserInfo();
 void ExtractCPsGetUserInfo();
@@ -19,6 +19,7 @@
 #include <cstdlib>
 #include <algorithm>
 #include <cmath>
+#include <cfloat>
 
 #include <omp.h>
 
@@ -45,6 +46,7 @@
 #include "CSM_CALC_VARS.h"
 #include "CSM_GRAD_PATH.h"
 #include "CSM_FE_VOLUME.h"
+#include "CSM_NODE_RECORD_CACHE.h"
 #include "CSM_GUI.h"
 #include "CSM_GEOMETRY.h"
 
@@ -77,7 +79,7 @@ struct MinFuncParams_GPLengthInPlane{
 	CritPoints_c * CPs = NULL;
 	double * TermPointRadius = NULL;
 	double * TermValue = NULL;
-	VolExtentIndexWeights_s * VolInfo = NULL;
+	std::shared_ptr<const VolExtentInfo_s> VolInfo;
 	const vector<FieldDataPointer_c> * HessPtrs = NULL;
 	const vector<FieldDataPointer_c> * GradPtrs = NULL;
 	const FieldDataPointer_c * RhoPtr = NULL;
@@ -101,7 +103,7 @@ struct MinFuncParams_GPLengthSpherical{
 	CritPoints_c * CPs = NULL;
 	double * TermPointRadius = NULL;
 	double * TermValue = NULL;
-	VolExtentIndexWeights_s * VolInfo = NULL;
+	std::shared_ptr<const VolExtentInfo_s> VolInfo;
 	const vector<FieldDataPointer_c> * HessPtrs = NULL;
 	const vector<FieldDataPointer_c> * GradPtrs = NULL;
 	const FieldDataPointer_c * RhoPtr = NULL;
@@ -677,8 +679,24 @@ void BondalyzerReturnUserInfo(const bool GuiSuccess,
 	fNum++;
 
 	if (CurrentCalcType == BondalyzerCalcType_CriticalPoints){
-		double CellSpacing = Fields[fNum].GetReturnDouble();
-		FindCritPoints(VolZoneNum, XYZVarNums, RhoVarNum, GradVarNums, HessVarNums, IsPeriodic, CellSpacing);
+		double CellSpacing = Fields[fNum++].GetReturnDouble();
+		Boolean_t UseNodeCache = Fields[fNum++].GetReturnBool();
+		Boolean_t SinglePrecisionCache = Fields[fNum++].GetReturnBool();
+		double RhoCutoff = Fields[fNum++].GetReturnDouble();
+		vector<double> RegionStart, RegionEnd;
+		if (Fields[fNum++].GetReturnBool()){
+			std::istringstream StartStream(Fields[fNum].GetReturnString()), EndStream(Fields[fNum + 1].GetReturnString());
+			double Val;
+			while (StartStream >> Val) RegionStart.push_back(Val);
+			while (EndStream >> Val) RegionEnd.push_back(Val);
+			if (RegionStart.size() != 3 || RegionEnd.size() != 3){
+				TecUtilDialogErrMsg("Search region needs three fractions (I, J, K) each for its start and end. Searching the whole volume.");
+				RegionStart.clear();
+				RegionEnd.clear();
+			}
+		}
+		fNum += 2;
+		FindCritPoints(VolZoneNum, XYZVarNums, RhoVarNum, GradVarNums, HessVarNums, IsPeriodic, CellSpacing, UseNodeCache, SinglePrecisionCache, RhoCutoff, RegionStart, RegionEnd);
 	}
 	else if (CurrentCalcType >= BondalyzerCalcType_BondPaths && CurrentCalcType < BondalyzerCalcType_GBA){
 
@@ -813,6 +831,12 @@ void BondalyzerGetUserInfo(BondalyzerCalcType_e CalcType, const vector<GuiField_
 
 	if (CalcType == BondalyzerCalcType_CriticalPoints){
 		Fields.push_back(GuiField_c(Gui_Double, "CP search grid spacing", to_string(DefaultCellSpacing)));
+		Fields.push_back(GuiField_c(Gui_Toggle, "Node record cache (extra copy of the data)", "0"));
+		Fields.push_back(GuiField_c(Gui_Toggle, "Single precision node cache"));
+		Fields.push_back(GuiField_c(Gui_Double, "Rho cutoff", to_string(DefaultRhoCutoff)));
+		Fields.push_back(GuiField_c(Gui_ToggleEnable, "Search part of the volume", to_string(Fields.size() + 1) + "," + to_string(Fields.size() + 2)));
+		Fields.push_back(GuiField_c(Gui_String, "Region start (I J K fractions)", "0 0 0"));
+		Fields.push_back(GuiField_c(Gui_String, "Region end (I J K fractions)", "1 1 1"));
 	}
 	else if (CalcType >= BondalyzerCalcType_BondPaths && CalcType < BondalyzerCalcType_GBA){
 		if (CalcType >= BondalyzerCalcType_InteratomicSurfaces){
@@ -1270,7 +1294,12 @@ const Boolean_t FindCritPoints(const int & VolZoneNum,
 								const vector<int> & GradVarNums,
 								const vector<int> & HessVarNums,
 								const Boolean_t & IsPeriodic,
-								const double & CellSpacing)
+								const double & CellSpacing,
+								const Boolean_t & UseNodeCache,
+								const Boolean_t & SinglePrecisionCache,
+								const double & InRhoCutoff,
+								const vector<double> & RegionStart,
+								const vector<double> & RegionEnd)
 {
 	TecUtilLockStart(AddOnID);
 
@@ -1281,7 +1310,7 @@ const Boolean_t FindCritPoints(const int & VolZoneNum,
 
 	StatusLaunch("Reading data into memory...", AddOnID, FALSE);
 
-	VolExtentIndexWeights_s VolInfo;
+	VolExtentInfo_s VolInfo;
 	VolInfo.AddOnID = AddOnID;
 
 	if (!GetVolInfo(VolZoneNum, XYZVarNums, IsPeriodic, VolInfo)){
@@ -1302,9 +1331,50 @@ const Boolean_t FindCritPoints(const int & VolZoneNum,
 
 	StatusDrop(AddOnID);
 
-	double RhoCutoff = DefaultRhoCutoff;
+	double RhoCutoff = InRhoCutoff;
+
+	/*
+	*	Search region, given as fractions of the volume along each
+	*	lattice direction, in lattice cells.
+	*/
+	vector<int> StartCell, EndCell;
+	if (RegionStart.size() == 3 && RegionEnd.size() == 3){
+		StartCell.resize(3);
+		EndCell.resize(3);
+		for (int d = 0; d < 3; ++d){
+			int NumCells = VolInfo.BasisExtent[d] / CellSpacing;
+			StartCell[d] = static_cast<int>(floor(MIN(MAX(RegionStart[d], 0.0), 1.0) * NumCells));
+			EndCell[d] = static_cast<int>(ceil(MIN(MAX(RegionEnd[d], 0.0), 1.0) * NumCells));
+		}
+	}
+
+	/*
+	*	Interleaved rho/grad/Hessian records for the cell searches.
+	*	Only if the user asked for it, since it's a second copy of the data.
+	*	Not fatal if it can't be built; FindCPs falls back to the pointers.
+	*	The single precision cache halves the memory traffic of the search
+	*	at the cost of the (small) errors reported by
+	*	"Single precision error report".
+	*/
+	NodeRecordCache_c NodeCache;
+	if (UseNodeCache)
+		NodeCache.Build(RhoPtr, GradPtrs, HessPtrs, NULL, NodeRecordLayout_Linear, SinglePrecisionCache);
+
+	/*
+	*	Kept between runs, so finding CPs again in the same volume with
+	*	the same settings (and the same or a higher rho cutoff) only
+	*	searches what wasn't searched before.
+	*/
+	static CPSearchCache_c CPSearchCache;
 
-	if (FindCPs(VolCPs, VolInfo, CellSpacing, RhoCutoff, IsPeriodic, RhoPtr, GradPtrs, HessPtrs)){
+	if (CPSearchCache.FindCPs(VolCPs, VolInfo, CellSpacing, RhoCutoff, IsPeriodic, RhoPtr, GradPtrs, HessPtrs, NodeCache.IsReady() ? &NodeCache : NULL, StartCell, EndCell)){
+		/*
+		*	If the CPs don't add up, look again at a finer spacing
+		*	where some seem to be missing.
+		*	Only for the whole volume, since part of it needn't add up.
+		*/
+		if (StartCell.empty())
+			CheckCPTopology(VolCPs, VolInfo, CellSpacing, RhoCutoff, IsPeriodic, RhoPtr, GradPtrs, HessPtrs, NodeCache.IsReady() ? &NodeCache : NULL);
 		VolCPs.SaveAsOrderedZone(XYZVarNums, RhoVarNum, TRUE);
 	}
 
@@ -1415,6 +1485,12 @@ const Boolean_t FindBondRingLines(const int & VolZoneNum,
 		return FALSE;
 	}
 
+	/*
+	*	Every gradient path below shares this one descriptor of the
+	*	grid and keeps only its own interpolation stencil.
+	*/
+	std::shared_ptr<const VolExtentInfo_s> VolInfoPtr = std::make_shared<const VolExtentInfo_s>(VolInfo);
+
 	vector<int> iJunk(2);
 	int NumCPs;
 	string CPZoneCheckString;
@@ -1490,7 +1566,7 @@ const Boolean_t FindBondRingLines(const int & VolZoneNum,
 		for (int d = -1; d < 2; d += 2){
 			StartPoint = AllCPs.GetXYZ(TypeInd, CPInd) + AllCPs.GetPrincDir(TypeInd, CPInd) * StartPointOffset * static_cast<double>(d);
 
-			GPs.push_back(GradPath_c(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr));
+			GPs.push_back(GradPath_c(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr));
 			GPs.back().SetStartEndCPNum(AllCPs.GetTotOffsetFromTypeNumOffset(TypeInd, CPInd), 0);
 
 		}
@@ -1635,7 +1711,7 @@ double MinFunc_GPLength_Spherical(const gsl_vector * ThetaPhi, void * params){
 		GPParams->CPs,
 		GPParams->TermPointRadius,
 		GPParams->TermValue,
-		*GPParams->VolInfo,
+		GPParams->VolInfo,
 		*GPParams->HessPtrs,
 		*GPParams->GradPtrs,
 		*GPParams->RhoPtr);
@@ -1707,6 +1783,12 @@ const Boolean_t FindCageNuclearPaths(const int & VolZoneNum,
 		return FALSE;
 	}
 
+	/*
+	*	Every gradient path below shares this one descriptor of the
+	*	grid and keeps only its own interpolation stencil.
+	*/
+	std::shared_ptr<const VolExtentInfo_s> VolInfoPtr = std::make_shared<const VolExtentInfo_s>(VolInfo);
+
 	vector<int> iJunk(2);
 	int NumCPs;
 	string CPZoneCheckString;
@@ -1780,7 +1862,7 @@ const Boolean_t FindCageNuclearPaths(const int & VolZoneNum,
 
 		for (vec3 & Pt : SeedPoints){
 			Pt += AllCPs.GetXYZ(TypeInd, SelectedCPNums[iCP] - 1);
-			GPs.push_back(GradPath_c(Pt, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr));
+			GPs.push_back(GradPath_c(Pt, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr));
 			GPs.back().SetStartEndCPNum(AllCPs.GetTotOffsetFromTypeNumOffset(TypeInd, SelectedCPNums[iCP] - 1), 0);
 		}
 
@@ -1837,7 +1919,7 @@ const Boolean_t FindCageNuclearPaths(const int & VolZoneNum,
 			GPParams.CPs = &AllCPs;
 			GPParams.TermPointRadius = &TermRadius;
 			GPParams.TermValue = &RhoCutoff;
-			GPParams.VolInfo = &VolInfo;
+			GPParams.VolInfo = VolInfoPtr;
 			GPParams.HessPtrs = &HessPtrs;
 			GPParams.GradPtrs = &GradPtrs;
 			GPParams.RhoPtr = &RhoPtr;
@@ -2040,6 +2122,12 @@ const Boolean_t GradientPathsOnSphere(const int & NumSphereGPs,
 		return FALSE;
 	}
 
+	/*
+	*	Every gradient path below shares this one descriptor of the
+	*	grid and keeps only its own interpolation stencil.
+	*/
+	std::shared_ptr<const VolExtentInfo_s> VolInfoPtr = std::make_shared<const VolExtentInfo_s>(VolInfo);
+
 	vector<int> iJunk(2);
 	int NumCPs;
 	string CPZoneCheckString;
@@ -2110,7 +2198,7 @@ const Boolean_t GradientPathsOnSphere(const int & NumSphereGPs,
 
 		for (vec3 & Pt : SeedPoints){
 			Pt += AllCPs.GetXYZ(CPTypeIndOffset[0], CPTypeIndOffset[1]);
-			GPs.push_back(GradPath_c(Pt, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr));
+			GPs.push_back(GradPath_c(Pt, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr));
 			GPs.back().SetStartEndCPNum(AllCPs.GetTotOffsetFromTypeNumOffset(CPTypeIndOffset[0], CPTypeIndOffset[1]), (CPTypeIndOffset[0] == 0 ? 1 : 0));
 		}
 
@@ -2283,6 +2371,386 @@ void GradientPathsOnSphereGetUserInfo(){
 	CSMGui("GPs around cage/nuclear CPs", Fields, GradientPathsOnSphereReturnUserInfo, AddOnID);
 }
 
+void BenchmarkNodeRecordLayoutsReturnUserInfo(const bool GuiSuccess,
+	const vector<GuiField_c> & Fields,
+	const vector<GuiField_c> PassthroughFields){
+	if (!GuiSuccess) return;
+
+	TecUtilLockStart(AddOnID);
+
+	int VolZoneNum, RhoVarNum;
+	vector<int> XYZVarNums(3), GradVarNums(3);
+	Boolean_t IsPeriodic;
+
+	int fNum = 0;
+
+	VolZoneNum = Fields[fNum++].GetReturnInt();
+	IsPeriodic = Fields[fNum++].GetReturnBool();
+	fNum++;
+	for (int i = 0; i < 3; ++i) XYZVarNums[i] = i + Fields[fNum].GetReturnInt();
+	fNum += 2;
+	RhoVarNum = Fields[fNum++].GetReturnInt();
+	fNum++;
+	for (int i = 0; i < 3; ++i) GradVarNums[i] = i + Fields[fNum].GetReturnInt();
+	fNum += 2;
+	int NumGPs = Fields[fNum++].GetReturnInt();
+
+	VolExtentInfo_s VolGrid;
+	if (!GetVolInfo(VolZoneNum, XYZVarNums, IsPeriodic, VolGrid)){
+		TecUtilDialogErrMsg("Failed to get volume zone info");
+		TecUtilLockFinish(AddOnID);
+		return;
+	}
+	VolGrid.AddOnID = AddOnID;
+	std::shared_ptr<const VolExtentInfo_s> VolInfo = std::make_shared<const VolExtentInfo_s>(VolGrid);
+
+	TecUtilDataLoadBegin();
+
+	FieldDataPointer_c RhoPtr;
+	vector<FieldDataPointer_c> GradPtrs(3);
+	Boolean_t IsOk = RhoPtr.GetReadPtr(VolZoneNum, RhoVarNum);
+	for (int i = 0; i < 3 && IsOk; ++i)
+		IsOk = GradPtrs[i].GetReadPtr(VolZoneNum, GradVarNums[i]);
+
+	vector<double> SeedTimes, MaxEndPointDiff;
+	if (IsOk)
+		IsOk = BenchmarkNodeRecordLayouts(VolInfo, RhoPtr, GradPtrs, NumGPs, SeedTimes, MaxEndPointDiff, &AddOnID);
+	else
+		TecUtilDialogErrMsg("Failed to get read pointer(s)");
+
+	TecUtilDataLoadEnd();
+
+	if (IsOk){
+		const vector<string> LayoutNames = { "No cache", "Linear", "Bricked", "Morton" };
+		stringstream ss;
+		ss << "Seeding " << NumGPs << " gradient paths in a "
+			<< VolGrid.MaxIJK[0] << "x" << VolGrid.MaxIJK[1] << "x" << VolGrid.MaxIJK[2] << " zone:\n\n";
+		for (int l = 0; l < SeedTimes.size(); ++l){
+			if (SeedTimes[l] < 0.0){
+				ss << LayoutNames[l] << ": skipped (couldn't build cache)\n";
+				continue;
+			}
+			ss << LayoutNames[l] << ": " << setprecision(4) << SeedTimes[l] << " s";
+			if (l > 0)
+				ss << " (" << setprecision(3) << SeedTimes[0] / SeedTimes[l] << "x, max end point difference " << MaxEndPointDiff[l] << ")";
+			ss << "\n";
+		}
+		TecUtilDialogMessageBox(ss.str().c_str(), MessageBoxType_Information);
+	}
+
+	TecUtilLockFinish(AddOnID);
+}
+
+void BenchmarkNodeRecordLayoutsGetUserInfo(){
+
+	vector<GuiField_c> Fields = {
+		GuiField_c(Gui_ZoneSelect, "Volume zone", CSMZoneName.FullVolume.substr(0, 10)),
+		GuiField_c(Gui_Toggle, "Periodic system"),
+		GuiField_c(Gui_VertSep),
+		GuiField_c(Gui_VarSelect, "X", "X"),
+		GuiField_c(Gui_VertSep),
+		GuiField_c(Gui_VarSelect, "Electron Density", CSMVarName.Dens),
+		GuiField_c(Gui_VertSep),
+		GuiField_c(Gui_VarSelect, CSMVarName.DensGradVec[0], CSMVarName.DensGradVec[0]),
+		GuiField_c(Gui_VertSep),
+		GuiField_c(Gui_Int, "Number of gradient paths", "10000")
+	};
+
+	CSMGui("Benchmark volume storage layouts", Fields, BenchmarkNodeRecordLayoutsReturnUserInfo, AddOnID);
+}
+
+void BenchmarkGradPathIntegratorsReturnUserInfo(const bool GuiSuccess,
+	const vector<GuiField_c> & Fields,
+	const vector<GuiField_c> PassthroughFields){
+	if (!GuiSuccess) return;
+
+	TecUtilLockStart(AddOnID);
+
+	int VolZoneNum, RhoVarNum;
+	vector<int> XYZVarNums(3), GradVarNums(3);
+	Boolean_t IsPeriodic;
+
+	int fNum = 0;
+
+	VolZoneNum = Fields[fNum++].GetReturnInt();
+	IsPeriodic = Fields[fNum++].GetReturnBool();
+	fNum++;
+	for (int i = 0; i < 3; ++i) XYZVarNums[i] = i + Fields[fNum].GetReturnInt();
+	fNum += 2;
+	RhoVarNum = Fields[fNum++].GetReturnInt();
+	fNum++;
+	for (int i = 0; i < 3; ++i) GradVarNums[i] = i + Fields[fNum].GetReturnInt();
+	fNum += 2;
+	int NumGPs = Fields[fNum++].GetReturnInt();
+
+	VolExtentInfo_s VolGrid;
+	if (!GetVolInfo(VolZoneNum, XYZVarNums, IsPeriodic, VolGrid)){
+		TecUtilDialogErrMsg("Failed to get volume zone info");
+		TecUtilLockFinish(AddOnID);
+		return;
+	}
+	VolGrid.AddOnID = AddOnID;
+	std::shared_ptr<const VolExtentInfo_s> VolInfo = std::make_shared<const VolExtentInfo_s>(VolGrid);
+
+	TecUtilDataLoadBegin();
+
+	FieldDataPointer_c RhoPtr;
+	vector<FieldDataPointer_c> GradPtrs(3);
+	Boolean_t IsOk = RhoPtr.GetReadPtr(VolZoneNum, RhoVarNum);
+	for (int i = 0; i < 3 && IsOk; ++i)
+		IsOk = GradPtrs[i].GetReadPtr(VolZoneNum, GradVarNums[i]);
+
+	vector<double> SeedTimes, MaxEndPointDiff;
+	vector<int> NumSteps, NumOverTol;
+	if (IsOk)
+		IsOk = BenchmarkGradPathIntegrators(VolInfo, RhoPtr, GradPtrs, NumGPs, SeedTimes, NumSteps, MaxEndPointDiff, NumOverTol, &AddOnID);
+	else
+		TecUtilDialogErrMsg("Failed to get read pointer(s)");
+
+	TecUtilDataLoadEnd();
+
+	if (IsOk){
+		const vector<string> IntegratorNames = { "GSL rk4", "Dormand-Prince" };
+		stringstream ss;
+		ss << "Seeding " << NumGPs << " gradient paths in a "
+			<< VolGrid.MaxIJK[0] << "x" << VolGrid.MaxIJK[1] << "x" << VolGrid.MaxIJK[2] << " zone:\n\n";
+		Boolean_t EndPointsAgree = TRUE;
+		for (int m = 0; m < SeedTimes.size(); ++m){
+			ss << IntegratorNames[m] << ": " << setprecision(4) << SeedTimes[m] << " s, " << NumSteps[m] << " points";
+			if (m > 0){
+				ss << " (" << setprecision(3) << SeedTimes[0] / SeedTimes[m] << "x, max end point difference " << MaxEndPointDiff[m] << ")";
+				if (NumOverTol[m] > 0){
+					ss << "\n    WARNING: " << NumOverTol[m] << " path(s) ended more than " << GP_BenchmarkEndPointTol << " grid spacings away";
+					EndPointsAgree = FALSE;
+				}
+			}
+			ss << "\n";
+		}
+		TecUtilDialogMessageBox(ss.str().c_str(), EndPointsAgree ? MessageBoxType_Information : MessageBoxType_Warning);
+	}
+
+	TecUtilLockFinish(AddOnID);
+}
+
+void BenchmarkGradPathIntegratorsGetUserInfo(){
+
+	vector<GuiField_c> Fields = {
+		GuiField_c(Gui_ZoneSelect, "Volume zone", CSMZoneName.FullVolume.substr(0, 10)),
+		GuiField_c(Gui_Toggle, "Periodic system"),
+		GuiField_c(Gui_VertSep),
+		GuiField_c(Gui_VarSelect, "X", "X"),
+		GuiField_c(Gui_VertSep),
+		GuiField_c(Gui_VarSelect, "Electron Density", CSMVarName.Dens),
+		GuiField_c(Gui_VertSep),
+		GuiField_c(Gui_VarSelect, CSMVarName.DensGradVec[0], CSMVarName.DensGradVec[0]),
+		GuiField_c(Gui_VertSep),
+		GuiField_c(Gui_Int, "Number of gradient paths", "10000")
+	};
+
+	CSMGui("Benchmark gradient path integrators", Fields, BenchmarkGradPathIntegratorsReturnUserInfo, AddOnID);
+}
+
+void SinglePrecisionErrorReportReturnUserInfo(const bool GuiSuccess,
+	const vector<GuiField_c> & Fields,
+	const vector<GuiField_c> PassthroughFields){
+	if (!GuiSuccess) return;
+
+	TecUtilLockStart(AddOnID);
+
+	int VolZoneNum, RhoVarNum;
+	vector<int> XYZVarNums(3), GradVarNums, HessVarNums;
+	Boolean_t IsPeriodic;
+
+	int fNum = 0;
+
+	VolZoneNum = Fields[fNum++].GetReturnInt();
+	IsPeriodic = Fields[fNum++].GetReturnBool();
+	fNum++;
+	for (int i = 0; i < 3; ++i) XYZVarNums[i] = i + Fields[fNum].GetReturnInt();
+	fNum += 2;
+	RhoVarNum = Fields[fNum++].GetReturnInt();
+	fNum++;
+	if (Fields[fNum++].GetReturnBool()){
+		GradVarNums.resize(3);
+		for (int i = 0; i < 3; ++i) GradVarNums[i] = i + Fields[fNum].GetReturnInt();
+	}
+	fNum += 2;
+	if (Fields[fNum++].GetReturnBool()){
+		HessVarNums.resize(6);
+		for (int i = 0; i < 6; ++i) HessVarNums[i] = i + Fields[fNum].GetReturnInt();
+	}
+	fNum += 2;
+	double CellSpacing = Fields[fNum++].GetReturnDouble();
+	fNum++;
+	vector<int> IntVarNums = Fields[fNum++].GetReturnIntVec();
+	int IntResolution = Fields[fNum++].GetReturnInt();
+
+	VolExtentInfo_s VolInfo;
+	VolInfo.AddOnID = AddOnID;
+	if (!GetVolInfo(VolZoneNum, XYZVarNums, IsPeriodic, VolInfo)){
+		TecUtilDialogErrMsg("Failed to get volume zone info");
+		TecUtilLockFinish(AddOnID);
+		return;
+	}
+
+	TecUtilDataLoadBegin();
+
+	FieldDataPointer_c RhoPtr;
+	vector<FieldDataPointer_c> GradPtrs, HessPtrs;
+	if (!GetReadPtrsForZone(VolZoneNum,
+		RhoVarNum, GradVarNums, HessVarNums,
+		RhoPtr, GradPtrs, HessPtrs)){
+		TecUtilDialogErrMsg("Failed to get read pointer(s)");
+		TecUtilDataLoadEnd();
+		TecUtilLockFinish(AddOnID);
+		return;
+	}
+
+	stringstream ss;
+	ss << setprecision(3);
+
+	/*
+	*	Critical points: search once with each cache and match every
+	*	double precision CP to the nearest single precision CP of the
+	*	same type.
+	*/
+	vector<CritPoints_c> CPs(2);
+	Boolean_t IsOk = TRUE;
+	for (int p = 0; p < 2 && IsOk; ++p){
+		NodeRecordCache_c NodeCache;
+		IsOk = NodeCache.Build(RhoPtr, GradPtrs, HessPtrs, &AddOnID, NodeRecordLayout_Linear, p > 0);
+		double RhoCutoff = DefaultRhoCutoff;
+		if (IsOk)
+			IsOk = FindCPs(CPs[p], VolInfo, CellSpacing, RhoCutoff, IsPeriodic, RhoPtr, GradPtrs, HessPtrs, &NodeCache);
+	}
+
+	if (IsOk){
+		double MaxCPDist = 0.0;
+		int NumUnmatched = 0;
+		for (int t = 0; t < CPTypeList.size(); ++t){
+			for (int i = 0; i < CPs[0].NumCPs(t); ++i){
+				double MinDist = -1.0;
+				for (int j = 0; j < CPs[1].NumCPs(t); ++j){
+					double Dist = norm(CPs[0].GetXYZ(t, i) - CPs[1].GetXYZ(t, j));
+					if (MinDist < 0.0 || Dist < MinDist) MinDist = Dist;
+				}
+				if (MinDist < 0.0) NumUnmatched++;
+				else MaxCPDist = MAX(MaxCPDist, MinDist);
+			}
+		}
+		ss << "Critical points (double / single): " << CPs[0].NumCPs() << " / " << CPs[1].NumCPs() << "\n"
+			<< "Max CP position difference: " << MaxCPDist << "\n";
+		if (NumUnmatched > 0)
+			ss << "CPs without a single precision match: " << NumUnmatched << "\n";
+	}
+	else
+		ss << "Critical point search failed\n";
+
+	/*
+	*	Gradient bundle integration: integrate every GBA sphere element
+	*	once with each cache of the integration variables.
+	*/
+	if (IntVarNums.size() > 0){
+		vector<FieldDataPointer_c> IntVarPtrs(IntVarNums.size());
+		Boolean_t PtrsOk = (IntVarNums.size() <= VolInfo_MaxGatherVars);
+		for (int i = 0; i < IntVarNums.size() && PtrsOk; ++i)
+			PtrsOk = IntVarPtrs[i].GetReadPtr(VolZoneNum, IntVarNums[i]);
+
+		vector<NodeRecordCache_c> IntVarCaches(2);
+		for (int p = 0; p < 2 && PtrsOk; ++p)
+			PtrsOk = IntVarCaches[p].Build(IntVarPtrs, &AddOnID, NodeRecordLayout_Linear, p > 0);
+
+		vector<vector<FESurface_c> > VolumeLists(2);
+		if (PtrsOk){
+			int NumZones = TecUtilDataSetGetNumZones();
+			for (int i = 1; i <= NumZones; ++i){
+				if (TecUtilZoneIsFiniteElement(i) && AuxDataZoneHasItem(i, CSMAuxData.GBA.SphereCPName)){
+					for (int p = 0; p < 2; ++p){
+						VolumeLists[p].push_back(FESurface_c(i, VolZoneNum, XYZVarNums, IntVarNums));
+						VolumeLists[p].back().SetIntVarCache(&IntVarCaches[p]);
+					}
+				}
+			}
+		}
+
+		int NumVolumes = static_cast<int>(VolumeLists[0].size());
+		if (NumVolumes > 0){
+			StatusLaunch("Integrating gradient bundles...", AddOnID, FALSE);
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+			for (int i = 0; i < NumVolumes * 2; ++i)
+				VolumeLists[i % 2][i / 2].DoIntegrationNew(IntResolution, FALSE);
+			StatusDrop(AddOnID);
+
+			double MaxRelErr = 0.0;
+			vector<double> Totals[2];
+			for (int p = 0; p < 2; ++p) Totals[p].resize(IntVarNums.size(), 0.0);
+			for (int i = 0; i < NumVolumes; ++i){
+				vector<double> Results[2] = { VolumeLists[0][i].GetIntResults(), VolumeLists[1][i].GetIntResults() };
+				for (int v = 0; v < IntVarNums.size() && v < Results[0].size() && v < Results[1].size(); ++v){
+					double Denom = MAX(std::abs(Results[0][v]), DBL_EPSILON);
+					MaxRelErr = MAX(MaxRelErr, std::abs(Results[1][v] - Results[0][v]) / Denom);
+					for (int p = 0; p < 2; ++p) Totals[p][v] += Results[p][v];
+				}
+			}
+			ss << "\nIntegrated " << NumVolumes << " gradient bundles\n"
+				<< "Max relative error per bundle: " << MaxRelErr << "\n";
+			for (int v = 0; v < IntVarNums.size(); ++v){
+				char * VarName;
+				if (TecUtilVarGetName(IntVarNums[v], &VarName)){
+					ss << "Total " << VarName << ": " << setprecision(10) << Totals[0][v] << " / " << Totals[1][v]
+						<< setprecision(3) << " (relative error " << std::abs(Totals[1][v] - Totals[0][v]) / MAX(std::abs(Totals[0][v]), DBL_EPSILON) << ")\n";
+					TecUtilStringDealloc(&VarName);
+				}
+			}
+		}
+		else if (!PtrsOk)
+			ss << "\nFailed to cache integration variables\n";
+		else
+			ss << "\nNo gradient bundle zones to integrate\n";
+	}
+
+	TecUtilDataLoadEnd();
+
+	TecUtilDialogMessageBox(ss.str().c_str(), MessageBoxType_Information);
+
+	TecUtilLockFinish(AddOnID);
+}
+
+void SinglePrecisionErrorReportGetUserInfo(){
+
+	vector<GuiField_c> Fields = {
+		GuiField_c(Gui_ZoneSelect, "Volume zone", CSMZoneName.FullVolume.substr(0, 10)),
+		GuiField_c(Gui_Toggle, "Periodic system"),
+		GuiField_c(Gui_VertSep),
+		GuiField_c(Gui_VarSelect, "X", "X"),
+		GuiField_c(Gui_VertSep),
+		GuiField_c(Gui_VarSelect, "Electron Density", CSMVarName.Dens),
+		GuiField_c(Gui_VertSep)
+	};
+
+	int iTmp = Fields.size();
+	Fields.push_back(GuiField_c(Gui_ToggleEnable, "Density gradient vector variables present"));
+	Fields[iTmp].AppendSearchString(to_string(Fields.size()));
+	Fields.push_back(GuiField_c(Gui_VarSelect, CSMVarName.DensGradVec[0], CSMVarName.DensGradVec[0]));
+	Fields.push_back(GuiField_c(Gui_VertSep));
+
+	iTmp = Fields.size();
+	Fields.push_back(GuiField_c(Gui_ToggleEnable, "Density Hessian variables present"));
+	Fields[iTmp].AppendSearchString(to_string(Fields.size()));
+	Fields.push_back(GuiField_c(Gui_VarSelect, CSMVarName.DensHessTensor[0], CSMVarName.DensHessTensor[0]));
+	Fields.push_back(GuiField_c(Gui_VertSep));
+
+	Fields.push_back(GuiField_c(Gui_Double, "CP search grid spacing", to_string(DefaultCellSpacing)));
+	Fields.push_back(GuiField_c(Gui_VertSep));
+
+	Fields.push_back(GuiField_c(Gui_VarSelectMulti, "GBA integration variables", ""));
+	Fields.push_back(GuiField_c(Gui_Int, "Integration resolution", "1"));
+
+	CSMGui("Single precision error report", Fields, SinglePrecisionErrorReportReturnUserInfo, AddOnID);
+}
+
 double MinFunc_GPLength_InPlane(double alpha, void * params){
 	MinFuncParams_GPLengthInPlane * GPParams = reinterpret_cast<MinFuncParams_GPLengthInPlane*>(params);
 
@@ -2298,7 +2766,7 @@ double MinFunc_GPLength_InPlane(double alpha, void * params){
 		GPParams->CPs,
 		GPParams->TermPointRadius,
 		GPParams->TermValue,
-		*GPParams->VolInfo,
+		GPParams->VolInfo,
 		*GPParams->HessPtrs,
 		*GPParams->GradPtrs,
 		*GPParams->RhoPtr);
@@ -2408,6 +2876,12 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 		return FALSE;
 	}
 
+	/*
+	*	Every gradient path below shares this one descriptor of the
+	*	grid and keeps only its own interpolation stencil.
+	*/
+	std::shared_ptr<const VolExtentInfo_s> VolInfoPtr = std::make_shared<const VolExtentInfo_s>(VolInfo);
+
 	vector<int> iJunk(2);
 	int NumCPs;
 	string CPZoneCheckString;
@@ -2533,7 +3007,7 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 		GPParams.CPs = &AllCPs;
 		GPParams.TermPointRadius = &TermRadius;
 		GPParams.TermValue = &RhoCutoff;
-		GPParams.VolInfo = &VolInfo;
+		GPParams.VolInfo = VolInfoPtr;
 		GPParams.HessPtrs = &HessPtrs;
 		GPParams.GradPtrs = &GradPtrs;
 		GPParams.RhoPtr = &RhoPtr;
@@ -2562,7 +3036,7 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 
 			StartPoint = GPParams.StartPointOrigin + Rotate(StartVec, RotAngle, GPParams.RotAxis);
 
-			GPs.push_back(GradPath_c(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr));
+			GPs.push_back(GradPath_c(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr));
 			GPs.back().SetStartEndCPNum(GPParams.StartCPNum, 0);
 		}
 
@@ -2694,7 +3168,7 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 							Iter++;
 							AlphaGuess = (AlphaLower + AlphaUpper) * 0.5;
 							StartPoint = GPParams.StartPointOrigin + Rotate(StartVec, AlphaGuess, GPParams.RotAxis);
-							GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr);
+							GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr);
 							GP.SetStartEndCPNum(GPParams.StartCPNum, 0);
 							GP.Seed(false);
 							if (AllCPs.GetTypeFromTotOffset(GP.GetStartEndCPNum(EndCPPosition)) == SecondaryTermType){
@@ -2751,7 +3225,7 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 								Iter++;
 								RotAngle = AlphaGuess + (AngleStep * AngleFactor * SmallAngleFactor * static_cast<double>(MinGPDir));
 								StartPoint = GPParams.StartPointOrigin + Rotate(StartVec, RotAngle, GPParams.RotAxis);
-								GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr);
+								GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr);
 								GP.SetStartEndCPNum(GPParams.StartCPNum, 0);
 								GP.Seed(false);
 								if (GP.GetStartEndCPNum(EndCPPosition) == TermCPNum){
@@ -2798,7 +3272,7 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 								Iter++;
 								RotAngle += (AngleStep * AngleFactor * SmallAngleFactor * static_cast<double>(MinGPDir));
 								StartPoint = GPParams.StartPointOrigin + Rotate(StartVec, RotAngle, GPParams.RotAxis);
-								GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr);
+								GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr);
 								GP.SetStartEndCPNum(GPParams.StartCPNum, 0);
 								GP.Seed(false);
 								if (GP.GetStartEndCPNum(EndCPPosition) == TermCPNum){
@@ -2882,7 +3356,7 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 			vector<vec3> TmpStartPoints(3);
 			for (int j = 0; j < 3; ++j){
 				TmpStartPoints[j] = GPParams.StartPointOrigin + Rotate(StartVec, MinFunc_AlphaLowMidHigh[i][j], GPParams.RotAxis);
-				GradPath_c GP(TmpStartPoints[j], GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr);
+				GradPath_c GP(TmpStartPoints[j], GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr);
 
 				GP.SetStartEndCPNum(GPParams.StartCPNum, 0);
 				GP.Seed(false);
@@ -2944,7 +3418,7 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 			*/
 
 // 			SGPsPerCP[iCP][i] = reinterpret_cast<MinFuncParams_GPLengthInPlane*>(F.params)->GP;
-			SGPsPerCP[iCP][i].SetupGradPath(GPParams.StartPointOrigin + Rotate(StartVec, MinFunc_AlphaLowMidHigh[i][1], GPParams.RotAxis), GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr);
+			SGPsPerCP[iCP][i].SetupGradPath(GPParams.StartPointOrigin + Rotate(StartVec, MinFunc_AlphaLowMidHigh[i][1], GPParams.RotAxis), GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr);
 			SGPsPerCP[iCP][i].SetStartEndCPNum(GPParams.StartCPNum, 0);
 			SGPsPerCP[iCP][i].Seed(false);
 			if (GPDir != StreamDir_Both) SGPsPerCP[iCP][i].PointPrepend(GPParams.StartPointOrigin, AllCPs.GetRho(TypeInd, cpNum));
@@ -2995,11 +3469,11 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 
 					SaddleCPSupplementGPs[i][0].SetupGradPath(PtUp, GPDir, NumGPPts,
 						GPType_Classic, GPTerminate_AtRhoValue, NULL,
-						&AllCPs, &TermRadius, &RhoCutoff, VolInfo,
+						&AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr,
 						HessPtrs, GradPtrs, RhoPtr);
 					SaddleCPSupplementGPs[i][1].SetupGradPath(PtDn, GPDir, NumGPPts,
 						GPType_Classic, GPTerminate_AtRhoValue, NULL,
-						&AllCPs, &TermRadius, &RhoCutoff, VolInfo,
+						&AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr,
 						HessPtrs, GradPtrs, RhoPtr);
 					for (GradPath_c & GP : SaddleCPSupplementGPs[i]){
 						GP.SetStartEndCPNum(TermCPNums[i], 0);
@@ -3016,11 +3490,11 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 
 					SaddleCPSupplementGPs[i][0].SetupGradPath(PtDn, GPDir, NumGPPts,
 					GPType_Classic, GPTerminate_AtRhoValue, NULL,
-					&AllCPs, &TermRadius, &RhoCutoff, VolInfo,
+					&AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr,
 					HessPtrs, GradPtrs, RhoPtr);
 					SaddleCPSupplementGPs[i][1].SetupGradPath(PtUp, GPDir, NumGPPts,
 						GPType_Classic, GPTerminate_AtRhoValue, NULL,
-						&AllCPs, &TermRadius, &RhoCutoff, VolInfo,
+						&AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr,
 						HessPtrs, GradPtrs, RhoPtr);
 					for (GradPath_c & GP : SaddleCPSupplementGPs[i]){
 						GP.SetStartEndCPNum(TermCPNums[i], 0);
@@ -3078,10 +3552,12 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 
 				vector<double> RCSFuncCheckVals(NumRCSFuncCircleCheckPts);
 
+				IndexWeights_s Stencil;
 				for (int i = 0; i < NumRCSFuncCircleCheckPts; ++i){
 					double RotAngle = AngleStep * static_cast<double>(i);
 					StartPoint = GPParams.StartPointOrigin + Rotate(StartVec, RotAngle, GPParams.RotAxis);
-					RCSFuncCheckVals[i] = ValAtPointByPtr(StartPoint, VolInfo, RCSFuncPtr);
+					if (GetIndexAndWeightsForPoint(StartPoint, *VolInfoPtr, Stencil))
+						RCSFuncCheckVals[i] = ValByCurrentIndexAndWeightsFromRawPtr(Stencil, RCSFuncPtr);
 				}
 
 				/*
@@ -3163,7 +3639,7 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 						for (const double & iRCS : AvgMinNum){
 							double aRCS = iRCS * AngleStep;
 							StartPoint = GPParams.StartPointOrigin + Rotate(GPParams.RotVec, aRCS, GPParams.RotAxis);
-							GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr);
+							GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr);
 							GP.SetStartEndCPNum(AllCPs.GetTotOffsetFromTypeNumOffset(TypeInd, cpNum), 0);
 							GP.Seed(false);
 							GP.PointPrepend(GPParams.StartPointOrigin, AllCPs.GetRho(TypeInd, cpNum));
@@ -3283,7 +3759,7 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 				for (int j = 1; j < NumSepGPs; ++j){
 					double RotAngle = SGPSeedAngles[i] + SepAngleStep * static_cast<double>(j);
 					StartPoint = GPParams.StartPointOrigin + Rotate(StartVec, RotAngle, GPParams.RotAxis);
-					GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtRhoValue, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr);
+					GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtRhoValue, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr);
 					GP.SetStartEndCPNum(AllCPs.GetTotOffsetFromTypeNumOffset(TypeInd, cpNum), 0);
 					GP.Seed(false);
 					GP.PointPrepend(GPParams.StartPointOrigin, AllCPs.GetRho(TypeInd, cpNum));
@@ -3351,7 +3827,7 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 				for (int j = jLow; j <= jHigh; ++j){
 					double RotAngle = SGPSeedAngles[0] + AngleStep * static_cast<double>(j);
 					StartPoint = GPParams.StartPointOrigin + Rotate(StartVec, RotAngle, GPParams.RotAxis);
-					GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtRhoValue, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr);
+					GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtRhoValue, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr);
 					GP.SetStartEndCPNum(AllCPs.GetTotOffsetFromTypeNumOffset(TypeInd, cpNum), 0);
 					GP.Seed(false);
 					GP.PointPrepend(GPParams.StartPointOrigin, AllCPs.GetRho(TypeInd, cpNum));
@@ -3383,7 +3859,7 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 			for (int j = 0; j < NumCircleGPs; ++j){
 				double RotAngle = AngleStep * static_cast<double>(j);
 				StartPoint = GPParams.StartPointOrigin + Rotate(StartVec, RotAngle, GPParams.RotAxis);
-				GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtRhoValue, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr);
+				GradPath_c GP(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtRhoValue, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr);
 				GP.SetStartEndCPNum(AllCPs.GetTotOffsetFromTypeNumOffset(TypeInd, cpNum), 0);
 				GP.Seed(false);
 				GP.PointPrepend(GPParams.StartPointOrigin, AllCPs.GetRho(TypeInd, cpNum));
@@ -3555,7 +4031,7 @@ const Boolean_t FindBondRingSurfaces(const int & VolZoneNum,
 
 			StartPoint = AllCPs.GetXYZ(TypeInd, cpNum) + Rotate(StartVec, RotAngle, AllCPs.GetPrincDir(TypeInd, cpNum));
 
-			GPs.push_back(GradPath_c(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfo, HessPtrs, GradPtrs, RhoPtr));
+			GPs.push_back(GradPath_c(StartPoint, GPDir, NumGPPts, GPType_Classic, GPTerminate_AtCP, NULL, &AllCPs, &TermRadius, &RhoCutoff, VolInfoPtr, HessPtrs, GradPtrs, RhoPtr));
 			GPs.back().SetStartEndCPNum(AllCPs.GetTotOffsetFromTypeNumOffset(TypeInd, cpNum), 0);
 
 		}
@@ -4496,7 +4972,7 @@ void TestFunction(){
 }
 
 struct GradientPathToolData_s{
-	VolExtentIndexWeights_s VolInfo;
+	std::shared_ptr<const VolExtentInfo_s> VolInfo;
 	FieldDataPointer_c RhoPtr;
 	vector<FieldDataPointer_c> GradPtrs, HessPtrs;
 	StreamDir_e Dir;
@@ -4564,7 +5040,9 @@ void GradientPathToolReturnUserInfo(const bool GuiSuccess,
 	StreamDir_e StreamDir = StreamDir_e(Fields[fNum++].GetReturnInt()-1);
 	int RhoVarNum = Fields[fNum++].GetReturnInt();
 	GPToolData.Dir = StreamDir;
-	GetVolInfo(VolZoneNum, { 1, 2, 3 }, FALSE, GPToolData.VolInfo);
+	VolExtentInfo_s VolInfo;
+	GetVolInfo(VolZoneNum, { 1, 2, 3 }, FALSE, VolInfo);
+	GPToolData.VolInfo = std::make_shared<const VolExtentInfo_s>(VolInfo);
 
 	Boolean_t IsOk = GPToolData.RhoPtr.GetReadPtr(VolZoneNum, RhoVarNum);
 
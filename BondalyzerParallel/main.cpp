@@ -349,6 +349,51 @@ static void STDCALL GradientPathsOnSphereMenuCallback(void)
 	TecUtilLockFinish(AddOnID);
 }
 
+static void STDCALL BenchmarkNodeRecordLayoutsMenuCallback(void)
+{
+	TecUtilLockStart(AddOnID);
+	if (TecUtilDataSetIsAvailable())
+	{
+		BenchmarkNodeRecordLayoutsGetUserInfo();
+	}
+	else
+	{
+		TecUtilDialogErrMsg("No data set in current frame.");
+	}
+
+	TecUtilLockFinish(AddOnID);
+}
+
+static void STDCALL BenchmarkGradPathIntegratorsMenuCallback(void)
+{
+	TecUtilLockStart(AddOnID);
+	if (TecUtilDataSetIsAvailable())
+	{
+		BenchmarkGradPathIntegratorsGetUserInfo();
+	}
+	else
+	{
+		TecUtilDialogErrMsg("No data set in current frame.");
+	}
+
+	TecUtilLockFinish(AddOnID);
+}
+
+static void STDCALL SinglePrecisionErrorReportMenuCallback(void)
+{
+	TecUtilLockStart(AddOnID);
+	if (TecUtilDataSetIsAvailable())
+	{
+		SinglePrecisionErrorReportGetUserInfo();
+	}
+	else
+	{
+		TecUtilDialogErrMsg("No data set in current frame.");
+	}
+
+	TecUtilLockFinish(AddOnID);
+}
+
 static void STDCALL GetClosedIsoSurfaceFromPointsCallback(void)
 {
 	TecUtilLockStart(AddOnID);
@@ -800,6 +845,21 @@ EXPORTFROMADDON void STDCALL InitTecAddOn(void)
 		'\0',
 		ExtractRSIntersectionsCallback);
 
+	TecUtilMenuAddOption("MTG_Utilities",
+		string("Benchmark volume storage layouts").c_str(),
+		'\0',
+		BenchmarkNodeRecordLayoutsMenuCallback);
+
+	TecUtilMenuAddOption("MTG_Utilities",
+		string("Benchmark gradient path integrators").c_str(),
+		'\0',
+		BenchmarkGradPathIntegratorsMenuCallback);
+
+	TecUtilMenuAddOption("MTG_Utilities",
+		string("Single precision error report").c_str(),
+		'\0',
+		SinglePrecisionErrorReportMenuCallback);
+
 	TecUtilMenuAddOption("MTG_Utilities",
 		string("Test function").c_str(),
 		'\0',
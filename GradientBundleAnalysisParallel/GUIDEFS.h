@@ -26,6 +26,8 @@ extern LgIndex_t  RBRadMode_RADIO_T1_1;
 extern LgIndex_t  TFCutoff_TF_T1_1;
 extern LgIndex_t  LBLCutoff_LBL_T1_1;
 extern LgIndex_t  TGLOpenSys_TOG_T1_1;
+extern LgIndex_t  TGLNodeCache_TOG_T1_1;
+extern LgIndex_t  TGLSglPrec_TOG_T1_1;
 extern LgIndex_t  MLSelVars_MLST_T1_1;
 extern LgIndex_t  SCPrecise_SC_T1_1;
 extern LgIndex_t  LBL23_LBL_T1_1;
@@ -40,6 +42,8 @@ extern void BuildTab2_1(LgIndex_t  Parent);
 extern LgIndex_t  MLIntSelSph_MLST_T2_1;
 extern LgIndex_t  MLIntSelVar_MLST_T2_1;
 extern LgIndex_t  TGLIntVolInt_TOG_T2_1;
+extern LgIndex_t  TGLIntNodeCache_TOG_T2_1;
+extern LgIndex_t  TGLIntSglPrec_TOG_T2_1;
 extern LgIndex_t  LBL6_LBL_T2_1;
 extern LgIndex_t  SCIntPrecise_SC_T2_1;
 extern LgIndex_t  BTNIntegrate_BTN_T2_1;
@@ -18,6 +18,8 @@ const Boolean_t PerformIntegration(const vector<string> & AtomNameList,
 	const vector<string> & IntVarNameList,
 	const vector<int> & IntVarNumList,
 	const Boolean_t & IntegrateVolume,
-	const int & IntResolution);
+	const int & IntResolution,
+	const Boolean_t & UseNodeCache = FALSE,
+	const Boolean_t & SinglePrecisionCache = FALSE);
 
 #endif
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include <vector>
 #include <fstream>
 #include <algorithm>
+#include <memory>
 
 // for profiling
 #include <chrono>
@@ -27,6 +28,8 @@
 #include "CSM_FE_VOLUME.h"
 #include "CSM_GRAD_PATH.h"
 #include "CSM_CRIT_POINTS.h"
+#include "CSM_NODE_RECORD_CACHE.h"
+#include "CSM_GRAD_PATH_CACHE.h"
 #include "CSM_GUI.h"
 
 #include "GBAENGINE.h"
@@ -148,6 +151,8 @@ void MainFunction(){
 	TecGUITextFieldGetDouble(TFCutoff_TF_T1_1, &CutoffVal);
 	EntIndex_t CutoffVarNum = VarNumByName(string("Electron Density"));
 	LgIndex_t NumEdgeGPs = TecGUIScaleGetValue(SCNumEdgeGPs_SC_T1_1);
+	Boolean_t UseNodeCache = TecGUIToggleGet(TGLNodeCache_TOG_T1_1);
+	Boolean_t SinglePrecisionCache = TecGUIToggleGet(TGLSglPrec_TOG_T1_1);
 
 	/*
 	 *	When checking if two streamtraces are straddling two IBs,
@@ -186,8 +191,13 @@ void MainFunction(){
 
 
 
-	VolExtentIndexWeights_s VolInfo;
-	GetVolInfo(VolZoneNum, XYZVarNums, FALSE, VolInfo);
+	/*
+	*	One read-only grid descriptor shared by all the gradient
+	*	paths below, rather than each path copying its own.
+	*/
+	VolExtentInfo_s VolGrid;
+	GetVolInfo(VolZoneNum, XYZVarNums, FALSE, VolGrid);
+	const std::shared_ptr<const VolExtentInfo_s> VolInfo = std::make_shared<const VolExtentInfo_s>(VolGrid);
 
 
 	EntIndex_t OldNumZones = TecUtilDataSetGetNumZones();	
@@ -200,6 +210,40 @@ void MainFunction(){
 	}
 
 	vector<int> NumCPs;
+
+	/*
+	*	CPs of the zone the selected CPs come from, for finding the
+	*	closest other CP to each without checking them all.
+	*/
+	CritPoints_c ZoneCPs;
+	EntIndex_t ZoneCPsZoneNum = -1;
+
+	/*
+	*	The finished gradient paths of each sphere, and for each thread
+	*	the paths that seed them, kept from one sphere to the next so
+	*	their storage is only allocated once.
+	*/
+	GradPathSet_c SphereGPs;
+	/*
+	*	Compact copies of the SphereGPs paths that the gradient bundles
+	*	are sampled from, so SphereGPs can be freed once the paths are
+	*	saved. Made from the NumSTPoints paths in SphereGPs whether those
+	*	were seeded or read from the GP cache, so the bundles don't
+	*	depend on which.
+	*/
+	vector<CompactGradPath_c> SphereCompactGPs;
+	const int NumGPsPerRun = 4 * GP_BatchWidth;
+	vector<GradPathBatch_c> Batches(omp_get_max_threads());
+	vector<vector<GradPath_c> > SeedGPPools(omp_get_max_threads(), vector<GradPath_c>(NumGPsPerRun));
+
+	/*
+	*	Node and edge paths are kept in an on-disk cache if the user
+	*	has pointed GPCache_DirEnvVar at a directory, so rerunning with
+	*	the same sphere and path settings skips seeding them.
+	*/
+	const char * GPCacheDir = getenv(GPCache_DirEnvVar);
+	GradPathCache_c GPCache;
+
 	for (int SelectCPNum = 0; SelectCPNum < NumSelectedCPs && IsOk; ++SelectCPNum){
 
 		LgIndex_t CPNum = 1;
@@ -312,15 +356,19 @@ void MainFunction(){
 		double ClosestCPDist = 1e50;
 		if (IsOk){
 			if (IsCP){
-				for (int i = 1; i <= CPIJKMax[0] && IsOk; ++i){
-					if (i != CPNum && (int)TecUtilDataValueGetByZoneVar(CPZoneNum, CPTypeVarNum, i) != CPType){
-						vec3 OtherCP;
-						for (int j = 0; j < 3; ++j){
-							OtherCP[j] = TecUtilDataValueGetByZoneVar(CPZoneNum, XYZVarNums[j], i);
-						}
-						ClosestCPDist = MIN(ClosestCPDist, Distance(OtherCP, CPPos));
-					}
+				if (ZoneCPsZoneNum != CPZoneNum){
+					ZoneCPs = CritPoints_c(CPZoneNum, XYZVarNums, CPTypeVarNum);
+					ZoneCPsZoneNum = CPZoneNum;
 				}
+				vector<int> OtherTypeNums;
+				for (int t = 0; t < CPTypeList.size(); ++t){
+					if (CPTypeList[t] != CPType)
+						OtherTypeNums.push_back(t);
+				}
+				double OtherCPDist;
+				vec3 OtherCP;
+				if (ZoneCPs.GetClosestCP(CPPos, OtherCPDist, OtherCP, OtherTypeNums) >= 0)
+					ClosestCPDist = OtherCPDist;
 			}
 			else{
 				for (int ZoneNum = 1; ZoneNum <= TecUtilDataSetGetNumZones(); ++ZoneNum){
@@ -999,6 +1047,16 @@ void MainFunction(){
 			}
 		}
 
+		/*
+		*	Rho and gradient interleaved per node for the sphere seeding,
+		*	if the user asked for it (it's a second copy of the data).
+		*	Paths fall back to the raw pointers if it can't be built.
+		*/
+		NodeRecordCache_c NodeCache;
+		if (IsOk && UseNodeCache)
+			NodeCache.Build(RhoRawPtr, GradRawPtrs, vector<FieldDataPointer_c>(), NULL, NodeRecordLayout_Linear, SinglePrecisionCache);
+		const NodeRecordCache_c * NodeCachePtr = (NodeCache.IsReady() ? &NodeCache : NULL);
+
 		EntIndex_t NumZonesBeforeVolumes = TecUtilDataSetGetNumZones();
 
 		MemoryRequired = (sizeof(Boolean_t) * (2 * NumPoints + 2 * NumTriangles) + sizeof(EntIndex_t) * NumTriangles) / 1024;
@@ -1039,7 +1097,13 @@ void MainFunction(){
 		*/
 
 
-		vector<GradPath_c> GPsNonSaddle(NumPoints), GPsEdges(NumEdges * NumEdgeGPs);
+		/*
+		*	Node paths are the first NumPoints paths of SphereGPs,
+		*	and the NumEdgeGPs paths of each edge follow them.
+		*/
+		const int EdgeGPsBeg = NumPoints;
+		SphereGPs.Resize(NumPoints + NumEdges * NumEdgeGPs, NumSTPoints);
+		SphereCompactGPs.assign(SphereGPs.NumPaths(), CompactGradPath_c());
 		GPTerminate_e HowTerminate;
 		if (UseCutoff)
 			HowTerminate = GPTerminate_AtRhoValue;
@@ -1063,56 +1127,11 @@ void MainFunction(){
 
 		Boolean_t UserQuit = FALSE;
 
-		int TmpNumIterations = NumPoints / numCPU;
-		int NumCompleted = 0;
-
-#ifndef _DEBUG
-#pragma omp parallel for schedule(dynamic)
-#endif
-		for (int PtNum = 0; PtNum < NumPoints; ++PtNum){
-			if (omp_get_thread_num() == 0){
-				UserQuit = !StatusUpdate(NumCompleted++, TmpNumIterations, TmpString, AddOnID);
-#pragma omp flush (UserQuit)
-			}
-#pragma omp flush (UserQuit)
-
-			if (!NodeHasSaddleCP[PtNum] && !UserQuit){
-				vec3 NodePos;
-				for (int ii = 0; ii < 3; ++ii)
-					NodePos[ii] = p[PtNum][ii];
-
-// 				IsOk = GPsNonSaddle[PtNum].SetupGradPath(NodePos,
-// 					StreamDir, 
-// 					NumSTPoints,
-// 					HowTerminate, 
-// 					NULL, vector<FieldDataPointer_c>(), NULL, NULL,
-// 					&CutoffVal, 
-// 					VolMaxIJK,
-// 					VolMaxXYZ,
-// 					VolMinXYZ,
-// 					GradRawPtrs, 
-// 					RhoRawPtr);
-
-				IsOk = GPsNonSaddle[PtNum].SetupGradPath(NodePos, 
-					StreamDir, 
-					NumSTPoints, 
-					GPType_Classic, 
-					HowTerminate, 
-					NULL, NULL, NULL, 
-					&CutoffVal, 
-					VolInfo, 
-					vector<FieldDataPointer_c>(), 
-					GradRawPtrs, 
-					RhoRawPtr);
-
-				if (IsOk)
-					IsOk = GPsNonSaddle[PtNum].Seed();
-
-				if (IsOk && DistSqr(NodePos, GPsNonSaddle[PtNum].XYZAt(0)) > DistSqr(NodePos, GPsNonSaddle[PtNum].XYZAt(GPsNonSaddle[PtNum].GetCount() - 1))){
-					IsOk = GPsNonSaddle[PtNum].Reverse();
-				}
-			}
-		}
+		/*
+		*	Get the edge path seed points here, then seed the node
+		*	and edge paths below in batches.
+		*/
+		vector<vec3> GPsEdgesSeedPts(NumEdges * NumEdgeGPs);
 
 		vector<vector<int> > ConstrainedNeighborEdgeNodesNum = ConstrainedNeighborNodesNum;
 		vector<vector<int> > ConstrainedNeighborhoodEdgeNums(ConstrainedNeighborNodesNum.size());
@@ -1121,11 +1140,6 @@ void MainFunction(){
 #pragma omp parallel for schedule(dynamic)
 #endif
 		for (int EdgeNum = 0; EdgeNum < NumEdges; ++EdgeNum){
-			if (omp_get_thread_num() == 0){
-				UserQuit = !StatusUpdate(NumCompleted++, TmpNumIterations, TmpString, AddOnID);
-#pragma omp flush (UserQuit)
-			}
-#pragma omp flush (UserQuit)
 			// Get the first edge node and a vector to step down the edge
 			vec3 eNodes[2], DelVec, SeedPt;
 			for (int i = 0; i < 2; ++i){
@@ -1135,41 +1149,9 @@ void MainFunction(){
 			}
 			DelVec = (eNodes[1] - eNodes[0]) / static_cast<double>(NumEdgeGPs + 1);
 			for (int EdgeGPNum = 0; EdgeGPNum < NumEdgeGPs; ++EdgeGPNum){
-				if (!UserQuit){
-					SeedPt = eNodes[0] + DelVec * static_cast<double>(EdgeGPNum + 1);
-					int GPInd = EdgeNum * NumEdgeGPs + EdgeGPNum;
-
-// 					IsOk = GPsEdges[GPInd].SetupGradPath(SeedPt,
-// 						StreamDir,
-// 						NumSTPoints,
-// 						HowTerminate,
-// 						NULL, vector<FieldDataPointer_c>(), NULL, NULL,
-// 						&CutoffVal,
-// 						VolMaxIJK,
-// 						VolMaxXYZ,
-// 						VolMinXYZ,
-// 						GradRawPtrs,
-// 						RhoRawPtr);
-
-					IsOk = GPsEdges[GPInd].SetupGradPath(SeedPt,
-						StreamDir,
-						NumSTPoints,
-						GPType_Classic,
-						HowTerminate,
-						NULL, NULL, NULL,
-						&CutoffVal,
-						VolInfo,
-						vector<FieldDataPointer_c>(),
-						GradRawPtrs,
-						RhoRawPtr);
-
-					if (IsOk)
-						IsOk = GPsEdges[GPInd].Seed();
-
-					if (IsOk && DistSqr(SeedPt, GPsEdges[GPInd].XYZAt(0)) > DistSqr(SeedPt, GPsEdges[GPInd].XYZAt(GPsEdges[GPInd].GetCount() - 1))){
-						IsOk = GPsEdges[GPInd].Reverse();
-					}
-				}
+				SeedPt = eNodes[0] + DelVec * static_cast<double>(EdgeGPNum + 1);
+				int GPInd = EdgeNum * NumEdgeGPs + EdgeGPNum;
+				GPsEdgesSeedPts[GPInd] = SeedPt;
 			}
 
 			// Also update the ConstrainedNeighborEdgeNodesNum list so that the saddle GPs know their
@@ -1198,6 +1180,140 @@ void MainFunction(){
 			}
 		}
 
+		/*
+		*	Seed node then edge paths, in runs of neighboring seeds
+		*	that follow similar trajectories, each run integrated
+		*	in lockstep by one thread's GradPathBatch_c.
+		*/
+		vector<int> SeedPathNums;
+		vector<vec3> SeedPts;
+		SeedPathNums.reserve(SphereGPs.NumPaths());
+		SeedPts.reserve(SeedPathNums.capacity());
+		for (int i = 0; i < NumPoints; ++i){
+			if (!NodeHasSaddleCP[i]){
+				vec3 NodePos;
+				for (int ii = 0; ii < 3; ++ii)
+					NodePos[ii] = p[i][ii];
+				SeedPathNums.push_back(i);
+				SeedPts.push_back(NodePos);
+			}
+		}
+		for (int i = 0; i < GPsEdgesSeedPts.size(); ++i){
+			SeedPathNums.push_back(EdgeGPsBeg + i);
+			SeedPts.push_back(GPsEdgesSeedPts[i]);
+		}
+
+		/*
+		*	Take any paths already in the cache, and seed the rest.
+		*/
+		if (GPCacheDir != NULL){
+			GradPath_c & SetupGP = SeedGPPools[0][0];
+			if (SetupGP.SetupGradPath(CPPos,
+				StreamDir,
+				NumSTPoints,
+				GPType_Classic,
+				HowTerminate,
+				NULL, NULL, NULL,
+				&CutoffVal,
+				VolInfo,
+				vector<FieldDataPointer_c>(),
+				GradRawPtrs,
+				RhoRawPtr))
+			{
+				SetupGP.SetNodeCache(NodeCachePtr);
+				GPCache.Open(GPCacheDir, SetupGP);
+			}
+
+			if (GPCache.IsOpen()){
+				int NumToSeed = 0;
+				for (int i = 0; i < SeedPathNums.size(); ++i){
+					if (!GPCache.Find(SeedPts[i], SphereGPs, SeedPathNums[i])){
+						SeedPathNums[NumToSeed] = SeedPathNums[i];
+						SeedPts[NumToSeed] = SeedPts[i];
+						NumToSeed++;
+					}
+				}
+				SeedPathNums.resize(NumToSeed);
+				SeedPts.resize(NumToSeed);
+			}
+		}
+
+		int NumRuns = (static_cast<int>(SeedPathNums.size()) + NumGPsPerRun - 1) / NumGPsPerRun;
+
+		int TmpNumIterations = MAX(1, NumRuns / numCPU);
+		int NumCompleted = 0;
+		Boolean_t SeedOk = TRUE;
+
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic) reduction(&&:SeedOk)
+#endif
+		for (int RunNum = 0; RunNum < NumRuns; ++RunNum){
+			if (omp_get_thread_num() == 0){
+				UserQuit = !StatusUpdate(NumCompleted++, TmpNumIterations, TmpString, AddOnID);
+#pragma omp flush (UserQuit)
+			}
+#pragma omp flush (UserQuit)
+
+			if (!UserQuit){
+				int BegGPNum = RunNum * NumGPsPerRun,
+					EndGPNum = MIN(BegGPNum + NumGPsPerRun, static_cast<int>(SeedPathNums.size()));
+				vector<GradPath_c> & Pool = SeedGPPools[omp_get_thread_num()];
+				vector<GradPath_c*> RunGPs;
+				RunGPs.reserve(EndGPNum - BegGPNum);
+
+				for (int i = BegGPNum; i < EndGPNum; ++i){
+					GradPath_c & GP = Pool[i - BegGPNum];
+					if (GP.SetupGradPath(SeedPts[i],
+						StreamDir,
+						NumSTPoints,
+						GPType_Classic,
+						HowTerminate,
+						NULL, NULL, NULL,
+						&CutoffVal,
+						VolInfo,
+						vector<FieldDataPointer_c>(),
+						GradRawPtrs,
+						RhoRawPtr))
+					{
+						GP.SetNodeCache(NodeCachePtr);
+						RunGPs.push_back(&GP);
+					}
+				}
+
+				/*
+				*	Paths are resampled as they're copied into SphereGPs,
+				*	so don't resample them here.
+				*/
+				Boolean_t RunOk = Batches[omp_get_thread_num()].Seed(RunGPs, false);
+
+				for (int i = BegGPNum; i < EndGPNum; ++i){
+					int PathNum = SeedPathNums[i];
+					GradPath_c & GP = Pool[i - BegGPNum];
+					if (GP.IsMade() && DistSqr(SeedPts[i], GP.XYZAt(0)) > DistSqr(SeedPts[i], GP.XYZAt(GP.GetCount() - 1))){
+						RunOk = (GP.Reverse() && RunOk);
+					}
+					RunOk = (SphereGPs.SetPath(PathNum, GP, NumSTPoints) && RunOk);
+					if (GPCache.IsOpen())
+						GPCache.Add(SeedPts[i], SphereGPs, PathNum);
+				}
+
+				SeedOk = (SeedOk && RunOk);
+			}
+		}
+
+		IsOk = SeedOk;
+
+		if (GPCache.IsOpen())
+			GPCache.Flush();
+
+#ifndef _DEBUG
+#pragma omp parallel for schedule(dynamic)
+#endif
+		for (int i = 0; i < SphereGPs.NumPaths(); ++i){
+			if (SphereGPs.IsMade(i))
+				SphereCompactGPs[i].Build(SphereGPs, i);
+		}
+
 		if (UserQuit){
 			StatusDrop(AddOnID);
 
@@ -1212,7 +1328,8 @@ void MainFunction(){
 			delete e;
 
 			TecUtilMemoryChangeNotify((NumSTPoints * 4 * NumPoints * sizeof(double)) / 1024);
-			GPsNonSaddle.clear();
+			SphereGPs.Clear();
+			SphereCompactGPs.clear();
 
 			TecUtilDataLoadEnd();
 			TecUtilLockFinish(AddOnID);
@@ -1238,6 +1355,37 @@ void MainFunction(){
 		}
 #endif // _DEBUG
 
+		/*
+		*	Each saddle CP node's neighbors need the closest point between
+		*	the saddle CP and the neighbor's edge path. One tree over all the
+		*	sphere's edge paths answers them all, in one batch here.
+		*/
+		GradPathSegmentTree_c EdgeGPTree;
+		vector<int> SaddleQueryBeg(IntZoneSaddleCPNodeNums.size() + 1, 0);
+		vector<vec3> NeighborQueryPts, NeighborClosestPts;
+		vector<int> NeighborQueryGPNums, NeighborClosestPtNums;
+		vector<double> NeighborClosestDists;
+		if (NumEdges * NumEdgeGPs > 0){
+			vector<int> EdgeGPNums(NumEdges * NumEdgeGPs);
+			for (int i = 0; i < EdgeGPNums.size(); ++i)
+				EdgeGPNums[i] = EdgeGPsBeg + i;
+			EdgeGPTree.Build(SphereGPs, EdgeGPNums);
+		}
+		for (int i = 0; i < IntZoneSaddleCPNodeNums.size(); ++i){
+			SaddleQueryBeg[i] = NeighborQueryPts.size();
+			for (int j = 0; j < MovedPointNums.size(); ++j){
+				if (IntZoneSaddleCPNodeNums[i][3] == MovedPointNums[j]){
+					for (int k = 0; k < ConstrainedNeighborEdgeNodesNum[j].size(); ++k){
+						NeighborQueryPts.push_back(IntCPPos[i]);
+						NeighborQueryGPNums.push_back(EdgeGPsBeg + ConstrainedNeighborEdgeNodesNum[j][k]);
+					}
+					break;
+				}
+			}
+		}
+		SaddleQueryBeg.back() = NeighborQueryPts.size();
+		EdgeGPTree.ClosestPointsOnPaths(NeighborQueryPts, NeighborQueryGPNums, NeighborClosestPts, NeighborClosestPtNums, NeighborClosestDists);
+
 
 #ifndef _DEBUG
 #pragma omp parallel for schedule(dynamic)
@@ -1280,7 +1428,12 @@ void MainFunction(){
 						 *	the neighbor node's grad path.
 						 */
 // 						vec3 ClosestPoint = GPsNonSaddle[ConstrainedNeighborNodesNum[j][k]].ClosestPoint(VolCPPos, GPsNonSaddleClosestPtNums[i][k]);
-						vec3 ClosestPoint = GPsEdges[ConstrainedNeighborEdgeNodesNum[j][k]].ClosestPoint(VolCPPos, GPsNonSaddleClosestPtNums[i][k]);
+						/*
+						 *	Use the closest point on the path's segments rather than
+						 *	its closest point, so v2 doesn't depend on the point spacing.
+						 */
+						vec3 ClosestPoint = NeighborClosestPts[SaddleQueryBeg[i] + k];
+						GPsNonSaddleClosestPtNums[i][k] = NeighborClosestPtNums[SaddleQueryBeg[i] + k];
 						/*
 						*	v1 is the direction from the main node to the volume CP.
 						*	v2 is the direction from main node to neighbor node, and is
@@ -1321,6 +1474,7 @@ void MainFunction(){
 							RhoRawPtr);
 
 						if (IsOk){
+							GPsSaddle[i][k].SetNodeCache(NodeCachePtr);
 							IsOk = GPsSaddle[i][k].Seed();
 // 							GPsSaddle[i][k].SaveAsOrderedZone("Saddle GP " + CPName + " Node " + to_string(ConstrainedNeighborNodesNum[j][k]), Green_C);
 						}
@@ -1402,6 +1556,7 @@ void MainFunction(){
 										RhoRawPtr);
 
 									if (IsOk){
+										GPsSaddleEdges[i][GPInd].SetNodeCache(NodeCachePtr);
 										IsOk = GPsSaddleEdges[i][GPInd].Seed();
 										// 							GPsSaddle[i][k].SaveAsOrderedZone("Saddle GP " + CPName + " Node " + to_string(ConstrainedNeighborNodesNum[j][k]), Green_C);
 									}
@@ -1430,6 +1585,28 @@ void MainFunction(){
 		}
 		TecUtilDataLoadEnd();
 
+		/*
+		*	Move the saddle paths into SphereGPs, keeping the number of
+		*	the first path and first edge path of each saddle node.
+		*/
+		vector<int> GPsSaddleBeg(GPsSaddle.size()), GPsSaddleEdgesBeg(GPsSaddle.size());
+		for (int i = 0; i < GPsSaddle.size(); ++i){
+			GPsSaddleBeg[i] = SphereGPs.NumPaths();
+			for (const GradPath_c & GP : GPsSaddle[i]){
+				SphereGPs.AddPath(GP);
+				SphereCompactGPs.emplace_back();
+				SphereCompactGPs.back().Build(SphereGPs, SphereGPs.NumPaths() - 1);
+			}
+			GPsSaddleEdgesBeg[i] = SphereGPs.NumPaths();
+			for (const GradPath_c & GP : GPsSaddleEdges[i]){
+				SphereGPs.AddPath(GP);
+				SphereCompactGPs.emplace_back();
+				SphereCompactGPs.back().Build(SphereGPs, SphereGPs.NumPaths() - 1);
+			}
+		}
+		GPsSaddle.clear();
+		GPsSaddleEdges.clear();
+
 // #pragma omp parallel for
 // 		for (int i = 0; i < GPsNonSaddle.size(); ++i){
 // 			if (GPsNonSaddle[i].IsMade()){
@@ -1446,38 +1623,44 @@ void MainFunction(){
 // 			}
 // 		}
 // 
-		for (int i = 0; i < GPsNonSaddle.size(); ++i){
-			if (GPsNonSaddle[i].IsMade()){
-				GPsNonSaddle[i].SaveAsOrderedZone("GP " + CPName + " " + "Node " + to_string(i + 1));
-				AuxDataZoneSetItem(GPsNonSaddle[i].GetZoneNum(), GBASphereCPName, CPName);
-				AuxDataZoneSetItem(GPsNonSaddle[i].GetZoneNum(), GBASphereCPNum, to_string(CPNum));
-				AuxDataZoneSetItem(GPsNonSaddle[i].GetZoneNum(), GBAGPNodeNum, to_string(i + 1));
-				AuxDataZoneSetItem(GPsNonSaddle[i].GetZoneNum(), GBAZoneType, GBAZoneTypeGradPath);
+		for (int i = 0; i < NumPoints; ++i){
+			if (SphereGPs.IsMade(i)){
+				EntIndex_t GPZoneNum = SphereGPs.SaveAsOrderedZone(i, "GP " + CPName + " " + "Node " + to_string(i + 1));
+				AuxDataZoneSetItem(GPZoneNum, GBASphereCPName, CPName);
+				AuxDataZoneSetItem(GPZoneNum, GBASphereCPNum, to_string(CPNum));
+				AuxDataZoneSetItem(GPZoneNum, GBAGPNodeNum, to_string(i + 1));
+				AuxDataZoneSetItem(GPZoneNum, GBAZoneType, GBAZoneTypeGradPath);
 			}
 		}
 
-		for (int i = 0; i < GPsSaddle.size(); ++i){
-			for (int j = 0; j < GPsSaddle[i].size(); ++j){
-				if (GPsSaddle[i][j].IsMade()){
-					GPsSaddle[i][j].SaveAsOrderedZone("GP " + CPName + " " + "Node " + to_string(MovedPointNums[i] + 1) + "." + to_string(j + 1));
-					AuxDataZoneSetItem(GPsSaddle[i][j].GetZoneNum(), GBASphereCPName, CPName);
-					AuxDataZoneSetItem(GPsSaddle[i][j].GetZoneNum(), GBASphereCPNum, to_string(CPNum));
-					AuxDataZoneSetItem(GPsSaddle[i][j].GetZoneNum(), GBAGPNodeNum, to_string(MovedPointNums[i] + 1));
-					AuxDataZoneSetItem(GPsSaddle[i][j].GetZoneNum(), GBAZoneType, GBAZoneTypeGradPath);
+		for (int i = 0; i < GPsSaddleBeg.size(); ++i){
+			for (int j = 0; j < GPsSaddleEdgesBeg[i] - GPsSaddleBeg[i]; ++j){
+				if (SphereGPs.IsMade(GPsSaddleBeg[i] + j)){
+					EntIndex_t GPZoneNum = SphereGPs.SaveAsOrderedZone(GPsSaddleBeg[i] + j, "GP " + CPName + " " + "Node " + to_string(MovedPointNums[i] + 1) + "." + to_string(j + 1));
+					AuxDataZoneSetItem(GPZoneNum, GBASphereCPName, CPName);
+					AuxDataZoneSetItem(GPZoneNum, GBASphereCPNum, to_string(CPNum));
+					AuxDataZoneSetItem(GPZoneNum, GBAGPNodeNum, to_string(MovedPointNums[i] + 1));
+					AuxDataZoneSetItem(GPZoneNum, GBAZoneType, GBAZoneTypeGradPath);
 				}
 			}
 		}
 
-		for (int i = 0; i < GPsEdges.size(); ++i){
-			if (GPsEdges[i].IsMade()){
-				GPsEdges[i].SaveAsOrderedZone("GP " + CPName + " " + "Node " + to_string(i + 1));
-				AuxDataZoneSetItem(GPsEdges[i].GetZoneNum(), GBASphereCPName, CPName);
-				AuxDataZoneSetItem(GPsEdges[i].GetZoneNum(), GBASphereCPNum, to_string(CPNum));
-				AuxDataZoneSetItem(GPsEdges[i].GetZoneNum(), GBAGPNodeNum, to_string(i + 1));
-				AuxDataZoneSetItem(GPsEdges[i].GetZoneNum(), GBAZoneType, GBAZoneTypeGradPath);
+		for (int i = 0; i < NumEdges * NumEdgeGPs; ++i){
+			if (SphereGPs.IsMade(EdgeGPsBeg + i)){
+				EntIndex_t GPZoneNum = SphereGPs.SaveAsOrderedZone(EdgeGPsBeg + i, "GP " + CPName + " " + "Node " + to_string(i + 1));
+				AuxDataZoneSetItem(GPZoneNum, GBASphereCPName, CPName);
+				AuxDataZoneSetItem(GPZoneNum, GBASphereCPNum, to_string(CPNum));
+				AuxDataZoneSetItem(GPZoneNum, GBAGPNodeNum, to_string(i + 1));
+				AuxDataZoneSetItem(GPZoneNum, GBAZoneType, GBAZoneTypeGradPath);
 			}
 		}
 
+		/*
+		*	The bundles only need the compact paths from here on.
+		*/
+		TecUtilMemoryChangeNotify(-int(NumSTPoints * 4 * (NumPoints + IntZoneSaddleCPNodeNums.size()) * sizeof(double)) / 1024);
+		SphereGPs.Clear();
+
 
 		/*
 		 *	Now have all gradient paths.
@@ -1635,9 +1818,9 @@ void MainFunction(){
 			}
 #pragma omp flush (UserQuit)
 			if (!UserQuit){
-				vector<GradPath_c*> GPPtrs;
+				vector<int> GPNums;
 				if (TriangleHasSaddleCP[TriNum]){
-					GPPtrs.reserve(3 + 3 * NumEdgeGPs + 1);
+					GPNums.reserve(3 + 3 * NumEdgeGPs + 1);
 					/*
 					 *	Need to find which GPs to use
 					 *	for the FE volume.
@@ -1689,26 +1872,26 @@ void MainFunction(){
 						});
 						for (int n = 0; n < Nodes.size(); ++n){
 							if (n < Nodes.size() - 1){
-								GPPtrs.push_back(&GPsNonSaddle[Nodes[n]]);
+								GPNums.push_back(Nodes[n]);
 							}
 							else{
-								GPPtrs.push_back(&GPsSaddle[SaddleNum][ConstrainedGPNums[1]]);
+								GPNums.push_back(GPsSaddleBeg[SaddleNum] + ConstrainedGPNums[1]);
 								bool EdgeFound = false;
 								for (int ei = 0; ei < ConstrainedNeighborhoodEdgeNums[SaddleNum].size() && !EdgeFound; ++ei){
 									if (std::find(TriangleEdgeNums[TriNum].begin(), TriangleEdgeNums[TriNum].end(), ConstrainedNeighborhoodEdgeNums[SaddleNum][ei]) != TriangleEdgeNums[TriNum].end()){
 										if (e[ConstrainedNeighborhoodEdgeNums[SaddleNum][ei]][0] == NonConstrainedNodeNums[1]){
 											for (int i = 0; i < NumEdgeGPs; ++i){
-												GPPtrs.push_back(&GPsSaddleEdges[SaddleNum][ei * NumEdgeGPs + i]);
+												GPNums.push_back(GPsSaddleEdgesBeg[SaddleNum] + ei * NumEdgeGPs + i);
 											}
 										}
 										else{
 											for (int i = NumEdgeGPs - 1; i >= 0; --i){
-												GPPtrs.push_back(&GPsSaddleEdges[SaddleNum][ei * NumEdgeGPs + i]);
+												GPNums.push_back(GPsSaddleEdgesBeg[SaddleNum] + ei * NumEdgeGPs + i);
 											}
 										}
 									}
 								}
-								GPPtrs.push_back(&GPsSaddle[SaddleNum][ConstrainedGPNums[0]]);
+								GPNums.push_back(GPsSaddleBeg[SaddleNum] + ConstrainedGPNums[0]);
 							}
 							bool EdgeFound = false;
 							for (int ei = 0; ei < 3 && !EdgeFound; ++ei){
@@ -1716,12 +1899,12 @@ void MainFunction(){
 									if (e[TriangleEdgeNums[TriNum][ei]][i] == Nodes[n] && e[TriangleEdgeNums[TriNum][ei]][(i + 1) % 2] == Nodes[(n + 1) % Nodes.size()]) {
 										if (i == 0){
 											for (int j = 0; j < NumEdgeGPs; ++j){
-												GPPtrs.push_back(&GPsEdges[TriangleEdgeNums[TriNum][ei] * NumEdgeGPs + j]);
+												GPNums.push_back(EdgeGPsBeg + TriangleEdgeNums[TriNum][ei] * NumEdgeGPs + j);
 											}
 										}
 										else{
 											for (int j = NumEdgeGPs - 1; j >= 0; --j){
-												GPPtrs.push_back(&GPsEdges[TriangleEdgeNums[TriNum][ei] * NumEdgeGPs + j]);
+												GPNums.push_back(EdgeGPsBeg + TriangleEdgeNums[TriNum][ei] * NumEdgeGPs + j);
 											}
 										}
 										EdgeFound = true;
@@ -1752,21 +1935,21 @@ void MainFunction(){
 					}
 				}
 				else{
-					GPPtrs.reserve(3 + 3 * NumEdgeGPs);
+					GPNums.reserve(3 + 3 * NumEdgeGPs);
 					for (int n = 0; n < 3; ++n){
-						GPPtrs.push_back(&GPsNonSaddle[t[TriNum][n]]);
+						GPNums.push_back(t[TriNum][n]);
 						bool EdgeFound = false;
 						for (int ei = 0; ei < 3 && !EdgeFound; ++ei){
 							for (int i = 0; i < 2; ++i){
 								if (e[TriangleEdgeNums[TriNum][ei]][i] == t[TriNum][n] && e[TriangleEdgeNums[TriNum][ei]][(i + 1) % 2] == t[TriNum][(n + 1) % 3]) {
 									if (i == 0){
 										for (int j = 0; j < NumEdgeGPs; ++j){
-											GPPtrs.push_back(&GPsEdges[TriangleEdgeNums[TriNum][ei] * NumEdgeGPs + j]);
+											GPNums.push_back(EdgeGPsBeg + TriangleEdgeNums[TriNum][ei] * NumEdgeGPs + j);
 										}
 									}
 									else{
 										for (int j = NumEdgeGPs - 1; j >= 0; --j){
-											GPPtrs.push_back(&GPsEdges[TriangleEdgeNums[TriNum][ei] * NumEdgeGPs + j]);
+											GPNums.push_back(EdgeGPsBeg + TriangleEdgeNums[TriNum][ei] * NumEdgeGPs + j);
 										}
 									}
 									EdgeFound = true;
@@ -1789,7 +1972,11 @@ void MainFunction(){
 				}
 				if (IsOk){
 // 					if (TriNum < 3) TecUtilDialogMessageBox("Before making FEVolume", MessageBoxType_Information);
-					IsOk = FEVolumes[TriNum].MakeGradientBundle(GPPtrs);
+					vector<const CompactGradPath_c*> CompactGPPtrs;
+					CompactGPPtrs.reserve(GPNums.size());
+					for (const int & n : GPNums)
+						CompactGPPtrs.push_back(&SphereCompactGPs[n]);
+					IsOk = FEVolumes[TriNum].MakeGradientBundle(CompactGPPtrs, NumSTPoints);
 // 					if (TriNum < 3) TecUtilDialogMessageBox("After making FEVolume", MessageBoxType_Information);
 				}
 			}
@@ -1878,9 +2065,7 @@ void MainFunction(){
 			}
 			delete e;
 
-			TecUtilMemoryChangeNotify(-int(NumSTPoints * 4 * (NumPoints + IntZoneSaddleCPNodeNums.size()) * sizeof(double)) / 1024);
-			GPsNonSaddle.clear();
-			GPsSaddle.clear();
+			SphereCompactGPs.clear();
 
 			TecUtilMemoryChangeNotify((NumSTPoints * 4 * 4 * NumTriangles * sizeof(double)) / 1024);
 			FEVolumes.clear();
@@ -1892,9 +2077,7 @@ void MainFunction(){
 		TecUtilDataLoadEnd();
 
 
-		TecUtilMemoryChangeNotify(-int(NumSTPoints * 4 * (NumPoints + IntZoneSaddleCPNodeNums.size()) * sizeof(double)) / 1024);
-		GPsNonSaddle.clear();
-		GPsSaddle.clear();
+		SphereCompactGPs.clear();
 
 		/*
 		 *	Test volume integration of all FE zones
@@ -155,6 +155,22 @@ void BuildTab1_1(LgIndex_t  Parent)
                                "Open System",
                                TGLOpenSys_TOG_T1_1_CB);
 
+  TGLNodeCache_TOG_T1_1 = TecGUIToggleAdd(Tab1_1Manager,
+                                          2750,
+                                          1391,
+                                          1400,
+                                          124,
+                               "Node cache",
+                               TGLNodeCache_TOG_T1_1_CB);
+
+  TGLSglPrec_TOG_T1_1 = TecGUIToggleAdd(Tab1_1Manager,
+                                        4250,
+                                        1391,
+                                        1700,
+                                        124,
+                               "Single precision",
+                               TGLSglPrec_TOG_T1_1_CB);
+
   MLSelVars_MLST_T1_1 = TecGUIListAdd(Tab1_1Manager,
                                     2676,
                                     329,
@@ -265,6 +281,22 @@ void BuildTab2_1(LgIndex_t  Parent)
                                "Integrate Volume",
                                TGLIntVolInt_TOG_T2_1_CB);
 
+  TGLIntNodeCache_TOG_T2_1 = TecGUIToggleAdd(Tab2_1Manager,
+                                             7614,
+                                             1000,
+                                             2469,
+                                             124,
+                               "Node record cache",
+                               TGLIntNodeCache_TOG_T2_1_CB);
+
+  TGLIntSglPrec_TOG_T2_1 = TecGUIToggleAdd(Tab2_1Manager,
+                                           7614,
+                                           1286,
+                                           2469,
+                                           124,
+                               "Single precision cache",
+                               TGLIntSglPrec_TOG_T2_1_CB);
+
   LBL6_LBL_T2_1 = TecGUILabelAdd(Tab2_1Manager,
                                8354,
                                124,
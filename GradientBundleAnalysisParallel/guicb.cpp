@@ -65,6 +65,26 @@ static void TGLIntVolInt_TOG_T2_1_CB(const LgIndex_t *I)
 }
 
 
+/**
+*/
+static void TGLIntNodeCache_TOG_T2_1_CB(const LgIndex_t *I)
+{
+	TecUtilLockStart(AddOnID);
+	TRACE1("Toggle (TGLIntNodeCache_TOG_T2_1) Value Changed,  New value is: %d\n", *I);
+	TecUtilLockFinish(AddOnID);
+}
+
+
+/**
+*/
+static void TGLIntSglPrec_TOG_T2_1_CB(const LgIndex_t *I)
+{
+	TecUtilLockStart(AddOnID);
+	TRACE1("Toggle (TGLIntSglPrec_TOG_T2_1) Value Changed,  New value is: %d\n", *I);
+	TecUtilLockFinish(AddOnID);
+}
+
+
 /**
 */
 static void MLIntSelVar_MLST_T2_1_CB(const LgIndex_t *I)
@@ -353,6 +373,26 @@ static void TGLOpenSys_TOG_T1_1_CB(const LgIndex_t *I)
 }
 
 
+/**
+*/
+static void TGLNodeCache_TOG_T1_1_CB(const LgIndex_t *I)
+{
+	TecUtilLockStart(AddOnID);
+	TRACE1("Toggle (TGLNodeCache_TOG_T1_1) Value Changed,  New value is: %d\n", *I);
+	TecUtilLockFinish(AddOnID);
+}
+
+
+/**
+*/
+static void TGLSglPrec_TOG_T1_1_CB(const LgIndex_t *I)
+{
+	TecUtilLockStart(AddOnID);
+	TRACE1("Toggle (TGLSglPrec_TOG_T1_1) Value Changed,  New value is: %d\n", *I);
+	TecUtilLockFinish(AddOnID);
+}
+
+
 /**
 */
 static LgIndex_t  TFLevel_TFS_T1_1_ValueChanged_CB(const char *S)
@@ -622,6 +662,8 @@ Boolean_t GBAProcessSystemPrepareGUI(){
 	TecGUIListDeleteAllItems(MLSelVars_MLST_T1_1);
 	TecGUIToggleSet(TGLInt_TOG_T1_1, DefaultIntegrate);
 	TecGUIToggleSet(TGLVolInt_TOG_T1_1, DefaultVolIntegrate);
+	TecGUIToggleSet(TGLNodeCache_TOG_T1_1, FALSE);
+	TecGUIToggleSet(TGLSglPrec_TOG_T1_1, FALSE);
 	if (DefaultIntegrate){
 		ListPopulateWithVarNames(MLSelVars_MLST_T1_1);
 	}
@@ -741,17 +783,21 @@ void GBAProcessSystemDeleteCPLabels(){
 }
 
 void PrepareIntegration(Boolean_t IntegratingFromIntTab){
-	LgIndex_t AtomListID, VarListID, TGLID, ScaleID;
+	LgIndex_t AtomListID, VarListID, TGLID, CacheTGLID, SglPrecTGLID, ScaleID;
 	if (IntegratingFromIntTab){
 		AtomListID = MLIntSelSph_MLST_T2_1;
 		VarListID = MLIntSelVar_MLST_T2_1;
 		TGLID = TGLIntVolInt_TOG_T2_1;
+		CacheTGLID = TGLIntNodeCache_TOG_T2_1;
+		SglPrecTGLID = TGLIntSglPrec_TOG_T2_1;
 		ScaleID = SCIntPrecise_SC_T2_1;
 	}
 	else{
 		AtomListID = MLSelCPs_MLST_T1_1;
 		VarListID = MLSelVars_MLST_T1_1;
 		TGLID = TGLVolInt_TOG_T1_1;
+		CacheTGLID = TGLNodeCache_TOG_T1_1;
+		SglPrecTGLID = TGLSglPrec_TOG_T1_1;
 		ScaleID = SCPrecise_SC_T1_1;
 	}
 
@@ -760,7 +806,7 @@ void PrepareIntegration(Boolean_t IntegratingFromIntTab){
 	vector<int> IntVarNumList = ListGetSelectedItemNums(VarListID);
 
 	PerformIntegration(AtomNameList, IntVarNameList, IntVarNumList,
-		TecGUIToggleGet(TGLID), TecGUIScaleGetValue(ScaleID));
+		TecGUIToggleGet(TGLID), TecGUIScaleGetValue(ScaleID), TecGUIToggleGet(CacheTGLID), TecGUIToggleGet(SglPrecTGLID));
 	/*for (int i = 1; i < 5; ++i){
 		PerformIntegration(AtomNameList, IntVarNameList, IntVarNumList,
 			TecGUIToggleGet(TGLID), i);
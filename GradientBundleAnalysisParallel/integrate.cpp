@@ -22,6 +22,7 @@
 #include "ZONEVARINFO.h"
 #include "CSM_DATA_TYPES.h"
 #include "CSM_FE_VOLUME.h"
+#include "CSM_NODE_RECORD_CACHE.h"
 #include "VIEWRESULTS.h"
 #include "CSM_GUI.h"
 
@@ -60,6 +61,8 @@ void GBAIntegrationPrepareGUI(){
 	TecGUIListDeleteAllItems(MLIntSelSph_MLST_T2_1);
 	TecGUIListDeleteAllItems(MLIntSelVar_MLST_T2_1);
 	TecGUIToggleSet(TGLIntVolInt_TOG_T2_1, TRUE);
+	TecGUIToggleSet(TGLIntNodeCache_TOG_T2_1, FALSE);
+	TecGUIToggleSet(TGLIntSglPrec_TOG_T2_1, FALSE);
 	/*
 	*	First, populate the list of spheres.
 	*	Get a total list, then load them alphabetically
@@ -117,7 +120,9 @@ const Boolean_t PerformIntegration(const vector<string> & AtomNameList,
 	const vector<string> & IntVarNameList,
 	const vector<int> & IntVarNumList,
 	const Boolean_t & IntegrateVolume,
-	const int & IntResolution)
+	const int & IntResolution,
+	const Boolean_t & UseNodeCache,
+	const Boolean_t & SinglePrecisionCache)
 {
 
 	TecUtilLockStart(AddOnID);
@@ -283,6 +288,28 @@ const Boolean_t PerformIntegration(const vector<string> & AtomNameList,
 // 	}
 
 
+	/*
+	*	Interleave the integration variables once for all atoms so that
+	*	each volume reads one record per node instead of one value per
+	*	variable array. If the cache can't be made (too large, etc.)
+	*	the volumes just use their own pointers.
+	*	The cache is a second copy of the variables, so it's only made
+	*	if the user asks for it (UseNodeCache).
+	*	SinglePrecisionCache stores the records as float (sums are still
+	*	done in double), which halves the cache's memory footprint.
+	*/
+	NodeRecordCache_c IntVarCache;
+	if (IsOk && UseNodeCache){
+		TecUtilDataLoadBegin();
+		vector<FieldDataPointer_c> IntVarPtrs(IntVarNumList.size());
+		Boolean_t PtrsOk = TRUE;
+		for (int i = 0; i < IntVarNumList.size() && PtrsOk; ++i)
+			PtrsOk = IntVarPtrs[i].GetReadPtr(VolZoneNum, IntVarNumList[i]);
+		if (PtrsOk)
+			IntVarCache.Build(IntVarPtrs, &AddOnID, NodeRecordLayout_Linear, SinglePrecisionCache);
+		TecUtilDataLoadEnd();
+	}
+
 	Set_pa ZoneSet = TecUtilSetAlloc(FALSE);
 
 	for (int AtomNum = 0; AtomNum < AtomNameList.size(); ++AtomNum){
@@ -355,6 +382,10 @@ const Boolean_t PerformIntegration(const vector<string> & AtomNameList,
 		if (FreshIntegration || TecUtilDialogMessageBox("Variables have already been integrated for this zone."
 			" Integrate again?", MessageBox_YesNo)){
 			int NumVolumes = static_cast<int>(VolumeList.size());
+			if (IntVarCache.IsReady()){
+				for (FESurface_c & Vol : VolumeList)
+					Vol.SetIntVarCache(&IntVarCache);
+			}
 			int NumVolForPercentDone = NumVolumes;
 #ifndef _DEBUG
 			NumVolForPercentDone /= numCPU;